@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_epoch.h
+ * \brief  Epoch based deferred reclamation of the FIB DR/NH nodes.
+ */
+
+#ifndef __HAL_RT_EPOCH_H__
+#define __HAL_RT_EPOCH_H__
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+/* Max. number of threads that can be in an epoch read section at the same time,
+ * a thread keeps its reader slot till it exits */
+#define HAL_RT_EPOCH_MAX_READERS         32
+/* No. of pending retired nodes that triggers a reclaim from the retire path */
+#define HAL_RT_EPOCH_RECLAIM_THRESHOLD   1024
+/* Max. no. of nodes retired by a thread before they are flushed to the
+ * reclaim list, the writers flush them at the end of the lock hold */
+#define HAL_RT_EPOCH_RETIRE_BATCH        256
+
+typedef void (*hal_rt_epoch_free_fn_t) (void *p_node);
+
+/*
+ * Epoch based reclamation.
+ *
+ * A reader announces the global epoch in its slot when it enters the read
+ * section, the nodes unlinked from the FIB are retired with the epoch at the
+ * time of the flush of the thread retire batch and the global epoch is advanced,
+ * which is after the unlink of all the nodes of the batch. A retired node is freed
+ * only when every reader in a read section has entered after its retire epoch,
+ * so a reader can keep a node pointer across the nas_l3_lock drops for the
+ * whole of its read section.
+ */
+class hal_rt_epoch_t {
+    public:
+        hal_rt_epoch_t ();
+        hal_rt_epoch_t (const hal_rt_epoch_t&) = delete;
+        hal_rt_epoch_t& operator= (const hal_rt_epoch_t&) = delete;
+
+        /* Returns false if no reader slot is available for the thread */
+        bool enter ();
+        void exit ();
+        /* Adds the node to the retire batch of the thread */
+        void retire (void *p_node, hal_rt_epoch_free_fn_t free_fn);
+        /* Moves the retire batch of the thread to the reclaim list */
+        void retire_flush ();
+        /* Frees the retired nodes that are not reachable by any reader */
+        void reclaim ();
+        /* Flushes the retire batch and releases the reader slot of the thread */
+        void thread_exit ();
+
+        uint64_t epoch () const { return m_epoch.load (std::memory_order_relaxed); }
+        uint64_t retired () const { return m_retired.load (std::memory_order_relaxed); }
+        uint64_t reclaimed () const { return m_reclaimed.load (std::memory_order_relaxed); }
+        size_t pending () const { return m_pending.load (std::memory_order_relaxed); }
+
+        typedef struct {
+            void                   *p_node;
+            hal_rt_epoch_free_fn_t  free_fn;
+            uint64_t                epoch;
+        } retired_node_t;
+
+    private:
+
+        typedef struct {
+            std::atomic<bool>       in_use;
+            /* Epoch at the read section entry, 0 when not in a read section */
+            std::atomic<uint64_t>   epoch;
+        } reader_slot_t;
+
+        int slot_get ();
+        uint64_t min_reader_epoch () const;
+
+        std::atomic<uint64_t>       m_epoch;
+        reader_slot_t               m_readers[HAL_RT_EPOCH_MAX_READERS];
+        std::mutex                  m_retire_mutex;
+        /* Retired nodes in the ascending order of the retire epoch */
+        std::list<retired_node_t>   m_retire_list;
+        std::atomic<size_t>         m_pending;
+        std::atomic<uint64_t>       m_retired;
+        std::atomic<uint64_t>       m_reclaimed;
+};
+
+#endif /* __HAL_RT_EPOCH_H__ */
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_hash.h
+ * \brief  Open addressing hash index for the exact match lookups of the
+ *         DR and NH trees.
+ */
+
+#ifndef __HAL_RT_HASH_H__
+#define __HAL_RT_HASH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FIB_HASH_MIN_SLOTS  64
+
+/* An empty slot has no value, the hash of the key is kept in the slot so
+ * that a probe compares the keys of the matching hashes only */
+typedef struct {
+    void     *p_val;
+    uint32_t  hash;
+} t_fib_hash_slot;
+
+typedef struct _t_fib_hash {
+    t_fib_hash_slot *p_slots;
+    uint32_t         num_slots;   /* Power of 2 */
+    uint32_t         num_entries;
+    bool             is_valid;    /* false once an update failed for want of memory */
+} t_fib_hash;
+
+/* Returns true if the value has the key */
+typedef bool (*t_fib_hash_match_fn) (const void *p_val, const void *p_key);
+
+t_fib_hash *fib_hash_create (void);
+void fib_hash_destroy (t_fib_hash *p_hash);
+
+/* Hash of the key bytes */
+uint32_t fib_hash_key (const void *p_key, size_t len);
+
+/* Add the value, the caller makes sure its key is not in the index yet.
+ * Returns false if the index could not be updated, the index is invalid then */
+bool fib_hash_add (t_fib_hash *p_hash, uint32_t hash, void *p_val);
+/* Delete the value added with the hash */
+void fib_hash_del (t_fib_hash *p_hash, uint32_t hash, const void *p_val);
+
+/* Value with the hash and the key, NULL if none */
+void *fib_hash_lookup (const t_fib_hash *p_hash, uint32_t hash,
+                       t_fib_hash_match_fn match_fn, const void *p_key);
+
+static inline bool fib_hash_is_valid (const t_fib_hash *p_hash)
+{
+    return ((p_hash != NULL) && (p_hash->is_valid));
+}
+
+#endif /* __HAL_RT_HASH_H__ */
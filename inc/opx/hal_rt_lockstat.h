@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_lockstat.h
+ * \brief  Wait and hold time profiling of the nas_l3_lock per call site.
+ */
+
+#ifndef __HAL_RT_LOCKSTAT_H__
+#define __HAL_RT_LOCKSTAT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Max. no. of threads profiled at the same time, a thread keeps its buffer
+ * till it exits and the buffer is reused (with its stats) after that. The
+ * lock holds of the threads beyond these are counted as dropped. */
+#define HAL_RT_LOCKSTAT_MAX_THREADS  32
+/* Max. no. of call site and mode pairs profiled per thread, power of 2 */
+#define HAL_RT_LOCKSTAT_MAX_SITES    64
+/* Max. no. of nas_l3_lock holds nested in a thread */
+#define HAL_RT_LOCKSTAT_MAX_DEPTH    4
+
+typedef enum {
+    HAL_RT_LOCK_MODE_EXCL = 0,   /* nas_l3_lock */
+    HAL_RT_LOCK_MODE_SHARED,     /* nas_l3_lock_shared, no VRF being updated */
+    HAL_RT_LOCK_MODE_VRF,        /* nas_l3_vrf_lock, one VRF locked */
+    HAL_RT_LOCK_MODE_VRF_SHARED, /* nas_l3_vrf_lock_shared */
+    HAL_RT_LOCK_MODE_MAX,
+} t_hal_rt_lock_mode;
+
+/* Lock stats of a call site, in nano secs */
+typedef struct {
+    const char        *site;  /* Function that took the lock */
+    t_hal_rt_lock_mode mode;
+    uint64_t           count;
+    uint64_t           wait_nsecs;
+    uint64_t           wait_max;
+    uint64_t           hold_nsecs;
+    uint64_t           hold_max;
+} t_hal_rt_lockstat;
+
+/* Time the lock acquisition started at, to be passed to hal_rt_lockstat_acquired */
+uint64_t hal_rt_lockstat_start (void);
+
+/* Record the wait time of the lock taken by the site and start its hold time */
+void hal_rt_lockstat_acquired (const char *site, t_hal_rt_lock_mode mode, uint64_t start);
+
+/* Record the hold time of the last lock taken by the thread */
+void hal_rt_lockstat_released (void);
+
+/* Stats of all the threads summed up per site and mode, returns the no. of
+ * entries filled in p_stats */
+uint32_t hal_rt_lockstat_get (t_hal_rt_lockstat *p_stats, uint32_t max_stats);
+
+/* No. of lock holds not profiled for want of a thread buffer or a site entry */
+uint64_t hal_rt_lockstat_dropped_get (void);
+
+void hal_rt_lockstat_clear (void);
+
+const char *hal_rt_lock_mode_to_str (t_hal_rt_lock_mode mode);
+
+#endif /* __HAL_RT_LOCKSTAT_H__ */
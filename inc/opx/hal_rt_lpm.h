@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_lpm.h
+ * \brief  Multibit trie index for the longest prefix match of the DR trees.
+ */
+
+#ifndef __HAL_RT_LPM_H__
+#define __HAL_RT_LPM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Address bits taken per trie level */
+#define FIB_LPM_STRIDE      6
+#define FIB_LPM_SLOTS       (1 << FIB_LPM_STRIDE)
+
+/* Key of the index, the address bits are from the MSB of hi, an IPv4
+ * address is in the upper 32 bits of hi */
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} t_fib_lpm_key;
+
+/* Prefix ending in the stride of a node */
+typedef struct {
+    void    *p_val;
+    uint8_t  len;   /* Prefix length within the node, 1 to FIB_LPM_STRIDE */
+    uint8_t  bits;  /* Prefix bits within the node, right aligned */
+} t_fib_lpm_pfx;
+
+/*
+ * A slot of a node is either a child node or a leaf. The children and the
+ * leaves are packed in slot order and indexed by the popcount of the slot
+ * bitmaps (poptrie), the adjacent leaf slots with the same value share
+ * the leaf entry.
+ */
+typedef struct _t_fib_lpm_node {
+    uint64_t                vector;    /* Slots with a child node */
+    uint64_t                leafvec;   /* Leaf slots starting a run of the same leaf */
+    struct _t_fib_lpm_node *p_child;   /* Child nodes of the vector slots */
+    void                  **p_leaf;    /* Leaves of the leafvec runs, NULL for no prefix */
+    void                   *p_inherit; /* Longest prefix of the parent covering the node */
+    t_fib_lpm_pfx          *p_pfx;     /* Prefixes ending in the stride of the node */
+    uint16_t                num_pfx;
+    uint16_t                max_pfx;
+} t_fib_lpm_node;
+
+typedef struct _t_fib_lpm {
+    t_fib_lpm_node root;
+    void          *p_default;  /* Zero length prefix */
+    uint32_t       max_len;
+    bool           is_valid;   /* false once an update failed for want of memory */
+    uint32_t       num_pfx;
+    uint32_t       num_nodes;
+    uint64_t       num_bytes;
+} t_fib_lpm;
+
+t_fib_lpm *fib_lpm_create (uint32_t max_len);
+void fib_lpm_destroy (t_fib_lpm *p_lpm);
+
+/* Add or replace the value of the prefix, returns false if the index could
+ * not be updated, the index is invalid then */
+bool fib_lpm_add (t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len, void *p_val);
+void fib_lpm_del (t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len);
+
+/* Value of the longest prefix matching the key, NULL if none */
+void *fib_lpm_lookup (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key);
+/* Value of the longest prefix matching the key not longer than max_len */
+void *fib_lpm_lookup_len (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t max_len);
+/* Value of the longest prefix matching the key strictly shorter than len,
+ * the next best fit of the prefix of that length, NULL if none */
+void *fib_lpm_next_best (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len);
+
+static inline bool fib_lpm_is_valid (const t_fib_lpm *p_lpm)
+{
+    return ((p_lpm != NULL) && (p_lpm->is_valid));
+}
+
+#endif /* __HAL_RT_LPM_H__ */
@@ -35,6 +35,7 @@
 #include "nas_vrf_utils.h"
 
 #include <stdbool.h>
+#include <pthread.h>
 #include <sys/socket.h>
 #include "event_log.h"
 
@@ -48,6 +49,7 @@
 #define HAL_RT_V6_PREFIX_LEN              (8 * HAL_INET6_LEN)
 #define HAL_RT_MAX_ECMP_PATH              NDI_MAX_NH_ENTRIES_PER_GROUP   /* Maximum supported ECMP paths per Group */
 #define MAX_LEN_VRF_NAME                  32
+#define HAL_RT_CACHE_LINE_SIZE            64
 #define FIB_MIN_AFINDEX                   HAL_RT_V4_AFINDEX
 #define FIB_MAX_AFINDEX                   (HAL_RT_V6_AFINDEX + 1)
 /* The current neighbor reachable time is 1 hour, if the below variable changes,
@@ -163,11 +165,37 @@ typedef struct _t_fib_link_node {
     void    *self;
 } t_fib_link_node;
 
+/* Action taken by the msg producer when the msg queue is at its bounds */
+typedef enum {
+    FIB_MSG_QUEUE_OVERFLOW_BLOCK = 1, /* Block the producer till the queue drains */
+    FIB_MSG_QUEUE_OVERFLOW_RESYNC,    /* Drop the route add/update msgs and resync
+                                         the VRF routes from the kernel later */
+    FIB_MSG_QUEUE_OVERFLOW_MAX
+} t_fib_msg_queue_overflow_policy;
+
 typedef struct _t_fib_config {
     uint32_t         max_num_npu;
     uint32_t         ecmp_max_paths;
     bool             ecmp_path_fall_back;
     uint8_t          ecmp_hash_sel;
+    uint32_t         msg_batch_size; /* Max. no. of msgs processed per nas_l3_lock hold */
+    uint32_t         msg_batch_time_budget; /* Max. nas_l3_lock hold time (in micro secs)
+                                               for a msg batch, 0 means no time limit */
+    uint32_t         msg_queue_max_len; /* Max. no. of msgs pending in the msg queue */
+    uint64_t         msg_queue_max_bytes; /* Max. bytes of msgs pending in the msg queue,
+                                             0 means no bytes limit */
+    t_fib_msg_queue_overflow_policy msg_queue_overflow_policy;
+    uint32_t         msg_workers; /* No. of msg worker threads, the VRFs are sharded
+                                     across the workers */
+    uint32_t         walker_time_budget; /* Max. VRF lock hold time (in micro secs) for a
+                                            DR/NH walker batch, 0 means the max. batch */
+    uint32_t         walker_coalesce_time; /* Max. time (in micro secs) the DR walker wakeup
+                                              is held back since the first route change,
+                                              0 wakes the walker on every change */
+    uint32_t         walker_coalesce_changes; /* No. of route changes that wake the DR walker
+                                                 before the coalesce time, 0 means no limit */
+    uint32_t         rslv_workers; /* No. of resolution worker threads computing the DR
+                                      FH sets for the walkers, 0 to compute in the walkers */
 } t_fib_config;
 
 typedef struct _t_fib_gbl_info {
@@ -264,6 +292,15 @@ typedef struct _t_fib_vrf_info {
     std_radix_version_t nh_ha_max_radix_ver;
     t_fib_route_summary route_summary;
     uint32_t            event_filter_info;
+    /* Resolution burst of the walker holding the VRF lock, NULL otherwise */
+    struct _t_fib_rslv_burst *p_rslv_burst;
+    /* Shadow LPM index of the dr_tree for the best fit lookups, the dr_tree
+     * is looked up if the index could not be kept up to date */
+    struct _t_fib_lpm  *p_dr_lpm;
+    /* Shadow hash indexes of the dr_tree and nh_tree for the exact lookups,
+     * the trees are looked up if an index could not be kept up to date */
+    struct _t_fib_hash *p_dr_hash;
+    struct _t_fib_hash *p_nh_hash;
 } t_fib_vrf_info;
 
 typedef struct _t_fib_vrf_cntrs {
@@ -315,8 +352,17 @@ typedef struct _t_fib_vrf {
     t_fib_vrf_info   info [FIB_MAX_AFINDEX];
     t_fib_vrf_cntrs  cntrs [FIB_MAX_AFINDEX];
     hal_mac_addr_t   router_mac; /* VRF router MAC */
+    pthread_rwlock_t lock; /* Per VRF lock, see the lock order in hal_rt_main.c */
+    uint32_t         num_leak_refs; /* No. of DR-NH links with the other VRFs */
 } t_fib_vrf;
 
+/* Mode the VRF was locked in by nas_l3_vrf_lock */
+typedef enum _t_fib_vrf_lock_mode {
+    FIB_VRF_LOCK_NONE = 0, /* VRF not present, only the nas_l3_lock is held shared */
+    FIB_VRF_LOCK_VRF,      /* VRF lock held, the nas_l3_lock is held shared */
+    FIB_VRF_LOCK_EXCL,     /* nas_l3_lock held exclusive, the VRF has leaked routes */
+} t_fib_vrf_lock_mode;
+
 typedef enum _t_fib_cmp_result {
     FIB_CMP_RESULT_EQUAL = 1,
     FIB_CMP_RESULT_NOT_EQUAL = 2,
@@ -329,7 +375,9 @@ typedef enum {
     FIB_MSG_TYPE_NBR_MGR_NBR_INFO, /* Nbr notification from the Nbr mgr */
     FIB_MSG_TYPE_NL_NBR,
     FIB_MSG_TYPE_INTF_IP_UNREACH_CFG, /* IP unreachable configuration from the user */
-    FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG /* IP redirects configuration from the user */
+    FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG, /* IP redirects configuration from the user */
+    FIB_MSG_TYPE_BARRIER, /* Ordering barrier across the msg workers */
+    FIB_MSG_TYPE_MAX /* Keep this as the last entry */
 } t_fib_msg_type;
 
 typedef struct  {
@@ -353,6 +401,18 @@ typedef struct {
     uint32_t         nh_weight;
 } t_fib_nh_info;
 
+/* Result of the route msg validation, the validation is done before the msg
+ * is queued so that the interface lookups are done off the nas_l3_lock */
+typedef enum {
+    FIB_RT_VALIDATION_NONE = 0, /* Not validated yet, validated at the msg processing */
+    FIB_RT_VALIDATION_OK,       /* Valid route msg */
+    FIB_RT_VALIDATION_SKIP,     /* Route msg to be skipped */
+} t_fib_rt_validation;
+
+/* Side effects of the route msgs coalesced into a route msg at the queue,
+ * applied at its processing along with its own */
+#define FIB_RT_COALESCE_NEIGH_FLUSH     0x1 /* Flush the neighbors on the prefix */
+
 typedef struct  {
     t_fib_rt_msg_type msg_type;
     unsigned short  distance;
@@ -367,6 +427,9 @@ typedef struct  {
     uint8_t         nh_vrf_name[NAS_VRF_NAME_SZ + 1];
     hal_ip_addr_t         nh_addr;
     size_t hop_count;
+    t_fib_rt_validation validation;
+    bool            is_mgmt_intf; /* NH on the mgmt intf, set by the validation */
+    uint8_t         coalesce_flags; /* FIB_RT_COALESCE_XXX */
 
     /* variable size buffer to hold nh_list based on
      * the hop_count in received route event.
@@ -406,15 +469,58 @@ typedef struct {
 
 typedef struct {
     t_fib_msg_type type;
+    uint64_t       enq_time; /* Enqueue time in nsecs, for the msg latency stats */
     union {
         t_fib_route_entry route;
         t_fib_neighbour_entry nbr;
         t_fib_intf_entry intf;
         t_fib_intf_ip_unreach_config     ip_unreach_cfg;
         t_fib_intf_ip_redirects_config   ip_redirects_cfg;
+        void                            *p_barrier;
     };
 } t_fib_msg;
 
+typedef enum {
+    FIB_WALKER_DR = 0,
+    FIB_WALKER_NH,
+    FIB_WALKER_MAX,
+} t_fib_walker_type;
+
+/* Throughput stats of a DR/NH walker */
+typedef struct {
+    uint64_t num_batches;      /* No. of VRF lock holds with nodes processed */
+    uint64_t num_full_batches; /* No. of batches that used up the batch size */
+    uint64_t num_nodes;        /* No. of nodes processed */
+    uint64_t busy_nsecs;       /* Time spent processing the nodes */
+    uint32_t node_cost_nsecs;  /* Moving avg. of the time per node */
+    uint32_t batch_size;       /* Last batch size */
+    uint64_t num_propagated;   /* No. of dependent nodes resolved in the walker bursts */
+    uint64_t num_deferred;     /* No. of nodes marked again in a burst, left to the walkers */
+    uint64_t num_parallel;     /* No. of DRs with the FH set computed by the resolution workers */
+} t_fib_walker_stats;
+
+/* Route convergence delay, from the route change applied to the FIB to the
+ * route programmed by the DR walker, in micro secs */
+typedef struct {
+    uint64_t count;            /* No. of route changes programmed */
+    uint64_t delay_p50;
+    uint64_t delay_p99;
+    uint64_t delay_max;
+    uint64_t num_time_wakeups;   /* Walker wakeups on the coalesce time expiry */
+    uint64_t num_change_wakeups; /* Walker wakeups on the coalesce changes count */
+} t_fib_convergence_stats;
+
+/* Latency stats of a msg type, in micro secs */
+typedef struct {
+    uint64_t count; /* No. of msgs processed */
+    uint64_t queue_wait_p50;
+    uint64_t queue_wait_p99;
+    uint64_t queue_wait_max;
+    uint64_t process_time_p50;
+    uint64_t process_time_p99;
+    uint64_t process_time_max;
+} t_fib_msg_latency_stats;
+
 
 typedef enum {
     FIB_OFFLOAD_MSG_TYPE_NEIGH_FLUSH = 1, /* Neighbor flush to kernel */
@@ -438,16 +544,56 @@ typedef struct {
 } t_fib_offload_msg;
 
 t_fib_msg * hal_rt_alloc_mem_msg();
+t_fib_msg *hal_rt_alloc_mem_msg_by_type(t_fib_msg_type type);
 t_fib_msg *hal_rt_alloc_route_mem_msg(uint32_t buf_size);
+void hal_rt_free_mem_msg(t_fib_msg *p_msg);
+size_t hal_rt_msg_buf_size(const t_fib_msg *p_msg);
+/* No. of NHs the route msg buffer can hold */
+size_t hal_rt_route_msg_nh_max(const t_fib_msg *p_msg);
+/* Max. no. of NHs of the route msgs allocated from the msg pool,
+ * the route msgs with more NHs are allocated from the heap */
+#define HAL_RT_MSG_POOL_ROUTE_MAX_NH   64
 void hal_rt_cps_obj_to_neigh(cps_api_object_t obj, t_fib_neighbour_entry *n);
 bool hal_rt_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret);
 bool hal_rt_ip_addr_cps_obj_to_route (cps_api_object_t obj, t_fib_msg **p_msg_ret);
 bool hal_rt_cps_obj_to_intf(cps_api_object_t obj, t_fib_intf_entry *p_intf);
 
 t_fib_offload_msg *hal_rt_alloc_offload_msg();
+void hal_rt_free_offload_msg(t_fib_offload_msg *p_offload_msg);
+void hal_rt_msg_pool_dump(void);
 
 #define FIB_RDX_MAX_NAME_LEN           64
 #define FIB_DEFAULT_ECMP_HASH          0
+#define FIB_DEFAULT_MSG_BATCH_SIZE     256
+#define FIB_MAX_MSG_BATCH_SIZE         4096
+#define FIB_DEFAULT_MSG_BATCH_TIME_BUDGET   5000 /* micro secs */
+#define FIB_DEFAULT_WALKER_TIME_BUDGET      2000 /* micro secs */
+#define FIB_DEFAULT_WALKER_COALESCE_TIME    1000 /* micro secs */
+#define FIB_DEFAULT_WALKER_COALESCE_CHANGES 1024
+#define FIB_DEFAULT_MSG_QUEUE_MAX_LEN  (1 << 16)
+#define FIB_MAX_MSG_QUEUE_LEN          (1 << 17)
+#define FIB_DEFAULT_MSG_QUEUE_MAX_BYTES    (64 * 1024 * 1024)
+#define FIB_DEFAULT_MSG_WORKERS        1
+#define FIB_MAX_MSG_WORKERS            16
+/* Environment variable to run more than one msg worker */
+#define FIB_MSG_WORKERS_ENV            "NAS_RT_MSG_WORKERS"
+/* The resolution workers default to one less than the no. of CPUs, as the
+ * walker runs the job items too, up to FIB_DEFAULT_MAX_RSLV_WORKERS */
+#define FIB_DEFAULT_MAX_RSLV_WORKERS   4
+#define FIB_MAX_RSLV_WORKERS           32
+/* Environment variable to set the no. of resolution workers, 0 to disable */
+#define FIB_RSLV_WORKERS_ENV           "NAS_RT_RSLV_WORKERS"
+/* Environment variables to tune the msg processing and the walkers at init,
+ * the defaults above are retained for the values not set or not valid. The
+ * FIB config CPS object sets them at runtime */
+#define FIB_MSG_BATCH_SIZE_ENV         "NAS_RT_MSG_BATCH_SIZE"
+#define FIB_MSG_BATCH_TIME_BUDGET_ENV  "NAS_RT_MSG_BATCH_TIME_BUDGET"
+#define FIB_MSG_QUEUE_MAX_LEN_ENV      "NAS_RT_MSG_QUEUE_MAX_LEN"
+#define FIB_MSG_QUEUE_MAX_BYTES_ENV    "NAS_RT_MSG_QUEUE_MAX_BYTES"
+#define FIB_MSG_QUEUE_OVERFLOW_ENV     "NAS_RT_MSG_QUEUE_OVERFLOW_POLICY" /* t_fib_msg_queue_overflow_policy */
+#define FIB_WALKER_TIME_BUDGET_ENV     "NAS_RT_WALKER_TIME_BUDGET"
+#define FIB_WALKER_COALESCE_TIME_ENV   "NAS_RT_WALKER_COALESCE_TIME"
+#define FIB_WALKER_COALESCE_CHANGES_ENV "NAS_RT_WALKER_COALESCE_CHANGES"
 #define RT_PER_TLV_MAX_LEN             (2 * (sizeof(unsigned long)))
 #define FIB_RDX_INTF_KEY_LEN           (8 * (sizeof (t_fib_intf_key)))
 #define FIB_RDX_NHT_KEY_LEN           (8 * (sizeof (t_fib_nht_key)))
@@ -744,6 +890,12 @@ int hal_rt_task_init (void);
 void hal_rt_task_exit (void);
 
 const t_fib_config * hal_rt_access_fib_config(void);
+t_std_error hal_rt_fib_config_set_msg_batch_size (uint32_t batch_size);
+t_std_error hal_rt_fib_config_set_msg_batch_time_budget (uint32_t time_budget);
+t_std_error hal_rt_fib_config_set_walker_time_budget (uint32_t time_budget);
+t_std_error hal_rt_fib_config_set_walker_coalesce (uint32_t coalesce_time, uint32_t coalesce_changes);
+t_std_error hal_rt_fib_config_set_msg_queue_bounds (uint32_t max_len, uint64_t max_bytes,
+                                                    t_fib_msg_queue_overflow_policy policy);
 t_fib_gbl_info * hal_rt_access_fib_gbl_info(void);
 
 t_fib_vrf * hal_rt_access_fib_vrf(uint32_t vrf_id);
@@ -761,10 +913,36 @@ std_rt_table * hal_rt_access_intf_tree(void);
 std_rt_table * hal_rt_access_fib_vrf_nht_tree(uint32_t vrf_id, uint8_t af_index);
 
 
-void nas_l3_lock();
+/* The lock functions take the function name of the caller for the lock
+ * wait/hold time profiling (see hal_rt_lockstat.h), use the macros below */
+void nas_l3_lock_at(const char *site);
+#define nas_l3_lock() nas_l3_lock_at(__func__)
 
 void nas_l3_unlock();
 
+/* Shared mode of the nas_l3_lock for the read-only paths of all the VRFs,
+ * no VRF is updated while it is held */
+void nas_l3_lock_shared_at(const char *site);
+#define nas_l3_lock_shared() nas_l3_lock_shared_at(__func__)
+
+void nas_l3_unlock_shared();
+
+/* Lock a VRF for update, the other VRFs can be updated concurrently */
+t_fib_vrf_lock_mode nas_l3_vrf_lock_at(hal_vrf_id_t vrf_id, const char *site);
+#define nas_l3_vrf_lock(vrf_id) nas_l3_vrf_lock_at((vrf_id), __func__)
+
+void nas_l3_vrf_unlock(hal_vrf_id_t vrf_id, t_fib_vrf_lock_mode mode);
+
+/* Lock a VRF for read */
+void nas_l3_vrf_lock_shared_at(hal_vrf_id_t vrf_id, const char *site);
+#define nas_l3_vrf_lock_shared(vrf_id) nas_l3_vrf_lock_shared_at((vrf_id), __func__)
+
+void nas_l3_vrf_unlock_shared(hal_vrf_id_t vrf_id);
+
+/* Update the leak refs of the VRFs for a DR-NH link across them,
+ * called with the nas_l3_lock held exclusive */
+void hal_rt_vrf_leak_ref_update(hal_vrf_id_t dr_vrf_id, hal_vrf_id_t nh_vrf_id, bool is_add);
+
 t_std_error hal_rt_process_peer_routing_config (uint32_t vrf_id, nas_rt_peer_mac_config_t*p_status, bool status);
 t_std_error hal_rt_process_virtual_routing_ip_config (nas_rt_virtual_routing_ip_config_t *p_cfg, bool status);
 int fib_create_nht_tree (t_fib_vrf_info *p_vrf_info);
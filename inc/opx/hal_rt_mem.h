@@ -29,13 +29,18 @@
 
 #define FIB_MALLOC(_size_)             malloc(_size_)
 #define FIB_FREE(_p_)                  free ((void *)(_p_))
+#define FIB_REALLOC(_p_, _size_)       realloc ((void *)(_p_), _size_)
 
 #define FIB_VRF_MEM_MALLOC()           (t_fib_vrf *)FIB_MALLOC(sizeof (t_fib_vrf))
 #define FIB_VRF_MEM_FREE(_p_)          FIB_FREE(_p_)
 
-#define FIB_DR_MEM_MALLOC()            (t_fib_dr *)FIB_MALLOC(sizeof (t_fib_dr))
+/* sizeof is a multiple of the alignment as aligned_alloc () needs it */
+#define FIB_DR_MEM_MALLOC()            (t_fib_dr *)aligned_alloc(HAL_RT_CACHE_LINE_SIZE, sizeof (t_fib_dr))
 #define FIB_DR_MEM_FREE(_p_)           FIB_FREE(_p_)
 
+#define FIB_DR_COLD_MEM_MALLOC()       (t_fib_dr_cold *)FIB_MALLOC(sizeof (t_fib_dr_cold))
+#define FIB_DR_COLD_MEM_FREE(_p_)      FIB_FREE(_p_)
+
 #define FIB_NH_MEM_MALLOC()            (t_fib_nh *)FIB_MALLOC(sizeof (t_fib_nh))
 #define FIB_NH_MEM_FREE(_p_)           FIB_FREE(_p_)
 
@@ -48,8 +53,13 @@
 #define FIB_DR_FH_MEM_MALLOC()         (t_fib_dr_fh *)FIB_MALLOC(sizeof (t_fib_dr_fh))
 #define FIB_DR_FH_MEM_FREE(_p_)        FIB_FREE(_p_)
 
-#define FIB_NH_DEP_DR_MEM_MALLOC()     (t_fib_nh_dep_dr *)FIB_MALLOC(sizeof (t_fib_nh_dep_dr))
-#define FIB_NH_DEP_DR_MEM_FREE(_p_)    FIB_FREE(_p_)
+#define FIB_NH_DEP_DR_CHUNK_MEM_SIZE(_max_dr_)                                \
+        (sizeof (t_fib_nh_dep_dr_chunk) + ((_max_dr_) * sizeof (t_fib_nh_dep_dr)))
+#define FIB_NH_DEP_DR_CHUNK_MEM_MALLOC(_max_dr_)                              \
+        (t_fib_nh_dep_dr_chunk *)FIB_MALLOC(FIB_NH_DEP_DR_CHUNK_MEM_SIZE(_max_dr_))
+#define FIB_NH_DEP_DR_CHUNK_MEM_REALLOC(_p_, _max_dr_)                        \
+        (t_fib_nh_dep_dr_chunk *)FIB_REALLOC(_p_, FIB_NH_DEP_DR_CHUNK_MEM_SIZE(_max_dr_))
+#define FIB_NH_DEP_DR_CHUNK_MEM_FREE(_p_) FIB_FREE(_p_)
 
 #define FIB_ARP_INFO_MEM_MALLOC()      (t_fib_arp_info *)FIB_MALLOC(sizeof (t_fib_arp_info))
 #define FIB_ARP_INFO_MEM_FREE(_p_)     FIB_FREE(_p_)
@@ -96,5 +106,22 @@ t_fib_nht *fib_alloc_nht_node (void);
 
 void fib_free_nht_node (t_fib_nht *p_nht);
 
+/* Epoch read section, the DR/NH nodes freed while a reader is in the read
+ * section stay allocated till it exits. Returns false if the thread could
+ * not get a reader slot, the caller should keep the nas_l3_lock held then. */
+bool hal_rt_epoch_enter (void);
+
+void hal_rt_epoch_exit (void);
+
+void hal_rt_epoch_retire (void *p_node, void (*free_fn) (void *p_node));
+
+/* Flushes the nodes retired by the thread to the reclaim list, called by the
+ * writers at the end of the lock hold */
+void hal_rt_epoch_retire_flush (void);
+
+void hal_rt_epoch_reclaim (void);
+
+void hal_rt_epoch_stats_get (uint64_t *p_retired, uint64_t *p_reclaimed, uint64_t *p_pending);
+
 
 #endif /* __HAL_RT_MEM_H__ */
@@ -74,17 +74,6 @@ typedef struct _t_fib_mp_obj {
     uint32_t            ref_count;
 } t_fib_mp_obj;
 
-typedef struct _t_fib_hal_dr_info {
-    /*
-     * Need to have 'a_obj_status' per unit, because, the route could change
-     * from ECMP to non_ECMP (and vice-versa). The egress/multipath objects
-     * have to be cleaned up and this happens per unit. We cannot rely
-     * on 'status' of t_fib_hal_dr_info, since it is not per unit.
-     */
-    t_fib_ecmp_status  a_obj_status [HAL_RT_MAX_INSTANCE];
-    t_fib_mp_obj       *ap_mp_obj [HAL_RT_MAX_INSTANCE];
-} t_fib_hal_dr_info;
-
 typedef struct _t_fib_hal_nh_info {
     t_fib_nh_obj *ap_nh_obj [HAL_RT_MAX_INSTANCE];
     t_fib_mp_obj  *ap_mp_obj [HAL_RT_MAX_INSTANCE];
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_msg_pool.h
+ * \brief  Size-class pool for the HAL-RT and offload message buffers.
+ */
+
+#ifndef __HAL_RT_MSG_POOL_H__
+#define __HAL_RT_MSG_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_main.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "hal_rt_msg_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/* Size classes of the message pool, route messages are bucketed
+ * by the number of nexthops the buffer can hold. */
+typedef enum {
+    HAL_RT_MSG_POOL_INTF = 0,     /* Interface and interface config msgs */
+    HAL_RT_MSG_POOL_NBR,          /* Neighbor msgs */
+    HAL_RT_MSG_POOL_MSG,          /* Untyped t_fib_msg */
+    HAL_RT_MSG_POOL_ROUTE_NH1,    /* Route msgs with 1 NH */
+    HAL_RT_MSG_POOL_ROUTE_NH4,    /* Route msgs with 2 - 4 NHs */
+    HAL_RT_MSG_POOL_ROUTE_NH16,   /* Route msgs with 5 - 16 NHs */
+    HAL_RT_MSG_POOL_ROUTE_NH64,   /* Route msgs with 17 - 64 NHs */
+    HAL_RT_MSG_POOL_OFFLOAD,      /* Offload msgs */
+    HAL_RT_MSG_POOL_MAX,
+    HAL_RT_MSG_POOL_HEAP = HAL_RT_MSG_POOL_MAX /* Not pooled, freed to the heap */
+} hal_rt_msg_pool_class_t;
+
+/* Max. number of buffers kept per class, a class grows on demand
+ * up to this limit, the allocations beyond it go to the heap. */
+#define HAL_RT_MSG_POOL_INTF_MAX          (1 << 12)
+#define HAL_RT_MSG_POOL_NBR_MAX           (1 << 14)
+#define HAL_RT_MSG_POOL_MSG_MAX           (1 << 12)
+#define HAL_RT_MSG_POOL_ROUTE_NH1_MAX     (1 << 16)
+#define HAL_RT_MSG_POOL_ROUTE_NH4_MAX     (1 << 14)
+#define HAL_RT_MSG_POOL_ROUTE_NH16_MAX    (1 << 12)
+#define HAL_RT_MSG_POOL_ROUTE_NH64_MAX    (1 << 10)
+#define HAL_RT_MSG_POOL_OFFLOAD_MAX       (1 << 10)
+/* Number of buffers carved out of one slab when a class grows */
+#define HAL_RT_MSG_POOL_SLAB_BUFS         64
+/* Max. attempts to pop a free buffer that is being returned concurrently */
+#define HAL_RT_MSG_POOL_POP_RETRY         4
+#define HAL_RT_MSG_POOL_HDR_MAGIC         0x52544d50 /* "RTMP" */
+
+/* Header in front of every buffer handed out by the pool */
+typedef struct alignas(16) {
+    uint32_t class_id;
+    uint32_t magic;
+    uint32_t buf_size; /* Usable size of the buffer */
+} hal_rt_msg_pool_hdr_t;
+
+/*
+ * Thread-safe pool of message buffers.
+ *
+ * Each size class keeps its free buffers in a lock-free ring that can hold
+ * all the buffers of the class, so a free never fails. Buffers are carved out
+ * of slabs that are allocated when the free ring runs dry and are never
+ * returned to the heap, the pool size is bounded by the per class limits.
+ */
+class hal_rt_msg_pool_t {
+    public:
+        hal_rt_msg_pool_t ();
+        hal_rt_msg_pool_t (const hal_rt_msg_pool_t&) = delete;
+        hal_rt_msg_pool_t& operator= (const hal_rt_msg_pool_t&) = delete;
+
+        /* Buffer of the given class, contents are not initialized */
+        void *alloc (hal_rt_msg_pool_class_t class_id);
+        /* Buffer of at least buf_size bytes from the route classes */
+        void *alloc_route (size_t buf_size);
+        void release (void *p_buf);
+        /* Usable size of the buffer handed out by the pool */
+        static size_t buf_size (const void *p_buf);
+
+        std::string stats () const;
+        void dump () const;
+
+    private:
+        typedef struct {
+            size_t                           buf_size;
+            size_t                           max_bufs;
+            std::unique_ptr<hal_rt_ring_t<char>> free_ring;
+            std::atomic<size_t>              num_bufs;
+            std::atomic<size_t>              in_use;
+            std::atomic<size_t>              peak;
+            std::atomic<uint64_t>            hits;
+            std::atomic<uint64_t>            misses;
+        } pool_class_t;
+
+        void init_class (hal_rt_msg_pool_class_t class_id, size_t buf_size, size_t max_bufs);
+        char *grow (pool_class_t &pool_class);
+        void free_ring_push (pool_class_t &pool_class, char *p_hdr);
+        char *free_ring_pop (pool_class_t &pool_class);
+        void *hdr_to_buf (char *p_hdr, uint32_t class_id, size_t buf_size);
+
+        pool_class_t           m_class[HAL_RT_MSG_POOL_MAX];
+        std::atomic<size_t>    m_heap_in_use;
+        std::atomic<uint64_t>  m_heap_allocs;
+};
+
+#endif /* __HAL_RT_MSG_POOL_H__ */
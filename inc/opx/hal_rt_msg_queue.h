@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_msg_queue.h
+ * \brief  HAL-RT message queue between the CPS event producers and
+ *         the hal-rt-msg consumer thread.
+ */
+
+#ifndef __HAL_RT_MSG_QUEUE_H__
+#define __HAL_RT_MSG_QUEUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_main.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+/* Number of message slots in the HAL-RT message ring, must be power of 2.
+ * Producers back off when the ring is full, consumer drains it. */
+#define HAL_RT_MSGQ_DEPTH                (1 << 17)
+/* Max. number of messages moved from the ring to the consumer side staging
+ * area, route messages are coalesced within the staging area. */
+#define HAL_RT_MSGQ_STAGE_MAX            (1 << 16)
+/* Producer wait time when the message ring is full or the queue is at its bounds */
+#define HAL_RT_MSGQ_FULL_WAIT_USEC       100
+
+/*
+ * Bounded lock-free ring of pointers.
+ *
+ * Each cell carries a sequence number which tells whether the cell is free
+ * for the producer at position 'pos' (seq == pos) or holds data for the
+ * consumer at position 'pos' (seq == pos + 1). Any number of threads can push,
+ * pop is safe for any number of threads too, though the HAL-RT message queue
+ * uses it with a single consumer.
+ */
+template <typename T>
+class hal_rt_ring_t {
+    public:
+        explicit hal_rt_ring_t (size_t depth) {
+            size_t size = 1;
+            while (size < depth) size <<= 1;
+            m_mask = size - 1;
+            m_cells.reset (new cell_t[size]);
+            for (size_t i = 0; i < size; i++) {
+                m_cells[i].seq.store (i, std::memory_order_relaxed);
+                m_cells[i].data = nullptr;
+            }
+            m_head.store (0, std::memory_order_relaxed);
+            m_tail.store (0, std::memory_order_relaxed);
+        }
+
+        hal_rt_ring_t (const hal_rt_ring_t&) = delete;
+        hal_rt_ring_t& operator= (const hal_rt_ring_t&) = delete;
+
+        /* Returns false if the ring is full */
+        bool push (T *data) {
+            cell_t *cell;
+            size_t pos = m_head.load (std::memory_order_relaxed);
+            for (;;) {
+                cell = &m_cells[pos & m_mask];
+                size_t seq = cell->seq.load (std::memory_order_acquire);
+                intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak (pos, pos + 1,
+                                                      std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_head.load (std::memory_order_relaxed);
+                }
+            }
+            cell->data = data;
+            cell->seq.store (pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /* Returns nullptr if the ring is empty */
+        T *pop () {
+            cell_t *cell;
+            size_t pos = m_tail.load (std::memory_order_relaxed);
+            for (;;) {
+                cell = &m_cells[pos & m_mask];
+                size_t seq = cell->seq.load (std::memory_order_acquire);
+                intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak (pos, pos + 1,
+                                                      std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return nullptr;
+                } else {
+                    pos = m_tail.load (std::memory_order_relaxed);
+                }
+            }
+            T *data = cell->data;
+            cell->seq.store (pos + m_mask + 1, std::memory_order_release);
+            return data;
+        }
+
+        /* Approximate number of entries, exact when producers and consumer are idle */
+        size_t size () const {
+            size_t head = m_head.load (std::memory_order_relaxed);
+            size_t tail = m_tail.load (std::memory_order_relaxed);
+            return (head > tail) ? (head - tail) : 0;
+        }
+
+        size_t capacity () const { return (m_mask + 1); }
+
+    private:
+        struct cell_t {
+            std::atomic<size_t> seq;
+            T                  *data;
+        };
+        std::unique_ptr<cell_t[]> m_cells;
+        size_t                    m_mask;
+        /* Keep the producer and consumer positions on separate cache lines */
+        char                      m_pad0[HAL_RT_CACHE_LINE_SIZE];
+        std::atomic<size_t>       m_head;
+        char                      m_pad1[HAL_RT_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t>       m_tail;
+        char                      m_pad2[HAL_RT_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+/* Messages are allocated from the HAL-RT message pool */
+struct fib_msg_deleter_t {
+    void operator() (t_fib_msg *p_msg) const { hal_rt_free_mem_msg (p_msg); }
+};
+using fib_msg_uptr_t = std::unique_ptr<t_fib_msg, fib_msg_deleter_t>;
+
+/* Latency histogram buckets, each power of 2 range of nsecs is split into
+ * 8 linear sub buckets (12.5% resolution), up to 2^40 nsecs (~18 mins), the
+ * last bucket counts all the larger samples */
+#define HAL_RT_LATENCY_HIST_SUB_BITS     3
+#define HAL_RT_LATENCY_HIST_MAX_EXP      40
+#define HAL_RT_LATENCY_HIST_BUCKETS      \
+    ((HAL_RT_LATENCY_HIST_MAX_EXP - HAL_RT_LATENCY_HIST_SUB_BITS + 1) << HAL_RT_LATENCY_HIST_SUB_BITS)
+
+/*
+ * Lock-free log-linear latency histogram, the samples are recorded by the
+ * msg workers and read by the stats readers without any lock.
+ */
+class hal_rt_latency_hist_t {
+    public:
+        hal_rt_latency_hist_t () { clear (); }
+        hal_rt_latency_hist_t (const hal_rt_latency_hist_t&) = delete;
+        hal_rt_latency_hist_t& operator= (const hal_rt_latency_hist_t&) = delete;
+
+        void record (uint64_t nsecs);
+        void clear ();
+        uint64_t count () const { return m_count.load (std::memory_order_relaxed); }
+        uint64_t max () const { return m_max.load (std::memory_order_relaxed); }
+        /* Upper bound in nsecs of the bucket of the given percentile */
+        uint64_t percentile (uint32_t pct) const;
+
+    private:
+        static uint32_t bucket_get (uint64_t nsecs);
+        static uint64_t bucket_upper (uint32_t bucket);
+
+        std::atomic<uint64_t> m_buckets[HAL_RT_LATENCY_HIST_BUCKETS];
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_max;
+};
+
+/* Key of the route coalescing index */
+typedef struct {
+    uint32_t vrf_id;
+    uint32_t af;
+    uint32_t prefix_len;
+    uint8_t  addr[HAL_INET6_LEN];
+} hal_rt_route_key_t;
+
+struct hal_rt_route_key_hash_t {
+    size_t operator() (const hal_rt_route_key_t &key) const;
+};
+
+struct hal_rt_route_key_equal_t {
+    bool operator() (const hal_rt_route_key_t &key1, const hal_rt_route_key_t &key2) const;
+};
+
+/* Priority lanes of the HAL-RT message queue, in the order of priority */
+typedef enum {
+    HAL_RT_MSG_LANE_INTF = 0, /* Interface state and interface configs */
+    HAL_RT_MSG_LANE_NBR,      /* Neighbor updates */
+    HAL_RT_MSG_LANE_ROUTE,    /* Route updates */
+    HAL_RT_MSG_LANE_MAX
+} hal_rt_msg_lane_t;
+
+/* No. of msgs a lane gets per scheduling round when all lanes have msgs */
+#define HAL_RT_MSG_LANE_INTF_WEIGHT      8
+#define HAL_RT_MSG_LANE_NBR_WEIGHT       4
+#define HAL_RT_MSG_LANE_ROUTE_WEIGHT     1
+
+/*
+ * Multi-producer/single-consumer message queue.
+ *
+ * Producers never take a lock, the consumer is woken up through an eventfd
+ * only when it has announced that it is going to sleep on an empty ring.
+ *
+ * The consumer moves the messages from the ring into a private staging area
+ * with one FIFO lane per message class, the lanes are drained by a weighted
+ * scheduler in the lane priority order. A message can overtake the messages
+ * of the lower priority lanes only if they do not refer to any of its
+ * interfaces, the ordering per interface is kept by recording for each staged
+ * message the position in the other lanes it has to wait for.
+ *
+ * The pending route messages are indexed by (vrf, prefix, len), so that a route
+ * message superseded by a newer one for the same prefix is dropped before it
+ * reaches the FIB.
+ *
+ * A barrier message is not overtaken and does not overtake any message, it is
+ * used to order the messages across the queues of the HAL-RT msg workers.
+ *
+ * The queue is bounded by the number and the bytes of the pending messages.
+ * Producers block at the bounds, unless the resync policy is set, in which case
+ * the route add/update messages from the kernel are dropped and their VRF is
+ * marked for a resync from the kernel once the queue is drained.
+ */
+class hal_rt_msgq_t {
+    public:
+        explicit hal_rt_msgq_t (size_t depth);
+        ~hal_rt_msgq_t ();
+        hal_rt_msgq_t (const hal_rt_msgq_t&) = delete;
+        hal_rt_msgq_t& operator= (const hal_rt_msgq_t&) = delete;
+
+        bool enqueue (t_fib_msg *p_msg);
+        /* Consumer only - moves up to max_msgs pending messages to the batch in
+         * the processing order, blocks until at least one message is available */
+        size_t dequeue_batch (std::vector<fib_msg_uptr_t> &batch, size_t max_msgs);
+
+        void set_bounds (size_t max_len, uint64_t max_bytes,
+                         t_fib_msg_queue_overflow_policy policy);
+        /* Consumer only - returns false if no VRF is marked for resync */
+        bool resync_vrf_get (hal_vrf_id_t *p_vrf_id);
+
+        uint32_t msg_type_count (t_fib_msg_type msg_type) const;
+        size_t size () const {
+            return (m_ring.size() + m_staged_cnt.load (std::memory_order_relaxed));
+        }
+        uint64_t bytes () const { return m_bytes.load (std::memory_order_relaxed); }
+        std::string queue_stats () const;
+        std::string msg_type_stats () const;
+
+    private:
+        typedef struct {
+            fib_msg_uptr_t msg;
+            /* Lane positions (+1) that should be dequeued before this msg */
+            uint64_t       wait_pos[HAL_RT_MSG_LANE_MAX];
+        } staged_msg_t;
+
+        typedef struct {
+            std::deque<staged_msg_t> msgs;
+            uint64_t                 head_pos; /* Lane position of msgs.front() */
+            uint32_t                 credit;
+            uint32_t                 weight;
+            /* Last lane position (+1) of the staged msg per interface */
+            std::unordered_map<hal_ifindex_t, uint64_t> if_last_pos;
+            std::atomic<size_t>      cnt;
+            std::atomic<size_t>      peak;
+            std::atomic<uint64_t>    processed;
+        } lane_t;
+
+        bool is_full () const;
+        bool resync_on_full (t_fib_msg *p_msg);
+        void wakeup_consumer ();
+        void wait_for_producer ();
+        void msg_done (t_fib_msg *p_msg);
+        bool stage_msgs ();
+        void stage_msg (t_fib_msg *p_msg);
+        void stage_route_msg (uint64_t pos, t_fib_msg *p_msg);
+        void drop_staged_msg (uint64_t pos, t_fib_route_entry *p_rt);
+        bool move_staged_msg (uint64_t pos, uint64_t to_pos);
+        void unindex_route_msg (uint64_t pos, t_fib_msg *p_msg);
+        void lane_head_trim (lane_t &lane);
+        bool lane_head_ready (lane_t &lane);
+        int  pick_lane ();
+        fib_msg_uptr_t lane_pop (int lane_id);
+
+        hal_rt_ring_t<t_fib_msg> m_ring;
+        int                      m_evt_fd;
+        std::atomic<bool>        m_consumer_idle;
+        std::atomic<size_t>      m_peak;
+        std::atomic<uint64_t>    m_full_cnt;
+        std::atomic<uint64_t>    m_coalesced_cnt;
+        std::atomic<size_t>      m_staged_cnt;
+        std::atomic<uint64_t>    m_bytes;
+        std::atomic<uint64_t>    m_peak_bytes;
+        std::atomic<size_t>      m_max_len;
+        std::atomic<uint64_t>    m_max_bytes;
+        std::atomic<int>         m_overflow_policy;
+        std::atomic<uint64_t>    m_block_cnt;
+        std::atomic<uint64_t>    m_resync_drop_cnt;
+        std::atomic<uint64_t>    m_resync_cnt;
+        /* VRFs with the route msgs dropped at the queue bounds */
+        std::atomic<bool>        m_resync_vrf[FIB_MAX_VRF];
+        std::atomic<size_t>      m_resync_vrf_cnt;
+        /* stats counter for the queue on per msg type basis */
+        std::atomic<uint32_t>    m_type_cnt[FIB_MSG_TYPE_MAX];
+
+        /* Consumer private staging lanes */
+        lane_t                   m_lanes[HAL_RT_MSG_LANE_MAX];
+        /* Lane positions (+1) of the last barrier msg */
+        uint64_t                 m_fence_pos[HAL_RT_MSG_LANE_MAX];
+        std::vector<hal_ifindex_t> m_if_list;
+        /* Route lane positions of the pending route messages per route key */
+        std::unordered_map<hal_rt_route_key_t, std::vector<uint64_t>,
+                           hal_rt_route_key_hash_t, hal_rt_route_key_equal_t> m_route_idx;
+};
+
+#endif /* __HAL_RT_MSG_QUEUE_H__ */
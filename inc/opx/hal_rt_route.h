@@ -35,11 +35,26 @@
 
 #define FIB_RDX_DR_KEY_LEN             (8 * (sizeof (t_fib_dr_key)))
 #define FIB_RDX_NH_KEY_LEN             (8 * (sizeof (t_fib_nh_key)))
-#define FIB_RDX_NH_DEP_DR_KEY_LEN      (8 * (sizeof (t_fib_nh_dep_dr_key)))
 #define FIB_RDX_TNL_DEST_KEY_LEN       (8 * (sizeof (t_fib_tnl_key)))
 
-#define FIB_DR_WALKER_COUNT            100
-#define FIB_NH_WALKER_COUNT            100
+/* Min./max. no. of dependent DRs per chunk of the NH dep_dr_list */
+#define FIB_NH_DEP_DR_CHUNK_MIN        4
+#define FIB_NH_DEP_DR_CHUNK_MAX        64
+
+/* DR/NH walker batch sizes, the batch size is adapted to the walker time budget */
+#define FIB_WALKER_INIT_BATCH          100
+#define FIB_WALKER_MIN_BATCH           16
+#define FIB_WALKER_MAX_BATCH           8192
+/* Max. factor the batch is shrunk by for the route msgs backlog */
+#define FIB_WALKER_MAX_BACKLOG_SHRINK  8
+/* Max. lock holds of a VRF in a walker pass, for the VRFs with a larger backlog */
+#define FIB_WALKER_MAX_VRF_BATCHES     8
+/* No. of dependency ranks of the DR/NH resolution, the deeper nodes share the last rank */
+#define FIB_RSLV_MAX_RANK              16
+/* Min. no. of DRs of a rank for their FH sets to be computed by the resolution workers */
+#define FIB_RSLV_MIN_PARALLEL_DRS      64
+/* No. of FHs of a DR FH set held without an allocation */
+#define FIB_DR_FH_SET_INLINE_FHS       8
 #define FIB_DEFAULT_DR_OWNER_FIB       1
 #define FIB_DEFAULT_DR_OWNER_RTM       2
 
@@ -354,11 +369,6 @@
 #define FIB_GET_RDX_DR_KEY_LEN(_p_prefix, _prefix_len) \
         (((sizeof ((_p_prefix)->af_index)) * 8) + (_prefix_len))
 
-#define FIB_GET_RDX_NH_DEP_DR_KEY_LEN(_p_nh_dep_dr_key, _prefix_len)        \
-        (((sizeof ((_p_nh_dep_dr_key)->vrf_id)) * 8) +                      \
-         ((sizeof ((_p_nh_dep_dr_key)->dr_key.prefix.af_index)) * 8) +      \
-         (_prefix_len))
-
 #define FIB_IS_DR_DEFAULT(_p_)                                              \
         ((STD_IP_IS_ADDR_ZERO (&((_p_)->key.prefix))) && ((_p_)->prefix_len == 0))
 
@@ -483,6 +493,59 @@ typedef struct _t_fib_arp_info {
                                         the port thru which the MAC is learnt */
 } t_fib_arp_info;
 
+typedef enum {
+    FIB_RSLV_NODE_DR = 0,
+    FIB_RSLV_NODE_NH,
+} t_fib_rslv_node_type;
+
+#define FIB_RSLV_STATE_QUEUED          0x01 /* In a rank queue of the burst */
+#define FIB_RSLV_STATE_DONE            0x02 /* Resolved in the burst */
+#define FIB_RSLV_STATE_SEED            0x04 /* Queued from the walker changelist */
+#define FIB_RSLV_STATE_RESOLVED        0x08 /* Resolved by a burst after it was last
+                                               marked, skipped by its walker */
+#define FIB_RSLV_STATE_BATCHED         0x10 /* In the DR batch of the rank */
+
+/*
+ * Resolution state of a DR/NH. The rank is the depth of the node in the
+ * DR -> NH -> DR dependency chain: 0 for a FH, a recursive NH is ranked
+ * after its best fit DR and a DR after its NHs. The rank is learnt as the
+ * changes propagate, a node marked by a node of rank r is queued at r + 1
+ * at the least.
+ */
+typedef struct _t_fib_rslv_node {
+    std_dll            glue;
+    void              *p_owner;  /* t_fib_dr or t_fib_nh */
+    uint32_t           burst_id; /* Last burst the node was queued in */
+    uint32_t           batch_ix; /* Index of the FH set of a batched DR */
+    uint8_t            type;     /* t_fib_rslv_node_type */
+    uint8_t            rank;
+    uint8_t            state;
+} t_fib_rslv_node;
+
+/*
+ * Burst of the DR/NH changes of a VRF resolved in a walker lock hold. The
+ * changelist nodes of the walker are the seeds, the DRs/NHs they mark in
+ * the VRF are queued to the burst instead of the walker changelists and
+ * all the nodes are resolved in the order of their rank, each once.
+ */
+typedef struct _t_fib_rslv_burst {
+    uint32_t           burst_id;
+    int                cur_rank;       /* Rank being resolved, -1 while seeding */
+    bool               is_propagate;   /* false to leave the marks to the walkers */
+    uint32_t           num_nodes;      /* No. of nodes resolved */
+    uint32_t           num_seeds;
+    uint32_t           num_deferred;   /* Marked again after resolved in the burst */
+    uint32_t           num_parallel;   /* No. of DRs with the FH sets computed in parallel */
+    uint32_t           num_left;       /* Left to the walkers at the end of the time budget */
+    uint64_t           deadline_nsecs; /* End of the walker time budget, 0 if none */
+    bool               is_expired;
+    std_dll_head       rank_queue [FIB_RSLV_MAX_RANK];
+    /* DRs of the rank resolved after its NHs, their FH sets are computed
+     * by the resolution workers and committed in the order of the batch */
+    std_dll_head       dr_batch;
+    uint32_t           num_batch;
+} t_fib_rslv_burst;
+
 typedef struct _t_fib_dr_key {
     t_fib_ip_addr     prefix;
 } t_fib_dr_key;
@@ -510,13 +573,47 @@ typedef struct _t_fib_nht {
                                        to the App and FALSE otherwise */
 }t_fib_nht;
 
+typedef struct _t_fib_hal_dr_info {
+    /*
+     * Need to have 'a_obj_status' per unit, because, the route could change
+     * from ECMP to non_ECMP (and vice-versa). The egress/multipath objects
+     * have to be cleaned up and this happens per unit. We cannot rely
+     * on 'status' of t_fib_hal_dr_info, since it is not per unit.
+     */
+    t_fib_ecmp_status     a_obj_status [HAL_RT_MAX_INSTANCE];
+    struct _t_fib_mp_obj *ap_mp_obj [HAL_RT_MAX_INSTANCE];
+} t_fib_hal_dr_info;
+
+/*
+ * DR info used by the link local, degenerated and ECMP to non-ECMP
+ * routes only, allocated on its first update with fib_get_dr_cold () and
+ * freed with the DR. The fields read as 0 for a DR without it.
+ */
+typedef struct _t_fib_dr_cold {
+    t_fib_dr_fh        degen_dr_fh;
+    next_hop_id_t      old_nh_handle_nht;  /* old group_handle to be used by
+                                              NHT module for associated ACLs flush */
+    uint32_t           num_ipv6_link_local; /* No. of links on which link local addres
+                                               add received for same link local IPv6 addresses.
+                                               There could be interfaces that share same MAC address
+                                               due to which link local address will be same */
+    uint32_t           num_ipv6_rif_link_local; /* No. of RIF entries created
+                                               for this link local IPv6 addresses */
+} t_fib_dr_cold;
+
+#define FIB_DR_COLD_FIELD(_p_dr_, _field_) \
+    (((_p_dr_)->p_cold != NULL) ? (_p_dr_)->p_cold->_field_ : 0)
+
+/*
+ * The fields read by the lookups and the walkers come first, the ones
+ * updated with the route messages only after them and the rarely used
+ * ones are in the cold part. The node is cache line aligned.
+ */
 typedef struct _t_fib_dr {
     std_radical_head_t radical;
     t_fib_dr_key       key;
     uint8_t            prefix_len;
     hal_vrf_id_t       vrf_id;
-    rt_proto           proto;
-    uint32_t           default_dr_owner;
     uint32_t           status_flag;
     uint32_t           num_nh;
     uint32_t           num_fh;
@@ -524,34 +621,55 @@ typedef struct _t_fib_dr {
     std_dll_head       nh_list;
     std_dll_head       fh_list;
     std_dll_head       dep_nh_list;
-    t_fib_dr_fh        degen_dr_fh;
-    uint64_t           last_update_time;
-    uint8_t            a_is_written [HAL_RT_MAX_INSTANCE];
     next_hop_id_t      nh_handle;  /* nh_handle or ECMP group_handle */
     next_hop_id_t      onh_handle;  /* old nh_handle or ECMP group_handle */
-    next_hop_id_t      old_nh_handle_nht;  /* old group_handle to be used by
-                                              NHT module for associated ACLs flush */
-    bool               remove_old_handle;
-    bool               ecmp_handle_created; /* true if ecmp handle is present */
-    bool               is_nh_resolved; /* true if ARP is resolved for this route */
     uint32_t           ofh_cnt; /* Old fh list count to detect the Non-ECMP to ECMP route */
-    void              *p_hal_dr_handle; /* mp_obj details per SAI instance */
-    uint32_t           num_ipv6_link_local; /* No. of links on which link local addres
-                                               add received for same link local IPv6 addresses.
-                                               There could be interfaces that share same MAC address
-                                               due to which link local address will be same */
-    uint32_t           num_ipv6_rif_link_local; /* No. of RIF entries created
-                                               for this link local IPv6 addresses */
     t_rt_type          rt_type;     /* route with special nexthop types -
                                      * blackhole/unreachable/prohibit */
+    rt_proto           proto;
+    uint8_t            a_is_written [HAL_RT_MAX_INSTANCE];
+    bool               remove_old_handle;
+    bool               ecmp_handle_created; /* true if ecmp handle is present */
+    bool               is_nh_resolved; /* true if ARP is resolved for this route */
     bool               is_mgmt_route;
-} t_fib_dr;
+    t_fib_hal_dr_info  hal_dr_info; /* mp_obj details per SAI instance */
+    t_fib_rslv_node    rslv;
+
+    uint32_t           default_dr_owner;
+    uint64_t           last_update_time;
+    uint64_t           change_nsecs; /* Time of the first route change pending for the
+                                        walker, for the convergence delay stats */
+    t_fib_dr_cold     *p_cold;
+} __attribute__ ((aligned (HAL_RT_CACHE_LINE_SIZE))) t_fib_dr;
 
 typedef struct _t_fib_nh_key {
     t_fib_ip_addr      ip_addr;
     hal_ifindex_t      if_index;
 } t_fib_nh_key;
 
+typedef struct _t_fib_nh_dep_dr {
+    t_fib_dr          *p_dr;
+} t_fib_nh_dep_dr;
+
+typedef struct _t_fib_nh_dep_dr_chunk {
+    uint16_t           num_dr;
+    uint16_t           max_dr;
+    t_fib_nh_dep_dr    dep_dr [0];
+} t_fib_nh_dep_dr_chunk;
+
+/*
+ * Dependent DRs of a NH, in the order of the DR keys (vrf_id, prefix,
+ * prefix_len) in chunks of up to FIB_NH_DEP_DR_CHUNK_MAX DRs. An entry is
+ * valid till the next add or delete of a dependent DR of the NH, a walk
+ * gets the next entry from the key of the DR of the current entry.
+ */
+typedef struct _t_fib_nh_dep_dr_list {
+    t_fib_nh_dep_dr_chunk **p_chunks;
+    uint32_t                num_chunks;
+    uint32_t                max_chunks;
+    uint32_t                num_dr;
+} t_fib_nh_dep_dr_list;
+
 /*
  * t_fib_nh will either be a First Hop node or a Next Hope node. If 'key.if_index'
  * is non NULL, then it is a First hop node, else it is a next hop node.
@@ -579,7 +697,7 @@ typedef struct _t_fib_nh {
     uint32_t           dr_ref_count;
     /* Incremented when a NH is added to the FH list of a NH */
     uint32_t           nh_ref_count;
-    std_rt_table      *dep_dr_tree;
+    t_fib_nh_dep_dr_list dep_dr_list;
     uint64_t           arp_last_update_time;
     uint8_t            is_cam_host_count_incremented;
     uint8_t            is_audit_egr_info_matched;
@@ -592,8 +710,20 @@ typedef struct _t_fib_nh {
     bool               is_nht_active; /* true - if this NH is being tracked
                                         for PBR and ER-SPAN, false otherwise */
     bool               is_mgmt_nh;
+    t_fib_rslv_node    rslv;
 } t_fib_nh;
 
+/*
+ * FH set of a DR, computed from the DR NHs without updating the DR, so the
+ * FH sets of the DRs of a VRF are computed in parallel with the VRF locked.
+ */
+typedef struct _t_fib_dr_fh_set {
+    uint32_t           num_fh;
+    uint32_t           max_fh;
+    t_fib_nh         **p_fh;  /* a_fh or an allocated array */
+    t_fib_nh          *a_fh [FIB_DR_FH_SET_INLINE_FHS];
+} t_fib_dr_fh_set;
+
 /*
  * t_fib_nh_holder is a nh_holder structure used in the following macros:
  *    FIB_GET_FIRST_NH_FROM_DR
@@ -628,18 +758,6 @@ typedef struct _t_fib_tunnel_dr_fh {
     uint8_t          status;
 } t_fib_tunnel_dr_fh;
 
-typedef struct _t_fib_nh_dep_dr_key {
-    hal_vrf_id_t     vrf_id;
-    t_fib_dr_key     dr_key;
-} t_fib_nh_dep_dr_key;
-
-typedef struct _t_fib_nh_dep_dr {
-    std_rt_head         rt_head;
-    t_fib_nh_dep_dr_key key;
-    uint8_t             prefix_len;
-    t_fib_dr           *p_dr;
-} t_fib_nh_dep_dr;
-
 typedef struct _nas_rif_info_t {
     ndi_rif_id_t rif_id;
     uint32_t     ref_count;
@@ -654,6 +772,8 @@ typedef struct _t_fib_intf_key {
 typedef struct _t_fib_intf {
     std_rt_head    rt_head;
     t_fib_intf_key key;
+    /* Next intf of the same if_index in the direct intf index */
+    struct _t_fib_intf *p_next_if_index;
     /*
      * Each node in the list is of type 't_fib_link_node'.
      * The 'self' field of 't_fib_link_node' points to t_fib_nh node.
@@ -698,7 +818,11 @@ int fib_create_dr_tree (t_fib_vrf_info *p_vrf_info);
 
 int fib_destroy_dr_tree (t_fib_vrf_info *p_vrf_info);
 
-int fib_proc_dr_download (t_fib_route_entry *p_route_msg, uint32_t nas_num_route_msgs_in_queue);
+int fib_proc_dr_download (t_fib_route_entry *p_route_msg);
+
+int fib_proc_dr_resync (t_fib_route_entry *p_route_msg);
+
+t_fib_rt_validation fib_proc_dr_validate (t_fib_route_entry *p_rt_entry);
 
 int fib_proc_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_bytes);
 
@@ -767,14 +891,25 @@ int fib_del_dr_degen_fh (t_fib_dr *p_dr);
 
 t_fib_dr *fib_get_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr);
 
-t_fib_dr *fib_get_next_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr);
+t_fib_dr *fib_get_next_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr,
+                                    uint8_t prefix_len);
 
 t_fib_cmp_result fib_dr_nh_cmp (t_fib_dr *p_dr, void *p_rtm_fib_cmd, int *p_nhInfo_size);
 
 int fib_dr_walker_call_back (std_radical_head_t *p_rt_head, va_list ap);
 
+int fib_dr_rslv_process (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set);
+
+void fib_dr_fh_set_init (t_fib_dr_fh_set *p_fh_set);
+
+void fib_dr_fh_set_free (t_fib_dr_fh_set *p_fh_set);
+
+void fib_dr_fh_set_compute (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set);
+
 int fib_resolve_dr (t_fib_dr *p_dr);
 
+int fib_resolve_dr_fh_set (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set);
+
 int fib_updt_best_fit_Of_affected_nh (t_fib_dr *p_dr);
 
 int fib_proc_dr_degeneration (t_fib_dr *p_dr);
@@ -819,6 +954,8 @@ int fib_delete_all_dr_dep_nh (t_fib_dr *p_dr);
 
 void fib_free_dr_node (t_fib_dr *p_dr);
 
+t_fib_dr_cold *fib_get_dr_cold (t_fib_dr *p_dr);
+
 int fib_dr_walker_init (void);
 
 int fib_dr_walker_main (void );
@@ -890,6 +1027,8 @@ int fib_del_nh_dep_dr (t_fib_nh *p_nh, t_fib_nh_dep_dr *p_nh_dep_dr);
 
 int fib_delete_all_nh_dep_dr (t_fib_nh *p_nh);
 
+uint64_t fib_get_nh_dep_dr_mem_size (t_fib_nh *p_nh);
+
 int fib_add_nh_best_fit_dr (t_fib_nh *p_nh, t_fib_dr *p_best_fit_dr);
 
 t_fib_dr *fib_get_nh_best_fit_dr (t_fib_nh *p_nh);
@@ -927,6 +1066,8 @@ int fib_nh_walker_main (void);
 
 int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap);
 
+int fib_nh_rslv_process (t_fib_nh *p_nh);
+
 int fib_resolve_nh (t_fib_nh *p_nh);
 
 int fib_proc_nh_dead (t_fib_nh *p_nh);
@@ -984,6 +1125,27 @@ int fib_nbr_del_on_intf_down (int if_index, int vrf_id, int af_index);
 bool hal_rt_handle_ip_unreachable_config (t_fib_intf_ip_unreach_config *p_cfg, bool *p_os_gbl_cfg_req);
 t_fib_intf *fib_get_first_intf ();
 t_fib_intf *fib_get_next_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_index);
+t_fib_intf *fib_get_intf_any_af (uint32_t if_index, uint32_t vrf_id);
+void fib_intf_index_stats_get (bool *p_is_valid, uint32_t *p_num_direct,
+                               uint32_t *p_direct_size, uint32_t *p_num_sparse);
 t_std_error fib_del_all_intf_ip (t_fib_intf *p_intf);
 t_std_error fib_nh_del_nh(t_fib_nh *p_nh, bool is_force_del);
+
+/* Function signatures for rslv.c - Start */
+
+void fib_rslv_burst_start (t_fib_vrf_info *p_vrf_info, t_fib_rslv_burst *p_burst,
+                           bool is_propagate);
+
+bool fib_rslv_seed (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node,
+                    t_fib_rslv_node_type type, void *p_owner);
+
+bool fib_rslv_mark (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node,
+                    t_fib_rslv_node_type type, void *p_owner);
+
+void fib_rslv_unlink (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node);
+
+uint32_t fib_rslv_burst_run (t_fib_vrf_info *p_vrf_info, t_fib_rslv_burst *p_burst,
+                             uint64_t deadline_nsecs);
+
+/* Function signatures for rslv.c - End */
 #endif /* __HAL_RT_ROUTE_H__ */
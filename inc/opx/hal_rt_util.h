@@ -126,7 +126,56 @@ t_std_error nas_rt_fill_opaque_data(cps_api_object_t obj, uint64_t attr, int npu
 t_std_error hal_rt_get_intf_name(hal_vrf_id_t vrf_id, int if_index, char *p_if_name);
 uint32_t nas_rt_get_clock_sec();
 int nas_rt_process_msg(t_fib_msg *p_msg);
-int fib_msg_main(void);
+void hal_rt_msg_queue_set_bounds(uint32_t max_len, uint64_t max_bytes,
+                                 t_fib_msg_queue_overflow_policy policy);
+void hal_rt_msg_queue_gauges_get(uint32_t *p_depth, uint64_t *p_bytes);
+void hal_rt_route_validation_stats_get(uint64_t *p_validated, uint64_t *p_skipped,
+                                       uint64_t *p_nsecs);
+void hal_rt_route_validation_stats_clear(void);
+bool hal_rt_msg_latency_stats_get(t_fib_msg_type msg_type, t_fib_msg_latency_stats *p_stats);
+/* Batch size of the walker for the next VRF lock hold */
+uint32_t hal_rt_walker_batch_size_get(t_fib_walker_type type);
+uint64_t hal_rt_walker_batch_start(void);
+/* End of the walker time budget of the lock hold, 0 if no budget is set */
+uint64_t hal_rt_walker_batch_deadline(uint64_t start);
+/* Record the time taken for the nodes processed in the batch */
+void hal_rt_walker_batch_end(t_fib_walker_type type, uint64_t start, uint32_t num_nodes,
+                             uint32_t batch_size);
+/* Record the dependent nodes resolved in the burst of the batch */
+void hal_rt_walker_rslv_end(t_fib_walker_type type, uint32_t num_propagated,
+                            uint32_t num_deferred, uint32_t num_parallel);
+void hal_rt_walker_stats_get(t_fib_walker_type type, t_fib_walker_stats *p_stats);
+void hal_rt_walker_stats_clear(void);
+/* Coalescing of the walker wakeups, a change returns true if the walker is to
+ * be woken up right away, *p_is_first is set for the first change of the window */
+bool hal_rt_walker_change_notify(t_fib_walker_type type, bool *p_is_first);
+/* Time (in nsecs) the walker is to be woken up at, 0 if no change is pending */
+uint64_t hal_rt_walker_coalesce_deadline(t_fib_walker_type type);
+/* Start a new window, called by the walker when it wakes up */
+void hal_rt_walker_coalesce_reset(t_fib_walker_type type, bool is_time_wakeup);
+uint64_t hal_rt_walker_clock_nsecs(void);
+/* Record the convergence delay of a route changed at change_nsecs */
+void hal_rt_walker_convergence_record(uint64_t change_nsecs);
+void hal_rt_walker_convergence_stats_get(t_fib_convergence_stats *p_stats);
+void hal_rt_walker_convergence_stats_clear(void);
+/* Active VRF tracking of the walkers, the VRF is marked with its changes and
+ * cleared by the walker with the VRF locked */
+void hal_rt_walker_vrf_mark(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index);
+void hal_rt_walker_vrf_done(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index,
+                            uint32_t num_nodes, bool is_caught_up);
+bool hal_rt_walker_vrf_next(t_fib_walker_type type, uint8_t af_index, uint32_t *p_vrf_id);
+uint32_t hal_rt_walker_vrf_backlog_get(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index);
+uint32_t hal_rt_walker_vrf_batches_get(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index,
+                                       uint32_t num_dirty_vrfs, uint64_t tot_backlog);
+void hal_rt_msg_latency_stats_clear(void);
+int fib_msg_main(void *param);
+t_std_error hal_rt_msg_workers_init(uint32_t num_workers);
+/* Resolution workers, the job items are run in parallel by the workers and
+ * the caller, returns once all the items are done */
+typedef void (*hal_rt_rslv_job_fn_t)(void *p_arg, uint32_t item);
+int fib_rslv_worker_main(void *param);
+uint32_t hal_rt_rslv_workers_get(void);
+void hal_rt_rslv_workers_run(hal_rt_rslv_job_fn_t fn, void *p_arg, uint32_t num_items);
 bool nas_rt_peer_mac_db_add (nas_rt_peer_mac_config_t* mac_info);
 t_std_error nas_route_delete_vrf_peer_mac_config(uint32_t vrf_id);
 t_std_error nas_route_delete_vrf_virtual_routing_ip_config(uint32_t vrf_id);
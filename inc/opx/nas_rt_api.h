@@ -119,6 +119,12 @@ t_std_error nas_route_publish_object(cps_api_object_t obj);
 
 t_std_error nas_route_nht_publish_object(cps_api_object_t obj);
 
+/* No. of entries a get walks before dropping the shared VRF lock for the writers */
+#define FIB_GET_YIELD_COUNT  256
+
+bool nas_route_get_yield (uint32_t *p_cnt, bool in_epoch, hal_vrf_id_t vrf_id);
+
+/* Takes the VRF lock shared by itself, the caller should not hold the nas_l3_lock */
 t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
                                        hal_ip_addr_t *p_nh_addr, bool is_specific_nh_get,
                                        bool is_proactive_nh_get);
@@ -139,8 +145,10 @@ int nas_rt_publish_nht(t_fib_nht *p_nht, t_fib_dr *p_dr, t_fib_nh *p_nh, bool is
 t_fib_nht *fib_get_nht (uint32_t vrf_id, t_fib_ip_addr *p_dest_addr);
 t_fib_nht *fib_get_first_nht (uint32_t vrf_id, uint8_t af_index);
 t_fib_nht *fib_get_next_nht (uint32_t vrf_id, t_fib_ip_addr *p_dest_addr);
+/* Takes the VRF lock shared by itself, the caller should not hold the nas_l3_lock */
 t_std_error nas_route_get_all_nht_info(cps_api_object_list_t list, unsigned int vrf_id,
                                        unsigned int af, t_fib_ip_addr *p_dest_addr);
+/* Takes the VRF lock shared by itself, the caller should not hold the nas_l3_lock */
 t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
                                          hal_ip_addr_t *p_prefix, uint32_t pref_len, bool is_specific_prefix_get,
                                          bool is_specific_vrf_get);
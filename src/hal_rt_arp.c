@@ -22,6 +22,7 @@
  */
 
 #include "hal_rt_main.h"
+#include "hal_rt_mem.h"
 #include "hal_rt_route.h"
 #include "hal_rt_util.h"
 #include "hal_rt_debug.h"
@@ -521,6 +522,8 @@ t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, uint32_t vrf_
                                        bool is_proactive_nh_get) {
 
     t_fib_nh *p_nh = NULL;
+    uint32_t yield_cnt = 0;
+    t_std_error rc = STD_ERR_OK;
 
     if (af >= FIB_MAX_AFINDEX)
     {
@@ -528,12 +531,17 @@ t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, uint32_t vrf_
         return STD_ERR(ROUTE,FAIL,0);
     }
 
-    if (is_specific_nh_get) {
+    bool in_epoch = hal_rt_epoch_enter();
+    nas_l3_vrf_lock_shared(vrf_id);
+    if (!(FIB_IS_VRF_ID_VALID (vrf_id))) {
+        HAL_RT_LOG_ERR("NAS-RT-CPS-GET", "VRF-id:%d is not valid!", vrf_id);
+        rc = STD_ERR(ROUTE,FAIL,0);
+    } else if (is_specific_nh_get) {
         /* As we dont expect the user to provide the nh if-index, do the partial nh key get next
          * if NH is NULL, return, if there is a NH address mismatch on the get next entry, return */
         p_nh = fib_get_next_nh(vrf_id, p_nh_addr, 0);
-        if ((p_nh == NULL) || (memcmp(&p_nh->key.ip_addr, p_nh_addr, sizeof(t_fib_ip_addr)))) {
-            return STD_ERR_OK;
+        if ((p_nh != NULL) && (memcmp(&p_nh->key.ip_addr, p_nh_addr, sizeof(t_fib_ip_addr)))) {
+            p_nh = NULL;
         }
     } else {
         p_nh = fib_get_first_nh (vrf_id, af);
@@ -555,15 +563,26 @@ t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, uint32_t vrf_
             if (!cps_api_object_list_append(list,obj)) {
                 cps_api_object_delete(obj);
                 HAL_RT_LOG_ERR("HAL-RT-ARP","Failed to append object to object list");
-                return STD_ERR(ROUTE,FAIL,0);
+                rc = STD_ERR(ROUTE,FAIL,0);
+                break;
             }
         }
         if (is_specific_nh_get)
             break;
 
+        /* VRF could have been deleted while the lock was dropped, the NH memory
+         * is kept by the epoch read section */
+        if (nas_route_get_yield (&yield_cnt, in_epoch, vrf_id) &&
+            (!(FIB_IS_VRF_ID_VALID (vrf_id)))) {
+            break;
+        }
         p_nh = fib_get_next_nh (vrf_id, &p_nh->key.ip_addr, p_nh->key.if_index);
     }
-    return STD_ERR_OK;
+    nas_l3_vrf_unlock_shared(vrf_id);
+    if (in_epoch) {
+        hal_rt_epoch_exit();
+    }
+    return rc;
 }
 
 bool hal_rt_cps_obj_to_intf(cps_api_object_t obj, t_fib_intf_entry *p_intf) {
@@ -25,7 +25,11 @@
 #include "hal_rt_api.h"
 #include "hal_rt_debug.h"
 #include "hal_rt_util.h"
+#include "hal_rt_mem.h"
 #include "nas_rt_api.h"
+#include "hal_rt_lockstat.h"
+#include "hal_rt_lpm.h"
+#include "hal_rt_hash.h"
 #include "hal_shell.h"
 
 #include "std_ip_utils.h"
@@ -118,6 +122,9 @@ void fib_help (void)
 
 void fib_dump_config (void)
 {
+    uint32_t msg_queue_depth = 0;
+    uint64_t msg_queue_bytes = 0;
+
     printf ("**************************************************\r\n");
 
     printf ("  ecmp_max_paths                      :  %d\r\n",
@@ -129,6 +136,42 @@ void fib_dump_config (void)
     printf ("  ecmp_hash_sel                       :  %d\r\n",
             (hal_rt_access_fib_config())->ecmp_hash_sel);
 
+    printf ("  msg_batch_size                      :  %d\r\n",
+            (hal_rt_access_fib_config())->msg_batch_size);
+
+    printf ("  msg_batch_time_budget(usecs)        :  %d\r\n",
+            (hal_rt_access_fib_config())->msg_batch_time_budget);
+
+    printf ("  msg_queue_max_len                   :  %d\r\n",
+            (hal_rt_access_fib_config())->msg_queue_max_len);
+
+    printf ("  msg_queue_max_bytes                 :  %llu\r\n",
+            (unsigned long long)(hal_rt_access_fib_config())->msg_queue_max_bytes);
+
+    printf ("  msg_queue_overflow_policy           :  %s\r\n",
+            (((hal_rt_access_fib_config())->msg_queue_overflow_policy ==
+              FIB_MSG_QUEUE_OVERFLOW_RESYNC) ? "resync" : "block"));
+
+    printf ("  msg_workers                         :  %d\r\n",
+            (hal_rt_access_fib_config())->msg_workers);
+    printf ("  rslv_workers                        :  %d (running: %d)\r\n",
+            (hal_rt_access_fib_config())->rslv_workers, hal_rt_rslv_workers_get ());
+
+    printf ("  walker_time_budget(usecs)           :  %d\r\n",
+            (hal_rt_access_fib_config())->walker_time_budget);
+
+    printf ("  walker_coalesce_time(usecs)         :  %d\r\n",
+            (hal_rt_access_fib_config())->walker_coalesce_time);
+
+    printf ("  walker_coalesce_changes             :  %d\r\n",
+            (hal_rt_access_fib_config())->walker_coalesce_changes);
+
+    hal_rt_msg_queue_gauges_get (&msg_queue_depth, &msg_queue_bytes);
+    printf ("  msg_queue_depth                     :  %d\r\n", msg_queue_depth);
+
+    printf ("  msg_queue_bytes                     :  %llu\r\n",
+            (unsigned long long)msg_queue_bytes);
+
     printf ("**************************************************\r\n");
 
     return;
@@ -136,6 +179,11 @@ void fib_dump_config (void)
 
 void fib_dump_gbl_info(void)
 {
+    uint64_t rt_validated = 0, rt_validation_skip = 0, rt_validation_nsecs = 0;
+    uint64_t epoch_retired = 0, epoch_reclaimed = 0, epoch_pending = 0;
+    uint32_t intf_direct = 0, intf_direct_size = 0, intf_sparse = 0;
+    bool     is_intf_index_valid = false;
+
     printf ("**************************************************\r\n");
     printf ("  total_msgs                :  %d\r\n",
             (hal_rt_access_fib_gbl_info())->num_tot_msg);
@@ -151,6 +199,26 @@ void fib_dump_gbl_info(void)
             (hal_rt_access_fib_gbl_info())->num_unk_msg);
     printf ("  num_ip_msg                :  %d\r\n",
             (hal_rt_access_fib_gbl_info())->num_ip_msg);
+
+    /* Route msgs validated before queueing, the validation time is
+     * the nas_l3_lock hold time saved */
+    hal_rt_route_validation_stats_get (&rt_validated, &rt_validation_skip, &rt_validation_nsecs);
+    printf ("  num_route_validated       :  %llu\r\n", (unsigned long long)rt_validated);
+    printf ("  num_route_validation_skip :  %llu\r\n", (unsigned long long)rt_validation_skip);
+    printf ("  route_validation_time(us) :  %llu\r\n",
+            (unsigned long long)(rt_validation_nsecs / 1000));
+    printf ("  route_validation_avg(ns)  :  %llu\r\n",
+            (unsigned long long)(rt_validated ? (rt_validation_nsecs / rt_validated) : 0));
+    /* DR/NH nodes freed with the deferred reclamation */
+    hal_rt_epoch_stats_get (&epoch_retired, &epoch_reclaimed, &epoch_pending);
+    printf ("  num_node_retired          :  %llu\r\n", (unsigned long long)epoch_retired);
+    printf ("  num_node_reclaimed        :  %llu\r\n", (unsigned long long)epoch_reclaimed);
+    printf ("  num_node_reclaim_pending  :  %llu\r\n", (unsigned long long)epoch_pending);
+    /* Exact intf lookups, the tree is used if the index is invalid */
+    fib_intf_index_stats_get (&is_intf_index_valid, &intf_direct, &intf_direct_size, &intf_sparse);
+    printf ("  intf_index                :  %s direct:%d slots:%d sparse:%d\r\n",
+            (is_intf_index_valid ? "valid" : "invalid"), intf_direct,
+            intf_direct_size, intf_sparse);
     printf ("**************************************************\r\n");
 
     return;
@@ -165,10 +233,175 @@ void fib_dump_gbl_info_clear_cntr(void)
     (hal_rt_access_fib_gbl_info())->num_nei_msg = 0;
     (hal_rt_access_fib_gbl_info())->num_unk_msg = 0;
     (hal_rt_access_fib_gbl_info())->num_ip_msg = 0;
+    hal_rt_route_validation_stats_clear ();
+
+    return;
+}
+
+static const char *fib_msg_type_to_str (t_fib_msg_type msg_type)
+{
+    switch (msg_type) {
+        case FIB_MSG_TYPE_NL_INTF:               return "NL-Intf";
+        case FIB_MSG_TYPE_NBR_MGR_INTF:          return "NbrMgr-Intf";
+        case FIB_MSG_TYPE_NL_ROUTE:              return "NL-Route";
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:      return "NbrMgr-Nbr";
+        case FIB_MSG_TYPE_NL_NBR:                return "NL-Nbr";
+        case FIB_MSG_TYPE_INTF_IP_UNREACH_CFG:   return "IP-Unreach-Cfg";
+        case FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG: return "IP-Redirects-Cfg";
+        case FIB_MSG_TYPE_BARRIER:               return "Barrier";
+        default:
+            break;
+    }
+    return "Unknown";
+}
+
+/* Queue wait and processing time of the msgs per msg type */
+void fib_dump_msg_latency (void)
+{
+    t_fib_msg_latency_stats stats;
+    int msg_type;
+
+    printf ("%-18s %-10s %-28s %-28s\r\n", "", "", "Queue wait (us)", "Process time (us)");
+    printf ("%-18s %-10s %-8s %-8s %-10s %-8s %-8s %-10s\r\n", "MsgType", "Count",
+            "p50", "p99", "max", "p50", "p99", "max");
+    printf ("******************************************************************************\r\n");
+    for (msg_type = FIB_MSG_TYPE_NL_INTF; msg_type < FIB_MSG_TYPE_MAX; msg_type++) {
+        if (!hal_rt_msg_latency_stats_get (msg_type, &stats))
+            continue;
+        printf ("%-18s %-10llu %-8llu %-8llu %-10llu %-8llu %-8llu %-10llu\r\n",
+                fib_msg_type_to_str (msg_type), (unsigned long long)stats.count,
+                (unsigned long long)stats.queue_wait_p50, (unsigned long long)stats.queue_wait_p99,
+                (unsigned long long)stats.queue_wait_max, (unsigned long long)stats.process_time_p50,
+                (unsigned long long)stats.process_time_p99, (unsigned long long)stats.process_time_max);
+    }
+    printf ("******************************************************************************\r\n");
 
     return;
 }
 
+/* Throughput of the DR and NH walkers */
+void fib_dump_walker_stats (void)
+{
+    static const char *walker_names[FIB_WALKER_MAX] = {"DR", "NH"};
+    t_fib_walker_stats stats;
+    int walker;
+
+    printf ("%-8s %-12s %-12s %-14s %-12s %-12s %-12s %-10s %-14s %-12s %-14s\r\n", "Walker",
+            "Batches", "FullBatches", "Nodes", "Busy(ms)", "Nodes/sec", "NodeCost(ns)",
+            "BatchSize", "Propagated", "Deferred", "ParallelDRs");
+    printf ("****************************************************************************"
+            "*****************************************************************\r\n");
+    for (walker = FIB_WALKER_DR; walker < FIB_WALKER_MAX; walker++) {
+        hal_rt_walker_stats_get (walker, &stats);
+        printf ("%-8s %-12llu %-12llu %-14llu %-12llu %-12llu %-12u %-10u %-14llu %-12llu %-14llu\r\n",
+                walker_names[walker], (unsigned long long)stats.num_batches,
+                (unsigned long long)stats.num_full_batches, (unsigned long long)stats.num_nodes,
+                (unsigned long long)(stats.busy_nsecs / 1000000),
+                (unsigned long long)(stats.busy_nsecs ?
+                                     ((stats.num_nodes * 1000000000ULL) / stats.busy_nsecs) : 0),
+                stats.node_cost_nsecs, stats.batch_size,
+                (unsigned long long)stats.num_propagated, (unsigned long long)stats.num_deferred,
+                (unsigned long long)stats.num_parallel);
+    }
+
+    return;
+}
+
+/* Route convergence delay with the DR walker wakeups coalesced */
+void fib_dump_convergence (void)
+{
+    t_fib_convergence_stats stats;
+
+    hal_rt_walker_convergence_stats_get (&stats);
+    printf ("  Coalesce window          :  %d usecs / %d changes\r\n",
+            (hal_rt_access_fib_config())->walker_coalesce_time,
+            (hal_rt_access_fib_config())->walker_coalesce_changes);
+    printf ("  Routes programmed        :  %llu\r\n", (unsigned long long)stats.count);
+    printf ("  Delay p50/p99/max (us)   :  %llu/%llu/%llu\r\n",
+            (unsigned long long)stats.delay_p50, (unsigned long long)stats.delay_p99,
+            (unsigned long long)stats.delay_max);
+    printf ("  Wakeups on time/changes  :  %llu/%llu\r\n",
+            (unsigned long long)stats.num_time_wakeups,
+            (unsigned long long)stats.num_change_wakeups);
+
+    return;
+}
+
+/* Max. no. of lock call sites dumped, and the no. of top holders/waiters shown */
+#define FIB_LOCKSTAT_MAX_DUMP_SITES  256
+#define FIB_LOCKSTAT_TOP_N           10
+
+static int fib_lockstat_hold_cmp (const void *p_a, const void *p_b)
+{
+    const t_hal_rt_lockstat *p_stat_a = (const t_hal_rt_lockstat *)p_a;
+    const t_hal_rt_lockstat *p_stat_b = (const t_hal_rt_lockstat *)p_b;
+
+    if (p_stat_a->hold_nsecs == p_stat_b->hold_nsecs)
+        return 0;
+    return ((p_stat_a->hold_nsecs > p_stat_b->hold_nsecs) ? -1 : 1);
+}
+
+static int fib_lockstat_wait_cmp (const void *p_a, const void *p_b)
+{
+    const t_hal_rt_lockstat *p_stat_a = (const t_hal_rt_lockstat *)p_a;
+    const t_hal_rt_lockstat *p_stat_b = (const t_hal_rt_lockstat *)p_b;
+
+    if (p_stat_a->wait_nsecs == p_stat_b->wait_nsecs)
+        return 0;
+    return ((p_stat_a->wait_nsecs > p_stat_b->wait_nsecs) ? -1 : 1);
+}
+
+static void fib_dump_lockstat_top (const char *p_title, t_hal_rt_lockstat *p_stats,
+                                   uint32_t num_stats)
+{
+    uint32_t ix;
+
+    printf ("\r\n%s\r\n", p_title);
+    printf ("%-40s %-10s %-10s %-12s %-10s %-10s %-12s %-10s %-10s\r\n", "Function", "Mode",
+            "Count", "Hold(ms)", "AvgHold", "MaxHold", "Wait(ms)", "AvgWait", "MaxWait");
+    printf ("****************************************************************************"
+            "****************************************************\r\n");
+    for (ix = 0; (ix < num_stats) && (ix < FIB_LOCKSTAT_TOP_N); ix++) {
+        const t_hal_rt_lockstat *p_stat = &p_stats[ix];
+        uint64_t count = (p_stat->count ? p_stat->count : 1);
+
+        printf ("%-40s %-10s %-10llu %-12llu %-10llu %-10llu %-12llu %-10llu %-10llu\r\n",
+                p_stat->site, hal_rt_lock_mode_to_str (p_stat->mode),
+                (unsigned long long)p_stat->count,
+                (unsigned long long)(p_stat->hold_nsecs / 1000000),
+                (unsigned long long)(p_stat->hold_nsecs / count / 1000),
+                (unsigned long long)(p_stat->hold_max / 1000),
+                (unsigned long long)(p_stat->wait_nsecs / 1000000),
+                (unsigned long long)(p_stat->wait_nsecs / count / 1000),
+                (unsigned long long)(p_stat->wait_max / 1000));
+    }
+}
+
+/* Top holders and waiters of the nas_l3_lock per caller function and lock mode,
+ * the avg/max times are in micro secs */
+void fib_dump_lockstat (void)
+{
+    t_hal_rt_lockstat *p_stats = NULL;
+    uint32_t num_stats = 0;
+
+    p_stats = (t_hal_rt_lockstat *) calloc (FIB_LOCKSTAT_MAX_DUMP_SITES, sizeof (t_hal_rt_lockstat));
+    if (p_stats == NULL) {
+        printf ("Memory alloc failed for the lock stats\r\n");
+        return;
+    }
+    num_stats = hal_rt_lockstat_get (p_stats, FIB_LOCKSTAT_MAX_DUMP_SITES);
+    printf ("Lock call sites: %u, Dropped: %llu\r\n", num_stats,
+            (unsigned long long)hal_rt_lockstat_dropped_get ());
+
+    qsort (p_stats, num_stats, sizeof (t_hal_rt_lockstat), fib_lockstat_hold_cmp);
+    fib_dump_lockstat_top ("Top holders", p_stats, num_stats);
+    qsort (p_stats, num_stats, sizeof (t_hal_rt_lockstat), fib_lockstat_wait_cmp);
+    fib_dump_lockstat_top ("Top waiters", p_stats, num_stats);
+
+    free (p_stats);
+    return;
+}
+
 void fib_dump_vrf_info_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
 {
     uint8_t     af_index;
@@ -213,6 +446,13 @@ void fib_dump_vrf_info_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
     printf ("  num_nh_processed_by_walker    :  %d\r\n",
             p_vrf_info->num_nh_processed_by_walker);
 
+    /* Changes marked and not yet walked, 0 if the walker is idle for the VRF */
+    printf ("  dr_walker_backlog             :  %d\r\n",
+            hal_rt_walker_vrf_backlog_get (FIB_WALKER_DR, vrf_id, af_index));
+
+    printf ("  nh_walker_backlog             :  %d\r\n",
+            hal_rt_walker_vrf_backlog_get (FIB_WALKER_NH, vrf_id, af_index));
+
     printf ("  clear_ip_fib_on              :  %d\r\n", p_vrf_info->clear_ip_fib_on);
     printf ("  clear_ip_route_on            :  %d\r\n", p_vrf_info->clear_ip_route_on);
     printf ("  clear_arp_on                :  %d\r\n", p_vrf_info->clear_arp_on);
@@ -230,6 +470,26 @@ void fib_dump_vrf_info_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
             p_vrf_info->dr_ha_max_radix_ver);
     printf ("  nh_ha_max_radix_ver           :  %lld\r\n",
             p_vrf_info->nh_ha_max_radix_ver);
+    printf ("  num_leak_refs                 :  %d (%s lock)\r\n",
+            hal_rt_access_fib_vrf(vrf_id)->num_leak_refs,
+            (hal_rt_access_fib_vrf(vrf_id)->num_leak_refs ? "global" : "VRF"));
+
+    if (p_vrf_info->p_dr_lpm != NULL) {
+        printf ("  dr_lpm_index                  :  %s prefixes:%d nodes:%d bytes:%llu\r\n",
+                (fib_lpm_is_valid (p_vrf_info->p_dr_lpm) ? "valid" : "invalid"),
+                p_vrf_info->p_dr_lpm->num_pfx, p_vrf_info->p_dr_lpm->num_nodes,
+                (unsigned long long)p_vrf_info->p_dr_lpm->num_bytes);
+    }
+    if (p_vrf_info->p_dr_hash != NULL) {
+        printf ("  dr_hash_index                 :  %s entries:%d slots:%d\r\n",
+                (fib_hash_is_valid (p_vrf_info->p_dr_hash) ? "valid" : "invalid"),
+                p_vrf_info->p_dr_hash->num_entries, p_vrf_info->p_dr_hash->num_slots);
+    }
+    if (p_vrf_info->p_nh_hash != NULL) {
+        printf ("  nh_hash_index                 :  %s entries:%d slots:%d\r\n",
+                (fib_hash_is_valid (p_vrf_info->p_nh_hash) ? "valid" : "invalid"),
+                p_vrf_info->p_nh_hash->num_entries, p_vrf_info->p_nh_hash->num_slots);
+    }
 
     printf ("**************************************************\r\n");
 
@@ -354,13 +614,15 @@ void fib_dump_dr_node (t_fib_dr *p_dr)
     printf ("  default_dr_owner   :  %d\r\n", p_dr->default_dr_owner);
     printf ("  status_flag       :  0x%x\r\n", p_dr->status_flag);
     printf ("  last_update_time   :  %ld\r\n", p_dr->last_update_time);
-    printf ("  p_hal_dr_handle       :  %p\r\n", p_dr->p_hal_dr_handle);
+    printf ("  p_cold            :  %p\r\n", p_dr->p_cold);
     printf ("  num_nh            :  %d\r\n", p_dr->num_nh);
     printf ("  num_fh            :  %d\r\n", p_dr->num_fh);
 
     if (STD_IP_IS_ADDR_LINK_LOCAL(&p_dr->key.prefix)) {
-        printf ("  num_ipv6_link_local      :  %d\r\n", p_dr->num_ipv6_link_local);
-        printf ("  num_ipv6_rif_link_local  :  %d\r\n", p_dr->num_ipv6_rif_link_local);
+        printf ("  num_ipv6_link_local      :  %d\r\n",
+                FIB_DR_COLD_FIELD (p_dr, num_ipv6_link_local));
+        printf ("  num_ipv6_rif_link_local  :  %d\r\n",
+                FIB_DR_COLD_FIELD (p_dr, num_ipv6_rif_link_local));
     }
 
     printf ("**************************************************\r\n");
@@ -439,7 +701,7 @@ void fib_dump_dr_node (t_fib_dr *p_dr)
         count++;
     }
 
-    p_fh = (t_fib_nh *) (p_dr->degen_dr_fh.link_node.self);
+    p_fh = (t_fib_nh *) FIB_DR_COLD_FIELD (p_dr, degen_dr_fh.link_node.self);
 
     if (p_fh != NULL)
     {
@@ -449,7 +711,7 @@ void fib_dump_dr_node (t_fib_dr *p_dr)
 
         fib_dump_nh_node_key (p_fh);
 
-        p_dr_fh = &(p_dr->degen_dr_fh);
+        p_dr_fh = &(p_dr->p_cold->degen_dr_fh);
 
         printf ("  status                   :  %d\r\n", p_dr_fh->status);
         printf ("**************************************************\r\n");
@@ -525,6 +787,9 @@ void fib_dump_nh_node (t_fib_nh *p_nh)
     printf ("  tunnel_nh_ref_count   :  %d\r\n", p_nh->tunnel_nh_ref_count);
     printf ("  arp_last_update_time  :  %ld\r\n", p_nh->arp_last_update_time);
     printf ("  p_hal_nh_handle         :  %p\r\n", p_nh->p_hal_nh_handle);
+    printf ("  num_dep_dr              :  %d (chunks:%d bytes:%llu)\r\n",
+            p_nh->dep_dr_list.num_dr, p_nh->dep_dr_list.num_chunks,
+            (unsigned long long)fib_get_nh_dep_dr_mem_size (p_nh));
 
     printf ("**************************************************\r\n");
     printf ("  Dep_dr List:\r\n");
@@ -540,21 +805,21 @@ void fib_dump_nh_node (t_fib_nh *p_nh)
 
         printf ("-------------------------------------\r\n");
 
-        printf ("  vrf_id        :  %d\r\n", p_nh_dep_dr->key.vrf_id);
-        printf ("  vrf_name      :  %s\r\n", FIB_GET_VRF_NAME(p_nh_dep_dr->key.vrf_id,
-                                                              p_nh_dep_dr->key.dr_key.prefix.af_index));
+        printf ("  vrf_id        :  %d\r\n", p_nh_dep_dr->p_dr->vrf_id);
+        printf ("  vrf_name      :  %s\r\n", FIB_GET_VRF_NAME(p_nh_dep_dr->p_dr->vrf_id,
+                                                              p_nh_dep_dr->p_dr->key.prefix.af_index));
         printf ("  af_index      :  %d\r\n",
-                p_nh_dep_dr->key.dr_key.prefix.af_index);
+                p_nh_dep_dr->p_dr->key.prefix.af_index);
         printf ("  prefix       :  %s\r\n",
-                FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix));
-        printf ("  prefix_len    :  %d\r\n", p_nh_dep_dr->prefix_len);
+                FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->p_dr->key.prefix));
+        printf ("  prefix_len    :  %d\r\n", p_nh_dep_dr->p_dr->prefix_len);
         printf ("  p_dr          :  %p\r\n", p_nh_dep_dr->p_dr);
 
         printf ("-------------------------------------\r\n");
 
-        p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                      &p_nh_dep_dr->key.dr_key.prefix,
-                                      p_nh_dep_dr->prefix_len);
+        p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->p_dr->vrf_id,
+                                      &p_nh_dep_dr->p_dr->key.prefix,
+                                      p_nh_dep_dr->p_dr->prefix_len);
     }
 
     printf ("**************************************************\r\n");
@@ -1656,19 +1921,25 @@ static void nas_rt_shell_debug_counters (std_parsed_string_t handle)
         if(!strcmp(token,"help")) {
             nas_rt_shell_debug_counters_help();
         } else if(!strcmp(token,"all")) {
+            nas_l3_lock_shared();
             fib_dump_all_cntrs();
+            nas_l3_unlock_shared();
         } else if(!strcmp(token,"clear")) {
+            nas_l3_lock();
             fib_dbg_clear_all_cntrs();
+            nas_l3_unlock();
         } else if(NULL != token) {
             uint32_t vrf_id = strtol(token,NULL,0);
             token = std_parse_string_next(handle,&ix);
 
+            nas_l3_lock_shared();
             if(NULL != token) {
                 uint8_t af_index = strtol(token,NULL,0);
                 fib_dump_vrf_cntrs_per_vrf_per_af (vrf_id, af_index);
             } else {
                 fib_dump_vrf_cntrs_per_vrf (vrf_id);
             }
+            nas_l3_unlock_shared();
         }
     } else {
         nas_rt_shell_debug_counters_help();
@@ -1694,10 +1965,14 @@ static void nas_rt_shell_debug_intf (std_parsed_string_t handle)
         if(!strcmp(token,"help")) {
             nas_rt_shell_debug_intf_help();
         } else if(!strcmp(token,"all")) {
+            nas_l3_lock_shared();
             fib_dump_all_intf();
+            nas_l3_unlock_shared();
         } else if(NULL != token) {
             uint32_t if_index = strtol(token,NULL,0);
+            nas_l3_lock_shared();
             fib_dump_intf_per_if_index (if_index);
+            nas_l3_unlock_shared();
         }
     } else {
         nas_rt_shell_debug_intf_help();
@@ -1723,17 +1998,21 @@ static void nas_rt_shell_debug_vrf(std_parsed_string_t handle)
         if(!strcmp(token,"help")) {
             nas_rt_shell_debug_vrf_help();
         } else if(!strcmp(token,"all")) {
+            nas_l3_lock_shared();
             fib_dump_all_vrf_info();
+            nas_l3_unlock_shared();
         } else if(NULL != token) {
             uint32_t vrf_id = strtol(token,NULL,0);
             token = std_parse_string_next(handle,&ix);
 
+            nas_l3_lock_shared();
             if(NULL != token) {
                 uint8_t af_index = strtol(token,NULL,0);
                 fib_dump_vrf_info_per_vrf_per_af (vrf_id, af_index);
             } else {
                 fib_dump_vrf_info_per_vrf(vrf_id);
             }
+            nas_l3_unlock_shared();
         }
     } else {
         nas_rt_shell_debug_vrf_help();
@@ -1760,10 +2039,13 @@ static void nas_rt_shell_debug_dr(std_parsed_string_t handle)
         if(!strcmp(token,"help")) {
             nas_rt_shell_debug_dr_help();
         } else if(!strcmp(token,"all")) {
+            nas_l3_lock_shared();
             fib_dump_all_dr();
+            nas_l3_unlock_shared();
         } else if(NULL != token) {
             uint32_t vrf_id = strtol(token,NULL,0);
             token = std_parse_string_next(handle,&ix);
+            nas_l3_lock_shared();
             if(NULL != token) {
                 uint32_t af_index = strtol(token,NULL,0);
                 token = std_parse_string_next(handle,&ix);
@@ -1777,6 +2059,7 @@ static void nas_rt_shell_debug_dr(std_parsed_string_t handle)
             } else {
                fib_dump_dr_per_vrf(vrf_id);
             }
+            nas_l3_unlock_shared();
         }
     } else {
         nas_rt_shell_debug_dr_help();
@@ -1803,10 +2086,13 @@ static void nas_rt_shell_debug_nh(std_parsed_string_t handle)
         if(!strcmp(token,"help")) {
             nas_rt_shell_debug_nh_help();
         } else if(!strcmp(token,"all")) {
+            nas_l3_lock_shared();
             fib_dump_all_nh();
+            nas_l3_unlock_shared();
         } else if(NULL != token) {
             uint32_t vrf_id = strtol(token,NULL,0);
             token = std_parse_string_next(handle,&ix);
+            nas_l3_lock_shared();
             if(NULL != token) {
                 uint32_t af_index = strtol(token,NULL,0);
                 token = std_parse_string_next(handle,&ix);
@@ -1820,6 +2106,7 @@ static void nas_rt_shell_debug_nh(std_parsed_string_t handle)
             } else {
                fib_dump_nh_per_vrf (vrf_id);
             }
+            nas_l3_unlock_shared();
         }
     } else {
         nas_rt_shell_debug_nh_help();
@@ -1877,6 +2164,16 @@ static void nas_rt_shell_debug_help(void)
     printf("\t- NH module commands\r\n");
     printf("::nas-rt-debug rif\r\n");
     printf("\t- RIF module commands\r\n");
+    printf("::nas-rt-debug msg-pool\r\n");
+    printf("\t- Message pool occupancy and hit/miss stats\r\n");
+    printf("::nas-rt-debug msg-latency [clear]\r\n");
+    printf("\t- Message queue wait and processing time percentiles per msg type\r\n");
+    printf("::nas-rt-debug lockstat [clear]\r\n");
+    printf("\t- FIB lock top holders and waiters per function\r\n");
+    printf("::nas-rt-debug walker-stats [clear]\r\n");
+    printf("\t- DR and NH walker throughput and batch sizes\r\n");
+    printf("::nas-rt-debug convergence [clear]\r\n");
+    printf("\t- Route convergence delay percentiles and DR walker wakeups\r\n");
 
     return;
 }
@@ -1904,6 +2201,40 @@ void nas_rt_shell_dbg (std_parsed_string_t handle)
             nas_rt_shell_debug_nh(handle);
         } else if(!strcmp(token,"rif")) {
             nas_rt_shell_debug_rif(handle);
+        } else if(!strcmp(token,"msg-pool")) {
+            hal_rt_msg_pool_dump();
+        } else if(!strcmp(token,"msg-latency")) {
+            size_t ix = 1;
+            token = std_parse_string_next(handle,&ix);
+            if ((token != NULL) && (!strcmp(token,"clear"))) {
+                hal_rt_msg_latency_stats_clear();
+            } else {
+                fib_dump_msg_latency();
+            }
+        } else if(!strcmp(token,"lockstat")) {
+            size_t ix = 1;
+            token = std_parse_string_next(handle,&ix);
+            if ((token != NULL) && (!strcmp(token,"clear"))) {
+                hal_rt_lockstat_clear();
+            } else {
+                fib_dump_lockstat();
+            }
+        } else if(!strcmp(token,"walker-stats")) {
+            size_t ix = 1;
+            token = std_parse_string_next(handle,&ix);
+            if ((token != NULL) && (!strcmp(token,"clear"))) {
+                hal_rt_walker_stats_clear();
+            } else {
+                fib_dump_walker_stats();
+            }
+        } else if(!strcmp(token,"convergence")) {
+            size_t ix = 1;
+            token = std_parse_string_next(handle,&ix);
+            if ((token != NULL) && (!strcmp(token,"clear"))) {
+                hal_rt_walker_convergence_stats_clear();
+            } else {
+                fib_dump_convergence();
+            }
         } else {
             nas_rt_shell_debug_help();
         }
@@ -29,6 +29,8 @@
 #include "hal_rt_api.h"
 #include "hal_rt_mem.h"
 #include "nas_rt_api.h"
+#include "hal_rt_lpm.h"
+#include "hal_rt_hash.h"
 
 #include "event_log.h"
 #include "std_ip_utils.h"
@@ -39,35 +41,75 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
 
-/* Min. threshold percent of route messages to be processed from message queue
- * before signalling DR walker thread.
- */
-#define NAS_RT_DR_WALKER_SIG_MIN_THRESHOLD_PERCENT 30
 pthread_mutex_t fib_dr_mutex;
 pthread_cond_t  fib_dr_cond;
 static bool     is_dr_pending_for_processing = 0; //initialize the predicate for signal
 
-void hal_rt_cps_obj_nh_list_to_route_nh_list(cps_api_object_it_t nhit, t_fib_route_entry *r) {
+#define HAL_RT_ROUTE_MSG_SIZE(_nh_count_) \
+        (sizeof(t_fib_msg) + (sizeof (t_fib_nh_info) * (_nh_count_)))
+
+/* Moves the route msg to a buffer that can hold nh_count NHs, the buffer is
+ * from the pool class for the nh_count and *p_max_nh is set to the NHs the
+ * class holds. The current msg is freed on failure */
+static t_fib_msg *hal_rt_route_msg_grow(t_fib_msg *p_msg, size_t *p_max_nh, size_t nh_count) {
+    if (nh_count <= *p_max_nh)
+        return p_msg;
+
+    t_fib_msg *p_new_msg = hal_rt_alloc_route_mem_msg(HAL_RT_ROUTE_MSG_SIZE(nh_count));
+    if (p_new_msg) {
+        size_t max_nh = hal_rt_route_msg_nh_max(p_new_msg);
+        memcpy(p_new_msg, p_msg, HAL_RT_ROUTE_MSG_SIZE(*p_max_nh));
+        memset(&p_new_msg->route.nh_list[*p_max_nh], 0,
+               sizeof (t_fib_nh_info) * (max_nh - *p_max_nh));
+        *p_max_nh = max_nh;
+    }
+    hal_rt_free_mem_msg(p_msg);
+    return p_new_msg;
+}
+
+/* Decodes the NH list into the route msg, the msg is moved to the pool class
+ * for the NH count (or the NH list entry if the NH count is not known yet)
+ * whenever it is full, the heap buffer beyond the pool classes is doubled.
+ * Returns NULL if that failed */
+static t_fib_msg *hal_rt_cps_obj_nh_list_to_route_nh_list(cps_api_object_it_t nhit, t_fib_msg *p_msg,
+                                                          size_t *p_max_nh) {
 
     size_t hop = 0;
+    size_t addr_len = 0;
+    size_t nh_count = 0;
     for (cps_api_object_it_inside(&nhit); cps_api_object_it_valid(&nhit);
          cps_api_object_it_next(&nhit), ++hop) {
+        if (hop >= *p_max_nh) {
+            nh_count = ((hop + 1) > p_msg->route.hop_count) ? (hop + 1) : p_msg->route.hop_count;
+            if ((*p_max_nh >= HAL_RT_MSG_POOL_ROUTE_MAX_NH) && (nh_count < (2 * (*p_max_nh))))
+                nh_count = 2 * (*p_max_nh);
+            if ((p_msg = hal_rt_route_msg_grow(p_msg, p_max_nh, nh_count)) == NULL)
+                return NULL;
+        }
+
+        t_fib_nh_info *p_nh = &p_msg->route.nh_list[hop];
         cps_api_object_it_t node = nhit;
         for (cps_api_object_it_inside(&node); cps_api_object_it_valid(&node);
              cps_api_object_it_next(&node)) {
 
             switch(cps_api_object_attr_id(node.attr)) {
                 case BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX:
-                    r->nh_list[hop].nh_if_index = cps_api_object_attr_data_u32(node.attr);
+                    p_nh->nh_if_index = cps_api_object_attr_data_u32(node.attr);
                     break;
                 case BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR:
-                    memcpy(&r->nh_list[hop].nh_addr.u, cps_api_object_attr_data_bin(node.attr),
-                           cps_api_object_attr_len (node.attr));
+                    addr_len = cps_api_object_attr_len (node.attr);
+                    if (addr_len > sizeof(p_nh->nh_addr.u))
+                        addr_len = sizeof(p_nh->nh_addr.u);
+                    memcpy(&p_nh->nh_addr.u, cps_api_object_attr_data_bin(node.attr),
+                           addr_len);
                     break;
                 case BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT:
-                    r->nh_list[hop].nh_weight = cps_api_object_attr_data_u32(node.attr);
+                    p_nh->nh_weight = cps_api_object_attr_data_u32(node.attr);
                     break;
                 default:
                     break;
@@ -75,36 +117,28 @@ void hal_rt_cps_obj_nh_list_to_route_nh_list(cps_api_object_it_t nhit, t_fib_rou
 
         }
     }
+    return p_msg;
 }
 
+/* Decodes the route object in a single pass over its attributes, straight
+ * into a pooled route msg sized for one NH, the msg is moved to a larger
+ * buffer only for the ECMP routes.
+ */
 bool hal_rt_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret) {
     t_fib_msg *p_msg = NULL;
-    cps_api_object_attr_t nh_count_attr = CPS_API_ATTR_NULL;
-    uint32_t nh_count = 1;
+    size_t max_nh = 1;
+    size_t addr_len = 0;
 
     *p_msg_ret = NULL;
-    nh_count_attr = cps_api_object_attr_get(obj, BASE_ROUTE_OBJ_ENTRY_NH_COUNT);
-
-    if (nh_count_attr)
-        nh_count = cps_api_object_attr_data_u32(nh_count_attr);
-
-    /* allocate the memory for the route msg based on the nexthop count
-     * in the received event.
-     */
-    uint32_t buf_size = sizeof(t_fib_msg) + (sizeof (t_fib_nh_info) * nh_count);
-    p_msg = hal_rt_alloc_route_mem_msg(buf_size);
+    p_msg = hal_rt_alloc_route_mem_msg(HAL_RT_ROUTE_MSG_SIZE(max_nh));
 
     if (!p_msg) {
         HAL_RT_LOG_ERR("HAL-RT", "Memory alloc failed for route msg");
         return false;
     }
 
-    HAL_RT_LOG_DEBUG("HAL-RT", " allocated buffer for route message:%p"
-                     " bytes:%d nh_count:%d", p_msg, buf_size, nh_count);
-
-    *p_msg_ret = p_msg;
-
-    memset(p_msg, 0, buf_size);
+    max_nh = hal_rt_route_msg_nh_max(p_msg);
+    memset(p_msg, 0, HAL_RT_ROUTE_MSG_SIZE(max_nh));
     p_msg->type = FIB_MSG_TYPE_NL_ROUTE;
     t_fib_route_entry *r = &(p_msg->route);
 
@@ -138,8 +172,10 @@ bool hal_rt_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret) {
                 r->prefix.af_index = cps_api_object_attr_data_uint(it.attr);
                 break;
             case BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX:
-                memcpy(&r->prefix.u, cps_api_object_attr_data_bin(it.attr),
-                       cps_api_object_attr_len (it.attr));
+                addr_len = cps_api_object_attr_len (it.attr);
+                if (addr_len > sizeof(r->prefix.u))
+                    addr_len = sizeof(r->prefix.u);
+                memcpy(&r->prefix.u, cps_api_object_attr_data_bin(it.attr), addr_len);
                 break;
             case BASE_ROUTE_OBJ_VRF_ID:
                 r->vrfid = cps_api_object_attr_data_uint(it.attr);
@@ -165,10 +201,26 @@ bool hal_rt_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret) {
                             sizeof(r->nh_vrf_name));
                 break;
             case BASE_ROUTE_OBJ_ENTRY_NH_LIST:
-                hal_rt_cps_obj_nh_list_to_route_nh_list(it, r);
+                if ((p_msg = hal_rt_cps_obj_nh_list_to_route_nh_list(it, p_msg, &max_nh)) == NULL) {
+                    HAL_RT_LOG_ERR("HAL-RT", "Memory alloc failed for route msg nh_count:%lu",
+                                   (max_nh + 1));
+                    return false;
+                }
+                r = &(p_msg->route);
                 break;
         }
     }
+
+    /* The msg holds the max. of the NH count and the NH list entries */
+    if ((p_msg = hal_rt_route_msg_grow(p_msg, &max_nh, r->hop_count)) == NULL) {
+        HAL_RT_LOG_ERR("HAL-RT", "Memory alloc failed for route msg nh_count:%lu", r->hop_count);
+        return false;
+    }
+
+    HAL_RT_LOG_DEBUG("HAL-RT", " allocated buffer for route message:%p"
+                     " nh_count:%lu", p_msg, max_nh);
+
+    *p_msg_ret = p_msg;
     return true;
 }
 
@@ -217,6 +269,26 @@ int fib_create_dr_tree (t_fib_vrf_info *p_vrf_info)
 
     std_radix_enable_radical (p_vrf_info->dr_tree);
 
+    /* The best fit lookups fall back to the dr_tree without the index */
+    p_vrf_info->p_dr_lpm = fib_lpm_create (FIB_AFINDEX_TO_PREFIX_LEN (p_vrf_info->af_index));
+    if (p_vrf_info->p_dr_lpm == NULL)
+    {
+        HAL_RT_LOG_ERR("HAL-RT-DR",
+                   "%s (): LPM index create failed. Vrf_id: %d, "
+                   "af_index: %s", __FUNCTION__, p_vrf_info->vrf_id,
+                   STD_IP_AFINDEX_TO_STR (p_vrf_info->af_index));
+    }
+
+    /* The exact lookups fall back to the dr_tree without the index */
+    p_vrf_info->p_dr_hash = fib_hash_create ();
+    if (p_vrf_info->p_dr_hash == NULL)
+    {
+        HAL_RT_LOG_ERR("HAL-RT-DR",
+                   "%s (): Hash index create failed. Vrf_id: %d, "
+                   "af_index: %s", __FUNCTION__, p_vrf_info->vrf_id,
+                   STD_IP_AFINDEX_TO_STR (p_vrf_info->af_index));
+    }
+
     return STD_ERR_OK;
 }
 
@@ -245,50 +317,49 @@ int fib_destroy_dr_tree (t_fib_vrf_info *p_vrf_info)
 
     p_vrf_info->dr_tree = NULL;
 
+    fib_lpm_destroy (p_vrf_info->p_dr_lpm);
+    p_vrf_info->p_dr_lpm = NULL;
+
+    fib_hash_destroy (p_vrf_info->p_dr_hash);
+    p_vrf_info->p_dr_hash = NULL;
+
     return STD_ERR_OK;
 }
 
-int fib_proc_dr_download (t_fib_route_entry *p_rt_entry, uint32_t nas_num_route_msgs_in_queue)
+/* Formats the address into the given buffer, unlike FIB_IP_ADDR_TO_STR
+ * it does not use the scratch buffers of the calling thread */
+static const char *fib_dr_validate_addr_str (const hal_ip_addr_t *p_addr, char *p_buf, size_t len)
 {
-    int           ix,nh_info_size = 0;
-    uint32_t      vrf_id = 0;
-    uint8_t       af_index = 0;
-    bool          rt_change = false, is_rt_replace = false, is_mgmt_intf = false;
-    hal_ifindex_t nh_if_index = 0;
-    static uint32_t num_route_msgs_processed_before_signalling_dr_walker = 0;
-    static bool     pending_dr_walker_thread_wakeup = false;
-
-    num_route_msgs_processed_before_signalling_dr_walker++;
+    const char *p_str = NULL;
 
-    vrf_id   = p_rt_entry->vrfid;
-    if ((!(FIB_IS_VRF_ID_VALID (vrf_id))) || (!(FIB_IS_VRF_ID_VALID (p_rt_entry->nh_vrfid)))) {
-        HAL_RT_LOG_INFO("HAL-RT-DR", "Invalid vrf_id. rt-vrf_id: %d nh-vrf-id:%lu",
-                       vrf_id, p_rt_entry->nh_vrfid);
-        return STD_ERR_OK;
+    if (p_addr->af_index == HAL_RT_V4_AFINDEX) {
+        p_str = inet_ntop (AF_INET, (const void *)&p_addr->u.v4_addr, p_buf, len);
+    } else if (p_addr->af_index == HAL_RT_V6_AFINDEX) {
+        p_str = inet_ntop (AF_INET6, (const void *)&p_addr->u.v6_addr, p_buf, len);
     }
+    return ((p_str) ? p_str : "");
+}
 
-    /* If VRF related info. already cleared, return success */
-    if ((hal_rt_is_vrf_valid(vrf_id) == false) || (hal_rt_is_vrf_valid(p_rt_entry->nh_vrfid) == false)) {
-        return STD_ERR_OK;
-    }
-    af_index = HAL_RT_ADDR_FAM_TO_AFINDEX(p_rt_entry->prefix.af_index);
+/*
+ * Validate the NH interfaces and the prefix of the route msg, the result is
+ * saved in the msg. The checks do not refer to the FIB, so the validation is
+ * done before the msg is queued and is kept off the nas_l3_lock.
+ * The interface checks query the nas-interface DB through
+ * dn_hal_get_interface_info, which is protected by the nas-interface lock,
+ * the FIB intf tree is not read here. The producer threads run it
+ * concurrently, so the addresses are logged from a local buffer.
+ */
+t_fib_rt_validation fib_proc_dr_validate (t_fib_route_entry *p_rt_entry)
+{
+    int           ix;
+    uint8_t       af_index = HAL_RT_ADDR_FAM_TO_AFINDEX(p_rt_entry->prefix.af_index);
+    bool          is_mgmt_intf = false;
+    hal_ifindex_t nh_if_index = 0;
+    hal_ip_addr_t prefix;
+    char          addr_str[INET6_ADDRSTRLEN];
 
-    /* if there are no more route msgs in queue and there is pending
-     * walker wakeup, then resume dr walker. This trigger is to handle
-     * cases where there were lots of invalid msgs after the min threshold
-     * was reached, but then didn't had a chance to wake up the walker
-     * due to invalid msgs.
-     */
-    if (pending_dr_walker_thread_wakeup && !nas_num_route_msgs_in_queue)
-        fib_resume_dr_walker_thread (af_index);
-    HAL_RT_LOG_INFO("HAL-RT-MSG", "Route %s rt-vrf:%s(%d), af-index:%d"
-                    " prefix:%s/%d nh-vrf:%s(%lu) nh_cnt:%lu distance:%d type:%d",
-                    ((p_rt_entry->msg_type == FIB_RT_MSG_ADD) ? "Add" :
-                     ((p_rt_entry->msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")),
-                    p_rt_entry->vrf_name, vrf_id, af_index, FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix),
-                    p_rt_entry->prefix_masklen, p_rt_entry->nh_vrf_name,
-                    p_rt_entry->nh_vrfid, p_rt_entry->hop_count,
-                    p_rt_entry->distance, p_rt_entry->rt_type);
+    p_rt_entry->validation = FIB_RT_VALIDATION_SKIP;
+    p_rt_entry->is_mgmt_intf = false;
 
     /*
      * Check for ECMP NHs and check for nh_if_index appropriately
@@ -308,11 +379,13 @@ int fib_proc_dr_download (t_fib_route_entry *p_rt_entry, uint32_t nas_num_route_
         for (ix=0; ix<p_rt_entry->hop_count; ix++) {
             nh_if_index = p_rt_entry->nh_list[ix].nh_if_index;
             if(hal_rt_validate_intf(p_rt_entry->nh_vrfid, nh_if_index, &is_mgmt_intf) != STD_ERR_OK) {
-                HAL_RT_LOG_INFO("HAL-RT", "Invalid interface, so skipping route add. msg_type: %d rt-vrf_id %d, af-index %d"
+                HAL_RT_LOG_INFO("HAL-RT", "Invalid interface, so skipping route add. msg_type: %d rt-vrf_id %lu, af-index %d"
                                 " nh-vrf-id:%lu nh_count %lu addr:%s on if_index %d",
-                                p_rt_entry->msg_type, vrf_id, af_index, p_rt_entry->nh_vrfid, p_rt_entry->hop_count,
-                                FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix), nh_if_index);
-                return STD_ERR_OK;
+                                p_rt_entry->msg_type, p_rt_entry->vrfid, af_index, p_rt_entry->nh_vrfid,
+                                p_rt_entry->hop_count,
+                                fib_dr_validate_addr_str(&p_rt_entry->prefix, addr_str, sizeof(addr_str)),
+                                nh_if_index);
+                return p_rt_entry->validation;
             }
         }
     } else if (STD_IP_IS_ADDR_LINK_LOCAL(&p_rt_entry->prefix)) {
@@ -321,37 +394,132 @@ int fib_proc_dr_download (t_fib_route_entry *p_rt_entry, uint32_t nas_num_route_
             if ((hal_rt_is_intf_lpbk(p_rt_entry->nh_vrfid, nh_if_index)) ||
                 (hal_rt_is_intf_mgmt(p_rt_entry->nh_vrfid, nh_if_index))) {
                 HAL_RT_LOG_INFO("HAL-RT", "skipping link local route with loopback/mgmt intf msg_type: %d"
-                                "rt-vrf_id %d, af-index %d"
+                                "rt-vrf_id %lu, af-index %d"
                                 " nh-vrf-id:%lu nh_count %lu addr:%s on if_index %d",
-                                p_rt_entry->msg_type, vrf_id, af_index, p_rt_entry->nh_vrfid, p_rt_entry->hop_count,
-                                FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix), nh_if_index);
-                return STD_ERR_OK;
+                                p_rt_entry->msg_type, p_rt_entry->vrfid, af_index, p_rt_entry->nh_vrfid,
+                                p_rt_entry->hop_count,
+                                fib_dr_validate_addr_str(&p_rt_entry->prefix, addr_str, sizeof(addr_str)),
+                                nh_if_index);
+                return p_rt_entry->validation;
             }
         }
     }
-    HAL_RT_LOG_DEBUG("HAL-RT", "type: %d vrf_id %d, af-index %d"
-                     " route count %d, nh_count %lu distance %d", p_rt_entry->msg_type,
-                     vrf_id, af_index, 1, p_rt_entry->hop_count, p_rt_entry->distance);
 
-    p_rt_entry->prefix.af_index = af_index;
-    if (hal_rt_is_reserved_ipv4(&p_rt_entry->prefix)) {
+    prefix = p_rt_entry->prefix;
+    prefix.af_index = af_index;
+    if (hal_rt_is_reserved_ipv4(&prefix)) {
         HAL_RT_LOG_DEBUG("HAL-RT-DR", "Skipping rsvd ipv4 addr %s on if_indx %d",
-                     FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix), nh_if_index);
-        return STD_ERR_OK;
+                     fib_dr_validate_addr_str(&prefix, addr_str, sizeof(addr_str)), nh_if_index);
+        return p_rt_entry->validation;
     }
 
-    if (hal_rt_is_reserved_ipv6(&p_rt_entry->prefix)) {
+    if (hal_rt_is_reserved_ipv6(&prefix)) {
         HAL_RT_LOG_DEBUG("HAL-RT-DR", "Skipping rsvd ipv6 addr %s on if_indx %d",
-                     FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix), nh_if_index);
+                     fib_dr_validate_addr_str(&prefix, addr_str, sizeof(addr_str)), nh_if_index);
+        return p_rt_entry->validation;
+    }
+
+    p_rt_entry->is_mgmt_intf = is_mgmt_intf;
+    p_rt_entry->validation = FIB_RT_VALIDATION_OK;
+    return p_rt_entry->validation;
+}
+
+/* Stamp the DR with its first route change not yet programmed by the walker */
+static inline void fib_dr_change_stamp (t_fib_dr *p_dr)
+{
+    if (p_dr->change_nsecs == 0) {
+        p_dr->change_nsecs = hal_rt_walker_clock_nsecs ();
+    }
+}
+
+/* Wake up the DR walker if the coalesce window is full, else have the walker
+ * sleep till the window expires for the first change of the window */
+static void fib_dr_walker_change_notify (uint8_t af_index)
+{
+    bool is_first = false;
+
+    if (hal_rt_walker_change_notify (FIB_WALKER_DR, &is_first)) {
+        fib_resume_dr_walker_thread (af_index);
+    } else if (is_first) {
+        pthread_mutex_lock (&fib_dr_mutex);
+        pthread_cond_signal (&fib_dr_cond);
+        pthread_mutex_unlock (&fib_dr_mutex);
+    }
+}
+
+/* Neighbor flush on the route prefix for the connected route replaced/deleted
+ * by a route msg coalesced into this msg at the msg queue */
+static void fib_proc_dr_coalesced_neigh_flush (t_fib_route_entry *p_rt_entry)
+{
+    t_fib_offload_msg *p_offload_msg = hal_rt_alloc_offload_msg ();
+
+    if (!p_offload_msg) {
+        HAL_RT_LOG_ERR ("HAL-RT", "Memory alloc failed for offload msg");
+        return;
+    }
+    memset (p_offload_msg, 0, sizeof (t_fib_offload_msg));
+    p_offload_msg->type = FIB_OFFLOAD_MSG_TYPE_NEIGH_FLUSH;
+    p_offload_msg->neigh_flush_msg.vrf_id = p_rt_entry->vrfid;
+    memcpy (&p_offload_msg->neigh_flush_msg.prefix, &p_rt_entry->prefix,
+            sizeof (p_offload_msg->neigh_flush_msg.prefix));
+    p_offload_msg->neigh_flush_msg.prefix_len = p_rt_entry->prefix_masklen;
+    p_offload_msg->neigh_flush_msg.is_neigh_flush_with_intf = false;
+
+    HAL_RT_LOG_DEBUG("HAL-RT", "Coalesced route neigh flush for vrf_id: %d, prefix: %s/%d",
+                     p_rt_entry->vrfid, FIB_IP_ADDR_TO_STR (&p_rt_entry->prefix),
+                     p_rt_entry->prefix_masklen);
+    nas_rt_process_offload_msg (p_offload_msg);
+}
+
+int fib_proc_dr_download (t_fib_route_entry *p_rt_entry)
+{
+    int           nh_info_size = 0;
+    uint32_t      vrf_id = 0;
+    uint8_t       af_index = 0;
+    bool          rt_change = false, is_rt_replace = false;
+
+    vrf_id   = p_rt_entry->vrfid;
+    if ((!(FIB_IS_VRF_ID_VALID (vrf_id))) || (!(FIB_IS_VRF_ID_VALID (p_rt_entry->nh_vrfid)))) {
+        HAL_RT_LOG_INFO("HAL-RT-DR", "Invalid vrf_id. rt-vrf_id: %d nh-vrf-id:%lu",
+                       vrf_id, p_rt_entry->nh_vrfid);
         return STD_ERR_OK;
     }
 
+    /* If VRF related info. already cleared, return success */
+    if ((hal_rt_is_vrf_valid(vrf_id) == false) || (hal_rt_is_vrf_valid(p_rt_entry->nh_vrfid) == false)) {
+        return STD_ERR_OK;
+    }
+    af_index = HAL_RT_ADDR_FAM_TO_AFINDEX(p_rt_entry->prefix.af_index);
+
+    HAL_RT_LOG_INFO("HAL-RT-MSG", "Route %s rt-vrf:%s(%d), af-index:%d"
+                    " prefix:%s/%d nh-vrf:%s(%lu) nh_cnt:%lu distance:%d type:%d",
+                    ((p_rt_entry->msg_type == FIB_RT_MSG_ADD) ? "Add" :
+                     ((p_rt_entry->msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")),
+                    p_rt_entry->vrf_name, vrf_id, af_index, FIB_IP_ADDR_TO_STR(&p_rt_entry->prefix),
+                    p_rt_entry->prefix_masklen, p_rt_entry->nh_vrf_name,
+                    p_rt_entry->nh_vrfid, p_rt_entry->hop_count,
+                    p_rt_entry->distance, p_rt_entry->rt_type);
+
+    /* The msgs queued by the producers are validated before queueing,
+     * only the msgs processed inline are validated here */
+    if (p_rt_entry->validation == FIB_RT_VALIDATION_NONE)
+        fib_proc_dr_validate (p_rt_entry);
+    if (p_rt_entry->validation != FIB_RT_VALIDATION_OK)
+        return STD_ERR_OK;
+
+    HAL_RT_LOG_DEBUG("HAL-RT", "type: %d vrf_id %d, af-index %d"
+                     " route count %d, nh_count %lu distance %d", p_rt_entry->msg_type,
+                     vrf_id, af_index, 1, p_rt_entry->hop_count, p_rt_entry->distance);
+
+    p_rt_entry->prefix.af_index = af_index;
+
     switch (p_rt_entry->msg_type) {
         case FIB_RT_MSG_UPD:
             is_rt_replace = true;
         case FIB_RT_MSG_ADD:
             FIB_INCR_CNTRS_ROUTE_ADD (vrf_id, af_index);
-            fib_proc_dr_add_msg (af_index, p_rt_entry, &nh_info_size, is_rt_replace, is_mgmt_intf);
+            fib_proc_dr_add_msg (af_index, p_rt_entry, &nh_info_size, is_rt_replace,
+                                 p_rt_entry->is_mgmt_intf);
             rt_change = true;
             break;
 
@@ -364,20 +532,118 @@ int fib_proc_dr_download (t_fib_route_entry *p_rt_entry, uint32_t nas_num_route_
             HAL_RT_LOG_ERR("HAL-RT-DR", "%s (): Invalid case. ", __FUNCTION__);
             break;
     }
+    if (rt_change && (p_rt_entry->coalesce_flags & FIB_RT_COALESCE_NEIGH_FLUSH)) {
+        fib_proc_dr_coalesced_neigh_flush (p_rt_entry);
+    }
     if(rt_change) {
-        /* Wake-up DR walker only after processing min. threshold percentage of
-         * route messages from the queue.
-         */
-        if (((nas_num_route_msgs_in_queue * NAS_RT_DR_WALKER_SIG_MIN_THRESHOLD_PERCENT/100)
-              < num_route_msgs_processed_before_signalling_dr_walker)) {
-        fib_resume_dr_walker_thread (af_index);
-            num_route_msgs_processed_before_signalling_dr_walker = 0;
-            pending_dr_walker_thread_wakeup = false;
-        } else {
-            pending_dr_walker_thread_wakeup = true;
+        /* The DR walker wakeups are coalesced over the route changes */
+        fib_dr_walker_change_notify (af_index);
+    }
+
+    return STD_ERR_OK;
+}
+
+/* Is the DR NH one of the NHs of the route msg */
+static bool fib_dr_nh_in_route_msg (uint8_t af_index, t_fib_route_entry *p_rt_entry,
+                                    t_fib_nh *p_nh)
+{
+    t_fib_nh_msg_info nh_msg_info;
+    size_t            i;
+
+    for (i = 0; i < p_rt_entry->hop_count; i++) {
+        fib_form_nh_msg_info (af_index, p_rt_entry, &nh_msg_info, i);
+        if (fib_get_nh (nh_msg_info.vrf_id, &nh_msg_info.ip_addr,
+                        nh_msg_info.if_index) == p_nh) {
+            return true;
         }
     }
+    return false;
+}
+
+/* First NH of the DR that is not in the route msg */
+static t_fib_nh *fib_dr_stale_nh_get (uint8_t af_index, t_fib_route_entry *p_rt_entry,
+                                      t_fib_dr *p_dr)
+{
+    t_fib_nh        *p_nh;
+    t_fib_nh_holder  nh_holder;
+
+    FIB_FOR_EACH_NH_FROM_DR (p_dr, p_nh, nh_holder) {
+        if (!fib_dr_nh_in_route_msg (af_index, p_rt_entry, p_nh))
+            return p_nh;
+    }
+    return NULL;
+}
+
+/*
+ * Resync the DR with the kernel route after the route msgs were dropped at
+ * the msg queue bounds. Only the route adds/updates are dropped at the bounds,
+ * so the kernel route is replayed as an add (appends the missing NHs) and the
+ * DR NHs not in the kernel route any more are deleted one at a time, leaving
+ * at least one NH on the DR. The DR is never replaced or deleted from here,
+ * so the DRs in sync are left untouched and no neighbor flush is triggered.
+ */
+int fib_proc_dr_resync (t_fib_route_entry *p_rt_entry)
+{
+    t_fib_dr_msg_info  dr_msg_info;
+    t_fib_dr          *p_dr;
+    t_fib_nh          *p_nh;
+    uint8_t            af_index;
+    struct {
+        t_fib_route_entry rt;
+        t_fib_nh_info     nh;
+    } stale_msg;
+
+    if ((!(FIB_IS_VRF_ID_VALID (p_rt_entry->vrfid))) ||
+        (!(FIB_IS_VRF_ID_VALID (p_rt_entry->nh_vrfid))) ||
+        (hal_rt_is_vrf_valid(p_rt_entry->vrfid) == false) ||
+        (hal_rt_is_vrf_valid(p_rt_entry->nh_vrfid) == false)) {
+        return STD_ERR_OK;
+    }
+    af_index = HAL_RT_ADDR_FAM_TO_AFINDEX(p_rt_entry->prefix.af_index);
+    fib_form_dr_msg_info (af_index, p_rt_entry, &dr_msg_info);
+
+    p_dr = fib_get_dr (dr_msg_info.vrf_id, &dr_msg_info.prefix, dr_msg_info.prefix_len);
+    if ((p_dr != NULL) && (p_dr->rt_type == dr_msg_info.rt_type) &&
+        (p_dr->proto == dr_msg_info.proto) &&
+        (p_dr->num_nh == p_rt_entry->hop_count) &&
+        (fib_dr_stale_nh_get (af_index, p_rt_entry, p_dr) == NULL)) {
+        return STD_ERR_OK;
+    }
+
+    p_rt_entry->msg_type = FIB_RT_MSG_ADD;
+    fib_proc_dr_download (p_rt_entry);
+
+    p_dr = fib_get_dr (dr_msg_info.vrf_id, &dr_msg_info.prefix, dr_msg_info.prefix_len);
+    if ((p_dr == NULL) || (p_rt_entry->hop_count == 0)) {
+        return STD_ERR_OK;
+    }
 
+    memset (&stale_msg, 0, sizeof (stale_msg));
+    memcpy (&stale_msg.rt, p_rt_entry, sizeof (stale_msg.rt));
+    stale_msg.rt.msg_type = FIB_RT_MSG_DEL;
+    stale_msg.rt.hop_count = 1;
+    while ((p_dr->num_nh > 1) &&
+           ((p_nh = fib_dr_stale_nh_get (af_index, p_rt_entry, p_dr)) != NULL)) {
+        HAL_RT_LOG_INFO("HAL-RT-RESYNC", "Stale NH vrf_id: %d, prefix: %s/%d, "
+                        "NH: vrf_id: %d, ip_addr: %s, if_index: %d", p_dr->vrf_id,
+                        FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+                        p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr),
+                        p_nh->key.if_index);
+        stale_msg.rt.nh_vrfid = p_nh->vrf_id;
+        stale_msg.rt.nh_list[0].nh_if_index = p_nh->key.if_index;
+        memcpy (&stale_msg.rt.nh_list[0].nh_addr, &p_nh->key.ip_addr,
+                sizeof (stale_msg.rt.nh_list[0].nh_addr));
+        fib_proc_dr_nh_del (p_dr, &stale_msg.rt);
+        if (fib_dr_stale_nh_get (af_index, p_rt_entry, p_dr) == p_nh) {
+            /* NH not deleted from the DR, leave it to the next kernel update */
+            break;
+        }
+        fib_updt_best_fit_dr_of_affected_nh (p_dr);
+        p_dr->status_flag |= FIB_DR_STATUS_ADD;
+        fib_dr_change_stamp (p_dr);
+        fib_mark_dr_for_resolution (p_dr);
+    }
+    fib_dr_walker_change_notify (af_index);
     return STD_ERR_OK;
 }
 
@@ -607,7 +873,6 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
         std_dll_init (&p_dr->nh_list);
         std_dll_init (&p_dr->fh_list);
         std_dll_init (&p_dr->dep_nh_list);
-        std_dll_init (&p_dr->degen_dr_fh.tunnel_fh_list);
 
         FIB_INCR_CNTRS_FIB_ROUTE_ENTRIES (dr_msg_info.vrf_id, af_index);
 
@@ -622,16 +887,20 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
         if (((t_fib_route_entry  *)p_rtm_fib_cmd)->msg_type != FIB_RT_MSG_ADD) {
             return STD_ERR_OK;
         }
+        t_fib_dr_cold *p_dr_cold = fib_get_dr_cold (p_dr);
+        if (p_dr_cold == NULL) {
+            return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+        }
         /* @@TODO If there is a duplicate link local route update from kernel,
          * this link local count will cause the stale RIF in the NPU,
          * Now, the assumption is, kernel wont notify duplicate link local route */
-        p_dr->num_ipv6_link_local++;
+        p_dr_cold->num_ipv6_link_local++;
         hal_ifindex_t if_index = ((t_fib_route_entry  *)p_rtm_fib_cmd)->nh_list[0].nh_if_index;
         HAL_RT_LOG_INFO("HAL-RT-LLA", "LLA add vrf_id: %d, prefix: %s/%d,"
                         " proto: %d out-if:%d updated link-local-cnt:%d route-present:%d RIF-ref-cnt:%d",
                         dr_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                         dr_msg_info.prefix_len, dr_msg_info.proto, if_index,
-                        p_dr->num_ipv6_link_local, is_route_present,
+                        p_dr_cold->num_ipv6_link_local, is_route_present,
                         hal_rt_rif_ref_get(dr_msg_info.vrf_id, if_index));
 
         t_fib_intf *p_intf = fib_get_intf (if_index, dr_msg_info.vrf_id, af_index);
@@ -658,7 +927,7 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
                            " proto: %d out-if:%d link-local-cnt:%d RIF-ref-cnt:%d route-present:%d RIF-ref-cnt:%d",
                         dr_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                         dr_msg_info.prefix_len, dr_msg_info.proto, if_index,
-                           p_dr->num_ipv6_link_local, p_dr->num_ipv6_rif_link_local, is_route_present,
+                           p_dr_cold->num_ipv6_link_local, p_dr_cold->num_ipv6_rif_link_local, is_route_present,
                            hal_rt_rif_ref_get(dr_msg_info.vrf_id, if_index));
 
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
@@ -668,7 +937,7 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
                            " proto: %d out-if:%d link-local-cnt:%d route-present:%d RIF-ref-cnt:%d",
                            dr_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                            dr_msg_info.prefix_len, dr_msg_info.proto, if_index,
-                           p_dr->num_ipv6_link_local, is_route_present,
+                           p_dr_cold->num_ipv6_link_local, is_route_present,
                            hal_rt_rif_ref_get(dr_msg_info.vrf_id, if_index));
 
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
@@ -682,13 +951,13 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
             (p_intf->admin_status == RT_INTF_ADMIN_STATUS_UP)) {
             if (hal_rif_index_get_or_create(0, dr_msg_info.vrf_id, if_index, &rif_id) == STD_ERR_OK) {
                 hal_rt_rif_ref_inc(dr_msg_info.vrf_id, if_index);
-                p_dr->num_ipv6_rif_link_local++;
+                p_dr_cold->num_ipv6_rif_link_local++;
             } else {
                 HAL_RT_LOG_ERR("HAL-RT-LLA", " RIF get failed for Route add vrf_id: %d, prefix: %s/%d,"
                                " proto: %d out-if:%d link-local-cnt:%d route-present:%d RIF-ref-cnt:%d",
                                dr_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                                dr_msg_info.prefix_len, dr_msg_info.proto, if_index,
-                               p_dr->num_ipv6_link_local, is_route_present,
+                               p_dr_cold->num_ipv6_link_local, is_route_present,
                                hal_rt_rif_ref_get(dr_msg_info.vrf_id, if_index));
             }
         }
@@ -766,6 +1035,7 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
     if (is_mgmt_route) {
         nas_route_publish_route(p_dr, (is_rt_replace ? FIB_RT_MSG_UPD : FIB_RT_MSG_ADD));
     }
+    fib_dr_change_stamp (p_dr);
     fib_mark_dr_for_resolution (p_dr);
 
     if (is_neigh_flush_required) {
@@ -845,13 +1115,17 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
     if ((p_dr->rt_type != RT_UNREACHABLE) &&
         (STD_IP_IS_ADDR_LINK_LOCAL(&dr_msg_info.prefix))) {
         hal_ifindex_t if_index = ((t_fib_route_entry  *)p_rtm_fib_cmd)->nh_list[0].nh_if_index;
+        t_fib_dr_cold *p_dr_cold = fib_get_dr_cold (p_dr);
+        if (p_dr_cold == NULL) {
+            return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+        }
 
         t_fib_intf *p_intf = fib_get_intf (if_index, dr_msg_info.vrf_id, af_index);
         if (p_intf == NULL) {
             HAL_RT_LOG_ERR("HAL-RT-LLA", "Invalid intf vrf_id: %d, prefix: %s/%d, "
                            " proto: %d out-if:%d link-local-cnt:%d RIF-ref-cnt:%d", p_dr->vrf_id,
                            FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
-                           dr_msg_info.proto, if_index, p_dr->num_ipv6_link_local,
+                           dr_msg_info.proto, if_index, p_dr_cold->num_ipv6_link_local,
                            hal_rt_rif_ref_get(p_dr->vrf_id, if_index));
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
         }
@@ -863,20 +1137,20 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
             HAL_RT_LOG_INFO("HAL-RT-LLA", "Invalid IP del vrf_id: %d, prefix: %s/%d, "
                            " proto: %d out-if:%d link-local-cnt:%d RIF-ref-cnt:%d", p_dr->vrf_id,
                            FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
-                           dr_msg_info.proto, if_index, p_dr->num_ipv6_link_local,
+                           dr_msg_info.proto, if_index, p_dr_cold->num_ipv6_link_local,
                            hal_rt_rif_ref_get(p_dr->vrf_id, if_index));
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
         }
 
-        if (p_dr->num_ipv6_link_local > 0)
-            p_dr->num_ipv6_link_local--;
+        if (p_dr_cold->num_ipv6_link_local > 0)
+            p_dr_cold->num_ipv6_link_local--;
 
         /* RIF ref count would have been decremented when the interface mode
          * changed from L3 to L2, but num_ipv6_link_local will still be intact
          * as it is tracking the kernel notification. So validation to be done
          * accordingly.
          */
-        if ((p_dr->num_ipv6_link_local > 0) &&
+        if ((p_dr_cold->num_ipv6_link_local > 0) &&
             (FIB_IS_INTF_MODE_L3 (p_intf->mode)) &&
             (hal_rt_rif_ref_get(p_dr->vrf_id, if_index) == -1)) {
             /* Looks like duplicate link local route delete,
@@ -890,7 +1164,7 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
                        " proto: %d out-if:%d intf-mode:%s link-local-cnt:%d RIF-ref-cnt:%d", p_dr->vrf_id,
                         FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
                        dr_msg_info.proto, if_index, hal_rt_intf_mode_to_str(p_intf->mode),
-                       p_dr->num_ipv6_link_local, hal_rt_rif_ref_get(p_dr->vrf_id, if_index));
+                       p_dr_cold->num_ipv6_link_local, hal_rt_rif_ref_get(p_dr->vrf_id, if_index));
 
         /* RIF ref count would have been decremented when the interface mode
          * changed from L3 to L2 or when interface admin changed
@@ -901,13 +1175,13 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
             (p_intf->admin_status == RT_INTF_ADMIN_STATUS_UP)) {
             if (!hal_rt_rif_ref_dec(p_dr->vrf_id, if_index))
                 hal_rif_index_remove(0, p_dr->vrf_id, if_index);
-            p_dr->num_ipv6_rif_link_local--;
+            p_dr_cold->num_ipv6_rif_link_local--;
         }
 
         /* If there are other interfaces using the link local route,
          * dont delete the route */
 
-        if (p_dr->num_ipv6_link_local > 0) {
+        if (p_dr_cold->num_ipv6_link_local > 0) {
             return STD_ERR_OK;
         }
     }
@@ -945,6 +1219,7 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
         if (p_dr->num_nh) {
             /* set ADD flag to trigger route download to walker */
             p_dr->status_flag |= FIB_DR_STATUS_ADD;
+            fib_dr_change_stamp (p_dr);
             fib_mark_dr_for_resolution (p_dr);
 
             return STD_ERR_OK;
@@ -960,7 +1235,7 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
          * sometimes there is a possibility that this NH would have been
          * already deleted from this Route, but both NH and Route might
          * still exists. In such cases, DR will not be present in NH
-         * dep_dr_tree and thus p_nh_dep_dr might be null.
+         * dep_dr_list and thus p_nh_dep_dr might be null.
          * So ignoring this failure here.
          */
         t_fib_nh_msg_info  nh_msg_info;
@@ -994,6 +1269,7 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
     // TODO This needs to revisited to handle the DR del in the DR walker
     // fib_mark_dr_for_resolution (p_dr);
     p_dr->status_flag |= FIB_DR_STATUS_DEL;
+    fib_dr_change_stamp (p_dr);
 
     /* On route delete, trigger neighbor flush for the route prefix and interface.
      * This is done for following cases:
@@ -1368,7 +1644,7 @@ int fib_proc_dr_nh_del (t_fib_dr *p_dr, void *p_rtm_fib_cmd)
              * sometimes there is a possibility that this NH would have been
              * already deleted from this Route, but both NH and Route might
              * still exists. In such cases, DR will not be present in NH
-             * dep_dr_tree and thus p_nh_dep_dr might be null.
+             * dep_dr_list and thus p_nh_dep_dr might be null.
              * So ignoring this failure here.
              */
             HAL_RT_LOG_DEBUG ("HAL-RT-DR",
@@ -1658,7 +1934,6 @@ int fib_add_default_dr (uint32_t vrf_id, uint8_t af_index)
     std_dll_init (&p_dr->nh_list);
     std_dll_init (&p_dr->fh_list);
     std_dll_init (&p_dr->dep_nh_list);
-    std_dll_init (&p_dr->degen_dr_fh.tunnel_fh_list);
 
     p_dr->vrf_id = vrf_id;
 
@@ -1724,7 +1999,6 @@ int fib_handle_default_link_local_route (uint32_t vrf_id, bool is_add)
         std_dll_init (&p_dr->nh_list);
         std_dll_init (&p_dr->fh_list);
         std_dll_init (&p_dr->dep_nh_list);
-        std_dll_init (&p_dr->degen_dr_fh.tunnel_fh_list);
 
         p_dr->vrf_id = vrf_id;
 
@@ -1751,6 +2025,105 @@ int fib_handle_default_link_local_route (uint32_t vrf_id, bool is_add)
     return STD_ERR_OK;
 }
 
+/* LPM index key of the address */
+static inline void fib_dr_lpm_key (const t_fib_ip_addr *p_ip_addr, t_fib_lpm_key *p_key)
+{
+    uint32_t ix = 0;
+
+    if (p_ip_addr->af_index == HAL_RT_V4_AFINDEX) {
+        p_key->hi = ((uint64_t) ntohl (p_ip_addr->u.v4_addr)) << 32;
+        p_key->lo = 0;
+        return;
+    }
+    p_key->hi = 0;
+    p_key->lo = 0;
+    for (ix = 0; ix < 8; ix++) {
+        p_key->hi = (p_key->hi << 8) | p_ip_addr->u.v6_addr[ix];
+        p_key->lo = (p_key->lo << 8) | p_ip_addr->u.v6_addr[ix + 8];
+    }
+}
+
+/* Keep the LPM index of the VRF in sync with the dr_tree */
+static void fib_dr_lpm_update (uint32_t vrf_id, t_fib_dr *p_dr, bool is_add)
+{
+    t_fib_vrf_info *p_vrf_info = FIB_GET_VRF_INFO (vrf_id, p_dr->key.prefix.af_index);
+    t_fib_lpm_key   key;
+
+    if ((p_vrf_info == NULL) || (!fib_lpm_is_valid (p_vrf_info->p_dr_lpm)))
+        return;
+
+    fib_dr_lpm_key (&p_dr->key.prefix, &key);
+    if (!is_add) {
+        fib_lpm_del (p_vrf_info->p_dr_lpm, &key, p_dr->prefix_len);
+    } else if (!fib_lpm_add (p_vrf_info->p_dr_lpm, &key, p_dr->prefix_len, p_dr)) {
+        HAL_RT_LOG_ERR("HAL-RT-DR", "LPM index update failed, best fit lookups "
+                       "fall back to the DR tree. vrf_id: %d, prefix: %s, prefix_len: %d",
+                       vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+    }
+}
+
+/* Hash index key of the DR, the prefix bits past the prefix length are not
+ * part of the key, as in the dr_tree */
+typedef struct {
+    t_fib_ip_addr prefix;
+    uint32_t      prefix_len;
+} t_fib_dr_hash_key;
+
+static inline uint32_t fib_dr_hash_key (const t_fib_ip_addr *p_prefix, uint8_t prefix_len,
+                                        t_fib_dr_hash_key *p_key)
+{
+    uint8_t *p_addr = (uint8_t *) &p_key->prefix.u;
+
+    if (prefix_len > (8 * sizeof (p_key->prefix.u)))
+        prefix_len = (8 * sizeof (p_key->prefix.u));
+
+    memset (p_key, 0, sizeof (t_fib_dr_hash_key));
+    p_key->prefix.af_index = p_prefix->af_index;
+    p_key->prefix_len = prefix_len;
+    memcpy (p_addr, &p_prefix->u, (prefix_len + 7) / 8);
+    if (prefix_len % 8)
+        p_addr[prefix_len / 8] &= (0xff << (8 - (prefix_len % 8)));
+
+    return fib_hash_key (p_key, sizeof (t_fib_dr_hash_key));
+}
+
+static bool fib_dr_hash_match (const void *p_val, const void *p_key)
+{
+    const t_fib_dr          *p_dr = (const t_fib_dr *) p_val;
+    const t_fib_dr_hash_key *p_dr_key = (const t_fib_dr_hash_key *) p_key;
+    const uint8_t           *p_addr = (const uint8_t *) &p_dr->key.prefix.u;
+    const uint8_t           *p_key_addr = (const uint8_t *) &p_dr_key->prefix.u;
+    uint32_t                 len = p_dr_key->prefix_len;
+
+    if ((p_dr->prefix_len != len) ||
+        (p_dr->key.prefix.af_index != p_dr_key->prefix.af_index) ||
+        (memcmp (p_addr, p_key_addr, len / 8) != 0))
+        return false;
+
+    return (((len % 8) == 0) ||
+            (((p_addr[len / 8] ^ p_key_addr[len / 8]) & (0xff << (8 - (len % 8))) & 0xff) == 0));
+}
+
+/* Keep the hash index of the VRF in sync with the dr_tree */
+static void fib_dr_hash_update (uint32_t vrf_id, t_fib_dr *p_dr, bool is_add)
+{
+    t_fib_vrf_info   *p_vrf_info = FIB_GET_VRF_INFO (vrf_id, p_dr->key.prefix.af_index);
+    t_fib_dr_hash_key key;
+    uint32_t          hash;
+
+    if ((p_vrf_info == NULL) || (!fib_hash_is_valid (p_vrf_info->p_dr_hash)))
+        return;
+
+    hash = fib_dr_hash_key (&p_dr->key.prefix, p_dr->prefix_len, &key);
+    if (!is_add) {
+        fib_hash_del (p_vrf_info->p_dr_hash, hash, p_dr);
+    } else if (!fib_hash_add (p_vrf_info->p_dr_hash, hash, p_dr)) {
+        HAL_RT_LOG_ERR("HAL-RT-DR", "Hash index update failed, exact lookups "
+                       "fall back to the DR tree. vrf_id: %d, prefix: %s, prefix_len: %d",
+                       vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+    }
+}
+
 t_fib_dr *fib_add_dr (uint32_t vrf_id, t_fib_ip_addr *p_prefix,
                   uint8_t prefix_len)
 {
@@ -1809,6 +2182,9 @@ t_fib_dr *fib_add_dr (uint32_t vrf_id, t_fib_ip_addr *p_prefix,
         return NULL;
     }
 
+    /* The new DR is on the change list of the DR tree */
+    hal_rt_walker_vrf_mark (FIB_WALKER_DR, vrf_id, af_index);
+
     if (p_radix_head != ((std_rt_head *)p_dr))
     {
         HAL_RT_LOG_DEBUG("HAL-RT-DR",
@@ -1821,15 +2197,22 @@ t_fib_dr *fib_add_dr (uint32_t vrf_id, t_fib_ip_addr *p_prefix,
 
         p_dr = (t_fib_dr *)p_radix_head;
     }
+    else
+    {
+        fib_dr_lpm_update (vrf_id, p_dr, true);
+        fib_dr_hash_update (vrf_id, p_dr, true);
+    }
 
     return p_dr;
 }
 
 t_fib_dr *fib_get_dr (uint32_t vrf_id, t_fib_ip_addr *p_prefix, uint8_t prefix_len)
 {
-    t_fib_dr      *p_dr = NULL;
-    t_fib_dr_key   key;
-    uint8_t        af_index = 0;
+    t_fib_dr          *p_dr = NULL;
+    t_fib_dr_key       key;
+    t_fib_dr_hash_key  hash_key;
+    t_fib_vrf_info    *p_vrf_info = NULL;
+    uint8_t            af_index = 0;
 
     if (!p_prefix)
     {
@@ -1847,13 +2230,25 @@ t_fib_dr *fib_get_dr (uint32_t vrf_id, t_fib_ip_addr *p_prefix, uint8_t prefix_l
 
     af_index = p_prefix->af_index;
 
-    memset (&key, 0, sizeof (t_fib_dr_key));
+    p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
 
-    memcpy (&key.prefix, p_prefix, sizeof (t_fib_ip_addr));
+    if ((p_vrf_info != NULL) && (fib_hash_is_valid (p_vrf_info->p_dr_hash)))
+    {
+        p_dr = (t_fib_dr *)
+            fib_hash_lookup (p_vrf_info->p_dr_hash,
+                             fib_dr_hash_key (p_prefix, prefix_len, &hash_key),
+                             fib_dr_hash_match, &hash_key);
+    }
+    else
+    {
+        memset (&key, 0, sizeof (t_fib_dr_key));
 
-    p_dr = (t_fib_dr *)
-        std_radix_getexact (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index),
-                          (uint8_t *)&key, FIB_GET_RDX_DR_KEY_LEN (p_prefix, prefix_len));
+        memcpy (&key.prefix, p_prefix, sizeof (t_fib_ip_addr));
+
+        p_dr = (t_fib_dr *)
+            std_radix_getexact (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index),
+                              (uint8_t *)&key, FIB_GET_RDX_DR_KEY_LEN (p_prefix, prefix_len));
+    }
 
     if (p_dr != NULL)
     {
@@ -1963,6 +2358,10 @@ int fib_del_dr (t_fib_dr *p_dr)
     vrf_id   = p_dr->vrf_id;
     af_index = p_dr->key.prefix.af_index;
 
+    fib_rslv_unlink (FIB_GET_VRF_INFO (vrf_id, af_index), &p_dr->rslv);
+
+    fib_dr_lpm_update (vrf_id, p_dr, false);
+    fib_dr_hash_update (vrf_id, p_dr, false);
     std_radix_remove (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index), (std_rt_head *)(&p_dr->radical));
 
     fib_free_dr_node (p_dr);
@@ -2063,6 +2462,10 @@ t_fib_dr_nh *fib_add_dr_nh (t_fib_dr *p_dr, t_fib_nh *p_nh, uint8_t *p_cur_nh_tl
 
     p_nh->dr_ref_count++;
 
+    /* Leaked route, both the VRFs are locked exclusive from now on */
+    if (p_dr->vrf_id != p_nh->vrf_id)
+        hal_rt_vrf_leak_ref_update (p_dr->vrf_id, p_nh->vrf_id, true);
+
     HAL_RT_LOG_DEBUG("HAL-RT-DR",
                "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                "nh_count: %d dr_ref_count: %d", p_nh->vrf_id,
@@ -2143,6 +2546,9 @@ int fib_del_dr_nh (t_fib_dr *p_dr, t_fib_dr_nh *p_dr_nh)
         {
             p_nh->dr_ref_count--;
         }
+
+        if (p_dr->vrf_id != p_nh->vrf_id)
+            hal_rt_vrf_leak_ref_update (p_dr->vrf_id, p_nh->vrf_id, false);
     }
 
     std_dll_remove (&p_dr->nh_list, &p_dr_nh->link_node.glue);
@@ -2534,6 +2940,7 @@ int fib_delete_all_dr_dep_nh (t_fib_dr *p_dr)
 int fib_add_dr_degen_fh (t_fib_dr *p_dr, t_fib_nh *p_fh, t_fib_tunnel_fh *p_tunnel_fh)
 {
     t_fib_tunnel_dr_fh *p_tunnel_dr_fh_node = NULL;
+    t_fib_dr_cold      *p_dr_cold = NULL;
 
     if ((!p_dr))
     {
@@ -2555,7 +2962,14 @@ int fib_add_dr_degen_fh (t_fib_dr *p_dr, t_fib_nh *p_fh, t_fib_tunnel_fh *p_tunn
                    p_fh->key.if_index);
     }
 
-    p_dr->degen_dr_fh.link_node.self = p_fh;
+    p_dr_cold = fib_get_dr_cold (p_dr);
+
+    if (p_dr_cold == NULL)
+    {
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+
+    p_dr_cold->degen_dr_fh.link_node.self = p_fh;
 
     if (p_tunnel_fh != NULL)
     {
@@ -2563,7 +2977,7 @@ int fib_add_dr_degen_fh (t_fib_dr *p_dr, t_fib_nh *p_fh, t_fib_tunnel_fh *p_tunn
 
         p_tunnel_dr_fh_node->link_node.self = p_tunnel_fh;
 
-        std_dll_insertatback (&(p_dr->degen_dr_fh.tunnel_fh_list),
+        std_dll_insertatback (&(p_dr_cold->degen_dr_fh.tunnel_fh_list),
                             &p_tunnel_dr_fh_node->link_node.glue);
     }
 
@@ -2586,7 +3000,7 @@ t_fib_nh *fib_get_dr_degen_fh (t_fib_dr *p_dr)
                p_dr->vrf_id,
                FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
 
-    return (p_dr->degen_dr_fh.link_node.self);
+    return ((t_fib_nh *) FIB_DR_COLD_FIELD (p_dr, degen_dr_fh.link_node.self));
 }
 
 int fib_del_dr_degen_fh (t_fib_dr *p_dr)
@@ -2608,14 +3022,19 @@ int fib_del_dr_degen_fh (t_fib_dr *p_dr)
                p_dr->vrf_id,
                FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
 
-    p_dr->degen_dr_fh.link_node.self = NULL;
+    if (p_dr->p_cold == NULL)
+    {
+        return STD_ERR_OK;
+    }
+
+    p_dr->p_cold->degen_dr_fh.link_node.self = NULL;
 
-    FIB_GET_FIRST_TUNNEL_FH_FROM_DRFH (&p_dr->degen_dr_fh, nh_holder);
+    FIB_GET_FIRST_TUNNEL_FH_FROM_DRFH (&p_dr->p_cold->degen_dr_fh, nh_holder);
     p_tunnel_dr_fh_node = FIB_GET_TUNNEL_DRFH_NODE_FROM_NH_HOLDER (nh_holder);
 
     if (p_tunnel_dr_fh_node != NULL)
     {
-        std_dll_remove (&p_dr->degen_dr_fh.tunnel_fh_list,
+        std_dll_remove (&p_dr->p_cold->degen_dr_fh.tunnel_fh_list,
                       &p_tunnel_dr_fh_node->link_node.glue);
 
         memset (p_tunnel_dr_fh_node, 0, sizeof (t_fib_tunnel_dr_fh));
@@ -2630,6 +3049,8 @@ t_fib_dr *fib_get_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr)
 {
     t_fib_dr       *p_best_fit_dr = NULL;
     uint8_t     af_index = 0;
+    t_fib_lpm      *p_lpm = NULL;
+    t_fib_lpm_key   key;
 
     if (!p_ip_addr)
     {
@@ -2638,6 +3059,13 @@ t_fib_dr *fib_get_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr)
 
     af_index = p_ip_addr->af_index;
 
+    p_lpm = FIB_GET_VRF_INFO (vrf_id, af_index)->p_dr_lpm;
+    if (fib_lpm_is_valid (p_lpm))
+    {
+        fib_dr_lpm_key (p_ip_addr, &key);
+        return ((t_fib_dr *) fib_lpm_lookup (p_lpm, &key));
+    }
+
     p_best_fit_dr = (t_fib_dr *)
         std_radix_getbest (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index),
                          (uint8_t *)p_ip_addr,
@@ -2649,122 +3077,204 @@ t_fib_dr *fib_get_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr)
 
 /* get Next best DR for the given route prefix. when a NH for a DR goes down,
  * for which tracking is on, then we need to find out
- * next best DR (with different route prefix length) and use that for NHT
+ * next best DR (with different route prefix length) and use that for NHT.
+ * The next best DR is strictly shorter than the given prefix length, so the
+ * DR of the prefix itself or a longer DR of the same address is not returned.
  */
-t_fib_dr *fib_get_next_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr)
+t_fib_dr *fib_get_next_best_fit_dr (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr,
+                                    uint8_t prefix_len)
 {
     t_fib_dr       *p_best_fit_dr = NULL;
     uint8_t     af_index = 0;
+    t_fib_lpm      *p_lpm = NULL;
+    t_fib_lpm_key   key;
 
-    if (!p_ip_addr)
+    if ((!p_ip_addr) || (prefix_len == 0))
     {
         return NULL;
     }
 
     af_index = p_ip_addr->af_index;
 
+    p_lpm = FIB_GET_VRF_INFO (vrf_id, af_index)->p_dr_lpm;
+    if (fib_lpm_is_valid (p_lpm))
+    {
+        fib_dr_lpm_key (p_ip_addr, &key);
+        return ((t_fib_dr *) fib_lpm_next_best (p_lpm, &key, prefix_len));
+    }
+
     p_best_fit_dr = (t_fib_dr *)
         std_radix_getnextbest (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index),
                          (uint8_t *)p_ip_addr,
-                         FIB_GET_RDX_DR_KEY_LEN (p_ip_addr,
-                         FIB_AFINDEX_TO_PREFIX_LEN (af_index)));
+                         FIB_GET_RDX_DR_KEY_LEN (p_ip_addr, prefix_len));
 
     return p_best_fit_dr;
 }
 
 int fib_dr_walker_init (void)
 {
+    pthread_condattr_t cond_attr;
+
     pthread_mutex_init(&fib_dr_mutex, NULL);
-    pthread_cond_init (&fib_dr_cond, NULL);
+    /* The coalesce window expiry is on the monotonic clock (steady_clock) */
+    pthread_condattr_init (&cond_attr);
+    pthread_condattr_setclock (&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init (&fib_dr_cond, &cond_attr);
+    pthread_condattr_destroy (&cond_attr);
 
     return STD_ERR_OK;
 }
 
-int fib_dr_walker_main (void)
+/* Walk a batch of the DR changes of the VRF with the VRF locked, returns the
+ * no. of DRs processed and whether the VRF has more changes pending */
+static uint32_t fib_dr_walker_walk_vrf (uint32_t vrf_id, uint8_t af_index, bool *p_is_more)
 {
-    t_fib_vrf_info         *p_vrf_info = NULL;
-    std_radix_version_t  marker_version = 0;
-    std_radix_version_t  max_version = 0;
+    t_fib_vrf_info      *p_vrf_info = NULL;
     std_radix_version_t  max_walker_version = 0;
+    uint32_t             num_dr_processed = 0;
+    uint32_t             batch_size = FIB_WALKER_INIT_BATCH;
+    uint64_t             batch_start = 0;
+    uint32_t             num_propagated = 0;
+    t_fib_rslv_burst     burst;
+    int                  rc = STD_ERR_OK;
+    t_fib_vrf_lock_mode  lock_mode = FIB_VRF_LOCK_NONE;
+
+    *p_is_more = false;
+
+    /* Only this VRF is locked, the other VRFs are updated concurrently */
+    lock_mode = nas_l3_vrf_lock(vrf_id);
+    if (hal_rt_access_fib_vrf(vrf_id) != NULL) {
+        p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
+    }
+    if (p_vrf_info == NULL) {
+        HAL_RT_LOG_DEBUG("HAL-RT-DR", "Vrf info NULL. "
+                         "vrf_id: %d, af_index: %d", vrf_id, af_index);
+
+        /* VRF deleted after its changes were marked */
+        hal_rt_walker_vrf_done (FIB_WALKER_DR, vrf_id, af_index, 0, true);
+        nas_l3_vrf_unlock(vrf_id, lock_mode);
+        return 0;
+    }
+
+    p_vrf_info->num_dr_processed_by_walker = 0;
+
+    if (p_vrf_info->dr_clear_on == true) {
+        max_walker_version = p_vrf_info->dr_clear_max_radix_ver;
+    }
+    else if (p_vrf_info->dr_ha_on == true) {
+        max_walker_version = p_vrf_info->dr_ha_max_radix_ver;
+    }
+    else {
+        max_walker_version = std_radix_getversion (p_vrf_info->dr_tree);
+    }
+
+    /* Process a maximum of batch_size nodes per vrf, the batch size
+     * is adapted to the walker time budget per lock hold */
+    batch_size = hal_rt_walker_batch_size_get (FIB_WALKER_DR);
+    batch_start = hal_rt_walker_batch_start ();
+
+    /* The changed DRs and the NHs/DRs depending on them are resolved in
+     * this lock hold, the changes are not propagated during a clear/HA */
+    fib_rslv_burst_start (p_vrf_info, &burst,
+                          ((!p_vrf_info->dr_clear_on) && (!p_vrf_info->dr_ha_on) &&
+                           (!p_vrf_info->nh_clear_on) && (!p_vrf_info->nh_ha_on) &&
+                           (!p_vrf_info->clear_ip_fib_on) && (!p_vrf_info->clear_arp_on)));
+    std_radical_walkchangelist (p_vrf_info->dr_tree,
+                                &p_vrf_info->dr_radical_marker,
+                                fib_dr_walker_call_back,
+                                0,
+                                batch_size,
+                                max_walker_version,
+                                &rc);
+    /* The burst gets what is left of the time budget after the walk */
+    fib_rslv_burst_run (p_vrf_info, &burst, hal_rt_walker_batch_deadline (batch_start));
+    num_propagated = burst.num_nodes - burst.num_seeds;
+
+    /*
+     * 'p_vrf_info->num_dr_processed_by_walker' is updated in
+     * fib_dr_walker_call_back ().
+     */
+    num_dr_processed = p_vrf_info->num_dr_processed_by_walker;
+    hal_rt_walker_batch_end (FIB_WALKER_DR, batch_start, num_dr_processed + num_propagated,
+                             batch_size);
+    hal_rt_walker_rslv_end (FIB_WALKER_DR, num_propagated, burst.num_deferred + burst.num_left,
+                            burst.num_parallel);
+
+    /* A partial batch means the walk caught up with the changes of the VRF,
+     * unless the burst left nodes on the changelists at the time budget */
+    *p_is_more = ((num_dr_processed >= batch_size) || (burst.num_left != 0));
+    hal_rt_walker_vrf_done (FIB_WALKER_DR, vrf_id, af_index, num_dr_processed, !(*p_is_more));
+    nas_l3_vrf_unlock(vrf_id, lock_mode);
+
+    return num_dr_processed;
+}
+
+int fib_dr_walker_main (void)
+{
     uint32_t             tot_dr_processed = 0;
-    uint32_t             num_active_vrfs = 0;
+    uint32_t             num_dirty_vrfs = 0;
+    uint64_t             tot_backlog = 0;
+    uint32_t             num_batches = 0;
+    uint32_t             batch = 0;
     uint32_t             vrf_id = 0;
     int                  af_index = 0;
-    int                  rc = STD_ERR_OK;
+    bool                 is_more = false;
+    bool                 is_time_wakeup = false;
+    uint64_t             deadline = 0;
+    struct timespec      deadline_ts;
 
     for ( ; ;)
     {
         pthread_mutex_lock( &fib_dr_mutex );
+        /* Woken up on the signal, or at the expiry of the coalesce window of
+         * the route changes, the window is armed with a signal as well */
+        is_time_wakeup = false;
         while (is_dr_pending_for_processing == 0) // check predicate for signal before wait
         {
-            pthread_cond_wait( &fib_dr_cond, &fib_dr_mutex );
+            deadline = hal_rt_walker_coalesce_deadline (FIB_WALKER_DR);
+            if (deadline == 0) {
+                pthread_cond_wait( &fib_dr_cond, &fib_dr_mutex );
+            } else if (hal_rt_walker_clock_nsecs () >= deadline) {
+                is_time_wakeup = true;
+                break;
+            } else {
+                deadline_ts.tv_sec = deadline / 1000000000;
+                deadline_ts.tv_nsec = deadline % 1000000000;
+                pthread_cond_timedwait( &fib_dr_cond, &fib_dr_mutex, &deadline_ts );
+            }
         }
         is_dr_pending_for_processing = 0; //reset the predicate for signal
+        hal_rt_walker_coalesce_reset (FIB_WALKER_DR, is_time_wakeup);
         pthread_mutex_unlock( &fib_dr_mutex );
 
         tot_dr_processed = 0;
-        num_active_vrfs  = 0;
 
-        for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
-            for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
-                nas_l3_lock();
-                if (hal_rt_access_fib_vrf(vrf_id) == NULL) {
-                    nas_l3_unlock();
-                    break;
-                }
-
-                p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
-                if (p_vrf_info == NULL){
-                    HAL_RT_LOG_DEBUG("HAL-RT-DR", "Vrf info NULL. "
-                                     "vrf_id: %d, af_index: %d", vrf_id, af_index);
-
-                    nas_l3_unlock();
-                    continue;
-                }
-
-                p_vrf_info->num_dr_processed_by_walker = 0;
-
-                if (p_vrf_info->dr_clear_on == true) {
-                    max_walker_version = p_vrf_info->dr_clear_max_radix_ver;
-                }
-                else if (p_vrf_info->dr_ha_on == true) {
-                    max_walker_version = p_vrf_info->dr_ha_max_radix_ver;
-                }
-                else {
-                    max_walker_version = std_radix_getversion (p_vrf_info->dr_tree);
-                }
-
-                /* Process a maximum of FIB_DR_WALKER_COUNT nodes per vrf */
-
-                std_radical_walkchangelist (p_vrf_info->dr_tree,
-                                            &p_vrf_info->dr_radical_marker,
-                                            fib_dr_walker_call_back,
-                                            0,
-                                            FIB_DR_WALKER_COUNT,
-                                            max_walker_version,
-                                            &rc);
-
-                /* @TODO: Need to handle version wrap */
-                max_version    = std_radix_getversion (p_vrf_info->dr_tree);
-                marker_version = p_vrf_info->dr_radical_marker.rth_version;
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            /* Only the VRFs with DR changes are walked, a VRF gets lock holds
+             * in the pass in proportion to its share of the backlog */
+            num_dirty_vrfs = 0;
+            tot_backlog = 0;
+            for (vrf_id = FIB_MIN_VRF;
+                 hal_rt_walker_vrf_next (FIB_WALKER_DR, af_index, &vrf_id); vrf_id++) {
+                num_dirty_vrfs++;
+                tot_backlog += hal_rt_walker_vrf_backlog_get (FIB_WALKER_DR, vrf_id, af_index);
+            }
 
-                if (marker_version != max_version) {
-                    num_active_vrfs++;
+            for (vrf_id = FIB_MIN_VRF;
+                 hal_rt_walker_vrf_next (FIB_WALKER_DR, af_index, &vrf_id); vrf_id++) {
+                num_batches = hal_rt_walker_vrf_batches_get (FIB_WALKER_DR, vrf_id, af_index,
+                                                             num_dirty_vrfs, tot_backlog);
+                is_more = true;
+                for (batch = 0; (batch < num_batches) && is_more; batch++) {
+                    tot_dr_processed += fib_dr_walker_walk_vrf (vrf_id, af_index, &is_more);
                 }
-
-                /*
-                 * 'p_vrf_info->num_dr_processed_by_walker' is updated in
-                 * fib_dr_walker_call_back ().
-                 */
-                if (p_vrf_info->num_dr_processed_by_walker == FIB_DR_WALKER_COUNT) {
+                if (is_more) {
                     HAL_RT_LOG_DEBUG("HAL-RT-DR", "Max DR processed %d per walk, relinquish now",
                                      tot_dr_processed);
                     is_dr_pending_for_processing = true;
                 }
-                tot_dr_processed += p_vrf_info->num_dr_processed_by_walker;
-                nas_l3_unlock();
             }
-        }  /* End of vrf loop */
+        }  /* End of AF loop */
 
         HAL_RT_LOG_DEBUG("HAL-RT-DR", "Total DR processed %d",  tot_dr_processed);
 
@@ -2837,10 +3347,34 @@ int fib_dr_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
         return STD_ERR_OK;
     }
 
+    /* Resolved by a burst since it was marked */
+    if (p_dr->rslv.state & FIB_RSLV_STATE_RESOLVED) {
+        p_dr->rslv.state &= ~FIB_RSLV_STATE_RESOLVED;
+        if (!(p_dr->status_flag & FIB_DR_STATUS_DEL)) {
+            return STD_ERR_OK;
+        }
+    }
+
+    /* Resolved with its dependents after the changelist walk */
+    if (fib_rslv_seed (p_vrf_info, &p_dr->rslv, FIB_RSLV_NODE_DR, p_dr)) {
+        return STD_ERR_OK;
+    }
+
+    return fib_dr_rslv_process (p_dr, NULL);
+}
+
+/* Resolve the DR with the FH set computed by the resolution workers, or
+ * computed here if NULL */
+int fib_dr_rslv_process (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set)
+{
+    /* Taken before the DR is freed by the delete */
+    uint64_t change_nsecs = p_dr->change_nsecs;
+
+    p_dr->change_nsecs = 0;
     if (p_dr->status_flag & FIB_DR_STATUS_DEL) {
         fib_proc_dr_del (p_dr);
     } else {
-        fib_resolve_dr (p_dr);
+        fib_resolve_dr_fh_set (p_dr, p_fh_set);
 
         fib_mark_dr_dep_nh_for_resolution (p_dr);
 
@@ -2854,16 +3388,109 @@ int fib_dr_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
                      p_dr->prefix_len, p_dr->status_flag);
     }
 
+    if (change_nsecs != 0) {
+        hal_rt_walker_convergence_record (change_nsecs);
+    }
+
     return STD_ERR_OK;
 }
 
-int fib_resolve_dr (t_fib_dr *p_dr)
+void fib_dr_fh_set_init (t_fib_dr_fh_set *p_fh_set)
+{
+    p_fh_set->num_fh = 0;
+    p_fh_set->max_fh = FIB_DR_FH_SET_INLINE_FHS;
+    p_fh_set->p_fh = p_fh_set->a_fh;
+}
+
+void fib_dr_fh_set_free (t_fib_dr_fh_set *p_fh_set)
+{
+    if (p_fh_set->p_fh != p_fh_set->a_fh) {
+        free (p_fh_set->p_fh);
+    }
+    fib_dr_fh_set_init (p_fh_set);
+}
+
+static bool fib_dr_fh_set_add (t_fib_dr_fh_set *p_fh_set, t_fib_nh *p_fh)
+{
+    t_fib_nh **p_new_fh = NULL;
+    uint32_t   ix = 0;
+
+    for (ix = 0; ix < p_fh_set->num_fh; ix++) {
+        if (p_fh_set->p_fh[ix] == p_fh) {
+            return true;
+        }
+    }
+
+    if (p_fh_set->num_fh == p_fh_set->max_fh) {
+        p_new_fh = (t_fib_nh **) malloc (2 * p_fh_set->max_fh * sizeof (t_fib_nh *));
+        if (p_new_fh == NULL) {
+            return false;
+        }
+        memcpy (p_new_fh, p_fh_set->p_fh, p_fh_set->num_fh * sizeof (t_fib_nh *));
+        if (p_fh_set->p_fh != p_fh_set->a_fh) {
+            free (p_fh_set->p_fh);
+        }
+        p_fh_set->p_fh = p_new_fh;
+        p_fh_set->max_fh *= 2;
+    }
+    p_fh_set->p_fh[p_fh_set->num_fh++] = p_fh;
+
+    return true;
+}
+
+/* FH set of the DR from its resolved NHs, the DR and NH nodes are only read.
+ * The set is cut short if it can not be grown. */
+void fib_dr_fh_set_compute (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set)
 {
-    t_fib_dr_fh    *p_dr_fh = NULL;
     t_fib_nh       *p_nh = NULL;
     t_fib_nh       *p_fh = NULL;
     t_fib_nh_holder nh_holder1;
     t_fib_nh_holder nh_holder2;
+
+    FIB_FOR_EACH_NH_FROM_DR (p_dr, p_nh, nh_holder1)
+    {
+        if (FIB_IS_NH_REQ_RESOLVE (p_nh))
+        {
+            continue;
+        }
+
+        /* First Hop */
+        if (FIB_IS_NH_FH (p_nh))
+        {
+            if (!fib_dr_fh_set_add (p_fh_set, p_nh))
+            {
+                return;
+            }
+        }
+        else /* Next Hop */
+        {
+            FIB_FOR_EACH_FH_FROM_NH (p_nh, p_fh, nh_holder2)
+            {
+                if ((FIB_IS_NH_REQ_RESOLVE (p_fh)) || (!FIB_IS_NH_FH (p_fh)))
+                {
+                    continue;
+                }
+                if (!fib_dr_fh_set_add (p_fh_set, p_fh))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+int fib_resolve_dr (t_fib_dr *p_dr)
+{
+    return fib_resolve_dr_fh_set (p_dr, NULL);
+}
+
+/* Resolve the DR with the given FH set, computed here if NULL */
+int fib_resolve_dr_fh_set (t_fib_dr *p_dr, t_fib_dr_fh_set *p_fh_set)
+{
+    t_fib_dr_fh    *p_dr_fh = NULL;
+    t_fib_nh       *p_fh = NULL;
+    t_fib_dr_fh_set fh_set;
+    uint32_t        ix = 0;
     dn_hal_route_err   hal_err = DN_HAL_ROUTE_E_NONE;
     const           t_fib_config *p_config = NULL;
 
@@ -2883,133 +3510,42 @@ int fib_resolve_dr (t_fib_dr *p_dr)
                FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
 
 
+    if (p_fh_set == NULL)
+    {
+        p_fh_set = &fh_set;
+        fib_dr_fh_set_init (p_fh_set);
+        fib_dr_fh_set_compute (p_dr, p_fh_set);
+    }
+
     fib_delete_all_dr_fh (p_dr);
 
     fib_del_dr_degen_fh (p_dr);
 
     p_dr->status_flag &= ~FIB_DR_STATUS_DEGENERATED;
 
-    FIB_FOR_EACH_NH_FROM_DR (p_dr, p_nh, nh_holder1)
+    for (ix = 0; ix < p_fh_set->num_fh; ix++)
     {
-        HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                   "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                   p_nh->vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
+        p_fh = p_fh_set->p_fh[ix];
 
-        if (FIB_IS_NH_REQ_RESOLVE (p_nh))
-        {
-            HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                       "NH in request resolve state. "
-                       "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                       p_nh->vrf_id,
-                       FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-            continue;
-        }
+        p_dr_fh = fib_add_dr_fh (p_dr, p_fh);
 
-        /* First Hop */
-        if (FIB_IS_NH_FH (p_nh))
+        if (p_dr_fh == NULL)
         {
-            p_dr_fh = fib_get_dr_fh (p_dr, p_nh);
-
-            if (p_dr_fh != NULL)
-            {
-                HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                           "Duplicate DRFH. "
-                           "DR: vrf_id: %d, prefix: %s, prefix_len: %d, "
-                           "FH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                           p_dr->vrf_id,
-                           FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
-                           p_dr->prefix_len, p_nh->vrf_id,
-                           FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr),
-                           p_nh->key.if_index);
-
-                continue;
-            }
-
-            p_dr_fh = fib_add_dr_fh (p_dr, p_nh);
-
-            if (p_dr_fh == NULL)
-            {
-                HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                           "DRFH addition failed. "
-                           "DR: vrf_id: %d, prefix: %s, prefix_len: %d, "
-                           "FH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                           p_dr->vrf_id,
-                           FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
-                           p_dr->prefix_len, p_nh->vrf_id,
-                           FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr),
-                           p_nh->key.if_index);
-
-                continue;
-            }
+            HAL_RT_LOG_DEBUG("HAL-RT-DR",
+                       "DRFH addition failed. "
+                       "DR: vrf_id: %d, prefix: %s, prefix_len: %d, "
+                       "FH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
+                       p_dr->vrf_id,
+                       FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                       p_dr->prefix_len, p_fh->vrf_id,
+                       FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
+                       p_fh->key.if_index);
         }
-        else /* Next Hop */
-        {
-            FIB_FOR_EACH_FH_FROM_NH (p_nh, p_fh, nh_holder2)
-            {
-                HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                           "FH: vrf_id: %d, ip_addr: %s, "
-                           "if_index: 0x%x",
-                           p_fh->vrf_id,
-                           FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
-                           p_fh->key.if_index);
-
-                if (FIB_IS_NH_REQ_RESOLVE (p_fh))
-                {
-                    HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                               "FH in request resolve state. "
-                               "FH: vrf_id: %d, ip_addr: %s, "
-                               "if_index: 0x%x",
-                               p_fh->vrf_id,
-                               FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
-                               p_fh->key.if_index);
-
-                    continue;
-                }
-
-                if (FIB_IS_NH_FH (p_fh))
-                {
-                    p_dr_fh = fib_get_dr_fh (p_dr, p_fh);
-
-                    if (p_dr_fh != NULL)
-                    {
-                        HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                                   "Duplicate DRFH. "
-                                   "DR: vrf_id: %d, prefix: %s, "
-                                   "prefix_len: %d, "
-                                   "FH: vrf_id: %d, ip_addr: %s, "
-                                   "if_index: 0x%x",
-                                   p_dr->vrf_id,
-                                   FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
-                                   p_dr->prefix_len, p_fh->vrf_id,
-                                   FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
-                                   p_fh->key.if_index);
-
-                        continue;
-                    }
-
-                    p_dr_fh = fib_add_dr_fh (p_dr, p_fh);
+    }
 
-                    if (p_dr_fh == NULL)
-                    {
-                        HAL_RT_LOG_DEBUG("HAL-RT-DR",
-                                   "DRFH addition failed. "
-                                   "DR: vrf_id: %d, prefix: %s, "
-                                   "prefix_len: %d, "
-                                   "FH: vrf_id: %d, ip_addr: %s, "
-                                   "if_index: 0x%x",
-                                   p_dr->vrf_id,
-                                   FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
-                                   p_dr->prefix_len, p_fh->vrf_id,
-                                   FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
-                                   p_fh->key.if_index);
-
-                        continue;
-                    }
-                }
-            }
-        }
+    if (p_fh_set == &fh_set)
+    {
+        fib_dr_fh_set_free (&fh_set);
     }
 
     HAL_RT_LOG_DEBUG("HAL-RT-DR",
@@ -3353,8 +3889,15 @@ int fib_mark_dr_for_resolution (t_fib_dr *p_dr)
     af_index = p_dr->key.prefix.af_index;
     vrf_id   = p_dr->vrf_id;
 
+    /* Resolved in the burst of the walker holding the VRF */
+    if (fib_rslv_mark (FIB_GET_VRF_INFO (vrf_id, af_index), &p_dr->rslv,
+                       FIB_RSLV_NODE_DR, p_dr)) {
+        return STD_ERR_OK;
+    }
+
     std_radical_appendtochangelist (hal_rt_access_fib_vrf_dr_tree(vrf_id, af_index),
                                   (std_radical_head_t *)&(p_dr->radical));
+    hal_rt_walker_vrf_mark (FIB_WALKER_DR, vrf_id, af_index);
 
 
     //fib_resume_dr_walker_thread (af_index);
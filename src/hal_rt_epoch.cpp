@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_epoch.cpp
+ * \brief  Epoch based deferred reclamation of the FIB DR/NH nodes
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_main.h"
+#include "hal_rt_mem.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "hal_rt_epoch.h"
+
+#include <limits>
+
+static auto &hal_rt_epoch = *new hal_rt_epoch_t;
+
+/* Reader slot of the thread, the read section nesting depth and the nodes
+ * retired by the thread not yet flushed to the reclaim list. The slot and
+ * the batch are given back at the thread exit. */
+typedef struct hal_rt_epoch_thread_s {
+    int      slot = -1;
+    uint32_t depth = 0;
+    std::list<hal_rt_epoch_t::retired_node_t> retire_batch;
+
+    ~hal_rt_epoch_thread_s () { hal_rt_epoch.thread_exit (); }
+} hal_rt_epoch_thread_t;
+
+static thread_local hal_rt_epoch_thread_t hal_rt_epoch_thread;
+
+hal_rt_epoch_t::hal_rt_epoch_t ()
+{
+    /* Epoch 0 marks an idle reader slot */
+    m_epoch.store (1, std::memory_order_relaxed);
+    for (int ix = 0; ix < HAL_RT_EPOCH_MAX_READERS; ix++) {
+        m_readers[ix].in_use.store (false, std::memory_order_relaxed);
+        m_readers[ix].epoch.store (0, std::memory_order_relaxed);
+    }
+    m_pending.store (0, std::memory_order_relaxed);
+    m_retired.store (0, std::memory_order_relaxed);
+    m_reclaimed.store (0, std::memory_order_relaxed);
+}
+
+int hal_rt_epoch_t::slot_get ()
+{
+    if (hal_rt_epoch_thread.slot >= 0)
+        return hal_rt_epoch_thread.slot;
+
+    for (int ix = 0; ix < HAL_RT_EPOCH_MAX_READERS; ix++) {
+        bool in_use = false;
+        if (m_readers[ix].in_use.compare_exchange_strong (in_use, true)) {
+            hal_rt_epoch_thread.slot = ix;
+            return ix;
+        }
+    }
+    return -1;
+}
+
+bool hal_rt_epoch_t::enter ()
+{
+    int slot = slot_get ();
+    if (slot < 0) {
+        return false;
+    }
+    if (hal_rt_epoch_thread.depth++ == 0) {
+        /* The nodes are looked up only with their VRF locked, a node unlinked
+         * before the reader takes the lock can not be reached by the reader,
+         * so the slot can be published after reading the global epoch */
+        m_readers[slot].epoch.store (m_epoch.load (std::memory_order_seq_cst),
+                                     std::memory_order_seq_cst);
+    }
+    return true;
+}
+
+void hal_rt_epoch_t::exit ()
+{
+    if ((hal_rt_epoch_thread.slot < 0) || (hal_rt_epoch_thread.depth == 0))
+        return;
+
+    if (--hal_rt_epoch_thread.depth == 0) {
+        m_readers[hal_rt_epoch_thread.slot].epoch.store (0, std::memory_order_release);
+    }
+}
+
+void hal_rt_epoch_t::thread_exit ()
+{
+    int slot = hal_rt_epoch_thread.slot;
+
+    retire_flush ();
+    if (slot < 0)
+        return;
+    hal_rt_epoch_thread.slot = -1;
+    hal_rt_epoch_thread.depth = 0;
+    m_readers[slot].epoch.store (0, std::memory_order_release);
+    m_readers[slot].in_use.store (false, std::memory_order_release);
+}
+
+void hal_rt_epoch_t::retire (void *p_node, hal_rt_epoch_free_fn_t free_fn)
+{
+    std::list<retired_node_t> &batch = hal_rt_epoch_thread.retire_batch;
+
+    /* The retire epoch is taken at the flush of the batch */
+    batch.push_back ({p_node, free_fn, 0});
+    m_retired.fetch_add (1, std::memory_order_relaxed);
+
+    if (batch.size () >= HAL_RT_EPOCH_RETIRE_BATCH) {
+        retire_flush ();
+    }
+}
+
+void hal_rt_epoch_t::retire_flush ()
+{
+    std::list<retired_node_t> &batch = hal_rt_epoch_thread.retire_batch;
+    size_t cnt = batch.size (), pending = 0;
+
+    if (cnt == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock (m_retire_mutex);
+        /* Readers entering from now on can not reach the nodes of the batch */
+        uint64_t epoch = m_epoch.fetch_add (1, std::memory_order_seq_cst);
+        for (retired_node_t &node : batch) {
+            node.epoch = epoch;
+        }
+        m_retire_list.splice (m_retire_list.end (), batch);
+        pending = m_pending.fetch_add (cnt, std::memory_order_relaxed) + cnt;
+    }
+
+    if (pending >= HAL_RT_EPOCH_RECLAIM_THRESHOLD) {
+        reclaim ();
+    }
+}
+
+uint64_t hal_rt_epoch_t::min_reader_epoch () const
+{
+    uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+
+    for (int ix = 0; ix < HAL_RT_EPOCH_MAX_READERS; ix++) {
+        uint64_t epoch = m_readers[ix].epoch.load (std::memory_order_seq_cst);
+        if ((epoch != 0) && (epoch < min_epoch)) {
+            min_epoch = epoch;
+        }
+    }
+    return min_epoch;
+}
+
+void hal_rt_epoch_t::reclaim ()
+{
+    retire_flush ();
+    if (m_pending.load (std::memory_order_relaxed) == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock (m_retire_mutex);
+    /* A node retired at epoch 'e' can be held only by the readers that
+     * entered at or before 'e' */
+    uint64_t min_epoch = min_reader_epoch ();
+    uint64_t cnt = 0;
+
+    while ((!m_retire_list.empty()) && (m_retire_list.front().epoch < min_epoch)) {
+        retired_node_t &node = m_retire_list.front();
+        node.free_fn (node.p_node);
+        m_retire_list.pop_front();
+        cnt++;
+    }
+    if (cnt) {
+        m_pending.fetch_sub (cnt, std::memory_order_relaxed);
+        m_reclaimed.fetch_add (cnt, std::memory_order_relaxed);
+    }
+}
+
+extern "C" {
+
+bool hal_rt_epoch_enter (void) {
+    return hal_rt_epoch.enter ();
+}
+
+void hal_rt_epoch_exit (void) {
+    hal_rt_epoch.exit ();
+}
+
+void hal_rt_epoch_retire (void *p_node, void (*free_fn) (void *p_node)) {
+    hal_rt_epoch.retire (p_node, free_fn);
+}
+
+void hal_rt_epoch_retire_flush (void) {
+    hal_rt_epoch.retire_flush ();
+}
+
+void hal_rt_epoch_reclaim (void) {
+    hal_rt_epoch.reclaim ();
+}
+
+void hal_rt_epoch_stats_get (uint64_t *p_retired, uint64_t *p_reclaimed, uint64_t *p_pending) {
+    *p_retired = hal_rt_epoch.retired ();
+    *p_reclaimed = hal_rt_epoch.reclaimed ();
+    *p_pending = hal_rt_epoch.pending ();
+}
+
+}
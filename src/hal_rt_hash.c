@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_hash.c
+ * \brief  Open addressing hash index for the exact match lookups of the
+ *         DR and NH trees.
+ */
+
+#include "hal_rt_hash.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Linear probing, kept at most 3/4 full. A delete shifts the following
+ * entries of the probe sequence back instead of leaving a tombstone, so a
+ * lookup stops at the first empty slot however many deletes were done.
+ * The table is halved once it is less than 1/8 full.
+ *
+ * The index is updated with its tree and accessed with the same lock.
+ */
+
+static inline uint64_t fib_hash_mix (uint64_t val)
+{
+    val ^= (val >> 33);
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= (val >> 33);
+    val *= 0xc4ceb9fe1a85ec53ULL;
+    val ^= (val >> 33);
+    return val;
+}
+
+uint32_t fib_hash_key (const void *p_key, size_t len)
+{
+    const uint8_t *p_byte = (const uint8_t *) p_key;
+    uint64_t       hash = 0x9e3779b97f4a7c15ULL ^ len;
+    uint64_t       word;
+
+    for (; len >= sizeof (word); len -= sizeof (word), p_byte += sizeof (word)) {
+        memcpy (&word, p_byte, sizeof (word));
+        hash = fib_hash_mix (hash ^ word);
+    }
+    if (len > 0) {
+        word = 0;
+        memcpy (&word, p_byte, len);
+        hash = fib_hash_mix (hash ^ word);
+    }
+    return (uint32_t) hash;
+}
+
+static t_fib_hash_slot *fib_hash_slots_alloc (uint32_t num_slots)
+{
+    return ((t_fib_hash_slot *) calloc (num_slots, sizeof (t_fib_hash_slot)));
+}
+
+static void fib_hash_slot_insert (t_fib_hash_slot *p_slots, uint32_t num_slots,
+                                  uint32_t hash, void *p_val)
+{
+    uint32_t ix = hash & (num_slots - 1);
+
+    while (p_slots[ix].p_val != NULL)
+        ix = (ix + 1) & (num_slots - 1);
+
+    p_slots[ix].p_val = p_val;
+    p_slots[ix].hash = hash;
+}
+
+static bool fib_hash_resize (t_fib_hash *p_hash, uint32_t num_slots)
+{
+    t_fib_hash_slot *p_slots = fib_hash_slots_alloc (num_slots);
+    uint32_t         ix;
+
+    if (p_slots == NULL)
+        return false;
+
+    for (ix = 0; ix < p_hash->num_slots; ix++) {
+        if (p_hash->p_slots[ix].p_val != NULL)
+            fib_hash_slot_insert (p_slots, num_slots, p_hash->p_slots[ix].hash,
+                                  p_hash->p_slots[ix].p_val);
+    }
+    free (p_hash->p_slots);
+    p_hash->p_slots = p_slots;
+    p_hash->num_slots = num_slots;
+    return true;
+}
+
+t_fib_hash *fib_hash_create (void)
+{
+    t_fib_hash *p_hash = (t_fib_hash *) calloc (1, sizeof (t_fib_hash));
+
+    if (p_hash == NULL)
+        return NULL;
+
+    p_hash->p_slots = fib_hash_slots_alloc (FIB_HASH_MIN_SLOTS);
+    if (p_hash->p_slots == NULL) {
+        free (p_hash);
+        return NULL;
+    }
+    p_hash->num_slots = FIB_HASH_MIN_SLOTS;
+    p_hash->is_valid = true;
+    return p_hash;
+}
+
+void fib_hash_destroy (t_fib_hash *p_hash)
+{
+    if (p_hash == NULL)
+        return;
+
+    free (p_hash->p_slots);
+    free (p_hash);
+}
+
+bool fib_hash_add (t_fib_hash *p_hash, uint32_t hash, void *p_val)
+{
+    if (!p_hash->is_valid)
+        return false;
+
+    if (((p_hash->num_entries + 1) * 4) > (p_hash->num_slots * 3)) {
+        if (!fib_hash_resize (p_hash, p_hash->num_slots * 2)) {
+            /* The entries are out of sync from now on, drop them */
+            free (p_hash->p_slots);
+            p_hash->p_slots = NULL;
+            p_hash->num_slots = 0;
+            p_hash->num_entries = 0;
+            p_hash->is_valid = false;
+            return false;
+        }
+    }
+    fib_hash_slot_insert (p_hash->p_slots, p_hash->num_slots, hash, p_val);
+    p_hash->num_entries++;
+    return true;
+}
+
+void fib_hash_del (t_fib_hash *p_hash, uint32_t hash, const void *p_val)
+{
+    uint32_t mask;
+    uint32_t ix;
+    uint32_t next_ix;
+    uint32_t home_ix;
+
+    if (!p_hash->is_valid)
+        return;
+
+    mask = p_hash->num_slots - 1;
+    for (ix = hash & mask; p_hash->p_slots[ix].p_val != p_val; ix = (ix + 1) & mask) {
+        if (p_hash->p_slots[ix].p_val == NULL)
+            return;
+    }
+
+    /* Move back the entries that probed past the deleted slot */
+    for (next_ix = (ix + 1) & mask; p_hash->p_slots[next_ix].p_val != NULL;
+         next_ix = (next_ix + 1) & mask) {
+        home_ix = p_hash->p_slots[next_ix].hash & mask;
+        if (((next_ix - home_ix) & mask) >= ((next_ix - ix) & mask)) {
+            p_hash->p_slots[ix] = p_hash->p_slots[next_ix];
+            ix = next_ix;
+        }
+    }
+    p_hash->p_slots[ix].p_val = NULL;
+    p_hash->p_slots[ix].hash = 0;
+    p_hash->num_entries--;
+
+    /* Failing to shrink leaves the index as it is */
+    if ((p_hash->num_slots > FIB_HASH_MIN_SLOTS) &&
+        ((p_hash->num_entries * 8) < p_hash->num_slots))
+        fib_hash_resize (p_hash, p_hash->num_slots / 2);
+}
+
+void *fib_hash_lookup (const t_fib_hash *p_hash, uint32_t hash,
+                       t_fib_hash_match_fn match_fn, const void *p_key)
+{
+    uint32_t mask = p_hash->num_slots - 1;
+    uint32_t ix;
+
+    for (ix = hash & mask; p_hash->p_slots[ix].p_val != NULL; ix = (ix + 1) & mask) {
+        if ((p_hash->p_slots[ix].hash == hash) &&
+            (match_fn (p_hash->p_slots[ix].p_val, p_key)))
+            return p_hash->p_slots[ix].p_val;
+    }
+    return NULL;
+}
@@ -82,12 +82,6 @@ int fib_process_route_add_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
     FIB_FOR_EACH_FH_FROM_INTF (p_intf, p_fh, nh_holder) {
         p_nh_dep_dr = fib_get_first_nh_dep_dr (p_fh);
         while (p_nh_dep_dr != NULL) {
-            if (p_nh_dep_dr->p_dr == NULL) {
-                p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->key.vrf_id,
-                                                      &p_nh_dep_dr->key.dr_key.prefix,
-                                                      p_nh_dep_dr->prefix_len);
-                continue;
-            }
             /* Init the FIB route add to true first,
              * if there aren't any valid path found in the ECMP,
              * then don't add the FIB route
@@ -125,9 +119,9 @@ int fib_process_route_add_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
             /* copy the route to be deleted and then get the next dependent dr,
              * to avoid accessing the invalid dep-dr after route deletion */
             p_add_dr = p_nh_dep_dr->p_dr;
-            p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->key.vrf_id,
-                                                  &p_nh_dep_dr->key.dr_key.prefix,
-                                                  p_nh_dep_dr->prefix_len);
+            p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->p_dr->vrf_id,
+                                                  &p_nh_dep_dr->p_dr->key.prefix,
+                                                  p_nh_dep_dr->p_dr->prefix_len);
             /* Dont delete the link local route on admin down,
              * wait for explicit route del from kernel thru netlink
              * The reason - let's say LAG(bond) has only one member and
@@ -172,6 +166,7 @@ int fib_process_route_add_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
 int fib_process_link_local_address_add_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_type intf_event) {
 
     t_fib_dr         *p_add_dr = NULL;
+    t_fib_dr_cold    *p_add_dr_cold = NULL;
     t_fib_ip_addr    *p_temp_ip = NULL;
     t_fib_ip_holder   ip_holder;
     hal_ifindex_t     if_index;
@@ -207,13 +202,17 @@ int fib_process_link_local_address_add_on_intf_event (t_fib_intf *p_intf, t_fib_
         if (!p_add_dr) {
             continue;
         }
+        p_add_dr_cold = fib_get_dr_cold (p_add_dr);
+        if (!p_add_dr_cold) {
+            continue;
+        }
         HAL_RT_LOG_INFO ("HAL-RT-LLA-ADD",
                          "Intf event: %d, DR: vrf_id: %d, prefix: %s/%d, "
                          "link_local_cnt: %d, RIF link_local_cnt: %d  rt_type: %d ",
                          intf_event, p_add_dr->vrf_id,
                          FIB_IP_ADDR_TO_STR (&p_add_dr->key.prefix),
-                         p_add_dr->prefix_len, p_add_dr->num_ipv6_link_local,
-                         p_add_dr->num_ipv6_rif_link_local, p_add_dr->rt_type);
+                         p_add_dr->prefix_len, p_add_dr_cold->num_ipv6_link_local,
+                         p_add_dr_cold->num_ipv6_rif_link_local, p_add_dr->rt_type);
 
         /* if num_ipv6_rif_link_local is > 1, then there are multiple interfaces
          * using same link local route.
@@ -224,16 +223,16 @@ int fib_process_link_local_address_add_on_intf_event (t_fib_intf *p_intf, t_fib_
         ndi_rif_id_t rif_id = 0;
         if (hal_rif_index_get_or_create(0, p_add_dr->vrf_id, if_index, &rif_id) == STD_ERR_OK) {
             hal_rt_rif_ref_inc(p_add_dr->vrf_id, if_index);
-            p_add_dr->num_ipv6_rif_link_local++;
+            p_add_dr_cold->num_ipv6_rif_link_local++;
         } else {
             HAL_RT_LOG_ERR("HAL-RT-LLA-ADD", " RIF get failed for Route add vrf_id: %d, prefix: %s/%d,"
                            " proto: %d out-if:%d link-local-cnt:%d RIF-ref-cnt:%d",
                            p_add_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_add_dr->key.prefix),
                            p_add_dr->prefix_len, p_add_dr->proto, if_index,
-                           p_add_dr->num_ipv6_link_local, hal_rt_rif_ref_get(p_intf->key.vrf_id, if_index));
+                           p_add_dr_cold->num_ipv6_link_local, hal_rt_rif_ref_get(p_intf->key.vrf_id, if_index));
         }
 
-        if (p_add_dr->num_ipv6_rif_link_local > 1) {
+        if (p_add_dr_cold->num_ipv6_rif_link_local > 1) {
             continue;
         }
 
@@ -246,8 +245,8 @@ int fib_process_link_local_address_add_on_intf_event (t_fib_intf *p_intf, t_fib_
                          "link_local_cnt: %d, RIF link_local_cnt: %d",
                          p_add_dr->vrf_id,
                          FIB_IP_ADDR_TO_STR (&p_add_dr->key.prefix),
-                         p_add_dr->prefix_len, p_add_dr->num_ipv6_link_local,
-                         p_add_dr->num_ipv6_rif_link_local);
+                         p_add_dr->prefix_len, p_add_dr_cold->num_ipv6_link_local,
+                         p_add_dr_cold->num_ipv6_rif_link_local);
 
         /* set ADD flag to trigger route download to walker */
         p_add_dr->status_flag |= FIB_DR_STATUS_ADD;
@@ -307,12 +306,6 @@ int fib_process_route_del_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
         p_fh->status_flag |= FIB_NH_STATUS_DEAD;
         p_nh_dep_dr = fib_get_first_nh_dep_dr (p_fh);
         while (p_nh_dep_dr != NULL) {
-            if (p_nh_dep_dr->p_dr == NULL) {
-                p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->key.vrf_id,
-                                                      &p_nh_dep_dr->key.dr_key.prefix,
-                                                      p_nh_dep_dr->prefix_len);
-                continue;
-            }
             /* Init the FIB route del to true first, if any valid path found in the ECMP, dont delete the FIB route */
             is_fib_route_del = true;
             HAL_RT_LOG_DEBUG("HAL-RT-DR-DEL",
@@ -346,9 +339,9 @@ int fib_process_route_del_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
             /* copy the route to be deleted and then get the next dependent dr,
              * to avoid accessing the invalid dep-dr after route deletion */
             p_del_dr = p_nh_dep_dr->p_dr;
-            p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->key.vrf_id,
-                                                  &p_nh_dep_dr->key.dr_key.prefix,
-                                                  p_nh_dep_dr->prefix_len);
+            p_nh_dep_dr = fib_get_next_nh_dep_dr (p_fh, p_nh_dep_dr->p_dr->vrf_id,
+                                                  &p_nh_dep_dr->p_dr->key.prefix,
+                                                  p_nh_dep_dr->p_dr->prefix_len);
             /* Dont delete the link local route on admin down,
              * wait for explicit route del from kernel thru netlink
              * The reason - let's say LAG(bond) has only one member and
@@ -386,6 +379,7 @@ int fib_process_route_del_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_ty
 int fib_process_link_local_address_del_on_intf_event (t_fib_intf *p_intf, t_fib_intf_event_type intf_event) {
 
     t_fib_dr         *p_del_dr = NULL;
+    t_fib_dr_cold    *p_del_dr_cold = NULL;
     t_fib_ip_addr    *p_temp_ip = NULL;
     t_fib_ip_holder   ip_holder;
     hal_ifindex_t     if_index;
@@ -421,16 +415,20 @@ int fib_process_link_local_address_del_on_intf_event (t_fib_intf *p_intf, t_fib_
         if (!p_del_dr) {
             continue;
         }
+        p_del_dr_cold = fib_get_dr_cold (p_del_dr);
+        if (!p_del_dr_cold) {
+            continue;
+        }
 
         HAL_RT_LOG_INFO ("HAL-RT-LLA-DEL",
                          "Intf event: %d, DR: vrf_id: %d, prefix: %s/%d, "
                          "link_local_cnt: %d, RIF link_local_cnt: %d  rt_type: %d ",
                          intf_event, p_del_dr->vrf_id,
                          FIB_IP_ADDR_TO_STR (&p_del_dr->key.prefix),
-                         p_del_dr->prefix_len, p_del_dr->num_ipv6_link_local,
-                         p_del_dr->num_ipv6_rif_link_local, p_del_dr->rt_type);
-        if (p_del_dr->num_ipv6_rif_link_local)
-            p_del_dr->num_ipv6_rif_link_local--;
+                         p_del_dr->prefix_len, p_del_dr_cold->num_ipv6_link_local,
+                         p_del_dr_cold->num_ipv6_rif_link_local, p_del_dr->rt_type);
+        if (p_del_dr_cold->num_ipv6_rif_link_local)
+            p_del_dr_cold->num_ipv6_rif_link_local--;
 
         /* Don't delete the LLA route from NDI if the DR's
          * num_ipv6_link_local is > 1,
@@ -438,7 +436,7 @@ int fib_process_link_local_address_del_on_intf_event (t_fib_intf *p_intf, t_fib_
          * interface on which this link local route
          * is configured; hence delete the LLA from NDI.
          */
-        if (p_del_dr->num_ipv6_rif_link_local >= 1) {
+        if (p_del_dr_cold->num_ipv6_rif_link_local >= 1) {
             if (!hal_rt_rif_ref_dec(p_intf->key.vrf_id, if_index))
                 hal_rif_index_remove(0, p_intf->key.vrf_id, if_index);
             continue;
@@ -808,9 +806,9 @@ int fib_process_route_del_on_mgmt_ip_del_event (hal_ifindex_t if_index, hal_vrf_
                                p_nh_dep_dr->p_dr->prefix_len, FIB_IP_ADDR_TO_STR(&p_nh->key.ip_addr));
                 p_nh_dep_dr->p_dr->status_flag |= FIB_DR_STATUS_DEL;
                 p_dr = p_nh_dep_dr->p_dr;
-                p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                                      &p_nh_dep_dr->key.dr_key.prefix,
-                                                      p_nh_dep_dr->prefix_len);
+                p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->p_dr->vrf_id,
+                                                      &p_nh_dep_dr->p_dr->key.prefix,
+                                                      p_nh_dep_dr->p_dr->prefix_len);
                 fib_proc_dr_del (p_dr);
             }
         }
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_lockstat.cpp
+ * \brief  Wait and hold time profiling of the nas_l3_lock per call site.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_lockstat.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Each thread records into its own buffer, so the lock paths do not share
+ * any cache line: a hash of the (call site, mode) entries and the stack of
+ * the locks it holds. Only the owner thread updates the entries, the dump
+ * reads them with relaxed loads. A clear bumps the generation, each thread
+ * zeroes its own entries on its next record, so the clear does not race the
+ * owner, and the buffers of an older generation are skipped by the dump.
+ */
+typedef struct {
+    std::atomic<const char *> site;
+    std::atomic<uint32_t>     mode;
+    std::atomic<uint64_t>     count;
+    std::atomic<uint64_t>     wait_nsecs;
+    std::atomic<uint64_t>     wait_max;
+    std::atomic<uint64_t>     hold_nsecs;
+    std::atomic<uint64_t>     hold_max;
+} hal_rt_lockstat_site_t;
+
+typedef struct {
+    const char        *site;
+    t_hal_rt_lock_mode mode;
+    uint64_t           acquired;
+} hal_rt_lockstat_held_t;
+
+typedef struct {
+    std::atomic<bool>      in_use;
+    std::atomic<uint32_t>  gen;
+    uint32_t               depth;
+    hal_rt_lockstat_held_t held[HAL_RT_LOCKSTAT_MAX_DEPTH];
+    hal_rt_lockstat_site_t sites[HAL_RT_LOCKSTAT_MAX_SITES];
+} hal_rt_lockstat_buf_t;
+
+static hal_rt_lockstat_buf_t hal_rt_lockstat_bufs[HAL_RT_LOCKSTAT_MAX_THREADS];
+static std::atomic<uint32_t> hal_rt_lockstat_gen {1};
+static std::atomic<uint64_t> hal_rt_lockstat_dropped {0};
+
+/* Buffer of the thread, kept till the thread exits. The lock holds of a thread
+ * that found no free buffer are counted as dropped. */
+static thread_local hal_rt_lockstat_buf_t *p_hal_rt_lockstat_buf = nullptr;
+static thread_local bool hal_rt_lockstat_no_buf = false;
+
+/* Gives the buffer of the thread back at the thread exit, the stats in the
+ * buffer are kept and added to by the next thread that takes it */
+typedef struct hal_rt_lockstat_buf_owner_s {
+    ~hal_rt_lockstat_buf_owner_s ()
+    {
+        if (p_hal_rt_lockstat_buf == nullptr)
+            return;
+        p_hal_rt_lockstat_buf->depth = 0;
+        p_hal_rt_lockstat_buf->in_use.store (false, std::memory_order_release);
+        p_hal_rt_lockstat_buf = nullptr;
+    }
+} hal_rt_lockstat_buf_owner_t;
+
+static hal_rt_lockstat_buf_t *hal_rt_lockstat_buf_get (void)
+{
+    if ((p_hal_rt_lockstat_buf != nullptr) || hal_rt_lockstat_no_buf)
+        return p_hal_rt_lockstat_buf;
+
+    for (int ix = 0; ix < HAL_RT_LOCKSTAT_MAX_THREADS; ix++) {
+        bool in_use = false;
+        if (hal_rt_lockstat_bufs[ix].in_use.compare_exchange_strong (in_use, true)) {
+            /* Constructed here only, so that the lock paths use the plain
+             * thread local pointer */
+            static thread_local hal_rt_lockstat_buf_owner_t buf_owner;
+            (void)buf_owner;
+            p_hal_rt_lockstat_buf = &hal_rt_lockstat_bufs[ix];
+            return p_hal_rt_lockstat_buf;
+        }
+    }
+    hal_rt_lockstat_no_buf = true;
+    return nullptr;
+}
+
+/* Zero the entries of the thread's buffer if a clear is pending */
+static void hal_rt_lockstat_buf_sync (hal_rt_lockstat_buf_t *p_buf)
+{
+    uint32_t gen = hal_rt_lockstat_gen.load (std::memory_order_acquire);
+
+    if (p_buf->gen.load (std::memory_order_relaxed) == gen)
+        return;
+
+    for (int ix = 0; ix < HAL_RT_LOCKSTAT_MAX_SITES; ix++) {
+        hal_rt_lockstat_site_t &entry = p_buf->sites[ix];
+        entry.site.store (nullptr, std::memory_order_relaxed);
+        entry.count.store (0, std::memory_order_relaxed);
+        entry.wait_nsecs.store (0, std::memory_order_relaxed);
+        entry.wait_max.store (0, std::memory_order_relaxed);
+        entry.hold_nsecs.store (0, std::memory_order_relaxed);
+        entry.hold_max.store (0, std::memory_order_relaxed);
+    }
+    p_buf->gen.store (gen, std::memory_order_release);
+}
+
+static hal_rt_lockstat_site_t *hal_rt_lockstat_site_get (hal_rt_lockstat_buf_t *p_buf,
+                                                         const char *site,
+                                                         t_hal_rt_lock_mode mode)
+{
+    uint32_t hash = (uint32_t)(((uintptr_t)site >> 3) ^ mode);
+
+    for (uint32_t probe = 0; probe < HAL_RT_LOCKSTAT_MAX_SITES; probe++) {
+        hal_rt_lockstat_site_t &entry =
+            p_buf->sites[(hash + probe) & (HAL_RT_LOCKSTAT_MAX_SITES - 1)];
+        const char *entry_site = entry.site.load (std::memory_order_relaxed);
+
+        if (entry_site == nullptr) {
+            entry.mode.store (mode, std::memory_order_relaxed);
+            entry.site.store (site, std::memory_order_release);
+            return &entry;
+        }
+        if ((entry_site == site) && (entry.mode.load (std::memory_order_relaxed) == (uint32_t)mode))
+            return &entry;
+    }
+    return nullptr;
+}
+
+/* Single writer, a plain load and store is enough */
+static inline void hal_rt_lockstat_add (std::atomic<uint64_t> &counter, uint64_t val)
+{
+    counter.store (counter.load (std::memory_order_relaxed) + val, std::memory_order_relaxed);
+}
+
+static inline void hal_rt_lockstat_max (std::atomic<uint64_t> &counter, uint64_t val)
+{
+    if (val > counter.load (std::memory_order_relaxed))
+        counter.store (val, std::memory_order_relaxed);
+}
+
+static inline uint64_t hal_rt_lockstat_nsecs (void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t hal_rt_lockstat_start (void)
+{
+    return hal_rt_lockstat_nsecs ();
+}
+
+void hal_rt_lockstat_acquired (const char *site, t_hal_rt_lock_mode mode, uint64_t start)
+{
+    hal_rt_lockstat_buf_t *p_buf = hal_rt_lockstat_buf_get ();
+    uint64_t now = hal_rt_lockstat_nsecs ();
+
+    if (p_buf == nullptr) {
+        hal_rt_lockstat_dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+    if (p_buf->depth++ >= HAL_RT_LOCKSTAT_MAX_DEPTH) {
+        hal_rt_lockstat_dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+    p_buf->held[p_buf->depth - 1] = {site, mode, now};
+
+    hal_rt_lockstat_buf_sync (p_buf);
+    hal_rt_lockstat_site_t *p_entry = hal_rt_lockstat_site_get (p_buf, site, mode);
+    if (p_entry == nullptr) {
+        hal_rt_lockstat_dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+    hal_rt_lockstat_add (p_entry->count, 1);
+    hal_rt_lockstat_add (p_entry->wait_nsecs, now - start);
+    hal_rt_lockstat_max (p_entry->wait_max, now - start);
+}
+
+void hal_rt_lockstat_released (void)
+{
+    hal_rt_lockstat_buf_t *p_buf = p_hal_rt_lockstat_buf;
+
+    if ((p_buf == nullptr) || (p_buf->depth == 0))
+        return;
+    if (p_buf->depth-- > HAL_RT_LOCKSTAT_MAX_DEPTH)
+        return;
+
+    const hal_rt_lockstat_held_t &held = p_buf->held[p_buf->depth];
+    uint64_t hold = hal_rt_lockstat_nsecs () - held.acquired;
+
+    /* Looked up again, the entry could have been zeroed by a clear in between */
+    hal_rt_lockstat_buf_sync (p_buf);
+    hal_rt_lockstat_site_t *p_entry = hal_rt_lockstat_site_get (p_buf, held.site, held.mode);
+    if (p_entry == nullptr)
+        return;
+    hal_rt_lockstat_add (p_entry->hold_nsecs, hold);
+    hal_rt_lockstat_max (p_entry->hold_max, hold);
+}
+
+uint32_t hal_rt_lockstat_get (t_hal_rt_lockstat *p_stats, uint32_t max_stats)
+{
+    uint32_t gen = hal_rt_lockstat_gen.load (std::memory_order_acquire);
+    uint32_t num_stats = 0;
+
+    for (int buf_ix = 0; buf_ix < HAL_RT_LOCKSTAT_MAX_THREADS; buf_ix++) {
+        hal_rt_lockstat_buf_t &buf = hal_rt_lockstat_bufs[buf_ix];
+
+        /* The buffers of the exited threads keep their stats till a clear */
+        if (buf.gen.load (std::memory_order_acquire) != gen)
+            continue;
+
+        for (int ix = 0; ix < HAL_RT_LOCKSTAT_MAX_SITES; ix++) {
+            hal_rt_lockstat_site_t &entry = buf.sites[ix];
+            const char *site = entry.site.load (std::memory_order_acquire);
+            if (site == nullptr)
+                continue;
+
+            t_hal_rt_lock_mode mode = (t_hal_rt_lock_mode)entry.mode.load (std::memory_order_relaxed);
+            uint32_t stat_ix = 0;
+            while ((stat_ix < num_stats) &&
+                   ((p_stats[stat_ix].site != site) || (p_stats[stat_ix].mode != mode)))
+                stat_ix++;
+
+            if (stat_ix == num_stats) {
+                if (num_stats >= max_stats)
+                    continue;
+                p_stats[stat_ix] = {site, mode, 0, 0, 0, 0, 0};
+                num_stats++;
+            }
+            t_hal_rt_lockstat &stat = p_stats[stat_ix];
+            uint64_t wait_max = entry.wait_max.load (std::memory_order_relaxed);
+            uint64_t hold_max = entry.hold_max.load (std::memory_order_relaxed);
+
+            stat.count += entry.count.load (std::memory_order_relaxed);
+            stat.wait_nsecs += entry.wait_nsecs.load (std::memory_order_relaxed);
+            stat.hold_nsecs += entry.hold_nsecs.load (std::memory_order_relaxed);
+            if (wait_max > stat.wait_max)
+                stat.wait_max = wait_max;
+            if (hold_max > stat.hold_max)
+                stat.hold_max = hold_max;
+        }
+    }
+    return num_stats;
+}
+
+uint64_t hal_rt_lockstat_dropped_get (void)
+{
+    return hal_rt_lockstat_dropped.load (std::memory_order_relaxed);
+}
+
+void hal_rt_lockstat_clear (void)
+{
+    hal_rt_lockstat_gen.fetch_add (1, std::memory_order_acq_rel);
+    hal_rt_lockstat_dropped.store (0, std::memory_order_relaxed);
+}
+
+const char *hal_rt_lock_mode_to_str (t_hal_rt_lock_mode mode)
+{
+    switch (mode) {
+        case HAL_RT_LOCK_MODE_EXCL:       return "Excl";
+        case HAL_RT_LOCK_MODE_SHARED:     return "Shared";
+        case HAL_RT_LOCK_MODE_VRF:        return "VRF";
+        case HAL_RT_LOCK_MODE_VRF_SHARED: return "VRF-Shared";
+        default:
+            break;
+    }
+    return "Unknown";
+}
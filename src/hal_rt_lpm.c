@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_lpm.c
+ * \brief  Multibit trie index for the longest prefix match of the DR trees.
+ */
+
+#include "hal_rt_lpm.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * A node at depth D takes the address bits D to D+5 and holds the prefixes
+ * of length D+1 to D+6, the zero length prefix is held by the index. The
+ * leaves of a node are expanded from its own prefixes only, the longest
+ * prefix of the parent covering a child node is kept in the child, so an
+ * update rebuilds the leaves of one node and sets the inherited prefix of
+ * its children, and the lookup remembers the last inherited prefix on the
+ * way down. A lookup takes a node and its leaf or child per level.
+ *
+ * The index is updated with the DR tree and accessed with the same lock.
+ */
+
+#define FIB_LPM_MAX_DEPTH  ((128 / FIB_LPM_STRIDE) + 1)
+#define FIB_LPM_INIT_PFX   4
+
+/* Slot of the key in the node at depth */
+static inline uint32_t fib_lpm_key_slot (const t_fib_lpm_key *p_key, uint32_t depth)
+{
+    if ((depth + FIB_LPM_STRIDE) <= 64)
+        return ((p_key->hi >> (64 - FIB_LPM_STRIDE - depth)) & (FIB_LPM_SLOTS - 1));
+    if (depth < 64)
+        return (((p_key->hi << (depth + FIB_LPM_STRIDE - 64)) |
+                 (p_key->lo >> (128 - FIB_LPM_STRIDE - depth))) & (FIB_LPM_SLOTS - 1));
+    if ((depth + FIB_LPM_STRIDE) <= 128)
+        return ((p_key->lo >> (128 - FIB_LPM_STRIDE - depth)) & (FIB_LPM_SLOTS - 1));
+    return ((p_key->lo << (depth + FIB_LPM_STRIDE - 128)) & (FIB_LPM_SLOTS - 1));
+}
+
+/* Depth of the node holding the prefix of len, len > 0 */
+static inline uint32_t fib_lpm_pfx_depth (uint32_t len)
+{
+    return (((len - 1) / FIB_LPM_STRIDE) * FIB_LPM_STRIDE);
+}
+
+/* Mask of the slots up to and including slot */
+static inline uint64_t fib_lpm_slot_mask (uint32_t slot)
+{
+    return (((1ULL << slot) << 1) - 1);
+}
+
+t_fib_lpm *fib_lpm_create (uint32_t max_len)
+{
+    t_fib_lpm *p_lpm = (t_fib_lpm *) calloc (1, sizeof (t_fib_lpm));
+
+    if (p_lpm == NULL)
+        return NULL;
+
+    /* The root starts with a single run of no prefix */
+    p_lpm->root.p_leaf = (void **) calloc (1, sizeof (void *));
+    if (p_lpm->root.p_leaf == NULL) {
+        free (p_lpm);
+        return NULL;
+    }
+    p_lpm->root.leafvec = 1;
+    p_lpm->max_len = max_len;
+    p_lpm->is_valid = true;
+    p_lpm->num_nodes = 1;
+    p_lpm->num_bytes = sizeof (t_fib_lpm) + sizeof (void *);
+
+    return p_lpm;
+}
+
+static void fib_lpm_node_free (t_fib_lpm_node *p_node)
+{
+    uint32_t num_child = __builtin_popcountll (p_node->vector);
+    uint32_t ix = 0;
+
+    for (ix = 0; ix < num_child; ix++) {
+        fib_lpm_node_free (&p_node->p_child[ix]);
+    }
+    free (p_node->p_child);
+    free (p_node->p_leaf);
+    free (p_node->p_pfx);
+}
+
+void fib_lpm_destroy (t_fib_lpm *p_lpm)
+{
+    if (p_lpm == NULL)
+        return;
+
+    fib_lpm_node_free (&p_lpm->root);
+    free (p_lpm);
+}
+
+/*
+ * Expand the prefixes of the node into its leaves, the shorter prefixes
+ * first so that the longer ones win, and pass the prefix covering each
+ * child down to the child.
+ */
+static bool fib_lpm_node_rebuild (t_fib_lpm *p_lpm, t_fib_lpm_node *p_node)
+{
+    void     *a_slot[FIB_LPM_SLOTS];
+    void     *a_leaf[FIB_LPM_SLOTS];
+    void    **p_leaf = NULL;
+    uint64_t  leafvec = 0;
+    uint32_t  num_leaf = 0, old_num_leaf = 0;
+    uint32_t  len = 0, ix = 0, slot = 0, child_ix = 0;
+    uint32_t  first = 0, last = 0;
+    bool      is_first_leaf = true;
+
+    memset (a_slot, 0, sizeof (a_slot));
+    for (len = 1; len <= FIB_LPM_STRIDE; len++) {
+        for (ix = 0; ix < p_node->num_pfx; ix++) {
+            if (p_node->p_pfx[ix].len != len)
+                continue;
+            first = ((uint32_t)p_node->p_pfx[ix].bits << (FIB_LPM_STRIDE - len));
+            last = first + (1 << (FIB_LPM_STRIDE - len));
+            for (slot = first; slot < last; slot++) {
+                a_slot[slot] = p_node->p_pfx[ix].p_val;
+            }
+        }
+    }
+
+    for (slot = 0; slot < FIB_LPM_SLOTS; slot++) {
+        if (p_node->vector & (1ULL << slot)) {
+            p_node->p_child[child_ix++].p_inherit = a_slot[slot];
+            continue;
+        }
+        if (is_first_leaf || (a_slot[slot] != a_leaf[num_leaf - 1])) {
+            leafvec |= (1ULL << slot);
+            a_leaf[num_leaf++] = a_slot[slot];
+            is_first_leaf = false;
+        }
+    }
+
+    old_num_leaf = __builtin_popcountll (p_node->leafvec);
+    if (num_leaf != old_num_leaf) {
+        p_leaf = NULL;
+        if (num_leaf != 0) {
+            p_leaf = (void **) malloc (num_leaf * sizeof (void *));
+            if (p_leaf == NULL)
+                return false;
+        }
+        free (p_node->p_leaf);
+        p_node->p_leaf = p_leaf;
+        p_lpm->num_bytes += ((int64_t)num_leaf - (int64_t)old_num_leaf) * sizeof (void *);
+    }
+    if (num_leaf != 0) {
+        memcpy (p_node->p_leaf, a_leaf, num_leaf * sizeof (void *));
+    }
+    p_node->leafvec = leafvec;
+
+    return true;
+}
+
+/* Add an empty child at the slot, the leaves of the node are to be rebuilt */
+static t_fib_lpm_node *fib_lpm_child_add (t_fib_lpm *p_lpm, t_fib_lpm_node *p_node,
+                                          uint32_t slot)
+{
+    uint32_t        num_child = __builtin_popcountll (p_node->vector);
+    uint32_t        child_ix = __builtin_popcountll (p_node->vector & ((1ULL << slot) - 1));
+    t_fib_lpm_node *p_child = NULL;
+
+    p_child = (t_fib_lpm_node *) malloc ((num_child + 1) * sizeof (t_fib_lpm_node));
+    if (p_child == NULL)
+        return NULL;
+
+    /* The children own their arrays, so they are moved by copy */
+    if (child_ix != 0) {
+        memcpy (p_child, p_node->p_child, child_ix * sizeof (t_fib_lpm_node));
+    }
+    if (child_ix != num_child) {
+        memcpy (&p_child[child_ix + 1], &p_node->p_child[child_ix],
+                (num_child - child_ix) * sizeof (t_fib_lpm_node));
+    }
+    memset (&p_child[child_ix], 0, sizeof (t_fib_lpm_node));
+    free (p_node->p_child);
+    p_node->p_child = p_child;
+    p_node->vector |= (1ULL << slot);
+
+    p_lpm->num_nodes++;
+    p_lpm->num_bytes += sizeof (t_fib_lpm_node);
+    return &p_child[child_ix];
+}
+
+/* Remove the empty child at the slot, the leaves of the node are to be rebuilt */
+static void fib_lpm_child_del (t_fib_lpm *p_lpm, t_fib_lpm_node *p_node, uint32_t slot)
+{
+    uint32_t        num_child = __builtin_popcountll (p_node->vector);
+    uint32_t        child_ix = __builtin_popcountll (p_node->vector & ((1ULL << slot) - 1));
+    t_fib_lpm_node *p_child = NULL;
+
+    fib_lpm_node_free (&p_node->p_child[child_ix]);
+    if (num_child > 1) {
+        /* On a failure to shrink, the children are moved within the array */
+        p_child = (t_fib_lpm_node *) malloc ((num_child - 1) * sizeof (t_fib_lpm_node));
+        if (p_child != NULL) {
+            memcpy (p_child, p_node->p_child, child_ix * sizeof (t_fib_lpm_node));
+        } else {
+            p_child = p_node->p_child;
+        }
+        memmove (&p_child[child_ix], &p_node->p_child[child_ix + 1],
+                 (num_child - child_ix - 1) * sizeof (t_fib_lpm_node));
+    }
+    if (p_child != p_node->p_child) {
+        free (p_node->p_child);
+    }
+    p_node->p_child = p_child;
+    p_node->vector &= ~(1ULL << slot);
+
+    p_lpm->num_nodes--;
+    p_lpm->num_bytes -= sizeof (t_fib_lpm_node);
+}
+
+static inline bool fib_lpm_node_is_empty (const t_fib_lpm_node *p_node)
+{
+    return ((p_node->num_pfx == 0) && (p_node->vector == 0));
+}
+
+bool fib_lpm_add (t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len, void *p_val)
+{
+    t_fib_lpm_node *p_node = NULL;
+    t_fib_lpm_node *p_child = NULL;
+    t_fib_lpm_pfx  *p_pfx = NULL;
+    uint32_t        depth = 0, node_depth = 0, slot = 0;
+    uint32_t        rel_len = 0, bits = 0, ix = 0;
+
+    if ((p_lpm == NULL) || (!p_lpm->is_valid) || (len > p_lpm->max_len))
+        return false;
+
+    if (len == 0) {
+        if (p_lpm->p_default == NULL)
+            p_lpm->num_pfx++;
+        p_lpm->p_default = p_val;
+        return true;
+    }
+
+    node_depth = fib_lpm_pfx_depth (len);
+    p_node = &p_lpm->root;
+    for (depth = 0; depth < node_depth; depth += FIB_LPM_STRIDE) {
+        slot = fib_lpm_key_slot (p_key, depth);
+        if (p_node->vector & (1ULL << slot)) {
+            p_node = &p_node->p_child[__builtin_popcountll (p_node->vector & ((1ULL << slot) - 1))];
+            continue;
+        }
+        p_child = fib_lpm_child_add (p_lpm, p_node, slot);
+        if ((p_child == NULL) || (!fib_lpm_node_rebuild (p_lpm, p_node)))
+            goto fail;
+        p_node = p_child;
+        /* The new node has a single run of no prefix */
+        if (!fib_lpm_node_rebuild (p_lpm, p_node))
+            goto fail;
+    }
+
+    rel_len = len - node_depth;
+    bits = fib_lpm_key_slot (p_key, node_depth) >> (FIB_LPM_STRIDE - rel_len);
+    for (ix = 0; ix < p_node->num_pfx; ix++) {
+        if ((p_node->p_pfx[ix].len == rel_len) && (p_node->p_pfx[ix].bits == bits))
+            break;
+    }
+    if (ix == p_node->num_pfx) {
+        if (p_node->num_pfx == p_node->max_pfx) {
+            uint32_t max_pfx = (p_node->max_pfx ? (2 * p_node->max_pfx) : FIB_LPM_INIT_PFX);
+            p_pfx = (t_fib_lpm_pfx *) realloc (p_node->p_pfx, max_pfx * sizeof (t_fib_lpm_pfx));
+            if (p_pfx == NULL)
+                goto fail;
+            p_lpm->num_bytes += (max_pfx - p_node->max_pfx) * sizeof (t_fib_lpm_pfx);
+            p_node->p_pfx = p_pfx;
+            p_node->max_pfx = max_pfx;
+        }
+        p_node->p_pfx[ix].len = rel_len;
+        p_node->p_pfx[ix].bits = bits;
+        p_node->num_pfx++;
+        p_lpm->num_pfx++;
+    }
+    p_node->p_pfx[ix].p_val = p_val;
+
+    if (!fib_lpm_node_rebuild (p_lpm, p_node))
+        goto fail;
+    return true;
+
+fail:
+    /* The leaves could be stale, the index is not used any more */
+    p_lpm->is_valid = false;
+    return false;
+}
+
+void fib_lpm_del (t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len)
+{
+    t_fib_lpm_node *a_path[FIB_LPM_MAX_DEPTH];
+    uint32_t        a_slot[FIB_LPM_MAX_DEPTH];
+    t_fib_lpm_node *p_node = NULL;
+    uint32_t        depth = 0, node_depth = 0, level = 0, slot = 0;
+    uint32_t        rel_len = 0, bits = 0, ix = 0;
+
+    if ((p_lpm == NULL) || (!p_lpm->is_valid) || (len > p_lpm->max_len))
+        return;
+
+    if (len == 0) {
+        if (p_lpm->p_default != NULL)
+            p_lpm->num_pfx--;
+        p_lpm->p_default = NULL;
+        return;
+    }
+
+    node_depth = fib_lpm_pfx_depth (len);
+    p_node = &p_lpm->root;
+    for (depth = 0; depth < node_depth; depth += FIB_LPM_STRIDE) {
+        slot = fib_lpm_key_slot (p_key, depth);
+        if (!(p_node->vector & (1ULL << slot)))
+            return;
+        a_path[level] = p_node;
+        a_slot[level++] = slot;
+        p_node = &p_node->p_child[__builtin_popcountll (p_node->vector & ((1ULL << slot) - 1))];
+    }
+
+    rel_len = len - node_depth;
+    bits = fib_lpm_key_slot (p_key, node_depth) >> (FIB_LPM_STRIDE - rel_len);
+    for (ix = 0; ix < p_node->num_pfx; ix++) {
+        if ((p_node->p_pfx[ix].len == rel_len) && (p_node->p_pfx[ix].bits == bits))
+            break;
+    }
+    if (ix == p_node->num_pfx)
+        return;
+
+    p_node->p_pfx[ix] = p_node->p_pfx[--p_node->num_pfx];
+    p_lpm->num_pfx--;
+
+    /* The nodes left empty are removed bottom up */
+    while ((level > 0) && fib_lpm_node_is_empty (p_node)) {
+        p_lpm->num_bytes -= p_node->max_pfx * sizeof (t_fib_lpm_pfx);
+        p_lpm->num_bytes -= __builtin_popcountll (p_node->leafvec) * sizeof (void *);
+        level--;
+        p_node = a_path[level];
+        fib_lpm_child_del (p_lpm, p_node, a_slot[level]);
+    }
+
+    if (!fib_lpm_node_rebuild (p_lpm, p_node)) {
+        p_lpm->is_valid = false;
+    }
+}
+
+void *fib_lpm_lookup (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key)
+{
+    const t_fib_lpm_node *p_node = &p_lpm->root;
+    void                 *p_best = p_lpm->p_default;
+    void                 *p_leaf = NULL;
+    uint32_t              depth = 0, slot = 0;
+
+    for (;;) {
+        slot = fib_lpm_key_slot (p_key, depth);
+        if (!(p_node->vector & (1ULL << slot)))
+            break;
+        p_node = &p_node->p_child[__builtin_popcountll (p_node->vector & ((1ULL << slot) - 1))];
+        if (p_node->p_inherit != NULL)
+            p_best = p_node->p_inherit;
+        depth += FIB_LPM_STRIDE;
+    }
+
+    p_leaf = p_node->p_leaf[__builtin_popcountll (p_node->leafvec & fib_lpm_slot_mask (slot)) - 1];
+    return ((p_leaf != NULL) ? p_leaf : p_best);
+}
+
+/* Off the fast path, the prefixes of the nodes are matched one by one */
+void *fib_lpm_lookup_len (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t max_len)
+{
+    const t_fib_lpm_node *p_node = &p_lpm->root;
+    void                 *p_best = p_lpm->p_default;
+    uint32_t              depth = 0, slot = 0, best_len = 0, ix = 0;
+
+    for (;;) {
+        slot = fib_lpm_key_slot (p_key, depth);
+        best_len = 0;
+        for (ix = 0; ix < p_node->num_pfx; ix++) {
+            const t_fib_lpm_pfx *p_pfx = &p_node->p_pfx[ix];
+
+            if ((p_pfx->len > best_len) && ((depth + p_pfx->len) <= max_len) &&
+                (p_pfx->bits == (slot >> (FIB_LPM_STRIDE - p_pfx->len)))) {
+                p_best = p_pfx->p_val;
+                best_len = p_pfx->len;
+            }
+        }
+        if (((depth + FIB_LPM_STRIDE) >= max_len) || (!(p_node->vector & (1ULL << slot))))
+            break;
+        p_node = &p_node->p_child[__builtin_popcountll (p_node->vector & ((1ULL << slot) - 1))];
+        depth += FIB_LPM_STRIDE;
+    }
+
+    return p_best;
+}
+
+/* A longer prefix of the same key is never returned, so a walk from a
+ * prefix to its next best fit always moves to a shorter prefix */
+void *fib_lpm_next_best (const t_fib_lpm *p_lpm, const t_fib_lpm_key *p_key, uint32_t len)
+{
+    if (len == 0)
+        return NULL;
+
+    return fib_lpm_lookup_len (p_lpm, p_key, len - 1);
+}
@@ -30,6 +30,7 @@
 #include "hal_rt_debug.h"
 #include "hal_rt_util.h"
 #include "nas_rt_api.h"
+#include "hal_rt_lockstat.h"
 #include "hal_rt_mpath_grp.h"
 #include "hal_if_mapping.h"
 #include "nas_switch.h"
@@ -51,14 +52,24 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Thread names are limited to 16 chars including the null */
+#define HAL_RT_MSG_THREAD_NAME_LEN 16
 
 /**************************************************************************
  *                            GLOBALS
  **************************************************************************/
 static std_thread_create_param_t hal_rt_dr_thr;
 static std_thread_create_param_t hal_rt_nh_thr;
-static std_thread_create_param_t hal_rt_msg_thr;
+static std_thread_create_param_t hal_rt_msg_thr[FIB_MAX_MSG_WORKERS];
+static char hal_rt_msg_thr_name[FIB_MAX_MSG_WORKERS][HAL_RT_MSG_THREAD_NAME_LEN];
+static std_thread_create_param_t hal_rt_rslv_thr[FIB_MAX_RSLV_WORKERS];
+static char hal_rt_rslv_thr_name[FIB_MAX_RSLV_WORKERS][HAL_RT_MSG_THREAD_NAME_LEN];
 static std_thread_create_param_t hal_rt_offload_msg_thr;
 
 static t_fib_config      g_fib_config;
@@ -71,14 +82,147 @@ static cps_api_operation_handle_t nas_rt_nht_cps_handle;
 #define NUM_INT_NAS_RT_CPS_API_THREAD 1
 #define NUM_INT_NAS_RT_NHT_CPS_API_THREAD 1
 
-static std_mutex_lock_create_static_init_fast(nas_l3_mutex);
+/*
+ * nas_l3_lock protects the VRF/DR/NH/NHT/Intf databases. It is a writer
+ * preferring reader/writer lock, so that a stream of CPS gets can not hold
+ * off the msg workers and walkers. Each VRF has its own reader/writer lock
+ * for its DR/NH/MP/NHT trees, so that the VRFs converge independently.
+ * The VRF gate lock stops the VRF writers for the readers of all the VRFs,
+ * the VRF writers hold it shared and these readers exclusive.
+ *
+ * Exclusive mode (nas_l3_lock) - every path that modifies more than one VRF:
+ *   - HAL-RT msg workers for the intf msgs, the IP unreachable config,
+ *     the barrier msgs and the routes leaked across VRFs
+ *   - CPS sets/actions: event filter, peer routing, virtual routing IP,
+ *     FIB config, intf mode change, VRF config and the IP redirects config
+ *   - nas-rt-debug counters clear
+ *
+ * VRF mode (nas_l3_vrf_lock) - nas_l3_lock shared, the VRF gate lock shared
+ * and the VRF lock exclusive:
+ *   - HAL-RT msg workers for the route and nbr msgs of the VRF (batches and
+ *     the kernel route resync)
+ *   - DR and NH walkers, for each VRF in turn
+ *   - CPS NHT set
+ * A VRF with routes leaked to/from other VRFs (num_leak_refs) is locked
+ * exclusive instead, the DR of one VRF then refers the NH of the other.
+ * The leak refs are updated only with the nas_l3_lock exclusive, so they
+ * are stable for the holders of the shared nas_l3_lock.
+ *
+ * Read modes:
+ *   - nas_l3_vrf_lock_shared: nas_l3_lock shared and the VRF lock shared.
+ *     The route, ARP/neighbor, NHT and FIB summary gets. These take the
+ *     lock by themselves and drop it every FIB_GET_YIELD_COUNT entries, the
+ *     DR/NH they resume from is kept allocated by the epoch read section
+ *     (see hal_rt_epoch.h).
+ *   - nas_l3_lock_shared: nas_l3_lock shared and the VRF gate lock
+ *     exclusive, i.e. no VRF is being updated. The other CPS gets (event
+ *     filter, peer routing, virtual routing IP, IP unreachables, IP
+ *     redirects) and the nas-rt-debug dumps. These read the intf tree and
+ *     the VRF info of all the VRFs, the cost of the lock does not depend on
+ *     the no. of VRFs. They are rare, so they are not run concurrently.
+ * These paths only look up and walk the radix trees with keys on the stack
+ * (std_radix getexact/getnext), read the entries and build the CPS objects
+ * or print them, the address to string conversions use the per thread
+ * scratch buffers. They never publish, allocate or free a DB entry, update
+ * a counter or take the lock again.
+ *
+ * Lock order: nas_l3_lock, the VRF gate lock, a VRF lock, then the intf
+ * tree lock (see hal_rt_nh.c). No path holds more than one VRF lock, the
+ * paths that update more than one VRF take the nas_l3_lock exclusive.
+ * The intf tree is shared by all the VRFs, its lock is held only for the
+ * tree lookup/insert/remove, no other lock is taken with it held.
+ *
+ * The wait and hold times of the lock modes above are profiled per caller
+ * function in per thread buffers (see hal_rt_lockstat.h), the lock macros
+ * in hal_rt_main.h pass the caller. "nas-rt-debug lockstat" dumps them.
+ */
+static pthread_rwlock_t nas_l3_rwlock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+static pthread_rwlock_t nas_l3_vrf_gate_rwlock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
 
 /***************************************************************************
  *                          Private Functions
  ***************************************************************************/
 
+/* Value of the environment variable in the range min_val-max_val, false if
+ * it is not set or not valid, the config is retained for an invalid value */
+static bool hal_rt_config_env_get (const char *p_env, uint64_t min_val, uint64_t max_val,
+                                   uint64_t *p_val)
+{
+    const char         *p_str = getenv (p_env);
+    char               *p_end = NULL;
+    unsigned long long  val = 0;
+
+    if (p_str == NULL) {
+        return false;
+    }
+    errno = 0;
+    val = strtoull (p_str, &p_end, 0);
+    if ((errno != 0) || (p_end == p_str) || (*p_end != '\0') || (strchr (p_str, '-') != NULL)) {
+        HAL_RT_LOG_ERR("HAL-RT", "Invalid %s:%s, not a number", p_env, p_str);
+        return false;
+    }
+    if ((val < min_val) || (val > max_val)) {
+        HAL_RT_LOG_ERR("HAL-RT", "Invalid %s:%s, valid range %llu-%llu", p_env, p_str,
+                       (unsigned long long) min_val, (unsigned long long) max_val);
+        return false;
+    }
+    *p_val = val;
+    return true;
+}
+
+/* The tunables set in the environment, each one is range checked on its own
+ * and the default is retained for the ones not valid */
+static void hal_rt_config_env_init (void)
+{
+    uint64_t val = 0;
+
+    if (hal_rt_config_env_get (FIB_MSG_BATCH_SIZE_ENV, 1, FIB_MAX_MSG_BATCH_SIZE, &val)) {
+        hal_rt_fib_config_set_msg_batch_size ((uint32_t) val);
+    }
+    if (hal_rt_config_env_get (FIB_MSG_BATCH_TIME_BUDGET_ENV, 0, UINT32_MAX, &val)) {
+        hal_rt_fib_config_set_msg_batch_time_budget ((uint32_t) val);
+    }
+    if (hal_rt_config_env_get (FIB_WALKER_TIME_BUDGET_ENV, 0, UINT32_MAX, &val)) {
+        hal_rt_fib_config_set_walker_time_budget ((uint32_t) val);
+    }
+    if (hal_rt_config_env_get (FIB_WALKER_COALESCE_TIME_ENV, 0, UINT32_MAX, &val)) {
+        hal_rt_fib_config_set_walker_coalesce ((uint32_t) val, g_fib_config.walker_coalesce_changes);
+    }
+    if (hal_rt_config_env_get (FIB_WALKER_COALESCE_CHANGES_ENV, 0, UINT32_MAX, &val)) {
+        hal_rt_fib_config_set_walker_coalesce (g_fib_config.walker_coalesce_time, (uint32_t) val);
+    }
+    if (hal_rt_config_env_get (FIB_MSG_QUEUE_MAX_LEN_ENV, 1, FIB_MAX_MSG_QUEUE_LEN, &val)) {
+        hal_rt_fib_config_set_msg_queue_bounds ((uint32_t) val, g_fib_config.msg_queue_max_bytes,
+                                                g_fib_config.msg_queue_overflow_policy);
+    }
+    if (hal_rt_config_env_get (FIB_MSG_QUEUE_MAX_BYTES_ENV, 0, UINT64_MAX, &val)) {
+        hal_rt_fib_config_set_msg_queue_bounds (g_fib_config.msg_queue_max_len, val,
+                                                g_fib_config.msg_queue_overflow_policy);
+    }
+    if (hal_rt_config_env_get (FIB_MSG_QUEUE_OVERFLOW_ENV, FIB_MSG_QUEUE_OVERFLOW_BLOCK,
+                               (FIB_MSG_QUEUE_OVERFLOW_MAX - 1), &val)) {
+        hal_rt_fib_config_set_msg_queue_bounds (g_fib_config.msg_queue_max_len,
+                                                g_fib_config.msg_queue_max_bytes,
+                                                (t_fib_msg_queue_overflow_policy) val);
+    }
+}
+
+/* No. of the resolution workers when not set in the environment */
+static uint32_t hal_rt_rslv_workers_default (void)
+{
+    long num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+    if (num_cpus <= 1) {
+        return 0;
+    }
+    return (((num_cpus - 1) < FIB_DEFAULT_MAX_RSLV_WORKERS) ?
+            (uint32_t)(num_cpus - 1) : FIB_DEFAULT_MAX_RSLV_WORKERS);
+}
+
 int hal_rt_config_init (void)
 {
+    uint64_t val = 0;
+
     /* Init the configs to default values */
     memset (&g_fib_config, 0, sizeof (g_fib_config));
     memset (&g_fib_gbl_info, 0, sizeof (g_fib_gbl_info));
@@ -86,6 +230,28 @@ int hal_rt_config_init (void)
     g_fib_config.ecmp_max_paths       = HAL_RT_MAX_ECMP_PATH;
     g_fib_config.ecmp_path_fall_back  = false;
     g_fib_config.ecmp_hash_sel        = FIB_DEFAULT_ECMP_HASH;
+    g_fib_config.msg_batch_size       = FIB_DEFAULT_MSG_BATCH_SIZE;
+    g_fib_config.msg_batch_time_budget = FIB_DEFAULT_MSG_BATCH_TIME_BUDGET;
+    g_fib_config.msg_queue_max_len    = FIB_DEFAULT_MSG_QUEUE_MAX_LEN;
+    g_fib_config.msg_queue_max_bytes  = FIB_DEFAULT_MSG_QUEUE_MAX_BYTES;
+    g_fib_config.msg_queue_overflow_policy = FIB_MSG_QUEUE_OVERFLOW_BLOCK;
+    g_fib_config.msg_workers          = FIB_DEFAULT_MSG_WORKERS;
+    g_fib_config.walker_time_budget   = FIB_DEFAULT_WALKER_TIME_BUDGET;
+    g_fib_config.walker_coalesce_time = FIB_DEFAULT_WALKER_COALESCE_TIME;
+    g_fib_config.walker_coalesce_changes = FIB_DEFAULT_WALKER_COALESCE_CHANGES;
+    g_fib_config.rslv_workers         = hal_rt_rslv_workers_default ();
+
+    if (hal_rt_config_env_get (FIB_MSG_WORKERS_ENV, 1, FIB_MAX_MSG_WORKERS, &val)) {
+        g_fib_config.msg_workers = (uint32_t) val;
+    }
+    hal_rt_msg_workers_init (g_fib_config.msg_workers);
+
+    if (hal_rt_config_env_get (FIB_RSLV_WORKERS_ENV, 0, FIB_MAX_RSLV_WORKERS, &val)) {
+        g_fib_config.rslv_workers = (uint32_t) val;
+    }
+    hal_rt_msg_queue_set_bounds (g_fib_config.msg_queue_max_len, g_fib_config.msg_queue_max_bytes,
+                                 g_fib_config.msg_queue_overflow_policy);
+    hal_rt_config_env_init ();
 
     return STD_ERR_OK;
 }
@@ -95,19 +261,176 @@ const t_fib_config * hal_rt_access_fib_config(void)
     return(&g_fib_config);
 }
 
+/* The configs below are set from the environment at init and from the FIB
+ * config CPS object with the nas_l3_lock held, the msg workers and walkers
+ * read each one once per batch, a change applies from their next batch */
+t_std_error hal_rt_fib_config_set_msg_batch_size (uint32_t batch_size)
+{
+    if ((batch_size == 0) || (batch_size > FIB_MAX_MSG_BATCH_SIZE)) {
+        HAL_RT_LOG_ERR("HAL-RT", "Invalid msg batch size:%d, valid range 1-%d",
+                       batch_size, FIB_MAX_MSG_BATCH_SIZE);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_PARAM, 0));
+    }
+    g_fib_config.msg_batch_size = batch_size;
+    return STD_ERR_OK;
+}
+
+t_std_error hal_rt_fib_config_set_msg_batch_time_budget (uint32_t time_budget)
+{
+    g_fib_config.msg_batch_time_budget = time_budget;
+    return STD_ERR_OK;
+}
+
+/* The walkers read the time budget with the nas_l3_lock held shared */
+t_std_error hal_rt_fib_config_set_walker_time_budget (uint32_t time_budget)
+{
+    g_fib_config.walker_time_budget = time_budget;
+    return STD_ERR_OK;
+}
+
+/* The coalesce window is read by the msg workers and the DR walker without
+ * any lock, a change applies from the next route change */
+t_std_error hal_rt_fib_config_set_walker_coalesce (uint32_t coalesce_time, uint32_t coalesce_changes)
+{
+    g_fib_config.walker_coalesce_time = coalesce_time;
+    g_fib_config.walker_coalesce_changes = coalesce_changes;
+    return STD_ERR_OK;
+}
+
+/* The msg queue bounds are applied to the queue right away, the producers
+ * read them from the queue without any lock */
+t_std_error hal_rt_fib_config_set_msg_queue_bounds (uint32_t max_len, uint64_t max_bytes,
+                                                    t_fib_msg_queue_overflow_policy policy)
+{
+    if ((max_len == 0) || (max_len > FIB_MAX_MSG_QUEUE_LEN)) {
+        HAL_RT_LOG_ERR("HAL-RT", "Invalid msg queue max len:%d, valid range 1-%d",
+                       max_len, FIB_MAX_MSG_QUEUE_LEN);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_PARAM, 0));
+    }
+    if ((policy < FIB_MSG_QUEUE_OVERFLOW_BLOCK) || (policy >= FIB_MSG_QUEUE_OVERFLOW_MAX)) {
+        HAL_RT_LOG_ERR("HAL-RT", "Invalid msg queue overflow policy:%d", policy);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_PARAM, 0));
+    }
+    g_fib_config.msg_queue_max_len = max_len;
+    g_fib_config.msg_queue_max_bytes = max_bytes;
+    g_fib_config.msg_queue_overflow_policy = policy;
+    hal_rt_msg_queue_set_bounds (max_len, max_bytes, policy);
+    return STD_ERR_OK;
+}
+
 t_fib_gbl_info * hal_rt_access_fib_gbl_info(void)
 {
     return(&g_fib_gbl_info);
 }
 
-void nas_l3_lock()
+void nas_l3_lock_at(const char *site)
 {
-    std_mutex_lock(&nas_l3_mutex);
+    uint64_t start = hal_rt_lockstat_start();
+
+    pthread_rwlock_wrlock(&nas_l3_rwlock);
+    hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_EXCL, start);
 }
 
 void nas_l3_unlock()
 {
-    std_mutex_unlock(&nas_l3_mutex);
+    hal_rt_lockstat_released();
+    pthread_rwlock_unlock(&nas_l3_rwlock);
+    hal_rt_epoch_retire_flush();
+}
+
+void nas_l3_lock_shared_at(const char *site)
+{
+    uint64_t start = hal_rt_lockstat_start();
+
+    pthread_rwlock_rdlock(&nas_l3_rwlock);
+    pthread_rwlock_wrlock(&nas_l3_vrf_gate_rwlock);
+    hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_SHARED, start);
+}
+
+void nas_l3_unlock_shared()
+{
+    hal_rt_lockstat_released();
+    pthread_rwlock_unlock(&nas_l3_vrf_gate_rwlock);
+    pthread_rwlock_unlock(&nas_l3_rwlock);
+}
+
+static inline t_fib_vrf *nas_l3_vrf_get(hal_vrf_id_t vrf_id)
+{
+    return ((vrf_id < FIB_MAX_VRF) ? ga_fib_vrf[vrf_id] : NULL);
+}
+
+t_fib_vrf_lock_mode nas_l3_vrf_lock_at(hal_vrf_id_t vrf_id, const char *site)
+{
+    t_fib_vrf *p_vrf = NULL;
+    uint64_t start = hal_rt_lockstat_start();
+
+    pthread_rwlock_rdlock(&nas_l3_rwlock);
+    if ((p_vrf = nas_l3_vrf_get(vrf_id)) == NULL) {
+        hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_VRF, start);
+        return FIB_VRF_LOCK_NONE;
+    }
+
+    if (p_vrf->num_leak_refs == 0) {
+        pthread_rwlock_rdlock(&nas_l3_vrf_gate_rwlock);
+        pthread_rwlock_wrlock(&p_vrf->lock);
+        hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_VRF, start);
+        return FIB_VRF_LOCK_VRF;
+    }
+    /* Leaked routes update the other VRFs as well */
+    pthread_rwlock_unlock(&nas_l3_rwlock);
+    pthread_rwlock_wrlock(&nas_l3_rwlock);
+    hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_EXCL, start);
+    return FIB_VRF_LOCK_EXCL;
+}
+
+void nas_l3_vrf_unlock(hal_vrf_id_t vrf_id, t_fib_vrf_lock_mode mode)
+{
+    hal_rt_lockstat_released();
+    if (mode == FIB_VRF_LOCK_VRF) {
+        pthread_rwlock_unlock(&ga_fib_vrf[vrf_id]->lock);
+        pthread_rwlock_unlock(&nas_l3_vrf_gate_rwlock);
+    }
+    pthread_rwlock_unlock(&nas_l3_rwlock);
+    hal_rt_epoch_retire_flush();
+}
+
+void nas_l3_vrf_lock_shared_at(hal_vrf_id_t vrf_id, const char *site)
+{
+    t_fib_vrf *p_vrf = NULL;
+    uint64_t start = hal_rt_lockstat_start();
+
+    pthread_rwlock_rdlock(&nas_l3_rwlock);
+    /* The writers of the VRFs with leaked routes hold the nas_l3_lock
+     * exclusive, so the NHs leaked from other VRFs are stable as well */
+    if ((p_vrf = nas_l3_vrf_get(vrf_id)) != NULL)
+        pthread_rwlock_rdlock(&p_vrf->lock);
+    hal_rt_lockstat_acquired(site, HAL_RT_LOCK_MODE_VRF_SHARED, start);
+}
+
+void nas_l3_vrf_unlock_shared(hal_vrf_id_t vrf_id)
+{
+    t_fib_vrf *p_vrf = NULL;
+
+    hal_rt_lockstat_released();
+    if ((p_vrf = nas_l3_vrf_get(vrf_id)) != NULL)
+        pthread_rwlock_unlock(&p_vrf->lock);
+    pthread_rwlock_unlock(&nas_l3_rwlock);
+}
+
+void hal_rt_vrf_leak_ref_update(hal_vrf_id_t dr_vrf_id, hal_vrf_id_t nh_vrf_id, bool is_add)
+{
+    t_fib_vrf *vrfs[] = {nas_l3_vrf_get(dr_vrf_id), nas_l3_vrf_get(nh_vrf_id)};
+    uint32_t   ix = 0;
+
+    for (ix = 0; ix < (sizeof(vrfs)/sizeof(vrfs[0])); ix++) {
+        if (vrfs[ix] == NULL)
+            continue;
+        if (is_add) {
+            vrfs[ix]->num_leak_refs++;
+        } else if (vrfs[ix]->num_leak_refs > 0) {
+            vrfs[ix]->num_leak_refs--;
+        }
+    }
 }
 
 t_fib_vrf * hal_rt_access_fib_vrf(uint32_t vrf_id)
@@ -153,6 +476,7 @@ int hal_rt_vrf_init (hal_vrf_id_t vrf_id, const char *vrf_name)
     uint8_t         af_index = 0;
     ndi_vrf_id_t    ndi_vr_id = 0;
     t_std_error     rc = STD_ERR_OK;
+    pthread_rwlockattr_t lock_attr;
 
     p_vrf = hal_rt_access_fib_vrf(vrf_id);
     if (p_vrf != NULL) {
@@ -185,6 +509,10 @@ int hal_rt_vrf_init (hal_vrf_id_t vrf_id, const char *vrf_name)
     memset (p_vrf, 0, sizeof (t_fib_vrf));
     p_vrf->vrf_id = vrf_id;
     p_vrf->vrf_obj_id = ndi_vr_id;
+    pthread_rwlockattr_init(&lock_attr);
+    pthread_rwlockattr_setkind_np(&lock_attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&p_vrf->lock, &lock_attr);
+    pthread_rwlockattr_destroy(&lock_attr);
 
     memcpy(&p_vrf->router_mac, &gbl_info->base_mac_addr, HAL_MAC_ADDR_LEN);
     ga_fib_vrf[vrf_id] = p_vrf;
@@ -278,6 +606,8 @@ int hal_rt_vrf_de_init (hal_vrf_id_t vrf_id)
     nas_route_delete_vrf_peer_mac_config(vrf_id);
     nas_route_delete_vrf_virtual_routing_ip_config(vrf_id);
 
+    /* Called with the nas_l3_lock exclusive, the VRF lock is not held by anyone */
+    pthread_rwlock_destroy(&p_vrf->lock);
     memset (p_vrf, 0, sizeof (t_fib_vrf));
     FIB_VRF_MEM_FREE (p_vrf);
     ga_fib_vrf[vrf_id] = NULL;
@@ -646,9 +976,8 @@ static bool hal_rt_process_msg(cps_api_object_t obj, void *param)
             /* Enqueue the intf messages for further processing
              * only it has the admin attribute.*/
             if (hal_rt_cps_obj_to_intf(obj,&intf)) {
-                p_msg = hal_rt_alloc_mem_msg();
+                p_msg = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_NL_INTF);
                 if (p_msg) {
-                    p_msg->type = FIB_MSG_TYPE_NL_INTF;
                     memcpy(&(p_msg->intf), &intf, sizeof(intf));
                     nas_rt_process_msg(p_msg);
                 }
@@ -755,6 +1084,7 @@ t_std_error hal_rt_nht_cps_thread(void)
 t_std_error hal_rt_init(void)
 {
     t_std_error     rc = STD_ERR_OK;
+    uint32_t        worker_id = 0;
 
     HAL_RT_LOG_DEBUG("HAL-RT", "Initializing HAL-Routing Threads");
 
@@ -788,12 +1118,33 @@ t_std_error hal_rt_init(void)
         return STD_ERR(ROUTE,FAIL,0);
     }
 
-    std_thread_init_struct(&hal_rt_msg_thr);
-    hal_rt_msg_thr.name = "hal-rt-msg";
-    hal_rt_msg_thr.thread_function = (std_thread_function_t)fib_msg_main;
-    if (std_thread_create(&hal_rt_msg_thr)!=STD_ERR_OK) {
-        HAL_RT_LOG_ERR( "HAL-RT-THREAD", "Error creating msg thread");
-        return STD_ERR(ROUTE,FAIL,0);
+    for (worker_id = 0; worker_id < g_fib_config.msg_workers; worker_id++) {
+        std_thread_init_struct(&hal_rt_msg_thr[worker_id]);
+        if (worker_id == 0) {
+            safestrncpy(hal_rt_msg_thr_name[worker_id], "hal-rt-msg", HAL_RT_MSG_THREAD_NAME_LEN);
+        } else {
+            snprintf(hal_rt_msg_thr_name[worker_id], HAL_RT_MSG_THREAD_NAME_LEN,
+                     "hal-rt-msg-%d", worker_id);
+        }
+        hal_rt_msg_thr[worker_id].name = hal_rt_msg_thr_name[worker_id];
+        hal_rt_msg_thr[worker_id].thread_function = (std_thread_function_t)fib_msg_main;
+        hal_rt_msg_thr[worker_id].param = (void *)(uintptr_t)worker_id;
+        if (std_thread_create(&hal_rt_msg_thr[worker_id])!=STD_ERR_OK) {
+            HAL_RT_LOG_ERR( "HAL-RT-THREAD", "Error creating msg thread:%d", worker_id);
+            return STD_ERR(ROUTE,FAIL,0);
+        }
+    }
+
+    for (worker_id = 0; worker_id < g_fib_config.rslv_workers; worker_id++) {
+        std_thread_init_struct(&hal_rt_rslv_thr[worker_id]);
+        snprintf(hal_rt_rslv_thr_name[worker_id], HAL_RT_MSG_THREAD_NAME_LEN,
+                 "hal-rt-rslv-%d", worker_id);
+        hal_rt_rslv_thr[worker_id].name = hal_rt_rslv_thr_name[worker_id];
+        hal_rt_rslv_thr[worker_id].thread_function = (std_thread_function_t)fib_rslv_worker_main;
+        if (std_thread_create(&hal_rt_rslv_thr[worker_id])!=STD_ERR_OK) {
+            HAL_RT_LOG_ERR( "HAL-RT-THREAD", "Error creating resolution thread:%d", worker_id);
+            return STD_ERR(ROUTE,FAIL,0);
+        }
     }
 
     std_thread_init_struct(&hal_rt_offload_msg_thr);
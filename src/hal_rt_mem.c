@@ -24,6 +24,7 @@
 #include "hal_rt_mem.h"
 #include "hal_rt_route.h"
 #include "hal_rt_debug.h"
+#include "hal_rt_util.h"
 #include "hal_rt_mpath_grp.h"
 
 #include "event_log.h"
@@ -32,9 +33,8 @@
 
 t_fib_dr *fib_alloc_dr_node (void)
 {
-    t_fib_dr          *p_dr;
-    t_fib_hal_dr_info *p_hal_dr_info;
-    void              *p_buf = NULL;
+    t_fib_dr *p_dr;
+    int       unit;
 
     p_dr = (t_fib_dr *) FIB_DR_MEM_MALLOC ();
 
@@ -44,31 +44,56 @@ t_fib_dr *fib_alloc_dr_node (void)
 
     memset (p_dr, 0, sizeof (t_fib_dr));
 
-       p_buf = malloc(sizeof (t_fib_hal_dr_info));
-       if (p_buf != NULL) {
-           memset (p_buf, 0, sizeof (t_fib_hal_dr_info));
-
-           p_hal_dr_info = (t_fib_hal_dr_info *) p_buf;
-           int unit;
-           for (unit = 0; unit <= hal_rt_access_fib_config()->max_num_npu; unit++) {
-               p_hal_dr_info->a_obj_status [unit] = HAL_RT_STATUS_ECMP_INVALID;
-           }
-       }
-       p_dr->p_hal_dr_handle = (void *) p_buf;
+    for (unit = 0; unit <= hal_rt_access_fib_config()->max_num_npu; unit++) {
+        p_dr->hal_dr_info.a_obj_status [unit] = HAL_RT_STATUS_ECMP_INVALID;
+    }
 
     return p_dr;
 }
 
-void fib_free_dr_node (t_fib_dr *p_dr)
+t_fib_dr_cold *fib_get_dr_cold (t_fib_dr *p_dr)
+{
+    t_fib_dr_cold *p_dr_cold = p_dr->p_cold;
+
+    if (p_dr_cold != NULL) {
+        return p_dr_cold;
+    }
+
+    p_dr_cold = (t_fib_dr_cold *) FIB_DR_COLD_MEM_MALLOC ();
+
+    if (p_dr_cold == NULL) {
+        HAL_RT_LOG_ERR("HAL-RT-DR", "%s (): Memory alloc failed. vrf_id: %d, prefix: %s/%d",
+                       __FUNCTION__, p_dr->vrf_id,
+                       FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+        return NULL;
+    }
+
+    memset (p_dr_cold, 0, sizeof (t_fib_dr_cold));
+    std_dll_init (&p_dr_cold->degen_dr_fh.tunnel_fh_list);
+
+    p_dr->p_cold = p_dr_cold;
+
+    return p_dr_cold;
+}
+
+static void fib_reclaim_dr_node (void *p_node)
 {
-    if (p_dr->p_hal_dr_handle != NULL) {
-        free ((void *) p_dr->p_hal_dr_handle);
-        p_dr->p_hal_dr_handle = NULL;
+    t_fib_dr *p_dr = (t_fib_dr *) p_node;
+
+    if (p_dr->p_cold != NULL) {
+        FIB_DR_COLD_MEM_FREE (p_dr->p_cold);
+        p_dr->p_cold = NULL;
     }
 
     FIB_DR_MEM_FREE (p_dr);
 }
 
+/* The DR could still be referred by an epoch reader, free is deferred */
+void fib_free_dr_node (t_fib_dr *p_dr)
+{
+    hal_rt_epoch_retire (p_dr, fib_reclaim_dr_node);
+}
+
 t_fib_nh *fib_alloc_nh_node (void)
 {
     t_fib_nh *p_nh;
@@ -84,8 +109,10 @@ t_fib_nh *fib_alloc_nh_node (void)
     return p_nh;
 }
 
-void fib_free_nh_node (t_fib_nh *p_nh)
+static void fib_reclaim_nh_node (void *p_node)
 {
+    t_fib_nh *p_nh = (t_fib_nh *) p_node;
+
     if (p_nh->p_hal_nh_handle != NULL) {
         free(p_nh->p_hal_nh_handle);
         p_nh->p_hal_nh_handle = NULL;
@@ -94,11 +121,18 @@ void fib_free_nh_node (t_fib_nh *p_nh)
     FIB_NH_MEM_FREE (p_nh);
 }
 
+/* The NH could still be referred by an epoch reader, free is deferred */
+void fib_free_nh_node (t_fib_nh *p_nh)
+{
+    hal_rt_epoch_retire (p_nh, fib_reclaim_nh_node);
+}
+
+/* Updated by the VRF writers concurrently */
 static int num_tunnel_fh_nodes = 0;
 
 int fib_num_tunnel_fh_nodes (void)
 {
-    return num_tunnel_fh_nodes;
+    return __atomic_load_n (&num_tunnel_fh_nodes, __ATOMIC_RELAXED);
 }
 
 t_fib_tunnel_fh *fib_alloc_tunnel_fh_node (void)
@@ -113,7 +147,7 @@ t_fib_tunnel_fh *fib_alloc_tunnel_fh_node (void)
 
     memset (p_tunnel_fh, 0, sizeof (t_fib_tunnel_fh));
 
-    num_tunnel_fh_nodes++;
+    __atomic_add_fetch (&num_tunnel_fh_nodes, 1, __ATOMIC_RELAXED);
 
     return p_tunnel_fh;
 }
@@ -126,8 +160,8 @@ void fib_free_tunnel_fh_node (t_fib_tunnel_fh *p_tunnel_fh)
 
     FIB_TUNNEL_FH_MEM_FREE (p_tunnel_fh);
 
-    if (num_tunnel_fh_nodes > 0) {
-        num_tunnel_fh_nodes--;
+    if (__atomic_load_n (&num_tunnel_fh_nodes, __ATOMIC_RELAXED) > 0) {
+        __atomic_sub_fetch (&num_tunnel_fh_nodes, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -517,7 +517,16 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
             /*
              * Change to new group handle
              */
-            p_dr->old_nh_handle_nht = p_dr->nh_handle;
+            if (p_dr->nh_handle != 0) {
+                if (fib_get_dr_cold (p_dr) != NULL) {
+                    p_dr->p_cold->old_nh_handle_nht = p_dr->nh_handle;
+                } else {
+                    HAL_RT_LOG_ERR("HAL-RT-MP",
+                                   "NHT ACLs of the old group %lu not flushed, no DR cold info. "
+                                   "Vrf_id: %d, Prefix: %s/%d", p_dr->nh_handle, vrf_id,
+                                   FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+                }
+            }
             p_dr->nh_handle = route_entry.nh_handle;
 
         } else {
@@ -541,7 +550,9 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
         if (route_entry.action == NDI_ROUTE_PACKET_ACTION_FORWARD) {
             nas_rt_handle_dest_change(p_dr, NULL, true);
         }
-        p_dr->old_nh_handle_nht = 0;
+        if (p_dr->p_cold != NULL) {
+            p_dr->p_cold->old_nh_handle_nht = 0;
+        }
 
         /*
          * Delete old group id that was marked for deletion
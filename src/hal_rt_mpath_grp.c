@@ -162,7 +162,7 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
     uint8_t             aui1_md5_digest [HAL_RT_MD5_DIGEST_LEN];
     next_hop_id_t       a_nh_obj_id [HAL_RT_MAX_ECMP_PATH];
 
-    p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+    p_hal_dr_info = &p_dr->hal_dr_info;
     unit = entry->npu_id;
 
     *p_out_is_mp_table_full   = false;
@@ -432,7 +432,7 @@ t_std_error hal_rt_delete_ecmp_group(t_fib_dr *p_dr, ndi_route_t  *entry,
     npu_id_t             unit;
     int             rc;
 
-    p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+    p_hal_dr_info = &p_dr->hal_dr_info;
     unit = entry->npu_id;
 
     p_mp_obj = p_hal_dr_info->ap_mp_obj [unit];
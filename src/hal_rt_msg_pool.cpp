@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_msg_pool.cpp
+ * \brief  HAL-RT message buffer pool
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_main.h"
+#include "hal_rt_util.h"
+#include "hal_rt_debug.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "hal_rt_msg_pool.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+static const char *hal_rt_msg_pool_class_name[HAL_RT_MSG_POOL_MAX] = {
+    "Intf", "Nbr", "Msg", "Route-NH1", "Route-NH4", "Route-NH16", "Route-NH64", "Offload"
+};
+
+static auto &hal_rt_msg_pool = *new hal_rt_msg_pool_t;
+
+static inline size_t hal_rt_msg_pool_stride (size_t buf_size)
+{
+    size_t size = sizeof(hal_rt_msg_pool_hdr_t) + buf_size;
+    return ((size + alignof(hal_rt_msg_pool_hdr_t) - 1) &
+            ~(alignof(hal_rt_msg_pool_hdr_t) - 1));
+}
+
+static inline size_t hal_rt_route_msg_size (size_t nh_count)
+{
+    return (sizeof(t_fib_msg) + (sizeof(t_fib_nh_info) * nh_count));
+}
+
+hal_rt_msg_pool_t::hal_rt_msg_pool_t ()
+{
+    size_t intf_size = std::max (sizeof(t_fib_intf_entry),
+                                 std::max (sizeof(t_fib_intf_ip_unreach_config),
+                                           sizeof(t_fib_intf_ip_redirects_config)));
+
+    init_class (HAL_RT_MSG_POOL_INTF, offsetof(t_fib_msg, intf) + intf_size,
+                HAL_RT_MSG_POOL_INTF_MAX);
+    init_class (HAL_RT_MSG_POOL_NBR, offsetof(t_fib_msg, nbr) + sizeof(t_fib_neighbour_entry),
+                HAL_RT_MSG_POOL_NBR_MAX);
+    init_class (HAL_RT_MSG_POOL_MSG, sizeof(t_fib_msg), HAL_RT_MSG_POOL_MSG_MAX);
+    init_class (HAL_RT_MSG_POOL_ROUTE_NH1, hal_rt_route_msg_size (1),
+                HAL_RT_MSG_POOL_ROUTE_NH1_MAX);
+    init_class (HAL_RT_MSG_POOL_ROUTE_NH4, hal_rt_route_msg_size (4),
+                HAL_RT_MSG_POOL_ROUTE_NH4_MAX);
+    init_class (HAL_RT_MSG_POOL_ROUTE_NH16, hal_rt_route_msg_size (16),
+                HAL_RT_MSG_POOL_ROUTE_NH16_MAX);
+    init_class (HAL_RT_MSG_POOL_ROUTE_NH64, hal_rt_route_msg_size (HAL_RT_MSG_POOL_ROUTE_MAX_NH),
+                HAL_RT_MSG_POOL_ROUTE_NH64_MAX);
+    init_class (HAL_RT_MSG_POOL_OFFLOAD, sizeof(t_fib_offload_msg), HAL_RT_MSG_POOL_OFFLOAD_MAX);
+
+    m_heap_in_use.store (0, std::memory_order_relaxed);
+    m_heap_allocs.store (0, std::memory_order_relaxed);
+}
+
+void hal_rt_msg_pool_t::init_class (hal_rt_msg_pool_class_t class_id, size_t buf_size,
+                                    size_t max_bufs)
+{
+    pool_class_t &pool_class = m_class[class_id];
+
+    pool_class.buf_size = buf_size;
+    pool_class.max_bufs = max_bufs;
+    /* Free ring holds all the buffers of the class, so the push never fails */
+    pool_class.free_ring.reset (new hal_rt_ring_t<char> (max_bufs));
+    pool_class.num_bufs.store (0, std::memory_order_relaxed);
+    pool_class.in_use.store (0, std::memory_order_relaxed);
+    pool_class.peak.store (0, std::memory_order_relaxed);
+    pool_class.hits.store (0, std::memory_order_relaxed);
+    pool_class.misses.store (0, std::memory_order_relaxed);
+}
+
+/* Allocates a new slab for the class, returns the first buffer of the slab
+ * and adds the rest to the free ring */
+char *hal_rt_msg_pool_t::grow (pool_class_t &pool_class)
+{
+    size_t num_bufs = std::min<size_t> (HAL_RT_MSG_POOL_SLAB_BUFS, pool_class.max_bufs);
+    size_t stride = hal_rt_msg_pool_stride (pool_class.buf_size);
+
+    if ((pool_class.num_bufs.fetch_add (num_bufs, std::memory_order_relaxed) + num_bufs) >
+        pool_class.max_bufs) {
+        pool_class.num_bufs.fetch_sub (num_bufs, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    char *p_slab = (char *)malloc (stride * num_bufs);
+    if (p_slab == nullptr) {
+        pool_class.num_bufs.fetch_sub (num_bufs, std::memory_order_relaxed);
+        return nullptr;
+    }
+    for (size_t ix = 1; ix < num_bufs; ix++) {
+        free_ring_push (pool_class, p_slab + (ix * stride));
+    }
+    return p_slab;
+}
+
+/* Free ring holds all the buffers of the class, so a failed push only means
+ * that a concurrent pop of the same slot is yet to complete */
+void hal_rt_msg_pool_t::free_ring_push (pool_class_t &pool_class, char *p_hdr)
+{
+    while (!pool_class.free_ring->push (p_hdr)) {
+        std::this_thread::yield();
+    }
+}
+
+/* Pop fails when the slot at the tail is still being pushed, retry a few
+ * times before growing the class when the ring is not really empty */
+char *hal_rt_msg_pool_t::free_ring_pop (pool_class_t &pool_class)
+{
+    char *p_hdr = nullptr;
+
+    for (int retry = 0; retry < HAL_RT_MSG_POOL_POP_RETRY; retry++) {
+        if ((p_hdr = pool_class.free_ring->pop()) != nullptr)
+            break;
+        if (pool_class.free_ring->size() == 0)
+            break;
+        std::this_thread::yield();
+    }
+    return p_hdr;
+}
+
+void *hal_rt_msg_pool_t::hdr_to_buf (char *p_hdr, uint32_t class_id, size_t buf_size)
+{
+    hal_rt_msg_pool_hdr_t *p_pool_hdr = (hal_rt_msg_pool_hdr_t *)p_hdr;
+
+    p_pool_hdr->class_id = class_id;
+    p_pool_hdr->buf_size = buf_size;
+    p_pool_hdr->magic = HAL_RT_MSG_POOL_HDR_MAGIC;
+    return (p_hdr + sizeof(hal_rt_msg_pool_hdr_t));
+}
+
+void *hal_rt_msg_pool_t::alloc (hal_rt_msg_pool_class_t class_id)
+{
+    pool_class_t &pool_class = m_class[class_id];
+    char *p_hdr = free_ring_pop (pool_class);
+
+    if (p_hdr) {
+        pool_class.hits.fetch_add (1, std::memory_order_relaxed);
+    } else {
+        pool_class.misses.fetch_add (1, std::memory_order_relaxed);
+        p_hdr = grow (pool_class);
+    }
+    if (p_hdr == nullptr) {
+        /* Class is at its limit, fall back to the heap */
+        p_hdr = (char *)malloc (sizeof(hal_rt_msg_pool_hdr_t) + pool_class.buf_size);
+        if (p_hdr == nullptr)
+            return nullptr;
+        m_heap_allocs.fetch_add (1, std::memory_order_relaxed);
+        m_heap_in_use.fetch_add (1, std::memory_order_relaxed);
+        return hdr_to_buf (p_hdr, HAL_RT_MSG_POOL_HEAP, pool_class.buf_size);
+    }
+
+    size_t in_use = pool_class.in_use.fetch_add (1, std::memory_order_relaxed) + 1;
+    size_t peak = pool_class.peak.load (std::memory_order_relaxed);
+    while ((in_use > peak) &&
+           !pool_class.peak.compare_exchange_weak (peak, in_use, std::memory_order_relaxed));
+    return hdr_to_buf (p_hdr, class_id, pool_class.buf_size);
+}
+
+void *hal_rt_msg_pool_t::alloc_route (size_t buf_size)
+{
+    for (int class_id = HAL_RT_MSG_POOL_ROUTE_NH1; class_id <= HAL_RT_MSG_POOL_ROUTE_NH64;
+         class_id++) {
+        if (buf_size <= m_class[class_id].buf_size)
+            return alloc ((hal_rt_msg_pool_class_t)class_id);
+    }
+
+    /* Too many nexthops to be pooled */
+    char *p_hdr = (char *)malloc (sizeof(hal_rt_msg_pool_hdr_t) + buf_size);
+    if (p_hdr == nullptr)
+        return nullptr;
+    m_heap_allocs.fetch_add (1, std::memory_order_relaxed);
+    m_heap_in_use.fetch_add (1, std::memory_order_relaxed);
+    return hdr_to_buf (p_hdr, HAL_RT_MSG_POOL_HEAP, buf_size);
+}
+
+void hal_rt_msg_pool_t::release (void *p_buf)
+{
+    if (p_buf == nullptr)
+        return;
+
+    char *p_hdr = (char *)p_buf - sizeof(hal_rt_msg_pool_hdr_t);
+    hal_rt_msg_pool_hdr_t *p_pool_hdr = (hal_rt_msg_pool_hdr_t *)p_hdr;
+
+    if (p_pool_hdr->magic != HAL_RT_MSG_POOL_HDR_MAGIC) {
+        HAL_RT_LOG_ERR("HAL-RT-MSG-POOL", "Invalid msg buffer:%p free, magic:0x%x",
+                       p_buf, p_pool_hdr->magic);
+        return;
+    }
+    /* Catch the double free */
+    p_pool_hdr->magic = 0;
+    if (p_pool_hdr->class_id >= HAL_RT_MSG_POOL_MAX) {
+        ::free (p_hdr);
+        m_heap_in_use.fetch_sub (1, std::memory_order_relaxed);
+        return;
+    }
+
+    pool_class_t &pool_class = m_class[p_pool_hdr->class_id];
+    pool_class.in_use.fetch_sub (1, std::memory_order_relaxed);
+    free_ring_push (pool_class, p_hdr);
+}
+
+size_t hal_rt_msg_pool_t::buf_size (const void *p_buf)
+{
+    if (p_buf == nullptr)
+        return 0;
+    return ((const hal_rt_msg_pool_hdr_t *)
+            ((const char *)p_buf - sizeof(hal_rt_msg_pool_hdr_t)))->buf_size;
+}
+
+std::string hal_rt_msg_pool_t::stats () const
+{
+    std::stringstream ss;
+    for (int class_id = 0; class_id < HAL_RT_MSG_POOL_MAX; class_id++) {
+        const pool_class_t &pool_class = m_class[class_id];
+        ss << "Class:" << hal_rt_msg_pool_class_name[class_id]
+           << " Size:" << pool_class.buf_size
+           << " Bufs:" << pool_class.num_bufs.load (std::memory_order_relaxed)
+           << " InUse:" << pool_class.in_use.load (std::memory_order_relaxed)
+           << " Peak:" << pool_class.peak.load (std::memory_order_relaxed)
+           << " Hits:" << pool_class.hits.load (std::memory_order_relaxed)
+           << " Misses:" << pool_class.misses.load (std::memory_order_relaxed) << "\n";
+    }
+    ss << "Heap InUse:" << m_heap_in_use.load (std::memory_order_relaxed)
+       << " Allocs:" << m_heap_allocs.load (std::memory_order_relaxed);
+    return ss.str();
+}
+
+void hal_rt_msg_pool_t::dump () const
+{
+    printf ("%-12s %-8s %-8s %-8s %-8s %-12s %-12s\r\n", "Class", "Size", "Bufs",
+            "InUse", "Peak", "Hits", "Misses");
+    printf ("***************************************************************************\r\n");
+    for (int class_id = 0; class_id < HAL_RT_MSG_POOL_MAX; class_id++) {
+        const pool_class_t &pool_class = m_class[class_id];
+        printf ("%-12s %-8zu %-8zu %-8zu %-8zu %-12llu %-12llu\r\n",
+                hal_rt_msg_pool_class_name[class_id], pool_class.buf_size,
+                pool_class.num_bufs.load (std::memory_order_relaxed),
+                pool_class.in_use.load (std::memory_order_relaxed),
+                pool_class.peak.load (std::memory_order_relaxed),
+                (unsigned long long)pool_class.hits.load (std::memory_order_relaxed),
+                (unsigned long long)pool_class.misses.load (std::memory_order_relaxed));
+    }
+    printf ("***************************************************************************\r\n");
+    printf ("  Heap InUse: %zu Allocs: %llu\r\n", m_heap_in_use.load (std::memory_order_relaxed),
+            (unsigned long long)m_heap_allocs.load (std::memory_order_relaxed));
+}
+
+static hal_rt_msg_pool_class_t hal_rt_msg_type_pool_class (t_fib_msg_type type, size_t *p_size)
+{
+    switch (type) {
+        case FIB_MSG_TYPE_NL_INTF:
+        case FIB_MSG_TYPE_NBR_MGR_INTF:
+            *p_size = offsetof(t_fib_msg, intf) + sizeof(t_fib_intf_entry);
+            return HAL_RT_MSG_POOL_INTF;
+        case FIB_MSG_TYPE_INTF_IP_UNREACH_CFG:
+            *p_size = offsetof(t_fib_msg, ip_unreach_cfg) + sizeof(t_fib_intf_ip_unreach_config);
+            return HAL_RT_MSG_POOL_INTF;
+        case FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG:
+            *p_size = offsetof(t_fib_msg, ip_redirects_cfg) + sizeof(t_fib_intf_ip_redirects_config);
+            return HAL_RT_MSG_POOL_INTF;
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+        case FIB_MSG_TYPE_NL_NBR:
+            *p_size = offsetof(t_fib_msg, nbr) + sizeof(t_fib_neighbour_entry);
+            return HAL_RT_MSG_POOL_NBR;
+        default:
+            break;
+    }
+    *p_size = sizeof(t_fib_msg);
+    return HAL_RT_MSG_POOL_MSG;
+}
+
+extern "C" {
+
+t_fib_msg *hal_rt_alloc_mem_msg() {
+    return (t_fib_msg *)hal_rt_msg_pool.alloc (HAL_RT_MSG_POOL_MSG);
+}
+
+/* allocate zeroed memory for the message of given type, only the
+ * union member of the type is accessible in the message.
+ */
+t_fib_msg *hal_rt_alloc_mem_msg_by_type(t_fib_msg_type type) {
+    size_t size = 0;
+    t_fib_msg *p_msg = (t_fib_msg *)hal_rt_msg_pool.alloc (hal_rt_msg_type_pool_class (type, &size));
+    if (p_msg) {
+        memset (p_msg, 0, size);
+        p_msg->type = type;
+    }
+    return p_msg;
+}
+
+/* allocate memory for the route message for given buffer size.
+ * route message buffer size is calculated based on the nh_count
+ * in the message.
+ */
+t_fib_msg *hal_rt_alloc_route_mem_msg(uint32_t buf_size) {
+    return (t_fib_msg *)hal_rt_msg_pool.alloc_route (buf_size);
+}
+
+void hal_rt_free_mem_msg(t_fib_msg *p_msg) {
+    hal_rt_msg_pool.release (p_msg);
+}
+
+size_t hal_rt_msg_buf_size(const t_fib_msg *p_msg) {
+    return hal_rt_msg_pool_t::buf_size (p_msg);
+}
+
+size_t hal_rt_route_msg_nh_max(const t_fib_msg *p_msg) {
+    size_t buf_size = hal_rt_msg_pool_t::buf_size (p_msg);
+    if (buf_size <= sizeof(t_fib_msg))
+        return 0;
+    return ((buf_size - sizeof(t_fib_msg)) / sizeof(t_fib_nh_info));
+}
+
+t_fib_offload_msg *hal_rt_alloc_offload_msg() {
+    return (t_fib_offload_msg *)hal_rt_msg_pool.alloc (HAL_RT_MSG_POOL_OFFLOAD);
+}
+
+void hal_rt_free_offload_msg(t_fib_offload_msg *p_offload_msg) {
+    hal_rt_msg_pool.release (p_offload_msg);
+}
+
+void hal_rt_msg_pool_dump (void) {
+    hal_rt_msg_pool.dump ();
+}
+
+}
@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_msg_queue.cpp
+ * \brief  HAL-RT lock-free message queue
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hal_rt_main.h"
+#include "hal_rt_util.h"
+#include "hal_rt_debug.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "hal_rt_msg_queue.h"
+
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+size_t hal_rt_route_key_hash_t::operator() (const hal_rt_route_key_t &key) const
+{
+    /* FNV-1a over the key bytes */
+    const uint8_t *p = (const uint8_t *)&key;
+    size_t hash = 14695981039346656037ULL;
+    for (size_t ix = 0; ix < sizeof(key); ix++) {
+        hash ^= p[ix];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool hal_rt_route_key_equal_t::operator() (const hal_rt_route_key_t &key1,
+                                           const hal_rt_route_key_t &key2) const
+{
+    return (memcmp (&key1, &key2, sizeof(hal_rt_route_key_t)) == 0);
+}
+
+/* Link local routes are reference counted per interface and
+ * are never coalesced */
+static bool hal_rt_msg_route_key_get (t_fib_route_entry *p_rt, hal_rt_route_key_t *p_key)
+{
+    if (STD_IP_IS_ADDR_LINK_LOCAL(&p_rt->prefix))
+        return false;
+
+    memset (p_key, 0, sizeof(*p_key));
+    p_key->vrf_id = p_rt->vrfid;
+    p_key->af = p_rt->prefix.af_index;
+    p_key->prefix_len = p_rt->prefix_masklen;
+    if (p_rt->prefix.af_index == HAL_INET4_FAMILY) {
+        memcpy (p_key->addr, &p_rt->prefix.u.v4_addr, HAL_INET4_LEN);
+    } else {
+        memcpy (p_key->addr, &p_rt->prefix.u.v6_addr, HAL_INET6_LEN);
+    }
+    return true;
+}
+
+static bool hal_rt_msg_is_same_nh_list (t_fib_route_entry *p_rt1, t_fib_route_entry *p_rt2)
+{
+    if ((p_rt1->hop_count != p_rt2->hop_count) || (p_rt1->nh_vrfid != p_rt2->nh_vrfid))
+        return false;
+
+    for (size_t ix = 0; ix < p_rt1->hop_count; ix++) {
+        t_fib_nh_info *p_nh1 = &p_rt1->nh_list[ix];
+        t_fib_nh_info *p_nh2 = &p_rt2->nh_list[ix];
+        if ((p_nh1->nh_if_index != p_nh2->nh_if_index) ||
+            (p_nh1->nh_addr.af_index != p_nh2->nh_addr.af_index))
+            return false;
+        size_t addr_len = (p_nh1->nh_addr.af_index == HAL_INET4_FAMILY) ? HAL_INET4_LEN : HAL_INET6_LEN;
+        if (memcmp (&p_nh1->nh_addr.u, &p_nh2->nh_addr.u, addr_len) != 0)
+            return false;
+    }
+    return true;
+}
+
+static const uint32_t hal_rt_msg_lane_weight[HAL_RT_MSG_LANE_MAX] = {
+    HAL_RT_MSG_LANE_INTF_WEIGHT,
+    HAL_RT_MSG_LANE_NBR_WEIGHT,
+    HAL_RT_MSG_LANE_ROUTE_WEIGHT,
+};
+
+static const char *hal_rt_msg_lane_name[HAL_RT_MSG_LANE_MAX] = {
+    "Intf", "Nbr", "Route"
+};
+
+static hal_rt_msg_lane_t hal_rt_msg_lane_get (int msg_type)
+{
+    switch (msg_type) {
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+        case FIB_MSG_TYPE_NL_NBR:
+            return HAL_RT_MSG_LANE_NBR;
+        case FIB_MSG_TYPE_NL_ROUTE:
+            return HAL_RT_MSG_LANE_ROUTE;
+        default:
+            break;
+    }
+    return HAL_RT_MSG_LANE_INTF;
+}
+
+/* Interfaces the msg refers to, for the per interface ordering across lanes */
+static void hal_rt_msg_if_index_get (t_fib_msg *p_msg, std::vector<hal_ifindex_t> &if_list)
+{
+    if_list.clear();
+    switch (p_msg->type) {
+        case FIB_MSG_TYPE_NL_INTF:
+        case FIB_MSG_TYPE_NBR_MGR_INTF:
+            if_list.push_back (p_msg->intf.if_index);
+            break;
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+        case FIB_MSG_TYPE_NL_NBR:
+            if_list.push_back (p_msg->nbr.if_index);
+            break;
+        case FIB_MSG_TYPE_NL_ROUTE:
+            for (size_t ix = 0; ix < p_msg->route.hop_count; ix++) {
+                if_list.push_back (p_msg->route.nh_list[ix].nh_if_index);
+            }
+            break;
+        case FIB_MSG_TYPE_INTF_IP_UNREACH_CFG:
+            if_list.push_back (p_msg->ip_unreach_cfg.if_index);
+            break;
+        case FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG:
+            if_list.push_back (p_msg->ip_redirects_cfg.if_index);
+            break;
+        default:
+            break;
+    }
+}
+
+hal_rt_msgq_t::hal_rt_msgq_t (size_t depth) : m_ring (depth)
+{
+    m_consumer_idle.store (false, std::memory_order_relaxed);
+    m_peak.store (0, std::memory_order_relaxed);
+    m_full_cnt.store (0, std::memory_order_relaxed);
+    m_coalesced_cnt.store (0, std::memory_order_relaxed);
+    m_staged_cnt.store (0, std::memory_order_relaxed);
+    memset (m_fence_pos, 0, sizeof(m_fence_pos));
+    m_bytes.store (0, std::memory_order_relaxed);
+    m_peak_bytes.store (0, std::memory_order_relaxed);
+    m_max_len.store (FIB_DEFAULT_MSG_QUEUE_MAX_LEN, std::memory_order_relaxed);
+    m_max_bytes.store (FIB_DEFAULT_MSG_QUEUE_MAX_BYTES, std::memory_order_relaxed);
+    m_overflow_policy.store (FIB_MSG_QUEUE_OVERFLOW_BLOCK, std::memory_order_relaxed);
+    m_block_cnt.store (0, std::memory_order_relaxed);
+    m_resync_drop_cnt.store (0, std::memory_order_relaxed);
+    m_resync_cnt.store (0, std::memory_order_relaxed);
+    for (auto &resync : m_resync_vrf) {
+        resync.store (false, std::memory_order_relaxed);
+    }
+    m_resync_vrf_cnt.store (0, std::memory_order_relaxed);
+    for (auto &cnt : m_type_cnt) {
+        cnt.store (0, std::memory_order_relaxed);
+    }
+    for (int lane_id = 0; lane_id < HAL_RT_MSG_LANE_MAX; lane_id++) {
+        lane_t &lane = m_lanes[lane_id];
+        lane.head_pos = 0;
+        lane.weight = hal_rt_msg_lane_weight[lane_id];
+        lane.credit = lane.weight;
+        lane.cnt.store (0, std::memory_order_relaxed);
+        lane.peak.store (0, std::memory_order_relaxed);
+        lane.processed.store (0, std::memory_order_relaxed);
+    }
+    m_evt_fd = eventfd (0, EFD_CLOEXEC);
+    if (m_evt_fd < 0) {
+        /* Consumer falls back to polling the ring */
+        HAL_RT_LOG_ERR("HAL-RT-MSGQ", "eventfd creation failed errno:%d", errno);
+    }
+}
+
+hal_rt_msgq_t::~hal_rt_msgq_t ()
+{
+    t_fib_msg *p_msg = nullptr;
+    while ((p_msg = m_ring.pop()) != nullptr) {
+        hal_rt_free_mem_msg (p_msg);
+    }
+    if (m_evt_fd >= 0) close (m_evt_fd);
+}
+
+void hal_rt_msgq_t::wakeup_consumer ()
+{
+    /* Pairs with the fence in dequeue_batch, either the consumer sees
+     * the new message on its re-check or we see it idle here. */
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (!m_consumer_idle.load (std::memory_order_relaxed))
+        return;
+    if (!m_consumer_idle.exchange (false))
+        return;
+    if (m_evt_fd >= 0) {
+        uint64_t val = 1;
+        while ((write (m_evt_fd, &val, sizeof(val)) < 0) && (errno == EINTR));
+    }
+}
+
+void hal_rt_msgq_t::wait_for_producer ()
+{
+    if (m_evt_fd < 0) {
+        usleep (HAL_RT_MSGQ_FULL_WAIT_USEC);
+        return;
+    }
+    uint64_t val = 0;
+    while ((read (m_evt_fd, &val, sizeof(val)) < 0) && (errno == EINTR));
+}
+
+void hal_rt_msgq_t::set_bounds (size_t max_len, uint64_t max_bytes,
+                                t_fib_msg_queue_overflow_policy policy)
+{
+    m_max_len.store (max_len, std::memory_order_relaxed);
+    m_max_bytes.store (max_bytes, std::memory_order_relaxed);
+    m_overflow_policy.store (policy, std::memory_order_relaxed);
+}
+
+/* Bounds are checked before the msg is added, so the queue can overshoot
+ * them by the no. of concurrent producers */
+bool hal_rt_msgq_t::is_full () const
+{
+    uint64_t max_bytes = m_max_bytes.load (std::memory_order_relaxed);
+
+    return ((size() >= m_max_len.load (std::memory_order_relaxed)) ||
+            (max_bytes && (m_bytes.load (std::memory_order_relaxed) >= max_bytes)));
+}
+
+/*
+ * With the resync policy, the route add/update msgs from the kernel are dropped
+ * at the queue bounds and their VRF is resynced from the kernel route table
+ * later. The route deletes, the self IP routes (no protocol) and the ref counted
+ * link local routes cannot be recovered that way and wait for the room as
+ * the other msgs. Returns true if the msg is dropped.
+ */
+bool hal_rt_msgq_t::resync_on_full (t_fib_msg *p_msg)
+{
+    t_fib_route_entry *p_rt = &p_msg->route;
+
+    if ((m_overflow_policy.load (std::memory_order_relaxed) != FIB_MSG_QUEUE_OVERFLOW_RESYNC) ||
+        (p_msg->type != FIB_MSG_TYPE_NL_ROUTE))
+        return false;
+    if (((p_rt->msg_type != FIB_RT_MSG_ADD) && (p_rt->msg_type != FIB_RT_MSG_UPD)) ||
+        (p_rt->protocol == 0) || (p_rt->vrfid >= FIB_MAX_VRF) ||
+        STD_IP_IS_ADDR_LINK_LOCAL(&p_rt->prefix))
+        return false;
+
+    if (!m_resync_vrf[p_rt->vrfid].exchange (true))
+        m_resync_vrf_cnt.fetch_add (1, std::memory_order_relaxed);
+    m_resync_drop_cnt.fetch_add (1, std::memory_order_relaxed);
+    hal_rt_free_mem_msg (p_msg);
+    return true;
+}
+
+bool hal_rt_msgq_t::resync_vrf_get (hal_vrf_id_t *p_vrf_id)
+{
+    if (m_resync_vrf_cnt.load (std::memory_order_relaxed) == 0)
+        return false;
+
+    for (hal_vrf_id_t vrf_id = 0; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        if (m_resync_vrf[vrf_id].load (std::memory_order_relaxed) &&
+            m_resync_vrf[vrf_id].exchange (false)) {
+            m_resync_vrf_cnt.fetch_sub (1, std::memory_order_relaxed);
+            m_resync_cnt.fetch_add (1, std::memory_order_relaxed);
+            *p_vrf_id = vrf_id;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Msg is owned by the queue once enqueued, returns false if the msg
+ * is dropped at the queue bounds */
+bool hal_rt_msgq_t::enqueue (t_fib_msg *p_msg)
+{
+    bool blocked = false;
+
+    if (p_msg == nullptr)
+        return false;
+
+    /* Back pressure the producer while the queue is at its bounds */
+    while (is_full ()) {
+        if (resync_on_full (p_msg))
+            return false;
+        if (!blocked) {
+            m_block_cnt.fetch_add (1, std::memory_order_relaxed);
+            blocked = true;
+        }
+        wakeup_consumer ();
+        usleep (HAL_RT_MSGQ_FULL_WAIT_USEC);
+    }
+
+    if ((p_msg->type > 0) && (p_msg->type < FIB_MSG_TYPE_MAX))
+        m_type_cnt[p_msg->type].fetch_add (1, std::memory_order_relaxed);
+    uint64_t msg_bytes = hal_rt_msg_buf_size (p_msg);
+    uint64_t bytes = m_bytes.fetch_add (msg_bytes, std::memory_order_relaxed) + msg_bytes;
+
+    while (!m_ring.push (p_msg)) {
+        /* Ring is full, let the consumer drain it */
+        m_full_cnt.fetch_add (1, std::memory_order_relaxed);
+        wakeup_consumer ();
+        usleep (HAL_RT_MSGQ_FULL_WAIT_USEC);
+    }
+
+    size_t cur = size();
+    size_t peak = m_peak.load (std::memory_order_relaxed);
+    while ((cur > peak) &&
+           !m_peak.compare_exchange_weak (peak, cur, std::memory_order_relaxed));
+    uint64_t peak_bytes = m_peak_bytes.load (std::memory_order_relaxed);
+    while ((bytes > peak_bytes) &&
+           !m_peak_bytes.compare_exchange_weak (peak_bytes, bytes, std::memory_order_relaxed));
+
+    wakeup_consumer ();
+    return true;
+}
+
+/* Message left the queue, either to be processed or coalesced */
+void hal_rt_msgq_t::msg_done (t_fib_msg *p_msg)
+{
+    if ((p_msg->type > 0) && (p_msg->type < FIB_MSG_TYPE_MAX))
+        m_type_cnt[p_msg->type].fetch_sub (1, std::memory_order_relaxed);
+    m_lanes[hal_rt_msg_lane_get (p_msg->type)].cnt.fetch_sub (1, std::memory_order_relaxed);
+    m_staged_cnt.fetch_sub (1, std::memory_order_relaxed);
+    m_bytes.fetch_sub (hal_rt_msg_buf_size (p_msg), std::memory_order_relaxed);
+}
+
+/* Side effects of the route msg that are lost if it is not processed */
+static uint8_t hal_rt_msg_coalesce_flags_get (t_fib_route_entry *p_rt)
+{
+    uint8_t flags = p_rt->coalesce_flags;
+
+    /* UPD/DEL of a connected route flushes the neighbors on its prefix,
+     * the msg overriding this ADD/UPD would have found the route connected */
+    if (((p_rt->msg_type == FIB_RT_MSG_ADD) || (p_rt->msg_type == FIB_RT_MSG_UPD)) &&
+        (!p_rt->is_mgmt_intf) && (p_rt->hop_count) &&
+        STD_IP_IS_ADDR_ZERO(&p_rt->nh_list[0].nh_addr))
+        flags |= FIB_RT_COALESCE_NEIGH_FLUSH;
+    return flags;
+}
+
+/* Drops the pending route msg at the pos, its side effects are
+ * folded into the route msg p_rt coalescing it */
+void hal_rt_msgq_t::drop_staged_msg (uint64_t pos, t_fib_route_entry *p_rt)
+{
+    lane_t &lane = m_lanes[HAL_RT_MSG_LANE_ROUTE];
+    fib_msg_uptr_t &p_msg_uptr = lane.msgs[pos - lane.head_pos].msg;
+    if (!p_msg_uptr)
+        return;
+    p_rt->coalesce_flags |= hal_rt_msg_coalesce_flags_get (&p_msg_uptr->route);
+    msg_done (p_msg_uptr.get());
+    p_msg_uptr.reset();
+    m_coalesced_cnt.fetch_add (1, std::memory_order_relaxed);
+}
+
+/*
+ * Moves the route msg staged at the pos to the dropped slot at to_pos, so that
+ * it takes the queue position of the msg it replaces. The msg can not move ahead
+ * of the msgs in the other lanes it has to wait for and the slot did not, e.g.
+ * the interface msgs staged after the slot, returns false in that case and
+ * the msg stays at the pos.
+ */
+bool hal_rt_msgq_t::move_staged_msg (uint64_t pos, uint64_t to_pos)
+{
+    lane_t &lane = m_lanes[HAL_RT_MSG_LANE_ROUTE];
+    staged_msg_t &staged = lane.msgs[pos - lane.head_pos];
+    staged_msg_t &slot = lane.msgs[to_pos - lane.head_pos];
+
+    if (slot.msg)
+        return false;
+    for (int ix = 0; ix < HAL_RT_MSG_LANE_MAX; ix++) {
+        if (staged.wait_pos[ix] > slot.wait_pos[ix])
+            return false;
+    }
+    /* The if_last_pos of the msg interfaces are left at the pos, the other lanes
+     * wait for the dropped slot at the pos, which is conservative */
+    slot.msg = std::move (staged.msg);
+    return true;
+}
+
+/*
+ * Coalesce the new route msg with the pending msgs of the same route,
+ * only the rules that hold irrespective of the current FIB state are applied:
+ *  - UPD (route replace) and DEL without nexthops override all pending msgs.
+ *  - DEL following an ADD with the same nexthops cancels the ADD. The DEL removes
+ *    only those nexthops from the route and ignores the ones not on the route,
+ *    so the DEL alone leaves the route as the ADD and DEL together would.
+ *    The DEL itself is retained, it is a cheap lookup if the route is absent.
+ * ADD followed by ADD is retained as it appends the nexthops (ECMP).
+ * A msg overrides the pending msgs only if it has been validated and its
+ * NH VRF is the same as theirs, so that the msg can not be rejected at the
+ * processing where the msgs it overrides would not be.
+ * The msg replaces the oldest msg it overrides in place, keeping its queue
+ * position, and carries the side effects of the overridden msgs (e.g. the
+ * neighbor flush on a connected route replace/delete). The NHT notifications
+ * need no folding, they follow the DR programming which only ever sees the
+ * route state left by the msgs processed.
+ */
+void hal_rt_msgq_t::stage_route_msg (uint64_t pos, t_fib_msg *p_msg)
+{
+    hal_rt_route_key_t key;
+    t_fib_route_entry *p_rt = &p_msg->route;
+    lane_t &lane = m_lanes[HAL_RT_MSG_LANE_ROUTE];
+
+    if (!hal_rt_msg_route_key_get (p_rt, &key))
+        return;
+
+    auto &pending = m_route_idx[key];
+    bool can_override = (p_rt->validation == FIB_RT_VALIDATION_OK);
+    for (auto pend_pos : pending) {
+        t_fib_msg *p_pend = lane.msgs[pend_pos - lane.head_pos].msg.get();
+        if (p_pend && (p_pend->route.nh_vrfid != p_rt->nh_vrfid)) {
+            can_override = false;
+            break;
+        }
+    }
+
+    if (!can_override) {
+        /* Keep all the pending msgs */
+    } else if ((p_rt->msg_type == FIB_RT_MSG_UPD) ||
+        ((p_rt->msg_type == FIB_RT_MSG_DEL) && (p_rt->hop_count == 0))) {
+        for (auto pend_pos : pending) {
+            drop_staged_msg (pend_pos, p_rt);
+        }
+        if ((!pending.empty()) && move_staged_msg (pos, pending.front()))
+            pos = pending.front();
+        pending.clear();
+    } else if ((p_rt->msg_type == FIB_RT_MSG_DEL) && (!pending.empty())) {
+        uint64_t last_pos = pending.back();
+        t_fib_msg *p_last = lane.msgs[last_pos - lane.head_pos].msg.get();
+        if (p_last && (p_last->route.msg_type == FIB_RT_MSG_ADD) &&
+            hal_rt_msg_is_same_nh_list (&p_last->route, p_rt)) {
+            drop_staged_msg (last_pos, p_rt);
+            pending.pop_back();
+            if (move_staged_msg (pos, last_pos))
+                pos = last_pos;
+        }
+    }
+    pending.push_back (pos);
+}
+
+void hal_rt_msgq_t::unindex_route_msg (uint64_t pos, t_fib_msg *p_msg)
+{
+    hal_rt_route_key_t key;
+
+    if (!hal_rt_msg_route_key_get (&p_msg->route, &key))
+        return;
+
+    auto it = m_route_idx.find (key);
+    if (it == m_route_idx.end())
+        return;
+    auto &pending = it->second;
+    for (auto pend_it = pending.begin(); pend_it != pending.end(); ++pend_it) {
+        if (*pend_it == pos) {
+            pending.erase (pend_it);
+            break;
+        }
+    }
+    if (pending.empty())
+        m_route_idx.erase (it);
+}
+
+void hal_rt_msgq_t::stage_msg (t_fib_msg *p_msg)
+{
+    int lane_id = hal_rt_msg_lane_get (p_msg->type);
+    lane_t &lane = m_lanes[lane_id];
+    uint64_t pos = lane.head_pos + lane.msgs.size();
+    staged_msg_t staged;
+
+    /* No msg overtakes the last barrier */
+    memcpy (staged.wait_pos, m_fence_pos, sizeof(staged.wait_pos));
+    staged.wait_pos[lane_id] = 0;
+    if (p_msg->type == FIB_MSG_TYPE_BARRIER) {
+        /* Barrier waits for all the msgs staged before it, and the route msgs
+         * are not coalesced across the barrier */
+        for (int ix = 0; ix < HAL_RT_MSG_LANE_MAX; ix++) {
+            if (ix != lane_id)
+                staged.wait_pos[ix] = m_lanes[ix].head_pos + m_lanes[ix].msgs.size();
+        }
+        m_fence_pos[lane_id] = pos + 1;
+        m_route_idx.clear();
+    }
+
+    /* Wait for the msgs already staged in the other lanes for the same interfaces */
+    hal_rt_msg_if_index_get (p_msg, m_if_list);
+    for (auto if_index : m_if_list) {
+        for (int ix = 0; ix < HAL_RT_MSG_LANE_MAX; ix++) {
+            if (ix == lane_id)
+                continue;
+            auto it = m_lanes[ix].if_last_pos.find (if_index);
+            if ((it != m_lanes[ix].if_last_pos.end()) && (it->second > staged.wait_pos[ix]))
+                staged.wait_pos[ix] = it->second;
+        }
+        lane.if_last_pos[if_index] = pos + 1;
+    }
+
+    staged.msg.reset (p_msg);
+    lane.msgs.emplace_back (std::move (staged));
+    m_staged_cnt.fetch_add (1, std::memory_order_relaxed);
+    size_t cnt = lane.cnt.fetch_add (1, std::memory_order_relaxed) + 1;
+    if (cnt > lane.peak.load (std::memory_order_relaxed))
+        lane.peak.store (cnt, std::memory_order_relaxed);
+
+    if (p_msg->type == FIB_MSG_TYPE_NL_ROUTE)
+        stage_route_msg (pos, p_msg);
+}
+
+/* Move the msgs from the ring to the staging lanes, returns true
+ * if any msg was staged */
+bool hal_rt_msgq_t::stage_msgs ()
+{
+    bool staged = false;
+    t_fib_msg *p_msg = nullptr;
+
+    while (m_staged_cnt.load (std::memory_order_relaxed) < HAL_RT_MSGQ_STAGE_MAX) {
+        if ((p_msg = m_ring.pop()) == nullptr)
+            break;
+        stage_msg (p_msg);
+        staged = true;
+    }
+    return staged;
+}
+
+/* Drops the coalesced slots at the head */
+void hal_rt_msgq_t::lane_head_trim (lane_t &lane)
+{
+    while ((!lane.msgs.empty()) && (!lane.msgs.front().msg)) {
+        lane.msgs.pop_front();
+        lane.head_pos++;
+    }
+}
+
+/* Returns true if the head msg can be processed as per
+ * the interface ordering across the lanes */
+bool hal_rt_msgq_t::lane_head_ready (lane_t &lane)
+{
+    if (lane.msgs.empty())
+        return false;
+
+    staged_msg_t &head = lane.msgs.front();
+    for (int ix = 0; ix < HAL_RT_MSG_LANE_MAX; ix++) {
+        if (m_lanes[ix].head_pos < head.wait_pos[ix])
+            return false;
+    }
+    return true;
+}
+
+/* Weighted round robin across the lanes in the priority order,
+ * returns the lane to dequeue from or -1 if no msg is ready */
+int hal_rt_msgq_t::pick_lane ()
+{
+    int lane_id = 0, ready_lane = -1;
+
+    /* The head msg of a lane can wait for the coalesced slots of a later lane */
+    for (auto &lane : m_lanes) {
+        lane_head_trim (lane);
+    }
+    for (lane_id = 0; lane_id < HAL_RT_MSG_LANE_MAX; lane_id++) {
+        if (!lane_head_ready (m_lanes[lane_id]))
+            continue;
+        if (m_lanes[lane_id].credit)
+            return lane_id;
+        if (ready_lane < 0)
+            ready_lane = lane_id;
+    }
+    if (ready_lane >= 0) {
+        /* All the ready lanes used up their credits, start a new round */
+        for (auto &lane : m_lanes) {
+            lane.credit = lane.weight;
+        }
+    }
+    return ready_lane;
+}
+
+fib_msg_uptr_t hal_rt_msgq_t::lane_pop (int lane_id)
+{
+    lane_t &lane = m_lanes[lane_id];
+    uint64_t pos = lane.head_pos;
+    fib_msg_uptr_t p_msg_uptr = std::move (lane.msgs.front().msg);
+
+    lane.msgs.pop_front();
+    lane.head_pos++;
+    if (lane.credit)
+        lane.credit--;
+
+    if (p_msg_uptr->type == FIB_MSG_TYPE_NL_ROUTE)
+        unindex_route_msg (pos, p_msg_uptr.get());
+    if (lane.msgs.empty())
+        lane.if_last_pos.clear();
+    msg_done (p_msg_uptr.get());
+    lane.processed.fetch_add (1, std::memory_order_relaxed);
+    return p_msg_uptr;
+}
+
+size_t hal_rt_msgq_t::dequeue_batch (std::vector<fib_msg_uptr_t> &batch, size_t max_msgs)
+{
+    size_t cnt = 0;
+    int lane_id = 0;
+
+    for (;;) {
+        stage_msgs ();
+        while ((cnt < max_msgs) && ((lane_id = pick_lane ()) >= 0)) {
+            batch.emplace_back (lane_pop (lane_id));
+            cnt++;
+        }
+        if (cnt)
+            return cnt;
+
+        /* Announce the sleep and re-check the ring before blocking,
+         * producers signal the eventfd only when we are idle. */
+        m_consumer_idle.store (true, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (!stage_msgs ()) {
+            wait_for_producer ();
+        }
+        m_consumer_idle.store (false, std::memory_order_relaxed);
+    }
+}
+
+uint32_t hal_rt_msgq_t::msg_type_count (t_fib_msg_type msg_type) const
+{
+    if ((msg_type <= 0) || (msg_type >= FIB_MSG_TYPE_MAX))
+        return 0;
+    return m_type_cnt[msg_type].load (std::memory_order_relaxed);
+}
+
+std::string hal_rt_msgq_t::queue_stats () const
+{
+    std::stringstream ss;
+    ss << "Current:" << size() << "Peak:" << m_peak.load (std::memory_order_relaxed)
+       << " Bytes:" << bytes() << " Peak Bytes:" << m_peak_bytes.load (std::memory_order_relaxed)
+       << " Max Len:" << m_max_len.load (std::memory_order_relaxed)
+       << " Max Bytes:" << m_max_bytes.load (std::memory_order_relaxed)
+       << " Ring Full:" << m_full_cnt.load (std::memory_order_relaxed)
+       << " Blocked:" << m_block_cnt.load (std::memory_order_relaxed)
+       << " Resync Dropped:" << m_resync_drop_cnt.load (std::memory_order_relaxed)
+       << " Resyncs:" << m_resync_cnt.load (std::memory_order_relaxed);
+    return ss.str();
+}
+
+std::string hal_rt_msgq_t::msg_type_stats () const
+{
+    std::stringstream ss;
+    for (int lane_id = 0; lane_id < HAL_RT_MSG_LANE_MAX; lane_id++) {
+        const lane_t &lane = m_lanes[lane_id];
+        ss << "Lane:" << hal_rt_msg_lane_name[lane_id]
+           << " Current:" << lane.cnt.load (std::memory_order_relaxed)
+           << "Peak:" << lane.peak.load (std::memory_order_relaxed)
+           << " Processed:" << lane.processed.load (std::memory_order_relaxed) << " ";
+        for (int type = FIB_MSG_TYPE_NL_INTF; type < FIB_MSG_TYPE_MAX; type++) {
+            if (hal_rt_msg_lane_get (type) != lane_id)
+                continue;
+            ss << "MsgType:" << type << "Msg Count:"
+               << m_type_cnt[type].load (std::memory_order_relaxed);
+        }
+        ss << "\n";
+    }
+    ss << "Coalesced Msg Count:" << m_coalesced_cnt.load (std::memory_order_relaxed);
+    return ss.str();
+}
+
+uint32_t hal_rt_latency_hist_t::bucket_get (uint64_t nsecs)
+{
+    const uint64_t sub_cnt = (1 << HAL_RT_LATENCY_HIST_SUB_BITS);
+
+    if (nsecs < sub_cnt)
+        return nsecs;
+
+    uint32_t exp = 63 - __builtin_clzll (nsecs);
+    if (exp >= HAL_RT_LATENCY_HIST_MAX_EXP)
+        return (HAL_RT_LATENCY_HIST_BUCKETS - 1);
+
+    uint32_t sub = (nsecs >> (exp - HAL_RT_LATENCY_HIST_SUB_BITS)) & (sub_cnt - 1);
+    return (((exp - HAL_RT_LATENCY_HIST_SUB_BITS + 1) << HAL_RT_LATENCY_HIST_SUB_BITS) + sub);
+}
+
+uint64_t hal_rt_latency_hist_t::bucket_upper (uint32_t bucket)
+{
+    const uint64_t sub_cnt = (1 << HAL_RT_LATENCY_HIST_SUB_BITS);
+
+    if (bucket < sub_cnt)
+        return bucket;
+
+    uint32_t shift = (bucket >> HAL_RT_LATENCY_HIST_SUB_BITS) - 1;
+    uint64_t sub = bucket & (sub_cnt - 1);
+    return (((sub_cnt + sub + 1) << shift) - 1);
+}
+
+void hal_rt_latency_hist_t::record (uint64_t nsecs)
+{
+    m_buckets[bucket_get (nsecs)].fetch_add (1, std::memory_order_relaxed);
+    m_count.fetch_add (1, std::memory_order_relaxed);
+
+    uint64_t max_nsecs = m_max.load (std::memory_order_relaxed);
+    while ((nsecs > max_nsecs) &&
+           !m_max.compare_exchange_weak (max_nsecs, nsecs, std::memory_order_relaxed));
+}
+
+void hal_rt_latency_hist_t::clear ()
+{
+    for (auto &bucket : m_buckets) {
+        bucket.store (0, std::memory_order_relaxed);
+    }
+    m_count.store (0, std::memory_order_relaxed);
+    m_max.store (0, std::memory_order_relaxed);
+}
+
+uint64_t hal_rt_latency_hist_t::percentile (uint32_t pct) const
+{
+    uint64_t total = 0, cum = 0;
+    uint64_t max_nsecs = max ();
+    uint32_t bucket = 0;
+
+    for (bucket = 0; bucket < HAL_RT_LATENCY_HIST_BUCKETS; bucket++) {
+        total += m_buckets[bucket].load (std::memory_order_relaxed);
+    }
+    if (total == 0)
+        return 0;
+
+    /* Buckets keep changing while being read, the samples recorded after
+     * the total was taken are counted in the max. bucket */
+    uint64_t rank = ((total * pct) + 99) / 100;
+    for (bucket = 0; bucket < (HAL_RT_LATENCY_HIST_BUCKETS - 1); bucket++) {
+        cum += m_buckets[bucket].load (std::memory_order_relaxed);
+        if ((cum >= rank) && (cum > 0)) {
+            uint64_t upper = bucket_upper (bucket);
+            return ((upper < max_nsecs) ? upper : max_nsecs);
+        }
+    }
+    return max_nsecs;
+}
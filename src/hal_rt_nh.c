@@ -28,6 +28,7 @@
 #include "hal_rt_util.h"
 #include "hal_rt_debug.h"
 #include "nas_rt_api.h"
+#include "hal_rt_hash.h"
 
 #include "event_log.h"
 #include "std_ip_utils.h"
@@ -43,12 +44,172 @@ pthread_mutex_t fib_nh_mutex;
 pthread_cond_t  fib_nh_cond;
 static bool     is_nh_pending_for_processing = 0; //initialize the predicate for signal
 std_rt_table   *rt_intf_tree = NULL;
+/* The intf tree is shared by all the VRFs, the nodes are keyed by the VRF and
+ * updated with their VRF locked, the tree itself is protected by this lock.
+ * It is taken last, see the lock order in hal_rt_main.c */
+static pthread_mutex_t rt_intf_tree_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 std_rt_table * hal_rt_access_intf_tree(void)
 {
     return (rt_intf_tree);
 }
 
+/* Index of the intf tree for the exact lookups. The intfs of an if_index
+ * (one per VRF/AF) are chained from the if_index slot of the direct table,
+ * the table grows up to FIB_INTF_INDEX_MAX_DIRECT slots and the larger
+ * if_index values go to the sparse hash. The tree is kept for the ordered
+ * walks. Both are protected by rt_intf_tree_mutex, the tree lookup is used
+ * once an update failed for want of memory. */
+#define FIB_INTF_INDEX_MIN_DIRECT   256
+#define FIB_INTF_INDEX_MAX_DIRECT   16384
+
+static t_fib_intf **rt_intf_direct = NULL;
+static uint32_t     rt_intf_direct_size = 0;
+static uint32_t     rt_intf_direct_cnt = 0;
+static t_fib_hash  *rt_intf_sparse = NULL;
+static bool         rt_intf_index_valid = false;
+
+static uint32_t fib_intf_sparse_hash (uint32_t if_index, uint32_t vrf_id, uint8_t af_index)
+{
+    t_fib_intf_key key;
+
+    memset (&key, 0, sizeof (key));
+    key.if_index = if_index;
+    key.vrf_id   = vrf_id;
+    key.af_index = af_index;
+
+    return fib_hash_key (&key, sizeof (key));
+}
+
+static bool fib_intf_sparse_match (const void *p_val, const void *p_key)
+{
+    const t_fib_intf_key *p_intf_key = &((const t_fib_intf *) p_val)->key;
+    const t_fib_intf_key *p_in_key = (const t_fib_intf_key *) p_key;
+
+    return ((p_intf_key->if_index == p_in_key->if_index) &&
+            (p_intf_key->vrf_id == p_in_key->vrf_id) &&
+            (p_intf_key->af_index == p_in_key->af_index));
+}
+
+static bool fib_intf_direct_grow (uint32_t if_index)
+{
+    t_fib_intf **p_direct = NULL;
+    uint32_t     size = (rt_intf_direct_size ? rt_intf_direct_size : FIB_INTF_INDEX_MIN_DIRECT);
+
+    while (size <= if_index)
+        size *= 2;
+
+    p_direct = (t_fib_intf **) FIB_REALLOC (rt_intf_direct, size * sizeof (t_fib_intf *));
+    if (p_direct == NULL)
+        return false;
+
+    memset (p_direct + rt_intf_direct_size, 0,
+            (size - rt_intf_direct_size) * sizeof (t_fib_intf *));
+    rt_intf_direct = p_direct;
+    rt_intf_direct_size = size;
+    return true;
+}
+
+static void fib_intf_index_invalidate (void)
+{
+    FIB_FREE (rt_intf_direct);
+    rt_intf_direct = NULL;
+    rt_intf_direct_size = 0;
+    rt_intf_direct_cnt = 0;
+    fib_hash_destroy (rt_intf_sparse);
+    rt_intf_sparse = NULL;
+    rt_intf_index_valid = false;
+
+    HAL_RT_LOG_ERR("HAL-RT-NH", "Intf index disabled, memory alloc failed");
+}
+
+static void fib_intf_index_add (t_fib_intf *p_intf)
+{
+    uint32_t if_index = p_intf->key.if_index;
+
+    if (!rt_intf_index_valid)
+        return;
+
+    if (if_index < FIB_INTF_INDEX_MAX_DIRECT) {
+        if ((if_index >= rt_intf_direct_size) && (!fib_intf_direct_grow (if_index))) {
+            fib_intf_index_invalidate ();
+            return;
+        }
+        p_intf->p_next_if_index = rt_intf_direct[if_index];
+        rt_intf_direct[if_index] = p_intf;
+        rt_intf_direct_cnt++;
+        return;
+    }
+
+    if (!fib_hash_add (rt_intf_sparse,
+                       fib_intf_sparse_hash (if_index, p_intf->key.vrf_id,
+                                             p_intf->key.af_index), p_intf)) {
+        fib_intf_index_invalidate ();
+    }
+}
+
+static void fib_intf_index_del (t_fib_intf *p_intf)
+{
+    uint32_t     if_index = p_intf->key.if_index;
+    t_fib_intf **pp_intf = NULL;
+
+    if (!rt_intf_index_valid)
+        return;
+
+    if (if_index < FIB_INTF_INDEX_MAX_DIRECT) {
+        if (if_index >= rt_intf_direct_size)
+            return;
+        for (pp_intf = &rt_intf_direct[if_index]; *pp_intf != NULL;
+             pp_intf = &(*pp_intf)->p_next_if_index) {
+            if (*pp_intf == p_intf) {
+                *pp_intf = p_intf->p_next_if_index;
+                p_intf->p_next_if_index = NULL;
+                rt_intf_direct_cnt--;
+                break;
+            }
+        }
+        return;
+    }
+
+    fib_hash_del (rt_intf_sparse,
+                  fib_intf_sparse_hash (if_index, p_intf->key.vrf_id, p_intf->key.af_index),
+                  p_intf);
+}
+
+static t_fib_intf *fib_intf_index_get (const t_fib_intf_key *p_key)
+{
+    t_fib_intf *p_intf = NULL;
+
+    if (p_key->if_index < FIB_INTF_INDEX_MAX_DIRECT) {
+        if (p_key->if_index >= rt_intf_direct_size)
+            return NULL;
+        for (p_intf = rt_intf_direct[p_key->if_index]; p_intf != NULL;
+             p_intf = p_intf->p_next_if_index) {
+            if ((p_intf->key.vrf_id == p_key->vrf_id) &&
+                (p_intf->key.af_index == p_key->af_index))
+                break;
+        }
+        return p_intf;
+    }
+
+    return ((t_fib_intf *)
+            fib_hash_lookup (rt_intf_sparse,
+                             fib_intf_sparse_hash (p_key->if_index, p_key->vrf_id,
+                                                   p_key->af_index),
+                             fib_intf_sparse_match, p_key));
+}
+
+void fib_intf_index_stats_get (bool *p_is_valid, uint32_t *p_num_direct,
+                               uint32_t *p_direct_size, uint32_t *p_num_sparse)
+{
+    pthread_mutex_lock (&rt_intf_tree_mutex);
+    *p_is_valid = rt_intf_index_valid;
+    *p_num_direct = rt_intf_direct_cnt;
+    *p_direct_size = rt_intf_direct_size;
+    *p_num_sparse = (fib_hash_is_valid (rt_intf_sparse) ? rt_intf_sparse->num_entries : 0);
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
+}
+
 int fib_create_nh_tree (t_fib_vrf_info *p_vrf_info)
 {
     char tree_name_str [FIB_RDX_MAX_NAME_LEN];
@@ -92,6 +253,16 @@ int fib_create_nh_tree (t_fib_vrf_info *p_vrf_info)
 
     std_radix_enable_radical (p_vrf_info->nh_tree);
 
+    /* The exact lookups fall back to the nh_tree without the index */
+    p_vrf_info->p_nh_hash = fib_hash_create ();
+    if (p_vrf_info->p_nh_hash == NULL)
+    {
+        HAL_RT_LOG_ERR("HAL-RT-NH",
+                   "%s (): Hash index create failed. Vrf_id: %d, "
+                   "af_index: %s", __FUNCTION__, p_vrf_info->vrf_id,
+                   STD_IP_AFINDEX_TO_STR (p_vrf_info->af_index));
+    }
+
     return STD_ERR_OK;
 }
 
@@ -124,75 +295,8 @@ int fib_destroy_nh_tree (t_fib_vrf_info *p_vrf_info)
 
     p_vrf_info->nh_tree = NULL;
 
-    return STD_ERR_OK;
-}
-
-int fib_create_nh_dep_dr_tree (t_fib_nh *p_nh)
-{
-    if (!p_nh)
-    {
-        HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "%s (): Invalid input param. p_nh: %p",
-                   __FUNCTION__, p_nh);
-
-        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
-    }
-
-    HAL_RT_LOG_DEBUG("HAL-RT-NH",
-                 "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                  p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-    if (p_nh->dep_dr_tree != NULL)
-    {
-        HAL_RT_LOG_DEBUG("HAL-RT-NH",
-                     "Dep DR tree already created. NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                     p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-        return STD_ERR_OK;
-    }
-
-    p_nh->dep_dr_tree = std_radix_create ("Fib_nh_dep_dr_tree", FIB_RDX_NH_DEP_DR_KEY_LEN,
-                                        NULL, NULL, 0);
-
-    if (p_nh->dep_dr_tree == NULL)
-    {
-        HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "std_radix_create failed.NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                   p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
-    }
-
-    return STD_ERR_OK;
-}
-
-int fib_destroy_nh_dep_dr_tree (t_fib_nh *p_nh)
-{
-    if (!p_nh)
-    {
-        HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "%s (): Invalid input param. p_nh: %p", __FUNCTION__, p_nh);
-        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
-    }
-
-    HAL_RT_LOG_DEBUG("HAL-RT-NH",
-                 "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                 p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-    if (p_nh->dep_dr_tree == NULL)
-    {
-        HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "%s (): Dep DR tree not present. "
-                   "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
-                   __FUNCTION__, p_nh->vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
-
-        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
-    }
-
-    std_radix_destroy (p_nh->dep_dr_tree);
-
-    p_nh->dep_dr_tree = NULL;
+    fib_hash_destroy (p_vrf_info->p_nh_hash);
+    p_vrf_info->p_nh_hash = NULL;
 
     return STD_ERR_OK;
 }
@@ -216,6 +320,15 @@ int fib_create_intf_tree (void)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
+    /* The lookups use the tree if the index could not be created */
+    rt_intf_sparse = fib_hash_create ();
+    if (rt_intf_sparse == NULL) {
+        HAL_RT_LOG_ERR("HAL-RT-NH",
+                   "%s (): Intf index create failed", __FUNCTION__);
+    } else {
+        rt_intf_index_valid = true;
+    }
+
     return STD_ERR_OK;
 }
 
@@ -233,6 +346,14 @@ int fib_destroy_intf_tree (void)
 
     rt_intf_tree = NULL;
 
+    FIB_FREE (rt_intf_direct);
+    rt_intf_direct = NULL;
+    rt_intf_direct_size = 0;
+    rt_intf_direct_cnt = 0;
+    fib_hash_destroy (rt_intf_sparse);
+    rt_intf_sparse = NULL;
+    rt_intf_index_valid = false;
+
     return STD_ERR_OK;
 }
 
@@ -280,8 +401,6 @@ t_fib_nh *fib_proc_nh_add (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr,
         p_nh->vrf_id = vrf_id;
         p_nh->is_mgmt_nh = is_mgmt_nh;
 
-        fib_create_nh_dep_dr_tree (p_nh);
-
         /* First Hop */
         if (((p_nh->key.if_index != 0) || (FIB_IS_NH_LOOP_BACK (p_nh))) &&
             (p_nh->p_arp_info == NULL))
@@ -875,6 +994,8 @@ int fib_pending_intf_call_back (uint32_t if_index, bool action)
 
     key.if_index = if_index;
 
+    /* Walks the intfs of all the VRFs, to be called with the
+     * nas_l3_lock exclusive */
     p_intf = (t_fib_intf *)std_radix_getexact (rt_intf_tree,(uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
 
     if (p_intf == NULL)
@@ -935,6 +1056,31 @@ int fib_pending_intf_call_back (uint32_t if_index, bool action)
     return STD_ERR_OK;
 }
 
+/* The hash index key is the whole NH key, as in the nh_tree */
+static bool fib_nh_hash_match (const void *p_val, const void *p_key)
+{
+    return (memcmp (&((const t_fib_nh *) p_val)->key, p_key, sizeof (t_fib_nh_key)) == 0);
+}
+
+/* Keep the hash index of the VRF in sync with the nh_tree */
+static void fib_nh_hash_update (uint32_t vrf_id, t_fib_nh *p_nh, bool is_add)
+{
+    t_fib_vrf_info *p_vrf_info = FIB_GET_VRF_INFO (vrf_id, p_nh->key.ip_addr.af_index);
+    uint32_t        hash;
+
+    if ((p_vrf_info == NULL) || (!fib_hash_is_valid (p_vrf_info->p_nh_hash)))
+        return;
+
+    hash = fib_hash_key (&p_nh->key, sizeof (t_fib_nh_key));
+    if (!is_add) {
+        fib_hash_del (p_vrf_info->p_nh_hash, hash, p_nh);
+    } else if (!fib_hash_add (p_vrf_info->p_nh_hash, hash, p_nh)) {
+        HAL_RT_LOG_ERR("HAL-RT-NH", "Hash index update failed, exact lookups "
+                       "fall back to the NH tree. vrf_id: %d, ip_addr: %s, if_index: 0x%x",
+                       vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
+    }
+}
+
 t_fib_nh *fib_add_nh (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr, uint32_t if_index)
 {
     t_fib_nh     *p_nh = NULL;
@@ -986,6 +1132,9 @@ t_fib_nh *fib_add_nh (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr, uint32_t if_ind
         return NULL;
     }
 
+    /* The new NH is on the change list of the NH tree */
+    hal_rt_walker_vrf_mark (FIB_WALKER_NH, vrf_id, af_index);
+
     if (p_radix_head != ((std_rt_head *)p_nh))
     {
         HAL_RT_LOG_DEBUG("HAL-RT-NH",
@@ -997,6 +1146,10 @@ t_fib_nh *fib_add_nh (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr, uint32_t if_ind
 
         p_nh = (t_fib_nh *)p_radix_head;
     }
+    else
+    {
+        fib_nh_hash_update (vrf_id, p_nh, true);
+    }
 
     return p_nh;
 }
@@ -1005,6 +1158,7 @@ t_fib_nh *fib_get_nh (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr, uint32_t if_ind
 {
     t_fib_nh    *p_nh = NULL;
     t_fib_nh_key  key;
+    t_fib_vrf_info *p_vrf_info = NULL;
     uint8_t  af_index = 0;
 
     if (!p_ip_addr)
@@ -1027,8 +1181,19 @@ t_fib_nh *fib_get_nh (uint32_t vrf_id, t_fib_ip_addr *p_ip_addr, uint32_t if_ind
 
     key.if_index = if_index;
 
-    p_nh = (t_fib_nh *) std_radix_getexact (hal_rt_access_fib_vrf_nh_tree(vrf_id, af_index),
-                          (uint8_t *) &key, FIB_RDX_NH_KEY_LEN);
+    p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
+
+    if ((p_vrf_info != NULL) && (fib_hash_is_valid (p_vrf_info->p_nh_hash)))
+    {
+        p_nh = (t_fib_nh *) fib_hash_lookup (p_vrf_info->p_nh_hash,
+                                             fib_hash_key (&key, sizeof (t_fib_nh_key)),
+                                             fib_nh_hash_match, &key);
+    }
+    else
+    {
+        p_nh = (t_fib_nh *) std_radix_getexact (hal_rt_access_fib_vrf_nh_tree(vrf_id, af_index),
+                              (uint8_t *) &key, FIB_RDX_NH_KEY_LEN);
+    }
 
     return p_nh;
 }
@@ -1150,6 +1315,9 @@ int fib_del_nh (t_fib_nh *p_nh)
 
     af_index = p_nh->key.ip_addr.af_index;
 
+    fib_rslv_unlink (FIB_GET_VRF_INFO (vrf_id, af_index), &p_nh->rslv);
+
+    fib_nh_hash_update (vrf_id, p_nh, false);
     std_radix_remove (hal_rt_access_fib_vrf_nh_tree(vrf_id, af_index),
                     (std_rt_head *)(&p_nh->radical));
 
@@ -1524,10 +1692,158 @@ int fib_resolve_connected_tunnel_nh (uint32_t vrf_id, t_fib_nh *p_fh)
     return STD_ERR_OK;
 }
 
+/* Mask of the byte ix of a prefix of prefix_len */
+static inline uint8_t fib_nh_dep_dr_mask (uint32_t prefix_len, uint32_t ix)
+{
+    if (prefix_len >= ((ix + 1) * 8))
+        return 0xff;
+    if (prefix_len <= (ix * 8))
+        return 0;
+    return ((uint8_t) (0xff << (8 - (prefix_len % 8))));
+}
+
+/* Compare the key (vrf_id, prefix, prefix_len) with the key of the DR, the
+ * prefix bits past the prefix length are not part of the key */
+static int fib_nh_dep_dr_key_cmp (uint32_t vrf_id, const t_fib_ip_addr *p_prefix,
+                                  uint8_t prefix_len, const t_fib_dr *p_dr)
+{
+    const uint8_t *p_addr = (const uint8_t *) &p_prefix->u;
+    const uint8_t *p_dr_addr = (const uint8_t *) &p_dr->key.prefix.u;
+    uint8_t        byte = 0;
+    uint8_t        dr_byte = 0;
+    uint32_t       ix = 0;
+
+    if (vrf_id != p_dr->vrf_id)
+        return ((vrf_id < p_dr->vrf_id) ? -1 : 1);
+
+    if (p_prefix->af_index != p_dr->key.prefix.af_index)
+        return ((p_prefix->af_index < p_dr->key.prefix.af_index) ? -1 : 1);
+
+    for (ix = 0; ix < STD_IP_AFINDEX_TO_ADDR_LEN (p_prefix->af_index); ix++)
+    {
+        byte = p_addr[ix] & fib_nh_dep_dr_mask (prefix_len, ix);
+        dr_byte = p_dr_addr[ix] & fib_nh_dep_dr_mask (p_dr->prefix_len, ix);
+
+        if (byte != dr_byte)
+            return ((byte < dr_byte) ? -1 : 1);
+    }
+
+    if (prefix_len != p_dr->prefix_len)
+        return ((prefix_len < p_dr->prefix_len) ? -1 : 1);
+
+    return 0;
+}
+
+/*
+ * Find the first entry of the list with the key less than (is_next false:
+ * not greater than) the key of the entry, returns false if there is none.
+ */
+static bool fib_nh_dep_dr_find (const t_fib_nh_dep_dr_list *p_list, uint32_t vrf_id,
+                                const t_fib_ip_addr *p_prefix, uint8_t prefix_len,
+                                bool is_next, uint32_t *p_chunk_ix, uint32_t *p_ix)
+{
+    const t_fib_nh_dep_dr_chunk *p_chunk = NULL;
+    int       bound = (is_next ? 0 : 1);
+    uint32_t  lo = 0;
+    uint32_t  hi = p_list->num_chunks;
+    uint32_t  mid = 0;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        p_chunk = p_list->p_chunks[mid];
+
+        if (fib_nh_dep_dr_key_cmp (vrf_id, p_prefix, prefix_len,
+                                   p_chunk->dep_dr[p_chunk->num_dr - 1].p_dr) < bound)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    if (lo == p_list->num_chunks)
+        return false;
+
+    *p_chunk_ix = lo;
+    p_chunk = p_list->p_chunks[lo];
+    lo = 0;
+    hi = p_chunk->num_dr;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+
+        if (fib_nh_dep_dr_key_cmp (vrf_id, p_prefix, prefix_len,
+                                   p_chunk->dep_dr[mid].p_dr) < bound)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    *p_ix = lo;
+
+    return true;
+}
+
+static t_fib_nh_dep_dr_chunk *fib_nh_dep_dr_chunk_add (t_fib_nh_dep_dr_list *p_list,
+                                                       uint32_t chunk_ix, uint16_t max_dr)
+{
+    t_fib_nh_dep_dr_chunk  *p_chunk = NULL;
+    t_fib_nh_dep_dr_chunk **p_chunks = NULL;
+    uint32_t                max_chunks = 0;
+
+    if (p_list->num_chunks == p_list->max_chunks)
+    {
+        max_chunks = ((p_list->max_chunks == 0) ? 1 : (2 * p_list->max_chunks));
+        p_chunks = (t_fib_nh_dep_dr_chunk **)
+            FIB_REALLOC (p_list->p_chunks, (max_chunks * sizeof (t_fib_nh_dep_dr_chunk *)));
+
+        if (p_chunks == NULL)
+            return NULL;
+
+        p_list->p_chunks = p_chunks;
+        p_list->max_chunks = max_chunks;
+    }
+
+    p_chunk = FIB_NH_DEP_DR_CHUNK_MEM_MALLOC (max_dr);
+
+    if (p_chunk == NULL)
+        return NULL;
+
+    p_chunk->num_dr = 0;
+    p_chunk->max_dr = max_dr;
+
+    memmove (&p_list->p_chunks[chunk_ix + 1], &p_list->p_chunks[chunk_ix],
+             ((p_list->num_chunks - chunk_ix) * sizeof (t_fib_nh_dep_dr_chunk *)));
+    p_list->p_chunks[chunk_ix] = p_chunk;
+    p_list->num_chunks++;
+
+    return p_chunk;
+}
+
+static void fib_nh_dep_dr_chunk_del (t_fib_nh_dep_dr_list *p_list, uint32_t chunk_ix)
+{
+    FIB_NH_DEP_DR_CHUNK_MEM_FREE (p_list->p_chunks[chunk_ix]);
+
+    p_list->num_chunks--;
+    memmove (&p_list->p_chunks[chunk_ix], &p_list->p_chunks[chunk_ix + 1],
+             ((p_list->num_chunks - chunk_ix) * sizeof (t_fib_nh_dep_dr_chunk *)));
+
+    if (p_list->num_chunks == 0)
+    {
+        FIB_FREE (p_list->p_chunks);
+        p_list->p_chunks = NULL;
+        p_list->max_chunks = 0;
+    }
+}
+
 t_fib_nh_dep_dr *fib_add_nh_dep_dr (t_fib_nh *p_nh, t_fib_dr *p_dr)
 {
-    t_fib_nh_dep_dr  *p_nh_dep_dr = NULL;
-    std_rt_head      *p_radix_head = NULL;
+    t_fib_nh_dep_dr_list  *p_list = NULL;
+    t_fib_nh_dep_dr_chunk *p_chunk = NULL;
+    t_fib_nh_dep_dr_chunk *p_new_chunk = NULL;
+    uint32_t               chunk_ix = 0;
+    uint32_t               ix = 0;
+    uint16_t               half = 0;
 
     if ((!p_nh) ||
         (!p_dr))
@@ -1547,34 +1863,85 @@ t_fib_nh_dep_dr *fib_add_nh_dep_dr (t_fib_nh *p_nh, t_fib_dr *p_dr)
                p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                p_dr->prefix_len);
 
-    p_nh_dep_dr = (t_fib_nh_dep_dr *) FIB_NH_DEP_DR_MEM_MALLOC ();
+    p_list = &p_nh->dep_dr_list;
 
-    if (p_nh_dep_dr == NULL)
+    if (fib_nh_dep_dr_find (p_list, p_dr->vrf_id, &p_dr->key.prefix, p_dr->prefix_len,
+                            false, &chunk_ix, &ix))
     {
-        HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "%s (): Memory alloc failed", __FUNCTION__);
-
-        return NULL;
-    }
+        p_chunk = p_list->p_chunks[chunk_ix];
 
-    memset (p_nh_dep_dr, 0, sizeof (t_fib_nh_dep_dr));
+        if ((ix < p_chunk->num_dr) &&
+            (fib_nh_dep_dr_key_cmp (p_dr->vrf_id, &p_dr->key.prefix, p_dr->prefix_len,
+                                    p_chunk->dep_dr[ix].p_dr) == 0))
+        {
+            HAL_RT_LOG_DEBUG("HAL-RT-NH",
+                       "Duplicate insertion. "
+                       "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
+                       "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
+                       p_nh->vrf_id,
+                       FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+                       p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                       p_dr->prefix_len);
 
-    p_nh_dep_dr->key.vrf_id = p_dr->vrf_id;
+            return (&p_chunk->dep_dr[ix]);
+        }
+    }
+    else if (p_list->num_chunks > 0)
+    {
+        /* Past the last entry */
+        chunk_ix = p_list->num_chunks - 1;
+        p_chunk = p_list->p_chunks[chunk_ix];
+        ix = p_chunk->num_dr;
+    }
+    else
+    {
+        chunk_ix = 0;
+        ix = 0;
+        p_chunk = fib_nh_dep_dr_chunk_add (p_list, 0, FIB_NH_DEP_DR_CHUNK_MIN);
+    }
 
-    memcpy (&p_nh_dep_dr->key.dr_key, &p_dr->key, sizeof (t_fib_dr_key));
+    if ((p_chunk != NULL) && (p_chunk->num_dr == p_chunk->max_dr))
+    {
+        if (p_chunk->max_dr < FIB_NH_DEP_DR_CHUNK_MAX)
+        {
+            p_new_chunk = FIB_NH_DEP_DR_CHUNK_MEM_REALLOC (p_chunk, (2 * p_chunk->max_dr));
+            if (p_new_chunk != NULL)
+            {
+                p_new_chunk->max_dr *= 2;
+                p_list->p_chunks[chunk_ix] = p_new_chunk;
+            }
+            p_chunk = p_new_chunk;
+        }
+        else
+        {
+            /* Split the chunk, the upper half moves to a new chunk */
+            half = p_chunk->num_dr / 2;
+            p_new_chunk = fib_nh_dep_dr_chunk_add (p_list, (chunk_ix + 1), FIB_NH_DEP_DR_CHUNK_MAX);
 
-    p_nh_dep_dr->rt_head.rth_addr = (uint8_t *) (&(p_nh_dep_dr->key));
+            if (p_new_chunk != NULL)
+            {
+                memcpy (p_new_chunk->dep_dr, &p_chunk->dep_dr[half],
+                        ((p_chunk->num_dr - half) * sizeof (t_fib_nh_dep_dr)));
+                p_new_chunk->num_dr = p_chunk->num_dr - half;
+                p_chunk->num_dr = half;
 
-    p_radix_head =
-        std_radix_insert (p_nh->dep_dr_tree,
-                        (std_rt_head *)(&p_nh_dep_dr->rt_head),
-                        FIB_GET_RDX_NH_DEP_DR_KEY_LEN (&p_nh_dep_dr->key,
-                                                       p_dr->prefix_len));
+                if (ix > half)
+                {
+                    p_chunk = p_new_chunk;
+                    ix -= half;
+                }
+            }
+            else
+            {
+                p_chunk = NULL;
+            }
+        }
+    }
 
-    if (p_radix_head == NULL)
+    if (p_chunk == NULL)
     {
         HAL_RT_LOG_ERR("HAL-RT-NH",
-                   "%s (): Radix insertion failed. "
+                   "%s (): Memory alloc failed. "
                    "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                    "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
                    __FUNCTION__, p_nh->vrf_id,
@@ -1582,40 +1949,26 @@ t_fib_nh_dep_dr *fib_add_nh_dep_dr (t_fib_nh *p_nh, t_fib_dr *p_dr)
                    p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                    p_dr->prefix_len);
 
-        FIB_NH_DEP_DR_MEM_FREE (p_nh_dep_dr);
         return NULL;
     }
 
-    if (p_radix_head != ((std_rt_head *)p_nh_dep_dr))
-    {
-        HAL_RT_LOG_DEBUG("HAL-RT-NH",
-                   "Duplicate radix insertion. "
-                   "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
-                   "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
-                   p_nh->vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-                   p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
-                   p_dr->prefix_len);
-
-        FIB_NH_DEP_DR_MEM_FREE (p_nh_dep_dr);
+    memmove (&p_chunk->dep_dr[ix + 1], &p_chunk->dep_dr[ix],
+             ((p_chunk->num_dr - ix) * sizeof (t_fib_nh_dep_dr)));
+    p_chunk->dep_dr[ix].p_dr = p_dr;
+    p_chunk->num_dr++;
+    p_list->num_dr++;
 
-        p_nh_dep_dr = (t_fib_nh_dep_dr *)p_radix_head;
-
-        return p_nh_dep_dr;
-    }
     if ((p_nh->p_arp_info) && (p_nh->p_arp_info->state == FIB_ARP_RESOLVED))
         p_dr->is_nh_resolved = true;
 
-    p_nh_dep_dr->prefix_len = p_dr->prefix_len;
-    p_nh_dep_dr->p_dr       = p_dr;
-
-    return p_nh_dep_dr;
+    return (&p_chunk->dep_dr[ix]);
 }
 
 t_fib_nh_dep_dr *fib_get_nh_dep_dr (t_fib_nh *p_nh, t_fib_dr *p_dr)
 {
-    t_fib_nh_dep_dr_key    key;
-    t_fib_nh_dep_dr      *p_nh_dep_dr = NULL;
+    t_fib_nh_dep_dr_chunk *p_chunk = NULL;
+    uint32_t               chunk_ix = 0;
+    uint32_t               ix = 0;
 
     if ((!p_dr) ||
         (!p_nh))
@@ -1635,26 +1988,21 @@ t_fib_nh_dep_dr *fib_get_nh_dep_dr (t_fib_nh *p_nh, t_fib_dr *p_dr)
                p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                p_dr->prefix_len);
 
-    memset (&key, 0, sizeof (t_fib_nh_dep_dr_key));
-
-    key.vrf_id = p_dr->vrf_id;
+    if (!fib_nh_dep_dr_find (&p_nh->dep_dr_list, p_dr->vrf_id, &p_dr->key.prefix,
+                             p_dr->prefix_len, false, &chunk_ix, &ix))
+        return NULL;
 
-    memcpy (&key.dr_key, &p_dr->key, sizeof (t_fib_dr_key));
+    p_chunk = p_nh->dep_dr_list.p_chunks[chunk_ix];
 
-    p_nh_dep_dr = (t_fib_nh_dep_dr *)
-        std_radix_getexact (p_nh->dep_dr_tree,
-                          (uint8_t *)&key,
-                          FIB_GET_RDX_NH_DEP_DR_KEY_LEN (&key,
-                                                         p_dr->prefix_len));
+    if (fib_nh_dep_dr_key_cmp (p_dr->vrf_id, &p_dr->key.prefix, p_dr->prefix_len,
+                               p_chunk->dep_dr[ix].p_dr) != 0)
+        return NULL;
 
-    return p_nh_dep_dr;
+    return (&p_chunk->dep_dr[ix]);
 }
 
 t_fib_nh_dep_dr *fib_get_first_nh_dep_dr (t_fib_nh *p_nh)
 {
-    t_fib_nh_dep_dr      *p_nh_dep_dr = NULL;
-    t_fib_nh_dep_dr_key    key;
-
     if (!p_nh)
     {
         HAL_RT_LOG_ERR("HAL-RT-NH",
@@ -1669,29 +2017,17 @@ t_fib_nh_dep_dr *fib_get_first_nh_dep_dr (t_fib_nh *p_nh)
                p_nh->vrf_id,
                FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
 
-    memset (&key, 0, sizeof (t_fib_nh_dep_dr_key));
-
-    p_nh_dep_dr = (t_fib_nh_dep_dr *)
-        std_radix_getexact (p_nh->dep_dr_tree,
-                          (uint8_t *)&key,
-                          FIB_GET_RDX_NH_DEP_DR_KEY_LEN (&key, 0));
-
-    if (p_nh_dep_dr == NULL)
-    {
-        p_nh_dep_dr = (t_fib_nh_dep_dr *)
-            std_radix_getnext (p_nh->dep_dr_tree,
-                             (uint8_t *)&key,
-                             FIB_GET_RDX_NH_DEP_DR_KEY_LEN (&key, 0));
-    }
+    if (p_nh->dep_dr_list.num_chunks == 0)
+        return NULL;
 
-    return p_nh_dep_dr;
+    return (&p_nh->dep_dr_list.p_chunks[0]->dep_dr[0]);
 }
 
 t_fib_nh_dep_dr *fib_get_next_nh_dep_dr (t_fib_nh *p_nh, uint32_t vrf_id,
                                 t_fib_ip_addr *p_prefix, uint8_t prefix_len)
 {
-    t_fib_nh_dep_dr      *p_nh_dep_dr = NULL;
-    t_fib_nh_dep_dr_key    key;
+    uint32_t  chunk_ix = 0;
+    uint32_t  ix = 0;
 
     if ((!p_nh) ||
         (!p_prefix))
@@ -1710,22 +2046,22 @@ t_fib_nh_dep_dr *fib_get_next_nh_dep_dr (t_fib_nh *p_nh, uint32_t vrf_id,
                FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
                vrf_id, FIB_IP_ADDR_TO_STR (p_prefix), prefix_len);
 
-    memset (&key, 0, sizeof (t_fib_nh_dep_dr_key));
-
-    key.vrf_id = vrf_id;
-
-    memcpy (&key.dr_key.prefix, p_prefix, sizeof (t_fib_ip_addr));
-
-    p_nh_dep_dr = (t_fib_nh_dep_dr *)
-        std_radix_getnext (p_nh->dep_dr_tree,
-                         (uint8_t *)&key,
-                         FIB_GET_RDX_NH_DEP_DR_KEY_LEN (&key, prefix_len));
+    if (!fib_nh_dep_dr_find (&p_nh->dep_dr_list, vrf_id, p_prefix, prefix_len,
+                             true, &chunk_ix, &ix))
+        return NULL;
 
-    return p_nh_dep_dr;
+    return (&p_nh->dep_dr_list.p_chunks[chunk_ix]->dep_dr[ix]);
 }
 
 int fib_del_nh_dep_dr (t_fib_nh *p_nh, t_fib_nh_dep_dr *p_nh_dep_dr)
 {
+    t_fib_nh_dep_dr_list  *p_list = NULL;
+    t_fib_nh_dep_dr_chunk *p_chunk = NULL;
+    t_fib_nh_dep_dr_chunk *p_next_chunk = NULL;
+    t_fib_dr              *p_dr = NULL;
+    uint32_t               chunk_ix = 0;
+    uint32_t               ix = 0;
+
     if ((!p_nh) ||
         (!p_nh_dep_dr))
     {
@@ -1736,29 +2072,77 @@ int fib_del_nh_dep_dr (t_fib_nh *p_nh, t_fib_nh_dep_dr *p_nh_dep_dr)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
+    p_dr = p_nh_dep_dr->p_dr;
+
     HAL_RT_LOG_DEBUG("HAL-RT-NH",
                "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
                p_nh->vrf_id,
                FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-               p_nh_dep_dr->key.vrf_id,
-               FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-               p_nh_dep_dr->prefix_len);
+               p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+               p_dr->prefix_len);
 
-    std_radix_remove (p_nh->dep_dr_tree, (std_rt_head *)(&p_nh_dep_dr->rt_head));
+    p_list = &p_nh->dep_dr_list;
 
-    memset (p_nh_dep_dr, 0, sizeof (t_fib_nh_dep_dr));
+    if ((!fib_nh_dep_dr_find (p_list, p_dr->vrf_id, &p_dr->key.prefix, p_dr->prefix_len,
+                              false, &chunk_ix, &ix)) ||
+        (p_list->p_chunks[chunk_ix]->dep_dr[ix].p_dr != p_dr))
+    {
+        HAL_RT_LOG_ERR("HAL-RT-NH",
+                   "%s (): Dep DR not present. "
+                   "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
+                   "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
+                   __FUNCTION__, p_nh->vrf_id,
+                   FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+                   p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                   p_dr->prefix_len);
+
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+
+    p_chunk = p_list->p_chunks[chunk_ix];
+    p_chunk->num_dr--;
+    memmove (&p_chunk->dep_dr[ix], &p_chunk->dep_dr[ix + 1],
+             ((p_chunk->num_dr - ix) * sizeof (t_fib_nh_dep_dr)));
+    p_list->num_dr--;
+
+    if (p_chunk->num_dr == 0)
+    {
+        fib_nh_dep_dr_chunk_del (p_list, chunk_ix);
+        return STD_ERR_OK;
+    }
 
-    FIB_NH_DEP_DR_MEM_FREE (p_nh_dep_dr);
+    /* Merge the next chunk if both fit in half of the chunk, otherwise
+     * shrink the chunk once it is 1/4 full */
+    p_next_chunk = (((chunk_ix + 1) < p_list->num_chunks) ?
+                    p_list->p_chunks[chunk_ix + 1] : NULL);
+
+    if ((p_next_chunk != NULL) &&
+        ((p_chunk->num_dr + p_next_chunk->num_dr) <= (p_chunk->max_dr / 2)))
+    {
+        memcpy (&p_chunk->dep_dr[p_chunk->num_dr], p_next_chunk->dep_dr,
+                (p_next_chunk->num_dr * sizeof (t_fib_nh_dep_dr)));
+        p_chunk->num_dr += p_next_chunk->num_dr;
+        fib_nh_dep_dr_chunk_del (p_list, (chunk_ix + 1));
+    }
+    else if ((p_chunk->max_dr > FIB_NH_DEP_DR_CHUNK_MIN) &&
+             (p_chunk->num_dr <= (p_chunk->max_dr / 4)))
+    {
+        p_chunk = FIB_NH_DEP_DR_CHUNK_MEM_REALLOC (p_chunk, (p_chunk->max_dr / 2));
+        if (p_chunk != NULL)
+        {
+            p_chunk->max_dr /= 2;
+            p_list->p_chunks[chunk_ix] = p_chunk;
+        }
+    }
 
     return STD_ERR_OK;
 }
 
 int fib_delete_all_nh_dep_dr (t_fib_nh *p_nh)
 {
-    t_fib_nh_dep_dr      *p_nh_dep_dr = NULL;
-    t_fib_nh_dep_dr_key    key;
-    uint8_t         prefix_len = 0;
+    t_fib_nh_dep_dr_list *p_list = NULL;
+    uint32_t              chunk_ix = 0;
 
     if (!p_nh)
     {
@@ -1769,34 +2153,40 @@ int fib_delete_all_nh_dep_dr (t_fib_nh *p_nh)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
+    p_list = &p_nh->dep_dr_list;
+
     HAL_RT_LOG_DEBUG("HAL-RT-NH",
-               "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x",
+               "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, num_dep_dr: %d",
                p_nh->vrf_id,
-               FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index);
+               FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+               p_list->num_dr);
 
-    memset (&key, 0, sizeof (t_fib_nh_dep_dr_key));
+    for (chunk_ix = 0; chunk_ix < p_list->num_chunks; chunk_ix++)
+    {
+        FIB_NH_DEP_DR_CHUNK_MEM_FREE (p_list->p_chunks[chunk_ix]);
+    }
 
-    p_nh_dep_dr = fib_get_first_nh_dep_dr (p_nh);
+    FIB_FREE (p_list->p_chunks);
 
-    while (p_nh_dep_dr != NULL)
-    {
-        HAL_RT_LOG_DEBUG("HAL-RT-NH",
-                   "Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
-                   p_nh_dep_dr->key.vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-                   p_nh_dep_dr->prefix_len);
+    memset (p_list, 0, sizeof (t_fib_nh_dep_dr_list));
 
-        memcpy (&key, &p_nh_dep_dr->key, sizeof (t_fib_nh_dep_dr_key));
+    return STD_ERR_OK;
+}
 
-        prefix_len = p_nh_dep_dr->prefix_len;
+uint64_t fib_get_nh_dep_dr_mem_size (t_fib_nh *p_nh)
+{
+    const t_fib_nh_dep_dr_list *p_list = &p_nh->dep_dr_list;
+    uint64_t                    mem_size = 0;
+    uint32_t                    chunk_ix = 0;
 
-        fib_del_nh_dep_dr (p_nh, p_nh_dep_dr);
+    mem_size = p_list->max_chunks * sizeof (t_fib_nh_dep_dr_chunk *);
 
-        p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, key.vrf_id, &key.dr_key.prefix,
-                                      prefix_len);
+    for (chunk_ix = 0; chunk_ix < p_list->num_chunks; chunk_ix++)
+    {
+        mem_size += FIB_NH_DEP_DR_CHUNK_MEM_SIZE (p_list->p_chunks[chunk_ix]->max_dr);
     }
 
-    return STD_ERR_OK;
+    return mem_size;
 }
 
 int fib_add_nh_best_fit_dr (t_fib_nh *p_nh, t_fib_dr *p_best_fit_dr)
@@ -1970,8 +2360,13 @@ t_fib_intf *fib_add_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_index)
     p_intf->rt_head.rth_addr = (uint8_t *) (&(p_intf->key));
 
 
+    pthread_mutex_lock (&rt_intf_tree_mutex);
     p_radix_head = std_radix_insert (rt_intf_tree, (std_rt_head *)(&p_intf->rt_head),
                                      FIB_RDX_INTF_KEY_LEN);
+    if (p_radix_head == ((std_rt_head *)p_intf)) {
+        fib_intf_index_add (p_intf);
+    }
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
 
     if (p_radix_head == NULL)
     {
@@ -2008,12 +2403,14 @@ t_fib_intf *fib_get_first_intf ()
 
     memset (&key, 0, sizeof (t_fib_intf_key));
 
+    pthread_mutex_lock (&rt_intf_tree_mutex);
     p_intf = (t_fib_intf *)
         std_radix_getexact (rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
     if (p_intf == NULL) {
         p_intf = (t_fib_intf *)
             std_radix_getnext(rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
     }
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
 
     return p_intf;
 }
@@ -2032,8 +2429,34 @@ t_fib_intf *fib_get_next_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_in
     key.vrf_id   = vrf_id;
     key.af_index = af_index;
 
+    pthread_mutex_lock (&rt_intf_tree_mutex);
     p_intf = (t_fib_intf *)
         std_radix_getnext(rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
+
+    return p_intf;
+}
+
+/* Intf of the VRF for the first available address family, the other VRF
+ * intfs are not returned since they can be deleted by their VRF writers */
+t_fib_intf *fib_get_intf_any_af (uint32_t if_index, uint32_t vrf_id)
+{
+    t_fib_intf_key   key;
+    t_fib_intf     *p_intf = NULL;
+
+    memset (&key, 0, sizeof (t_fib_intf_key));
+
+    key.if_index = if_index;
+    key.vrf_id   = vrf_id;
+
+    pthread_mutex_lock (&rt_intf_tree_mutex);
+    p_intf = (t_fib_intf *)
+        std_radix_getnext(rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
+    if ((p_intf != NULL) &&
+        ((p_intf->key.if_index != if_index) || (p_intf->key.vrf_id != vrf_id))) {
+        p_intf = NULL;
+    }
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
 
     return p_intf;
 }
@@ -2053,8 +2476,14 @@ t_fib_intf *fib_get_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_index)
     key.vrf_id   = vrf_id;
     key.af_index = af_index;
 
-    p_intf = (t_fib_intf *)
-              std_radix_getexact (rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
+    pthread_mutex_lock (&rt_intf_tree_mutex);
+    if (rt_intf_index_valid) {
+        p_intf = fib_intf_index_get (&key);
+    } else {
+        p_intf = (t_fib_intf *)
+                  std_radix_getexact (rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
+    }
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
 
     return p_intf;
 }
@@ -2075,7 +2504,10 @@ int fib_del_intf (t_fib_intf *p_intf)
                p_intf->key.if_index, p_intf->key.vrf_id,
                p_intf->key.af_index);
 
+    pthread_mutex_lock (&rt_intf_tree_mutex);
+    fib_intf_index_del (p_intf);
     std_radix_remove (rt_intf_tree, (std_rt_head *)(&p_intf->rt_head));
+    pthread_mutex_unlock (&rt_intf_tree_mutex);
 
     memset (p_intf, 0, sizeof (t_fib_intf));
 
@@ -2376,7 +2808,6 @@ int fib_check_and_delete_nh (t_fib_nh *p_nh, bool is_force_del)
         if (hal_fib_next_hop_del(p_nh) != DN_HAL_ROUTE_E_NONE)
             fib_mark_nh_for_resolution(p_nh);
         else {
-            fib_destroy_nh_dep_dr_tree (p_nh);
             fib_del_nh (p_nh);
         }
     }
@@ -2438,17 +2869,105 @@ int fib_nh_walker_init (void)
     return STD_ERR_OK;
 }
 
-int fib_nh_walker_main (void)
+/* Walk a batch of the NH changes of the VRF with the VRF locked, returns the
+ * no. of NHs processed and whether the VRF has more changes pending */
+static uint32_t fib_nh_walker_walk_vrf (uint32_t vrf_id, uint8_t af_index, bool *p_is_more)
 {
-    t_fib_vrf_info         *p_vrf_info = NULL;
-    std_radix_version_t  marker_version = 0;
-    std_radix_version_t  max_version = 0;
+    t_fib_vrf_info      *p_vrf_info = NULL;
     std_radix_version_t  max_walker_version = 0;
+    uint32_t             num_nh_processed = 0;
+    uint32_t             batch_size = FIB_WALKER_INIT_BATCH;
+    uint64_t             batch_start = 0;
+    uint32_t             num_propagated = 0;
+    t_fib_rslv_burst     burst;
+    int                  rc = STD_ERR_OK;
+    t_fib_vrf_lock_mode  lock_mode = FIB_VRF_LOCK_NONE;
+
+    *p_is_more = false;
+
+    /* Only this VRF is locked, the other VRFs are updated concurrently */
+    lock_mode = nas_l3_vrf_lock(vrf_id);
+    if (hal_rt_access_fib_vrf(vrf_id) != NULL) {
+        p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
+    }
+    if (p_vrf_info == NULL) {
+        HAL_RT_LOG_DEBUG("HAL-RT-NH", "Vrf info NULL. "
+                         "vrf_id: %d, af_index: %d", vrf_id, af_index);
+        /* VRF deleted after its changes were marked */
+        hal_rt_walker_vrf_done (FIB_WALKER_NH, vrf_id, af_index, 0, true);
+        nas_l3_vrf_unlock(vrf_id, lock_mode);
+        return 0;
+    }
+
+    /* The VRF stays marked, it is walked again after the DR clear/HA */
+    if ((p_vrf_info->dr_clear_on == true) ||
+        (p_vrf_info->dr_ha_on == true)) {
+        HAL_RT_LOG_DEBUG("HAL-RT-NH", "DR clear or HA in progress."
+                         "vrf_id: %d, af_index: %d, dr_clear_on: %d, dr_ha_on: %d",
+                         vrf_id, af_index, p_vrf_info->dr_clear_on, p_vrf_info->dr_ha_on);
+        nas_l3_vrf_unlock(vrf_id, lock_mode);
+        return 0;
+    }
+
+    p_vrf_info->num_nh_processed_by_walker = 0;
+    if (p_vrf_info->nh_clear_on == true) {
+        max_walker_version = p_vrf_info->nh_clear_max_radix_ver;
+    } else if (p_vrf_info->nh_ha_on == true) {
+        max_walker_version = p_vrf_info->nh_ha_max_radix_ver;
+    } else {
+        max_walker_version = std_radix_getversion (p_vrf_info->nh_tree);
+    }
+
+    /* Process a maximum of batch_size nodes per vrf, the batch size
+     * is adapted to the walker time budget per lock hold */
+    batch_size = hal_rt_walker_batch_size_get (FIB_WALKER_NH);
+    batch_start = hal_rt_walker_batch_start ();
+
+    /* The changed NHs and the DRs/NHs depending on them are resolved in
+     * this lock hold, the changes are not propagated during a clear/HA */
+    fib_rslv_burst_start (p_vrf_info, &burst,
+                          ((!p_vrf_info->nh_clear_on) && (!p_vrf_info->nh_ha_on) &&
+                           (!p_vrf_info->clear_ip_fib_on) && (!p_vrf_info->clear_arp_on)));
+    std_radical_walkchangelist (p_vrf_info->nh_tree,
+                                &p_vrf_info->nh_radical_marker,
+                                fib_nh_walker_call_back,
+                                0,
+                                batch_size,
+                                max_walker_version,
+                                &rc);
+    /* The burst gets what is left of the time budget after the walk */
+    fib_rslv_burst_run (p_vrf_info, &burst, hal_rt_walker_batch_deadline (batch_start));
+    num_propagated = burst.num_nodes - burst.num_seeds;
+
+    /*
+     * 'p_vrf_info->num_nh_processed_by_walker' is updated in
+     * fib_nh_walker_call_back ().
+     */
+    num_nh_processed = p_vrf_info->num_nh_processed_by_walker;
+    hal_rt_walker_batch_end (FIB_WALKER_NH, batch_start, num_nh_processed + num_propagated,
+                             batch_size);
+    hal_rt_walker_rslv_end (FIB_WALKER_NH, num_propagated, burst.num_deferred + burst.num_left,
+                            burst.num_parallel);
+
+    /* A partial batch means the walk caught up with the changes of the VRF,
+     * unless the burst left nodes on the changelists at the time budget */
+    *p_is_more = ((num_nh_processed >= batch_size) || (burst.num_left != 0));
+    hal_rt_walker_vrf_done (FIB_WALKER_NH, vrf_id, af_index, num_nh_processed, !(*p_is_more));
+    nas_l3_vrf_unlock(vrf_id, lock_mode);
+
+    return num_nh_processed;
+}
+
+int fib_nh_walker_main (void)
+{
     uint32_t             tot_nh_processed = 0;
-    uint32_t             num_active_vrfs = 0;
+    uint32_t             num_dirty_vrfs = 0;
+    uint64_t             tot_backlog = 0;
+    uint32_t             num_batches = 0;
+    uint32_t             batch = 0;
     uint32_t             vrf_id = 0;
     int                  af_index = 0;
-    int                  rc = STD_ERR_OK;
+    bool                 is_more = false;
 
     for ( ; ;)
     {
@@ -2461,72 +2980,33 @@ int fib_nh_walker_main (void)
         pthread_mutex_unlock( &fib_nh_mutex );
 
         tot_nh_processed = 0;
-        num_active_vrfs  = 0;
-
-        for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
-            for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
-                nas_l3_lock();
-                if (hal_rt_access_fib_vrf(vrf_id) == NULL) {
-                    nas_l3_unlock();
-                    break;
-                }
-                p_vrf_info = FIB_GET_VRF_INFO (vrf_id, af_index);
-                if (p_vrf_info == NULL) {
-                    HAL_RT_LOG_DEBUG("HAL-RT-NH", "Vrf info NULL. "
-                                     "vrf_id: %d, af_index: %d", vrf_id, af_index);
-                    nas_l3_unlock();
-                    continue;
-                }
-
-                if ((p_vrf_info->dr_clear_on == true) ||
-                    (p_vrf_info->dr_ha_on == true)) {
-                    HAL_RT_LOG_DEBUG("HAL-RT-NH", "DR clear or HA in progress."
-                                     "vrf_id: %d, af_index: %d, dr_clear_on: %d, dr_ha_on: %d",
-                                     vrf_id, af_index, p_vrf_info->dr_clear_on, p_vrf_info->dr_ha_on);
-                    nas_l3_unlock();
-                    continue;
-                }
-
-                p_vrf_info->num_nh_processed_by_walker = 0;
-                if (p_vrf_info->nh_clear_on == true) {
-                    max_walker_version = p_vrf_info->nh_clear_max_radix_ver;
-                } else if (p_vrf_info->nh_ha_on == true) {
-                    max_walker_version = p_vrf_info->nh_ha_max_radix_ver;
-                } else {
-                    max_walker_version = std_radix_getversion (p_vrf_info->nh_tree);
-                }
-
-                /* Process a maximum of FIB_NH_WALKER_COUNT nodes per vrf */
 
-                std_radical_walkchangelist (p_vrf_info->nh_tree,
-                                            &p_vrf_info->nh_radical_marker,
-                                            fib_nh_walker_call_back,
-                                            0,
-                                            FIB_NH_WALKER_COUNT,
-                                            max_walker_version,
-                                            &rc);
-
-                /* @@TODO: Need to handle version wrap */
-
-                max_version    = std_radix_getversion (p_vrf_info->nh_tree);
-                marker_version = p_vrf_info->nh_radical_marker.rth_version;
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            /* Only the VRFs with NH changes are walked, a VRF gets lock holds
+             * in the pass in proportion to its share of the backlog */
+            num_dirty_vrfs = 0;
+            tot_backlog = 0;
+            for (vrf_id = FIB_MIN_VRF;
+                 hal_rt_walker_vrf_next (FIB_WALKER_NH, af_index, &vrf_id); vrf_id++) {
+                num_dirty_vrfs++;
+                tot_backlog += hal_rt_walker_vrf_backlog_get (FIB_WALKER_NH, vrf_id, af_index);
+            }
 
-                if (marker_version != max_version) {
-                    num_active_vrfs++;
+            for (vrf_id = FIB_MIN_VRF;
+                 hal_rt_walker_vrf_next (FIB_WALKER_NH, af_index, &vrf_id); vrf_id++) {
+                num_batches = hal_rt_walker_vrf_batches_get (FIB_WALKER_NH, vrf_id, af_index,
+                                                             num_dirty_vrfs, tot_backlog);
+                is_more = true;
+                for (batch = 0; (batch < num_batches) && is_more; batch++) {
+                    tot_nh_processed += fib_nh_walker_walk_vrf (vrf_id, af_index, &is_more);
                 }
-                /*
-                 * 'p_vrf_info->num_nh_processed_by_walker' is updated in
-                 * fib_nh_walker_call_back ().
-                 */
-                if (p_vrf_info->num_nh_processed_by_walker == FIB_NH_WALKER_COUNT) {
+                if (is_more) {
                     HAL_RT_LOG_DEBUG("HAL-RT-NH", "Max NH (%d) processed per walk, relinquish now",
                                      tot_nh_processed);
                     is_nh_pending_for_processing = true;
                 }
-                tot_nh_processed += p_vrf_info->num_nh_processed_by_walker;
-                nas_l3_unlock();
             }
-        }  /* End of vrf loop */
+        }  /* End of AF loop */
 
 
         HAL_RT_LOG_DEBUG("HAL-RT-NH", "Total NH processed %d",  tot_nh_processed);
@@ -2632,8 +3112,6 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
 {
     t_fib_vrf_info   *p_vrf_info = NULL;
     t_fib_nh        *p_nh = NULL;
-    dn_hal_route_err     hal_err = DN_HAL_ROUTE_E_NONE;
-    bool           is_host_ready = true;
     char           p_buf[HAL_RT_MAX_BUFSZ];
 
     if (!p_rt_head)
@@ -2689,6 +3167,27 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
         }
     }
 
+    /* A NH resolved by a burst since it was marked has no resolution
+     * pending, unless the clear above requested it */
+    p_nh->rslv.state &= ~FIB_RSLV_STATE_RESOLVED;
+    if (!(p_nh->status_flag & FIB_NH_STATUS_REQ_RESOLVE))
+    {
+        return STD_ERR_OK;
+    }
+
+    /* Resolved with its dependents after the changelist walk */
+    if (fib_rslv_seed (p_vrf_info, &p_nh->rslv, FIB_RSLV_NODE_NH, p_nh)) {
+        return STD_ERR_OK;
+    }
+
+    return fib_nh_rslv_process (p_nh);
+}
+
+int fib_nh_rslv_process (t_fib_nh *p_nh)
+{
+    dn_hal_route_err     hal_err = DN_HAL_ROUTE_E_NONE;
+    bool           is_host_ready = true;
+
     if (!(p_nh->status_flag & FIB_NH_STATUS_REQ_RESOLVE))
     {
         return STD_ERR_OK;
@@ -3067,8 +3566,15 @@ int fib_mark_nh_for_resolution (t_fib_nh *p_nh)
     vrf_id   = p_nh->vrf_id;
     af_index = p_nh->key.ip_addr.af_index;
 
+    /* Resolved in the burst of the walker holding the VRF */
+    if (fib_rslv_mark (FIB_GET_VRF_INFO (vrf_id, af_index), &p_nh->rslv,
+                       FIB_RSLV_NODE_NH, p_nh)) {
+        return STD_ERR_OK;
+    }
+
     std_radical_appendtochangelist (hal_rt_access_fib_vrf_nh_tree(vrf_id, af_index),
                                   (std_radical_head_t *)&(p_nh->radical));
+    hal_rt_walker_vrf_mark (FIB_WALKER_NH, vrf_id, af_index);
 
     //fib_resume_nh_walker_thread(af_index);
 
@@ -3099,25 +3605,15 @@ int fib_mark_nh_dep_dr_for_resolution (t_fib_nh *p_nh)
 
     while (p_nh_dep_dr != NULL)
     {
-        if (p_nh_dep_dr->p_dr == NULL)
-        {
-            p_nh_dep_dr =
-                fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                   &p_nh_dep_dr->key.dr_key.prefix,
-                                   p_nh_dep_dr->prefix_len);
-
-            continue;
-        }
-
         HAL_RT_LOG_DEBUG("HAL-RT-NH",
                    "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                    "status_flag: 0x%x, owner_flag: 0x%x, "
                    "NH Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
                     p_nh->vrf_id,
                    FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->key.vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-                   p_nh_dep_dr->prefix_len);
+                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->p_dr->vrf_id,
+                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->p_dr->key.prefix),
+                   p_nh_dep_dr->p_dr->prefix_len);
 
         /*
          * Mark DR for resolution only for ECMP case
@@ -3129,9 +3625,9 @@ int fib_mark_nh_dep_dr_for_resolution (t_fib_nh *p_nh)
         }
 
         p_nh_dep_dr =
-            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                               &p_nh_dep_dr->key.dr_key.prefix,
-                               p_nh_dep_dr->prefix_len);
+            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->p_dr->vrf_id,
+                               &p_nh_dep_dr->p_dr->key.prefix,
+                               p_nh_dep_dr->p_dr->prefix_len);
     }
 
     return STD_ERR_OK;
@@ -3161,25 +3657,15 @@ int fib_update_nh_dep_dr_resolution_status (t_fib_nh *p_nh)
 
     while (p_nh_dep_dr != NULL)
     {
-        if (p_nh_dep_dr->p_dr == NULL)
-        {
-            p_nh_dep_dr =
-                fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                   &p_nh_dep_dr->key.dr_key.prefix,
-                                   p_nh_dep_dr->prefix_len);
-
-            continue;
-        }
-
         HAL_RT_LOG_DEBUG("HAL-RT-NH",
                    "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                    "status_flag: 0x%x, owner_flag: 0x%x, "
                    "NH Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
                     p_nh->vrf_id,
                    FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->key.vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-                   p_nh_dep_dr->prefix_len);
+                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->p_dr->vrf_id,
+                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->p_dr->key.prefix),
+                   p_nh_dep_dr->p_dr->prefix_len);
 
         if ((p_nh->p_arp_info) && (p_nh->p_arp_info->state == FIB_ARP_RESOLVED) &&
             !(p_nh->status_flag & FIB_NH_STATUS_DEAD)) {
@@ -3189,9 +3675,9 @@ int fib_update_nh_dep_dr_resolution_status (t_fib_nh *p_nh)
         }
 
         p_nh_dep_dr =
-            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                               &p_nh_dep_dr->key.dr_key.prefix,
-                               p_nh_dep_dr->prefix_len);
+            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->p_dr->vrf_id,
+                               &p_nh_dep_dr->p_dr->key.prefix,
+                               p_nh_dep_dr->p_dr->prefix_len);
     }
 
     return STD_ERR_OK;
@@ -3201,6 +3687,7 @@ int fib_update_nh_dep_dr_resolution_status (t_fib_nh *p_nh)
 int fib_resolve_nh_dep_dr (t_fib_nh *p_nh)
 {
     t_fib_nh_dep_dr   *p_nh_dep_dr = NULL;
+    t_fib_dr          *p_dep_dr = NULL;
 
     if (!p_nh)
     {
@@ -3222,39 +3709,33 @@ int fib_resolve_nh_dep_dr (t_fib_nh *p_nh)
 
     while (p_nh_dep_dr != NULL)
     {
-        if (p_nh_dep_dr->p_dr == NULL)
-        {
-            p_nh_dep_dr =
-                fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                   &p_nh_dep_dr->key.dr_key.prefix,
-                                   p_nh_dep_dr->prefix_len);
-
-            continue;
-        }
-
         HAL_RT_LOG_DEBUG("HAL-RT-NH",
                    "Resolve NH Dep DR. NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                    "status_flag: 0x%x, owner_flag: 0x%x, "
                    "NH Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d",
                     p_nh->vrf_id,
                    FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->key.vrf_id,
-                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-                   p_nh_dep_dr->prefix_len);
+                   p_nh->status_flag, p_nh->owner_flag, p_nh_dep_dr->p_dr->vrf_id,
+                   FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->p_dr->key.prefix),
+                   p_nh_dep_dr->p_dr->prefix_len);
 
         /*
          * Resolve DR only for ECMP case; non-ECMP routes are resolved already.
          */
-        if(p_nh_dep_dr->p_dr->num_nh > 1) {
+        /* The entry may not be valid after the resolution, the walk
+         * continues from the key of its DR */
+        p_dep_dr = p_nh_dep_dr->p_dr;
+
+        if(p_dep_dr->num_nh > 1) {
             /* set ADD flag to trigger route download to walker */
-            p_nh_dep_dr->p_dr->status_flag |= FIB_DR_STATUS_ADD;
-            fib_resolve_dr (p_nh_dep_dr->p_dr);
+            p_dep_dr->status_flag |= FIB_DR_STATUS_ADD;
+            fib_resolve_dr (p_dep_dr);
         }
 
         p_nh_dep_dr =
-            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                               &p_nh_dep_dr->key.dr_key.prefix,
-                               p_nh_dep_dr->prefix_len);
+            fib_get_next_nh_dep_dr (p_nh, p_dep_dr->vrf_id,
+                               &p_dep_dr->key.prefix,
+                               p_dep_dr->prefix_len);
     }
 
     return STD_ERR_OK;
@@ -57,7 +57,12 @@ extern "C" {
 #include "std_utils.h"
 #include "std_rw_lock.h"
 
-using fib_offload_msg_uptr_t = std::unique_ptr<t_fib_offload_msg>;
+struct fib_offload_msg_deleter_t {
+    void operator() (t_fib_offload_msg *p_offload_msg) const {
+        hal_rt_free_offload_msg (p_offload_msg);
+    }
+};
+using fib_offload_msg_uptr_t = std::unique_ptr<t_fib_offload_msg, fib_offload_msg_deleter_t>;
 static auto &hal_rt_offload_msg_list = *new std::deque<fib_offload_msg_uptr_t>;
 /* stats counter for hal_rt_offload_msg_list queue on per msg type basis */
 static auto hal_rt_offload_msg_list_stats = new std::unordered_map<uint32_t,uint32_t> {
@@ -127,11 +132,6 @@ int nas_rt_process_offload_msg(t_fib_offload_msg *p_offload_msg) {
 }
 
 
-t_fib_offload_msg *hal_rt_alloc_offload_msg() {
-    t_fib_offload_msg *p_offload_msg = new (std::nothrow) t_fib_offload_msg;
-    return p_offload_msg;
-}
-
 std::string hal_rt_offload_queue_stats ()
 {
     std::lock_guard<std::mutex> l {m_offload_mtx};
@@ -79,7 +79,10 @@ dn_hal_route_err hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr) {
      */
     if (hal_rt_is_ecmp_enabled() && (p_dr->num_fh > 1)) {
         if (p_dr->status_flag & FIB_DR_STATUS_DEGENERATED) {
-            rc = _hal_fib_route_add(vrf_id, p_dr, &p_dr->degen_dr_fh);
+            if (fib_get_dr_cold (p_dr) == NULL) {
+                return DN_HAL_ROUTE_E_MEM;
+            }
+            rc = _hal_fib_route_add(vrf_id, p_dr, &p_dr->p_cold->degen_dr_fh);
         } else {
             if (hal_fib_is_route_really_ecmp(p_dr, &is_cpu_route) == true) {
                 rc = hal_fib_ecmp_route_add(vrf_id, p_dr);
@@ -505,7 +508,14 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
                             vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                             p_dr->prefix_len, p_dr->num_fh, old_nh_handle, nh_handle,
                             npu_id);
-            p_dr->old_nh_handle_nht = old_nh_handle;
+            if (fib_get_dr_cold (p_dr) != NULL) {
+                p_dr->p_cold->old_nh_handle_nht = old_nh_handle;
+            } else {
+                HAL_RT_LOG_ERR("HAL-RT-NDI",
+                               "NHT ACLs of the old group %lu not flushed, no DR cold info. "
+                               "VRF %d Prefix: %s/%d", old_nh_handle, vrf_id,
+                               FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+            }
             if ((is_nht_notif_done == false) &&
                 (((p_fh && (p_fh->p_arp_info) && (p_fh->p_arp_info->state == FIB_ARP_RESOLVED)) ||
                   (p_nh && (p_nh->p_arp_info) && p_nh->p_arp_info->state == FIB_ARP_RESOLVED)) ||
@@ -514,7 +524,9 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
                 nas_rt_handle_dest_change(p_dr, NULL, true);
                 is_nht_notif_done = true;
             }
-            p_dr->old_nh_handle_nht = 0;
+            if (p_dr->p_cold != NULL) {
+                p_dr->p_cold->old_nh_handle_nht = 0;
+            }
             /*
              * Update the route by removing the ECMP group as it is now a non-ECMP route
              */
@@ -612,7 +624,9 @@ int hal_fib_set_all_dr_fh_to_un_written(t_fib_dr *p_dr) {
         return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
     }
 
-    p_dr->degen_dr_fh.status = FIB_DRFH_STATUS_UNWRITTEN;
+    if (p_dr->p_cold != NULL) {
+        p_dr->p_cold->degen_dr_fh.status = FIB_DRFH_STATUS_UNWRITTEN;
+    }
 
     FIB_FOR_EACH_FH_FROM_DR (p_dr, p_fh, nh_holder)
     {
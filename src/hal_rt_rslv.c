@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   hal_rt_rslv.c
+ * \brief  Incremental DR/NH re-resolution in the walker lock holds
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_util.h"
+
+#include "event_log.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * A DR resolved by a walker marks its dependent NHs and a NH marks its
+ * dependent DRs, so a change used to bounce between the DR and NH walkers
+ * through their changelists, and a DR with NHs resolved in different
+ * passes got resolved once per pass. In a burst, the marks of the nodes of
+ * the VRF are queued by rank and resolved in the same lock hold, a node is
+ * resolved after all the nodes it depends on and once. A node marked again
+ * after it was resolved (a dependency cycle) is left to its walker.
+ *
+ * The burst is only accessed with the VRF locked by the walker.
+ *
+ * The NHs of a rank are resolved before its DRs, the DRs of the rank do
+ * not depend on each other, so their FH sets are computed by the
+ * resolution workers with the VRF still locked by the walker, and the
+ * DRs are updated and programmed serially by the walker.
+ *
+ * The burst runs in what is left of the walker time budget after the
+ * changelist walk, the clock is checked before each marked node. Once the
+ * budget is over, the marked nodes not yet resolved and the nodes marked
+ * after are put on the changelists of their walkers with the VRF marked for
+ * them again, they are resolved as the seeds of the next lock hold. The
+ * seeds are resolved regardless, so that each lock hold makes progress with
+ * the changelist.
+ */
+
+typedef struct {
+    t_fib_dr        **p_dr;
+    t_fib_dr_fh_set  *p_fh_set;
+} t_fib_rslv_fh_set_job;
+
+static uint32_t fib_rslv_burst_id = 0;
+
+void fib_rslv_burst_start (t_fib_vrf_info *p_vrf_info, t_fib_rslv_burst *p_burst,
+                           bool is_propagate)
+{
+    int rank = 0;
+
+    memset (p_burst, 0, sizeof (*p_burst));
+
+    /* Burst id 0 is reserved for the nodes never queued */
+    do {
+        p_burst->burst_id = __atomic_add_fetch (&fib_rslv_burst_id, 1, __ATOMIC_RELAXED);
+    } while (p_burst->burst_id == 0);
+
+    p_burst->cur_rank = -1;
+    p_burst->is_propagate = is_propagate;
+    for (rank = 0; rank < FIB_RSLV_MAX_RANK; rank++) {
+        std_dll_init (&p_burst->rank_queue[rank]);
+    }
+    std_dll_init (&p_burst->dr_batch);
+
+    p_vrf_info->p_rslv_burst = p_burst;
+}
+
+static bool fib_rslv_enqueue (t_fib_rslv_burst *p_burst, t_fib_rslv_node *p_node,
+                              t_fib_rslv_node_type type, void *p_owner, bool is_seed)
+{
+    int rank = 0;
+
+    if (p_node->burst_id == p_burst->burst_id) {
+        if (p_node->state & FIB_RSLV_STATE_QUEUED) {
+            return true;
+        }
+        if (p_node->state & FIB_RSLV_STATE_DONE) {
+            p_burst->num_deferred++;
+            return false;
+        }
+    }
+
+    /* Ranked after the node that marked it, the seeds keep their rank */
+    rank = p_node->rank;
+    if (rank <= p_burst->cur_rank) {
+        rank = p_burst->cur_rank + 1;
+    }
+    if (rank >= FIB_RSLV_MAX_RANK) {
+        rank = FIB_RSLV_MAX_RANK - 1;
+    }
+
+    p_node->p_owner = p_owner;
+    p_node->type = type;
+    p_node->rank = rank;
+    p_node->burst_id = p_burst->burst_id;
+    p_node->state = FIB_RSLV_STATE_QUEUED | (is_seed ? FIB_RSLV_STATE_SEED : 0);
+
+    std_dll_insertatback (&p_burst->rank_queue[rank], &p_node->glue);
+
+    if (is_seed) {
+        p_burst->num_seeds++;
+    }
+    return true;
+}
+
+/* Queue a changelist node of the walker, false if no burst is in progress */
+bool fib_rslv_seed (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node,
+                    t_fib_rslv_node_type type, void *p_owner)
+{
+    if ((p_vrf_info == NULL) || (p_vrf_info->p_rslv_burst == NULL)) {
+        return false;
+    }
+    return fib_rslv_enqueue (p_vrf_info->p_rslv_burst, p_node, type, p_owner, true);
+}
+
+/* Queue a marked node to the burst of its VRF, false if it is to be put on
+ * the walker changelist instead */
+bool fib_rslv_mark (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node,
+                    t_fib_rslv_node_type type, void *p_owner)
+{
+    t_fib_rslv_burst *p_burst = NULL;
+
+    /* A new mark cancels the resolution by an earlier burst */
+    p_node->state &= ~FIB_RSLV_STATE_RESOLVED;
+
+    if (p_vrf_info == NULL) {
+        return false;
+    }
+    p_burst = p_vrf_info->p_rslv_burst;
+    if ((p_burst == NULL) || (!p_burst->is_propagate)) {
+        return false;
+    }
+    if (p_burst->is_expired) {
+        /* Out of the time budget, left to the walker */
+        p_burst->num_left++;
+        return false;
+    }
+    return fib_rslv_enqueue (p_burst, p_node, type, p_owner, false);
+}
+
+/* Unlink a node being freed from the burst */
+void fib_rslv_unlink (t_fib_vrf_info *p_vrf_info, t_fib_rslv_node *p_node)
+{
+    t_fib_rslv_burst *p_burst = NULL;
+
+    if ((p_vrf_info == NULL) || ((p_burst = p_vrf_info->p_rslv_burst) == NULL)) {
+        return;
+    }
+    if ((p_node->burst_id != p_burst->burst_id) ||
+        (!(p_node->state & FIB_RSLV_STATE_QUEUED))) {
+        return;
+    }
+
+    if (p_node->state & FIB_RSLV_STATE_BATCHED) {
+        std_dll_remove (&p_burst->dr_batch, &p_node->glue);
+        p_burst->num_batch--;
+    } else {
+        std_dll_remove (&p_burst->rank_queue[p_node->rank], &p_node->glue);
+    }
+    p_node->state &= ~(FIB_RSLV_STATE_QUEUED | FIB_RSLV_STATE_BATCHED);
+    if (p_node->state & FIB_RSLV_STATE_SEED) {
+        p_burst->num_seeds--;
+    }
+}
+
+/* The time budget of the burst is over, the clock is not read once it is */
+static bool fib_rslv_burst_expired (t_fib_rslv_burst *p_burst)
+{
+    if ((!p_burst->is_expired) && (p_burst->deadline_nsecs != 0) &&
+        (hal_rt_walker_clock_nsecs () >= p_burst->deadline_nsecs)) {
+        p_burst->is_expired = true;
+    }
+    return p_burst->is_expired;
+}
+
+/* Put a node not resolved in the time budget back on the changelist of its
+ * walker, with the VRF marked for the walker */
+static void fib_rslv_node_defer (t_fib_rslv_burst *p_burst, t_fib_rslv_node *p_node)
+{
+    t_fib_dr *p_dr = NULL;
+    t_fib_nh *p_nh = NULL;
+
+    p_node->state = 0;
+    p_burst->num_left++;
+
+    if (p_node->type == FIB_RSLV_NODE_DR) {
+        p_dr = (t_fib_dr *)p_node->p_owner;
+        std_radical_appendtochangelist (hal_rt_access_fib_vrf_dr_tree (p_dr->vrf_id,
+                                                                       p_dr->key.prefix.af_index),
+                                        (std_radical_head_t *)&(p_dr->radical));
+        hal_rt_walker_vrf_mark (FIB_WALKER_DR, p_dr->vrf_id, p_dr->key.prefix.af_index);
+    } else {
+        p_nh = (t_fib_nh *)p_node->p_owner;
+        std_radical_appendtochangelist (hal_rt_access_fib_vrf_nh_tree (p_nh->vrf_id,
+                                                                       p_nh->key.ip_addr.af_index),
+                                        (std_radical_head_t *)&(p_nh->radical));
+        hal_rt_walker_vrf_mark (FIB_WALKER_NH, p_nh->vrf_id, p_nh->key.ip_addr.af_index);
+    }
+}
+
+/* The node is skipped on the changelist of its walker, unless it is
+ * marked again, a seed was taken off the changelist */
+static void fib_rslv_node_done (t_fib_rslv_burst *p_burst, t_fib_rslv_node *p_node)
+{
+    p_node->state = FIB_RSLV_STATE_DONE |
+        ((p_node->state & FIB_RSLV_STATE_SEED) ? 0 : FIB_RSLV_STATE_RESOLVED);
+    p_burst->num_nodes++;
+}
+
+static void fib_rslv_fh_set_job_run (void *p_arg, uint32_t ix)
+{
+    t_fib_rslv_fh_set_job *p_job = (t_fib_rslv_fh_set_job *)p_arg;
+
+    fib_dr_fh_set_compute (p_job->p_dr[ix], &p_job->p_fh_set[ix]);
+}
+
+/* Compute the FH sets of the batched DRs in parallel, returns false to
+ * leave them to be computed by the walker */
+static bool fib_rslv_dr_batch_compute (t_fib_rslv_burst *p_burst, t_fib_rslv_fh_set_job *p_job)
+{
+    t_fib_rslv_node *p_node = NULL;
+    uint32_t         ix = 0;
+
+    if ((p_burst->num_batch < FIB_RSLV_MIN_PARALLEL_DRS) ||
+        (hal_rt_rslv_workers_get () == 0)) {
+        return false;
+    }
+
+    p_job->p_dr = (t_fib_dr **) malloc (p_burst->num_batch * sizeof (t_fib_dr *));
+    p_job->p_fh_set = (t_fib_dr_fh_set *) malloc (p_burst->num_batch * sizeof (t_fib_dr_fh_set));
+    if ((p_job->p_dr == NULL) || (p_job->p_fh_set == NULL)) {
+        free (p_job->p_dr);
+        free (p_job->p_fh_set);
+        return false;
+    }
+
+    for (p_node = (t_fib_rslv_node *) std_dll_getfirst (&p_burst->dr_batch); p_node != NULL;
+         p_node = (t_fib_rslv_node *) std_dll_getnext (&p_burst->dr_batch, &p_node->glue)) {
+        p_node->batch_ix = ix;
+        p_job->p_dr[ix] = (t_fib_dr *)p_node->p_owner;
+        fib_dr_fh_set_init (&p_job->p_fh_set[ix]);
+        ix++;
+    }
+
+    hal_rt_rslv_workers_run (fib_rslv_fh_set_job_run, p_job, ix);
+    p_burst->num_parallel += ix;
+
+    return true;
+}
+
+/* Resolve the DRs of the rank, with the NHs of the rank resolved */
+static void fib_rslv_dr_batch_run (t_fib_rslv_burst *p_burst)
+{
+    t_fib_rslv_fh_set_job job;
+    t_fib_rslv_node      *p_node = NULL;
+    uint32_t              num_fh_sets = p_burst->num_batch;
+    uint32_t              ix = 0;
+    bool                  is_parallel = false;
+
+    if (p_burst->num_batch == 0) {
+        return;
+    }
+
+    is_parallel = fib_rslv_dr_batch_compute (p_burst, &job);
+
+    while ((p_node = (t_fib_rslv_node *) std_dll_getfirst (&p_burst->dr_batch)) != NULL) {
+        std_dll_remove (&p_burst->dr_batch, &p_node->glue);
+        p_burst->num_batch--;
+        fib_rslv_node_done (p_burst, p_node);
+
+        /* The DRs updated before do not change the FH set of this DR, the
+         * FH set is of the NHs resolved before the batch */
+        fib_dr_rslv_process ((t_fib_dr *)p_node->p_owner,
+                             (is_parallel ? &job.p_fh_set[p_node->batch_ix] : NULL));
+    }
+
+    if (is_parallel) {
+        for (ix = 0; ix < num_fh_sets; ix++) {
+            fib_dr_fh_set_free (&job.p_fh_set[ix]);
+        }
+        free (job.p_dr);
+        free (job.p_fh_set);
+    }
+}
+
+/* Resolve the nodes queued at the rank, the NHs and the DRs being deleted
+ * in the queue order, and the rest of the DRs after them. The marked nodes
+ * are deferred once the time budget is over. */
+static void fib_rslv_rank_run (t_fib_rslv_burst *p_burst, int rank)
+{
+    t_fib_rslv_node *p_node = NULL;
+    t_fib_dr        *p_dr = NULL;
+
+    while ((p_node = (t_fib_rslv_node *)
+            std_dll_getfirst (&p_burst->rank_queue[rank])) != NULL) {
+        std_dll_remove (&p_burst->rank_queue[rank], &p_node->glue);
+
+        if ((!(p_node->state & FIB_RSLV_STATE_SEED)) && fib_rslv_burst_expired (p_burst)) {
+            fib_rslv_node_defer (p_burst, p_node);
+            continue;
+        }
+
+        if (p_node->type == FIB_RSLV_NODE_DR) {
+            p_dr = (t_fib_dr *)p_node->p_owner;
+            if (!(p_dr->status_flag & FIB_DR_STATUS_DEL)) {
+                p_node->state |= FIB_RSLV_STATE_BATCHED;
+                std_dll_insertatback (&p_burst->dr_batch, &p_node->glue);
+                p_burst->num_batch++;
+                continue;
+            }
+            fib_rslv_node_done (p_burst, p_node);
+            fib_dr_rslv_process (p_dr, NULL);
+        } else {
+            fib_rslv_node_done (p_burst, p_node);
+            fib_nh_rslv_process ((t_fib_nh *)p_node->p_owner);
+        }
+    }
+
+    fib_rslv_dr_batch_run (p_burst);
+}
+
+/* Resolve the queued nodes in the order of their rank, the nodes marked on
+ * the way are queued to the later ranks and resolved in the same pass till
+ * the deadline (0 for none). Returns the no. of nodes resolved. */
+uint32_t fib_rslv_burst_run (t_fib_vrf_info *p_vrf_info, t_fib_rslv_burst *p_burst,
+                             uint64_t deadline_nsecs)
+{
+    int rank = 0;
+
+    p_burst->deadline_nsecs = deadline_nsecs;
+    for (rank = 0; rank < FIB_RSLV_MAX_RANK; rank++) {
+        p_burst->cur_rank = rank;
+
+        /* The last rank is queued to while it is resolved */
+        while (std_dll_getfirst (&p_burst->rank_queue[rank]) != NULL) {
+            fib_rslv_rank_run (p_burst, rank);
+        }
+    }
+
+    HAL_RT_LOG_DEBUG("HAL-RT-RSLV", "Burst %u vrf_id: %d, af_index: %d, resolved: %u, "
+                     "seeds: %u, deferred: %u, left: %u, parallel: %u", p_burst->burst_id,
+                     p_vrf_info->vrf_id, p_vrf_info->af_index, p_burst->num_nodes,
+                     p_burst->num_seeds, p_burst->num_deferred, p_burst->num_left,
+                     p_burst->num_parallel);
+
+    p_vrf_info->p_rslv_burst = NULL;
+
+    return p_burst->num_nodes;
+}
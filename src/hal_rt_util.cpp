@@ -28,6 +28,7 @@ extern "C" {
 #include "hal_rt_main.h"
 #include "hal_rt_util.h"
 #include "hal_rt_debug.h"
+#include "hal_rt_mem.h"
 
 #ifdef __cplusplus
 }
@@ -40,14 +41,16 @@ extern "C" {
 #include "nas_if_utils.h"
 #include <unordered_map>
 #include <memory>
-#include <deque>
 #include <utility>
 #include <mutex>
 #include <sstream>
-#include <condition_variable>
 #include <algorithm>
+#include <vector>
+#include <chrono>
 #include "nas_ndi_obj_id_table.h"
 #include "dell-base-switch-element.h"
+#include "dell-base-routing.h"
+#include "os-routing-events.h"
 #include "std_utils.h"
 #include "nas_vrf_utils.h"
 
@@ -59,19 +62,77 @@ extern "C" {
 #include "std_utils.h"
 #include "std_rw_lock.h"
 
-using fib_msg_uptr_t = std::unique_ptr<t_fib_msg>;
-static auto &hal_rt_msg_list = *new std::deque<fib_msg_uptr_t>;
-/* stats counter for hal_rt_msg_list queue on per msg type basis */
-static auto hal_rt_msg_list_stats = new std::unordered_map<uint32_t,uint32_t> {
-            { FIB_MSG_TYPE_NL_INTF, 0 },
-            { FIB_MSG_TYPE_NBR_MGR_INTF, 0 },
-            { FIB_MSG_TYPE_NL_ROUTE, 0 },
-            { FIB_MSG_TYPE_NBR_MGR_NBR_INFO, 0 },
-            { FIB_MSG_TYPE_NL_NBR, 0 },
-            { FIB_MSG_TYPE_INTF_IP_UNREACH_CFG, 0 },
-            { FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG, 0 },
-};
-uint_t hal_rt_msg_peak_cnt = 0;
+#include "hal_rt_msg_queue.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+/* Msg queue per msg worker, the VRFs are sharded across the workers */
+static auto &hal_rt_msgq = *new std::array<std::unique_ptr<hal_rt_msgq_t>, FIB_MAX_MSG_WORKERS>;
+/* Set once at the init, before the producers and the workers are started */
+static std::atomic<uint32_t> hal_rt_msg_num_workers {0};
+/* Serializes the barrier enqueues, so that the barriers are in the same
+ * order in all the worker queues */
+static auto &hal_rt_msg_barrier_mutex = *new std::mutex;
+/* Route msgs validated before queueing, and the time spent in the validation,
+ * which is the nas_l3_lock hold time saved by validating off the lock */
+static std::atomic<uint64_t> hal_rt_route_validated_cnt {0};
+static std::atomic<uint64_t> hal_rt_route_validation_skip_cnt {0};
+static std::atomic<uint64_t> hal_rt_route_validation_nsecs {0};
+/* Queue wait and processing time of the msgs per msg type */
+static auto &hal_rt_msg_wait_hist = *new std::array<hal_rt_latency_hist_t, FIB_MSG_TYPE_MAX>;
+static auto &hal_rt_msg_proc_hist = *new std::array<hal_rt_latency_hist_t, FIB_MSG_TYPE_MAX>;
+
+/* DR/NH walker throughput, updated by the walker thread only */
+typedef struct {
+    std::atomic<uint64_t> num_batches;
+    std::atomic<uint64_t> num_full_batches;
+    std::atomic<uint64_t> num_nodes;
+    std::atomic<uint64_t> busy_nsecs;
+    std::atomic<uint32_t> node_cost_nsecs;
+    std::atomic<uint32_t> batch_size;
+    std::atomic<uint64_t> num_propagated;
+    std::atomic<uint64_t> num_deferred;
+    std::atomic<uint64_t> num_parallel;
+} hal_rt_walker_stats_t;
+
+static hal_rt_walker_stats_t hal_rt_walker_stats[FIB_WALKER_MAX];
+
+/* Coalescing window of the walker wakeups, the time of the first change not
+ * yet seen by the walker (0 if none) and the no. of changes since */
+typedef struct {
+    std::atomic<uint64_t> first_nsecs;
+    std::atomic<uint32_t> num_changes;
+    std::atomic<uint64_t> num_time_wakeups;
+    std::atomic<uint64_t> num_change_wakeups;
+} hal_rt_walker_coalesce_t;
+
+static hal_rt_walker_coalesce_t hal_rt_walker_coalesce[FIB_WALKER_MAX];
+/* Delay from the route change to the route programmed by the DR walker */
+static auto &hal_rt_convergence_hist = *new hal_rt_latency_hist_t;
+
+/* VRFs with changes pending for the walker per AF, and the no. of changes
+ * marked since the walker last caught up with the VRF */
+#define HAL_RT_WALKER_VRF_WORDS ((FIB_MAX_VRF + 63) / 64)
+static std::atomic<uint64_t> hal_rt_walker_dirty_vrfs[FIB_WALKER_MAX][FIB_MAX_AFINDEX][HAL_RT_WALKER_VRF_WORDS];
+static std::atomic<uint32_t> hal_rt_walker_vrf_backlog[FIB_WALKER_MAX][FIB_MAX_AFINDEX][FIB_MAX_VRF];
+
+/*
+ * Msg that should be processed only after the msgs queued before it to the
+ * workers in the barrier. Each of the workers gets a barrier token msg, the
+ * last worker to reach its token processes the msg while the other workers
+ * wait for it, so the msgs queued after the barrier are processed after the msg.
+ */
+typedef struct {
+    fib_msg_uptr_t          msg;
+    std::atomic<uint32_t>   pending; /* Workers yet to reach the barrier */
+    std::atomic<uint32_t>   refs;    /* Workers yet to leave the barrier */
+    std::mutex              mtx;
+    std::condition_variable cv;
+    bool                    done;
+} hal_rt_msg_barrier_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -89,8 +150,10 @@ extern "C" {
           { DN_HAL_ROUTE_E_END,            ""                   },   \
         }
 
-static uint8_t   ga_fib_scratch_buf [FIB_NUM_SCRATCH_BUF][FIB_MAX_SCRATCH_BUFSZ];
-static uint32_t  g_fib_scratch_buf_index = 0;
+/* Per thread, the address to string conversions are done by the msg workers,
+ * walkers and the CPS get handlers concurrently with the nas_l3_lock shared */
+static thread_local uint8_t   ga_fib_scratch_buf [FIB_NUM_SCRATCH_BUF][FIB_MAX_SCRATCH_BUFSZ];
+static thread_local uint32_t  g_fib_scratch_buf_index = 0;
 
 t_std_error hal_rt_lag_obj_id_get (hal_ifindex_t if_index, ndi_obj_id_t& obj_id);
 
@@ -625,11 +688,11 @@ t_std_error hal_rif_index_get_or_create (npu_id_t npu_id, hal_vrf_id_t vrf_id,
         /* fib_intf is stored on a per af basis, so retrieve
          * the interface for first available family and use its mac.
          */
-        p_intf = fib_get_next_intf (rt_if_index, vrf_id, 0);
+        p_intf = fib_get_intf_any_af (rt_if_index, vrf_id);
 
         /* @@TODO Revisit this, check whether interface could be NULL for non-default VRF,
          * if not, remove the "else" code below.*/
-        if (p_intf && (p_intf->key.vrf_id == vrf_id) && (p_intf->key.if_index == rt_if_index)) {
+        if (p_intf) {
             rif_entry.flags = NDI_RIF_ATTR_SRC_MAC_ADDRESS;
             memcpy(&rif_entry.src_mac, &p_intf->mac_addr, sizeof(hal_mac_addr_t));
         } else {
@@ -644,7 +707,7 @@ t_std_error hal_rif_index_get_or_create (npu_id_t npu_id, hal_vrf_id_t vrf_id,
         /* fib_intf is stored on a per af basis, so retrieve
          * the interface for first available family and use its mac.
          */
-        p_intf = fib_get_next_intf (if_index, vrf_id, 0);
+        p_intf = fib_get_intf_any_af (if_index, vrf_id);
 
         if (p_intf) {
             memcpy(&mac_addr, &p_intf->mac_addr, sizeof(hal_mac_addr_t));
@@ -809,123 +872,850 @@ uint32_t nas_rt_get_clock_sec() {
     return(time(NULL));
 }
 
-std::mutex m_mtx;
-std::condition_variable  m_data;
+uint32_t nas_rt_read_msg_list_stats (t_fib_msg_type msg_type)
+{
+    uint32_t cnt = 0;
 
-fib_msg_uptr_t nas_rt_read_msg () {
-    std::unique_lock<std::mutex> l {m_mtx};
-    if (hal_rt_msg_list.empty()) {
-        m_data.wait (l, []{return !hal_rt_msg_list.empty();});
+    for (uint32_t worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        cnt += hal_rt_msgq[worker_id]->msg_type_count(msg_type);
+    }
+    return cnt;
+}
+/* Process the given msg, called with the lock of the msg held (see fib_msg_lock) */
+static void fib_msg_process_locked (t_fib_msg *p_msg)
+{
+    switch(p_msg->type) {
+        case FIB_MSG_TYPE_NL_INTF:
+        case FIB_MSG_TYPE_NBR_MGR_INTF:
+            HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD",
+                             "Interface msg processing type:%d", p_msg->type);
+            hal_rt_process_intf_state_msg(p_msg->type, &(p_msg->intf));
+            break;
+        case FIB_MSG_TYPE_NL_ROUTE:
+            HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "Route msg processing");
+            fib_proc_dr_download(&(p_msg->route));
+            break;
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+            HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "Nbr msg processing");
+            fib_proc_nbr_download(&(p_msg->nbr));
+            break;
+        case FIB_MSG_TYPE_INTF_IP_UNREACH_CFG:
+            HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "IP unreachable config msg processing");
+            fib_proc_ip_unreach_config_msg(&(p_msg->ip_unreach_cfg));
+            break;
+        default:
+            break;
     }
-    auto p_msg = std::move(hal_rt_msg_list.front());
-    hal_rt_msg_list.pop_front();
-    auto it = hal_rt_msg_list_stats->find(p_msg->type);
-    if (it != hal_rt_msg_list_stats->end())
-        it->second--;
-    return p_msg;
 }
 
-uint32_t nas_rt_read_msg_list_stats (t_fib_msg_type msg_type)
+/* The route and nbr msgs are processed with only their VRF locked, the
+ * other msgs and the routes leaked across VRFs take the nas_l3_lock exclusive */
+static bool fib_msg_lock_vrf_get (t_fib_msg *p_msg, hal_vrf_id_t *p_vrf_id)
 {
-    std::lock_guard<std::mutex> l {m_mtx};
+    switch (p_msg->type) {
+        case FIB_MSG_TYPE_NL_ROUTE:
+            if (p_msg->route.vrfid != p_msg->route.nh_vrfid)
+                return false;
+            *p_vrf_id = p_msg->route.vrfid;
+            return true;
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+        case FIB_MSG_TYPE_NL_NBR:
+            *p_vrf_id = p_msg->nbr.vrfid;
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
 
-    auto it = hal_rt_msg_list_stats->find(msg_type);
-    if (it == hal_rt_msg_list_stats->end())
-        return 0;
-    return it->second;
+typedef struct _fib_msg_lock_t {
+    hal_vrf_id_t        vrf_id;
+    bool                is_vrf;
+    t_fib_vrf_lock_mode mode;
+} fib_msg_lock_t;
+
+static void fib_msg_lock (t_fib_msg *p_msg, fib_msg_lock_t &lock)
+{
+    lock.is_vrf = fib_msg_lock_vrf_get(p_msg, &lock.vrf_id);
+    if (lock.is_vrf) {
+        lock.mode = nas_l3_vrf_lock(lock.vrf_id);
+    } else {
+        nas_l3_lock();
+        lock.mode = FIB_VRF_LOCK_EXCL;
+    }
 }
-int fib_msg_main(void) {
-    uint32_t nas_num_route_msgs_in_queue = 0;
-    /* Process the messages from queue */
-    for(;;) {
-        fib_msg_uptr_t p_msg_uptr = nas_rt_read_msg();
-        if (!p_msg_uptr)
+
+static void fib_msg_unlock (fib_msg_lock_t &lock)
+{
+    if (lock.is_vrf) {
+        nas_l3_vrf_unlock(lock.vrf_id, lock.mode);
+    } else {
+        nas_l3_unlock();
+    }
+}
+
+/* Whether the msg can be processed with the lock already held */
+static bool fib_msg_lock_covers (const fib_msg_lock_t &lock, t_fib_msg *p_msg)
+{
+    hal_vrf_id_t vrf_id = 0;
+
+    if (lock.mode == FIB_VRF_LOCK_EXCL)
+        return true;
+    return (fib_msg_lock_vrf_get(p_msg, &vrf_id) && (vrf_id == lock.vrf_id));
+}
+
+static inline uint64_t fib_msg_clock_nsecs (std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+/* Record the queue wait and the processing time of the msg */
+static inline void fib_msg_latency_record (const t_fib_msg *p_msg,
+                                           std::chrono::steady_clock::time_point start,
+                                           std::chrono::steady_clock::time_point end)
+{
+    if ((p_msg->type <= 0) || (p_msg->type >= FIB_MSG_TYPE_MAX))
+        return;
+
+    uint64_t start_nsecs = fib_msg_clock_nsecs(start);
+    if (p_msg->enq_time && (start_nsecs >= p_msg->enq_time))
+        hal_rt_msg_wait_hist[p_msg->type].record(start_nsecs - p_msg->enq_time);
+    hal_rt_msg_proc_hist[p_msg->type].record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+/* Messages that take the nas_l3_lock by themselves */
+static inline bool fib_msg_is_self_locked (t_fib_msg *p_msg)
+{
+    return ((p_msg->type == FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG) ||
+            (p_msg->type == FIB_MSG_TYPE_BARRIER));
+}
+
+static void fib_msg_barrier_process (t_fib_msg *p_token)
+{
+    hal_rt_msg_barrier_t *p_barrier = (hal_rt_msg_barrier_t *)p_token->p_barrier;
+
+    if (p_barrier->pending.fetch_sub(1) == 1) {
+        t_fib_msg *p_msg = p_barrier->msg.get();
+        if (p_msg->type == FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG) {
+            fib_proc_ip_redirects_config_msg(&(p_msg->ip_redirects_cfg));
+        } else {
+            nas_l3_lock();
+            fib_msg_process_locked(p_msg);
+            nas_l3_unlock();
+        }
+        {
+            std::lock_guard<std::mutex> lock(p_barrier->mtx);
+            p_barrier->done = true;
+        }
+        p_barrier->cv.notify_all();
+    } else {
+        std::unique_lock<std::mutex> lock(p_barrier->mtx);
+        p_barrier->cv.wait(lock, [p_barrier] { return p_barrier->done; });
+    }
+    if (p_barrier->refs.fetch_sub(1) == 1)
+        delete p_barrier;
+}
+
+static void fib_msg_self_locked_process (t_fib_msg *p_msg)
+{
+    if (p_msg->type == FIB_MSG_TYPE_BARRIER) {
+        fib_msg_barrier_process(p_msg);
+        return;
+    }
+    HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "IP redirects config msg processing");
+    fib_proc_ip_redirects_config_msg(&(p_msg->ip_redirects_cfg));
+}
+
+/* The worker of a VRF is derived from the VRF id and not kept in t_fib_vrf,
+ * the producers map the msgs to the workers without the nas_l3_lock and the
+ * msgs of a VRF can arrive before the VRF is created or after it is deleted.
+ * The VRF state owned by the worker is the VRF lock in t_fib_vrf. */
+static inline uint32_t fib_msg_vrf_worker_get (unsigned long vrf_id)
+{
+    return (vrf_id % hal_rt_msg_num_workers);
+}
+
+/* Workers that should be done with their queued msgs before the msg is processed */
+static uint32_t fib_msg_worker_mask_get (t_fib_msg *p_msg)
+{
+    switch (p_msg->type) {
+        case FIB_MSG_TYPE_NL_ROUTE:
+            /* Route leaked from another VRF also waits for the NH VRF worker */
+            return ((1 << fib_msg_vrf_worker_get(p_msg->route.vrfid)) |
+                    (1 << fib_msg_vrf_worker_get(p_msg->route.nh_vrfid)));
+        case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
+        case FIB_MSG_TYPE_NL_NBR:
+            return (1 << fib_msg_vrf_worker_get(p_msg->nbr.vrfid));
+        case FIB_MSG_TYPE_NL_INTF:
+        case FIB_MSG_TYPE_NBR_MGR_INTF:
+            /* Interface msg affects the routes and nbrs of the interface VRF, and
+             * the routes leaked to the other VRFs via the NHs on the interface.
+             * The leaked route msgs are queued to the worker of the NH VRF too,
+             * so the interface VRF worker keeps the order with all of them. */
+            return (1 << fib_msg_vrf_worker_get(p_msg->intf.vrf_id));
+        default:
+            break;
+    }
+    /* Configs affect the routes and nbrs of all the VRFs */
+    return ((1 << hal_rt_msg_num_workers) - 1);
+}
+
+static bool fib_msg_barrier_enqueue (t_fib_msg *p_msg, uint32_t worker_mask)
+{
+    t_fib_msg *tokens[FIB_MAX_MSG_WORKERS];
+    uint32_t   worker_id = 0, num_tokens = 0;
+
+    hal_rt_msg_barrier_t *p_barrier = new (std::nothrow) hal_rt_msg_barrier_t;
+    if (p_barrier == NULL) {
+        hal_rt_free_mem_msg(p_msg);
+        return false;
+    }
+    p_barrier->msg.reset(p_msg);
+    p_barrier->done = false;
+    for (worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        if (!(worker_mask & (1 << worker_id)))
             continue;
-        auto p_msg = p_msg_uptr.get();
-        switch(p_msg->type) {
-            case FIB_MSG_TYPE_NL_INTF:
-            case FIB_MSG_TYPE_NBR_MGR_INTF:
-                HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD",
-                                 "Interface msg processing type:%d", p_msg->type);
-                nas_l3_lock();
-                hal_rt_process_intf_state_msg(p_msg->type, &(p_msg->intf));
-                nas_l3_unlock();
-                break;
-            case FIB_MSG_TYPE_NL_ROUTE:
-                HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "Route msg processing");
-                nas_num_route_msgs_in_queue = nas_rt_read_msg_list_stats (p_msg->type);
-                nas_l3_lock();
-                fib_proc_dr_download(&(p_msg->route), nas_num_route_msgs_in_queue);
-                nas_l3_unlock();
-                break;
-            case FIB_MSG_TYPE_NBR_MGR_NBR_INFO:
-                HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "Nbr msg processing");
-                nas_l3_lock();
-                fib_proc_nbr_download(&(p_msg->nbr));
-                nas_l3_unlock();
-                break;
-            case FIB_MSG_TYPE_INTF_IP_UNREACH_CFG:
-                HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "IP unreachable config msg processing");
-                nas_l3_lock();
-                fib_proc_ip_unreach_config_msg(&(p_msg->ip_unreach_cfg));
-                nas_l3_unlock();
-                break;
-            case FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG:
-                HAL_RT_LOG_DEBUG("HAL-RT-MSG-THREAD", "IP redirects config msg processing");
-                fib_proc_ip_redirects_config_msg(&(p_msg->ip_redirects_cfg));
-                break;
-            default:
-                break;
+        if ((tokens[num_tokens] = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_BARRIER)) == NULL) {
+            HAL_RT_LOG_ERR("HAL-RT-MSG", "Barrier alloc failed, msg type:%d dropped", p_msg->type);
+            while (num_tokens) {
+                hal_rt_free_mem_msg(tokens[--num_tokens]);
+            }
+            delete p_barrier;
+            return false;
+        }
+        tokens[num_tokens]->enq_time = p_msg->enq_time;
+        tokens[num_tokens++]->p_barrier = p_barrier;
+    }
+    p_barrier->pending.store(num_tokens);
+    p_barrier->refs.store(num_tokens);
+
+    std::lock_guard<std::mutex> lock(hal_rt_msg_barrier_mutex);
+    for (worker_id = 0, num_tokens = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        if (worker_mask & (1 << worker_id))
+            hal_rt_msgq[worker_id]->enqueue(tokens[num_tokens++]);
+    }
+    return true;
+}
+
+/* Validate the route msg before it is queued, returns false when the
+ * msg is to be skipped */
+static bool fib_msg_route_validate (t_fib_msg *p_msg)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool is_valid = (fib_proc_dr_validate(&(p_msg->route)) == FIB_RT_VALIDATION_OK);
+
+    hal_rt_route_validation_nsecs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                            (std::chrono::steady_clock::now() - start).count(),
+                                            std::memory_order_relaxed);
+    hal_rt_route_validated_cnt.fetch_add(1, std::memory_order_relaxed);
+    if (!is_valid)
+        hal_rt_route_validation_skip_cnt.fetch_add(1, std::memory_order_relaxed);
+    return is_valid;
+}
+
+/*
+ * Resync the DRs of the VRF with the kernel routes, the route msgs of the VRF
+ * were dropped at the msg queue bounds. The kernel routes are replayed as route
+ * adds diffed against the FIB (see fib_proc_dr_resync), the DRs in sync are not
+ * touched and no neighbor flush is done. Called from the msg thread with the
+ * queue drained, the routes are processed inline since the msg thread cannot
+ * wait on the queue it drains.
+ */
+static void fib_msg_vrf_route_resync (hal_vrf_id_t vrf_id)
+{
+    cps_api_get_params_t get_req;
+    char                 vrf_name[NAS_VRF_NAME_SZ + 1];
+    t_fib_msg           *p_msg = NULL;
+    size_t               ix = 0, len = 0;
+    uint32_t             batch_size = 0, resync_cnt = 0;
+    std::vector<fib_msg_uptr_t> msg_batch;
+
+    memset(vrf_name, 0, sizeof(vrf_name));
+    if (!hal_rt_get_vrf_name(vrf_id, vrf_name)) {
+        return;
+    }
+    if (cps_api_get_request_init (&get_req) != cps_api_ret_code_OK) {
+        HAL_RT_LOG_ERR("HAL-RT-RESYNC", "Route get request init failed for VRF:%s", vrf_name);
+        return;
+    }
+    cps_api_object_t filt = cps_api_object_list_create_obj_and_append(get_req.filters);
+    if (filt == NULL) {
+        cps_api_get_request_close (&get_req);
+        return;
+    }
+    cps_api_key_from_attr_with_qual(cps_api_object_key(filt), OS_RE_BASE_ROUTE_OBJ_ENTRY_OBJ,
+                                    cps_api_qualifier_TARGET);
+    cps_api_object_attr_add(filt, BASE_ROUTE_OBJ_VRF_NAME, vrf_name, strlen(vrf_name)+1);
+
+    if (cps_api_get(&get_req) != cps_api_ret_code_OK) {
+        HAL_RT_LOG_ERR("HAL-RT-RESYNC", "Kernel route get failed for VRF:%s", vrf_name);
+        cps_api_get_request_close (&get_req);
+        return;
+    }
+
+    len = cps_api_object_list_size(get_req.list);
+    msg_batch.reserve(FIB_MAX_MSG_BATCH_SIZE);
+    for (ix = 0; ix < len;) {
+        /* Decode and validate the batch before taking the lock */
+        batch_size = hal_rt_access_fib_config()->msg_batch_size;
+        msg_batch.clear();
+        for (; (msg_batch.size() < batch_size) && (ix < len); ix++) {
+            cps_api_object_t obj = cps_api_object_list_get(get_req.list, ix);
+            /* Add the kernel route, the stale NHs are removed at the resync */
+            cps_api_object_set_type_operation(cps_api_object_key(obj), cps_api_oper_CREATE);
+            if (!hal_rt_cps_obj_to_route(obj, &p_msg))
+                continue;
+            fib_msg_uptr_t p_msg_uptr(p_msg);
+            if (!fib_msg_route_validate(p_msg))
+                continue;
+            msg_batch.push_back(std::move(p_msg_uptr));
+        }
+        if (msg_batch.empty())
+            continue;
+
+        for (size_t cnt = 0; cnt < msg_batch.size();) {
+            fib_msg_lock_t lock;
+            fib_msg_lock(msg_batch[cnt].get(), lock);
+            do {
+                fib_proc_dr_resync(&(msg_batch[cnt]->route));
+                msg_batch[cnt++].reset();
+                resync_cnt++;
+            } while ((cnt < msg_batch.size()) && fib_msg_lock_covers(lock, msg_batch[cnt].get()));
+            fib_msg_unlock(lock);
+        }
+    }
+    cps_api_get_request_close (&get_req);
+    HAL_RT_LOG_INFO("HAL-RT-RESYNC", "VRF:%s resynced with %d kernel routes",
+                    vrf_name, resync_cnt);
+}
+
+int fib_msg_main(void *param) {
+    hal_rt_msgq_t &msgq = *hal_rt_msgq[(uintptr_t)param];
+    std::vector<fib_msg_uptr_t> msg_batch;
+    uint32_t batch_size = FIB_DEFAULT_MSG_BATCH_SIZE;
+    uint32_t batch_time_budget = FIB_DEFAULT_MSG_BATCH_TIME_BUDGET;
+    size_t   ix = 0;
+    hal_vrf_id_t resync_vrf_id = 0;
+    fib_msg_lock_t lock;
+
+    msg_batch.reserve(FIB_MAX_MSG_BATCH_SIZE);
+    /* Process the messages from queue in batches, the lock is taken once for
+     * the msgs of the batch that need the same lock (the VRF of the msg or the
+     * nas_l3_lock exclusive) and released when the batch is done or the batch
+     * time budget expires, so that the walkers get their turn.
+     */
+    for(;;) {
+        msg_batch.clear();
+        msgq.dequeue_batch(msg_batch, batch_size);
+
+        for (ix = 0; ix < msg_batch.size();) {
+            auto p_msg = msg_batch[ix].get();
+            if (fib_msg_is_self_locked(p_msg)) {
+                auto msg_start = std::chrono::steady_clock::now();
+                fib_msg_self_locked_process(p_msg);
+                fib_msg_latency_record(p_msg, msg_start, std::chrono::steady_clock::now());
+                msg_batch[ix++].reset();
+                continue;
+            }
+
+            fib_msg_lock(p_msg, lock);
+            batch_size = hal_rt_access_fib_config()->msg_batch_size;
+            batch_time_budget = hal_rt_access_fib_config()->msg_batch_time_budget;
+            auto hold_start = std::chrono::steady_clock::now();
+            auto msg_start = hold_start;
+            for (;;) {
+                fib_msg_process_locked(p_msg);
+                auto msg_end = std::chrono::steady_clock::now();
+                fib_msg_latency_record(p_msg, msg_start, msg_end);
+                msg_start = msg_end;
+                msg_batch[ix++].reset();
+                if (ix >= msg_batch.size())
+                    break;
+                p_msg = msg_batch[ix].get();
+                if (fib_msg_is_self_locked(p_msg) || !fib_msg_lock_covers(lock, p_msg))
+                    break;
+                if (batch_time_budget &&
+                    (std::chrono::duration_cast<std::chrono::microseconds>
+                     (msg_end - hold_start).count() >= batch_time_budget))
+                    break;
+            }
+            fib_msg_unlock(lock);
+            /* Free the DR/NH nodes deleted in the batch, unless a get still refers them */
+            hal_rt_epoch_reclaim();
+            /* Let the other workers take the lock between the holds */
+            if (hal_rt_msg_num_workers > 1)
+                std::this_thread::yield();
+        }
+
+        /* Resync the VRFs with the route msgs dropped at the queue bounds,
+         * once the msgs queued before the drop are processed */
+        while ((msgq.size() == 0) && msgq.resync_vrf_get(&resync_vrf_id)) {
+            fib_msg_vrf_route_resync(resync_vrf_id);
         }
     }
     return true;
 }
 
+t_std_error hal_rt_msg_workers_init(uint32_t num_workers) {
+    if ((num_workers == 0) || (num_workers > FIB_MAX_MSG_WORKERS)) {
+        HAL_RT_LOG_ERR("HAL-RT-MSG", "Invalid no. of msg workers:%d, valid range 1-%d",
+                       num_workers, FIB_MAX_MSG_WORKERS);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_PARAM, 0));
+    }
+    /* The no. of workers is fixed once set, the producers map the VRFs to
+     * the workers without a lock */
+    if (hal_rt_msg_num_workers != 0) {
+        HAL_RT_LOG_ERR("HAL-RT-MSG", "Msg workers already initialized with %d workers",
+                       hal_rt_msg_num_workers.load());
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_PARAM, 0));
+    }
+    for (uint32_t worker_id = 0; worker_id < num_workers; worker_id++) {
+        hal_rt_msgq[worker_id].reset(new hal_rt_msgq_t (HAL_RT_MSGQ_DEPTH));
+    }
+    /* Publish the queues along with the count */
+    hal_rt_msg_num_workers.store(num_workers, std::memory_order_release);
+    return STD_ERR_OK;
+}
+
+/*
+ * Resolution workers, a fork-join pool the walkers hand the per item jobs of
+ * a VRF lock hold to. The walker runs the job items too and returns once
+ * all the items are done, so the items run under the walker's VRF lock.
+ * A job runs at a time, a walker finding the pool busy runs its job itself.
+ */
+typedef struct {
+    std::mutex              job_mutex;  /* Held by the walker running a job */
+    std::mutex              mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t                job_id;
+    bool                    is_job_active;
+    uint32_t                num_busy;   /* Workers in the active job */
+    hal_rt_rslv_job_fn_t    fn;
+    void                   *p_arg;
+    uint32_t                num_items;
+    std::atomic<uint32_t>   next_item;
+    std::atomic<uint32_t>   num_workers;
+} hal_rt_rslv_pool_t;
+
+/* Value initialized, so the counters and atomics start at 0 */
+static auto &hal_rt_rslv_pool = *new hal_rt_rslv_pool_t();
+
+static void hal_rt_rslv_items_run(hal_rt_rslv_job_fn_t fn, void *p_arg, uint32_t num_items) {
+    uint32_t item;
+
+    while ((item = hal_rt_rslv_pool.next_item.fetch_add(1, std::memory_order_relaxed)) < num_items)
+        fn(p_arg, item);
+}
+
+int fib_rslv_worker_main(void *param) {
+    hal_rt_rslv_pool_t &pool = hal_rt_rslv_pool;
+    uint64_t job_id = 0;
+
+    pool.num_workers.fetch_add(1, std::memory_order_release);
+    for ( ; ; ) {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.start_cv.wait(lock, [&pool, job_id] { return pool.job_id != job_id; });
+        job_id = pool.job_id;
+        if (!pool.is_job_active)
+            continue;
+
+        hal_rt_rslv_job_fn_t fn = pool.fn;
+        void *p_arg = pool.p_arg;
+        uint32_t num_items = pool.num_items;
+        pool.num_busy++;
+        lock.unlock();
+
+        hal_rt_rslv_items_run(fn, p_arg, num_items);
+
+        lock.lock();
+        if (--pool.num_busy == 0)
+            pool.done_cv.notify_all();
+    }
+    return true;
+}
+
+uint32_t hal_rt_rslv_workers_get(void) {
+    return hal_rt_rslv_pool.num_workers.load(std::memory_order_acquire);
+}
+
+void hal_rt_rslv_workers_run(hal_rt_rslv_job_fn_t fn, void *p_arg, uint32_t num_items) {
+    hal_rt_rslv_pool_t &pool = hal_rt_rslv_pool;
+    std::unique_lock<std::mutex> job_lock(pool.job_mutex, std::try_to_lock);
+
+    if ((!job_lock.owns_lock()) || (hal_rt_rslv_workers_get() == 0)) {
+        for (uint32_t item = 0; item < num_items; item++)
+            fn(p_arg, item);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.fn = fn;
+        pool.p_arg = p_arg;
+        pool.num_items = num_items;
+        pool.next_item.store(0, std::memory_order_relaxed);
+        pool.is_job_active = true;
+        pool.job_id++;
+    }
+    pool.start_cv.notify_all();
+
+    hal_rt_rslv_items_run(fn, p_arg, num_items);
+
+    /* The items are all taken, wait for the workers still running one */
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.is_job_active = false;
+    pool.done_cv.wait(lock, [&pool] { return pool.num_busy == 0; });
+}
+
+/*
+ * Msgs are queued to the worker of their VRF. The msgs that refer to the VRFs
+ * of more than one worker are queued as a barrier to all those workers, which
+ * keeps their order with the msgs of all the VRFs they refer to.
+ */
 int nas_rt_process_msg(t_fib_msg *p_msg) {
-    bool hal_rt_msg_thr_wakeup = false;
-    if (p_msg) {
-        std::lock_guard<std::mutex> l {m_mtx};
-        hal_rt_msg_thr_wakeup = hal_rt_msg_list.empty();
-        hal_rt_msg_list.emplace_back(p_msg);
-        auto it = hal_rt_msg_list_stats->find(p_msg->type);
-        if (it != hal_rt_msg_list_stats->end())
-            it->second++;
-        if (hal_rt_msg_peak_cnt < hal_rt_msg_list.size())
-            hal_rt_msg_peak_cnt = hal_rt_msg_list.size();
-    }
-    if (hal_rt_msg_thr_wakeup) m_data.notify_one ();
+    /* Only the valid route msgs are queued for the processing under the lock */
+    if ((p_msg->type == FIB_MSG_TYPE_NL_ROUTE) && !fib_msg_route_validate(p_msg)) {
+        hal_rt_free_mem_msg(p_msg);
+        return true;
+    }
+    p_msg->enq_time = fib_msg_clock_nsecs(std::chrono::steady_clock::now());
+    if (hal_rt_msg_num_workers == 0) {
+        HAL_RT_LOG_ERR("HAL-RT-MSG", "Msg workers not initialized, msg type:%d dropped",
+                       p_msg->type);
+        hal_rt_free_mem_msg(p_msg);
+        return false;
+    }
+    if (hal_rt_msg_num_workers == 1) {
+        hal_rt_msgq[0]->enqueue(p_msg);
+        return true;
+    }
+
+    uint32_t worker_mask = fib_msg_worker_mask_get(p_msg);
+    if (worker_mask & (worker_mask - 1)) {
+        return fib_msg_barrier_enqueue(p_msg, worker_mask);
+    }
+    hal_rt_msgq[__builtin_ctz(worker_mask)]->enqueue(p_msg);
     return true;
 }
 
-t_fib_msg *hal_rt_alloc_mem_msg() {
-    t_fib_msg *p_msg = new (std::nothrow) t_fib_msg;
-    return p_msg;
+/* Bounds are split evenly across the worker queues */
+void hal_rt_msg_queue_set_bounds(uint32_t max_len, uint64_t max_bytes,
+                                 t_fib_msg_queue_overflow_policy policy) {
+    for (uint32_t worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        hal_rt_msgq[worker_id]->set_bounds(((max_len + hal_rt_msg_num_workers - 1) /
+                                            hal_rt_msg_num_workers),
+                                           (max_bytes / hal_rt_msg_num_workers), policy);
+    }
+}
+
+void hal_rt_msg_queue_gauges_get(uint32_t *p_depth, uint64_t *p_bytes) {
+    *p_depth = 0;
+    *p_bytes = 0;
+    for (uint32_t worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        *p_depth += hal_rt_msgq[worker_id]->size();
+        *p_bytes += hal_rt_msgq[worker_id]->bytes();
+    }
+}
+
+void hal_rt_route_validation_stats_get(uint64_t *p_validated, uint64_t *p_skipped,
+                                       uint64_t *p_nsecs) {
+    *p_validated = hal_rt_route_validated_cnt.load(std::memory_order_relaxed);
+    *p_skipped = hal_rt_route_validation_skip_cnt.load(std::memory_order_relaxed);
+    *p_nsecs = hal_rt_route_validation_nsecs.load(std::memory_order_relaxed);
+}
+
+void hal_rt_route_validation_stats_clear(void) {
+    hal_rt_route_validated_cnt.store(0, std::memory_order_relaxed);
+    hal_rt_route_validation_skip_cnt.store(0, std::memory_order_relaxed);
+    hal_rt_route_validation_nsecs.store(0, std::memory_order_relaxed);
 }
 
+static inline uint64_t fib_msg_nsecs_to_usecs (uint64_t nsecs)
+{
+    return ((nsecs + 999) / 1000);
+}
+
+bool hal_rt_msg_latency_stats_get(t_fib_msg_type msg_type, t_fib_msg_latency_stats *p_stats) {
+    if ((msg_type <= 0) || (msg_type >= FIB_MSG_TYPE_MAX))
+        return false;
+
+    const hal_rt_latency_hist_t &wait_hist = hal_rt_msg_wait_hist[msg_type];
+    const hal_rt_latency_hist_t &proc_hist = hal_rt_msg_proc_hist[msg_type];
+
+    p_stats->count = proc_hist.count();
+    p_stats->queue_wait_p50 = fib_msg_nsecs_to_usecs(wait_hist.percentile(50));
+    p_stats->queue_wait_p99 = fib_msg_nsecs_to_usecs(wait_hist.percentile(99));
+    p_stats->queue_wait_max = fib_msg_nsecs_to_usecs(wait_hist.max());
+    p_stats->process_time_p50 = fib_msg_nsecs_to_usecs(proc_hist.percentile(50));
+    p_stats->process_time_p99 = fib_msg_nsecs_to_usecs(proc_hist.percentile(99));
+    p_stats->process_time_max = fib_msg_nsecs_to_usecs(proc_hist.max());
+    return true;
+}
 
-/* allocate memory for the route message for given buffer size.
- * route message buffer size is calculated based on the nh_count
- * in the message.
+void hal_rt_msg_latency_stats_clear(void) {
+    for (int msg_type = 0; msg_type < FIB_MSG_TYPE_MAX; msg_type++) {
+        hal_rt_msg_wait_hist[msg_type].clear();
+        hal_rt_msg_proc_hist[msg_type].clear();
+    }
+}
+
+/*
+ * The walker batch is sized to the walker time budget from the moving avg.
+ * of the time per node, which goes up with the slow NDI calls. The batch is
+ * shrunk further for the route msgs pending, so that the msg workers of the
+ * VRF wait less for the VRF lock.
  */
-t_fib_msg *hal_rt_alloc_route_mem_msg(uint32_t buf_size) {
-    char *p_msg = new (std::nothrow) char[buf_size];
-    return (t_fib_msg *)p_msg;
+uint32_t hal_rt_walker_batch_size_get(t_fib_walker_type type) {
+    hal_rt_walker_stats_t &stats = hal_rt_walker_stats[type];
+    uint32_t node_cost = stats.node_cost_nsecs.load(std::memory_order_relaxed);
+    uint64_t time_budget = hal_rt_access_fib_config()->walker_time_budget;
+    uint64_t batch_size = FIB_WALKER_INIT_BATCH;
+
+    if (time_budget == 0) {
+        batch_size = FIB_WALKER_MAX_BATCH;
+    } else if (node_cost != 0) {
+        batch_size = (time_budget * 1000) / node_cost;
+    }
+
+    uint32_t msg_batch_size = hal_rt_access_fib_config()->msg_batch_size;
+    uint32_t backlog = nas_rt_read_msg_list_stats(FIB_MSG_TYPE_NL_ROUTE);
+    if ((msg_batch_size != 0) && (backlog > msg_batch_size)) {
+        batch_size /= std::min<uint32_t>((backlog / msg_batch_size) + 1, FIB_WALKER_MAX_BACKLOG_SHRINK);
+    }
+
+    batch_size = std::max<uint64_t>(batch_size, FIB_WALKER_MIN_BATCH);
+    batch_size = std::min<uint64_t>(batch_size, FIB_WALKER_MAX_BATCH);
+    stats.batch_size.store(batch_size, std::memory_order_relaxed);
+    return batch_size;
+}
+
+uint64_t hal_rt_walker_batch_start(void) {
+    return fib_msg_clock_nsecs(std::chrono::steady_clock::now());
+}
+
+uint64_t hal_rt_walker_batch_deadline(uint64_t start) {
+    uint64_t time_budget = hal_rt_access_fib_config()->walker_time_budget;
+
+    return ((time_budget == 0) ? 0 : (start + (time_budget * 1000)));
+}
+
+void hal_rt_walker_batch_end(t_fib_walker_type type, uint64_t start, uint32_t num_nodes,
+                             uint32_t batch_size) {
+    if (num_nodes == 0)
+        return;
+
+    hal_rt_walker_stats_t &stats = hal_rt_walker_stats[type];
+    uint64_t nsecs = fib_msg_clock_nsecs(std::chrono::steady_clock::now()) - start;
+    uint64_t sample = std::max<uint64_t>(nsecs / num_nodes, 1);
+    uint64_t node_cost = stats.node_cost_nsecs.load(std::memory_order_relaxed);
+
+    /* Moving avg. with 1/8 weight to the new sample */
+    node_cost = (node_cost == 0) ? sample : (((node_cost * 7) + sample) / 8);
+    stats.node_cost_nsecs.store(std::min<uint64_t>(node_cost, UINT32_MAX), std::memory_order_relaxed);
+
+    stats.num_batches.fetch_add(1, std::memory_order_relaxed);
+    if (num_nodes >= batch_size)
+        stats.num_full_batches.fetch_add(1, std::memory_order_relaxed);
+    stats.num_nodes.fetch_add(num_nodes, std::memory_order_relaxed);
+    stats.busy_nsecs.fetch_add(nsecs, std::memory_order_relaxed);
+}
+
+void hal_rt_walker_rslv_end(t_fib_walker_type type, uint32_t num_propagated,
+                            uint32_t num_deferred, uint32_t num_parallel) {
+    hal_rt_walker_stats_t &stats = hal_rt_walker_stats[type];
+
+    stats.num_propagated.fetch_add(num_propagated, std::memory_order_relaxed);
+    stats.num_deferred.fetch_add(num_deferred, std::memory_order_relaxed);
+    stats.num_parallel.fetch_add(num_parallel, std::memory_order_relaxed);
+}
+
+void hal_rt_walker_stats_get(t_fib_walker_type type, t_fib_walker_stats *p_stats) {
+    const hal_rt_walker_stats_t &stats = hal_rt_walker_stats[type];
+
+    p_stats->num_batches = stats.num_batches.load(std::memory_order_relaxed);
+    p_stats->num_full_batches = stats.num_full_batches.load(std::memory_order_relaxed);
+    p_stats->num_nodes = stats.num_nodes.load(std::memory_order_relaxed);
+    p_stats->busy_nsecs = stats.busy_nsecs.load(std::memory_order_relaxed);
+    p_stats->node_cost_nsecs = stats.node_cost_nsecs.load(std::memory_order_relaxed);
+    p_stats->batch_size = stats.batch_size.load(std::memory_order_relaxed);
+    p_stats->num_propagated = stats.num_propagated.load(std::memory_order_relaxed);
+    p_stats->num_deferred = stats.num_deferred.load(std::memory_order_relaxed);
+    p_stats->num_parallel = stats.num_parallel.load(std::memory_order_relaxed);
+}
+
+/*
+ * The changes of a VRF are marked and the walker is done with a VRF with the
+ * VRF locked, so a VRF is cleared only when the walker caught up with all of
+ * its changes. The bitmap words are shared by the VRFs, hence the atomic ops.
+ */
+void hal_rt_walker_vrf_mark(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index) {
+    if ((vrf_id >= FIB_MAX_VRF) || (af_index >= FIB_MAX_AFINDEX))
+        return;
+
+    hal_rt_walker_vrf_backlog[type][af_index][vrf_id].fetch_add(1, std::memory_order_relaxed);
+    hal_rt_walker_dirty_vrfs[type][af_index][vrf_id / 64].fetch_or((1ULL << (vrf_id % 64)),
+                                                                  std::memory_order_release);
+}
+
+void hal_rt_walker_vrf_done(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index,
+                            uint32_t num_nodes, bool is_caught_up) {
+    if ((vrf_id >= FIB_MAX_VRF) || (af_index >= FIB_MAX_AFINDEX))
+        return;
+
+    std::atomic<uint32_t> &backlog = hal_rt_walker_vrf_backlog[type][af_index][vrf_id];
+    if (is_caught_up) {
+        backlog.store(0, std::memory_order_relaxed);
+        hal_rt_walker_dirty_vrfs[type][af_index][vrf_id / 64].fetch_and(~(1ULL << (vrf_id % 64)),
+                                                                       std::memory_order_release);
+        return;
+    }
+    /* The same node could be marked more than once, the backlog is approximate */
+    uint32_t pending = backlog.load(std::memory_order_relaxed);
+    backlog.store(((pending > num_nodes) ? (pending - num_nodes) : 1), std::memory_order_relaxed);
+}
+
+/* First VRF at or after *p_vrf_id with changes pending */
+bool hal_rt_walker_vrf_next(t_fib_walker_type type, uint8_t af_index, uint32_t *p_vrf_id) {
+    uint32_t vrf_id = *p_vrf_id;
+
+    while (vrf_id < FIB_MAX_VRF) {
+        uint64_t word = hal_rt_walker_dirty_vrfs[type][af_index][vrf_id / 64].load(
+            std::memory_order_acquire) >> (vrf_id % 64);
+        if (word != 0) {
+            vrf_id += __builtin_ctzll(word);
+            if (vrf_id >= FIB_MAX_VRF)
+                break;
+            *p_vrf_id = vrf_id;
+            return true;
+        }
+        vrf_id = ((vrf_id / 64) + 1) * 64;
+    }
+    return false;
+}
+
+uint32_t hal_rt_walker_vrf_backlog_get(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index) {
+    if ((vrf_id >= FIB_MAX_VRF) || (af_index >= FIB_MAX_AFINDEX))
+        return 0;
+    return hal_rt_walker_vrf_backlog[type][af_index][vrf_id].load(std::memory_order_relaxed);
+}
+
+/* Lock holds of the VRF in a walker pass, in proportion to its share of the
+ * backlog of the dirty VRFs, so a busy VRF is not held off by the others */
+uint32_t hal_rt_walker_vrf_batches_get(t_fib_walker_type type, uint32_t vrf_id, uint8_t af_index,
+                                       uint32_t num_dirty_vrfs, uint64_t tot_backlog) {
+    uint64_t backlog = hal_rt_walker_vrf_backlog_get(type, vrf_id, af_index);
+
+    if (tot_backlog == 0)
+        return 1;
+
+    uint64_t num_batches = (backlog * num_dirty_vrfs) / tot_backlog;
+    return std::max<uint64_t>(std::min<uint64_t>(num_batches, FIB_WALKER_MAX_VRF_BATCHES), 1);
+}
+
+/*
+ * The walker is woken up on the N-th change of the window right away, else
+ * it sleeps till T from the first change of the window, so a single change
+ * waits at most T and a burst of changes is taken in by the walker N at a time.
+ */
+bool hal_rt_walker_change_notify(t_fib_walker_type type, bool *p_is_first) {
+    hal_rt_walker_coalesce_t &coalesce = hal_rt_walker_coalesce[type];
+    const t_fib_config *p_config = hal_rt_access_fib_config();
+    uint64_t first_nsecs = 0;
+
+    *p_is_first = coalesce.first_nsecs.compare_exchange_strong(
+        first_nsecs, fib_msg_clock_nsecs(std::chrono::steady_clock::now()),
+        std::memory_order_relaxed);
+    uint32_t num_changes = coalesce.num_changes.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    if (p_config->walker_coalesce_time == 0)
+        return true;
+    /* Only the change that fills up the window wakes up the walker */
+    if (num_changes == p_config->walker_coalesce_changes) {
+        coalesce.num_change_wakeups.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+uint64_t hal_rt_walker_coalesce_deadline(t_fib_walker_type type) {
+    uint64_t first_nsecs = hal_rt_walker_coalesce[type].first_nsecs.load(std::memory_order_relaxed);
+
+    if (first_nsecs == 0)
+        return 0;
+    return (first_nsecs + ((uint64_t)hal_rt_access_fib_config()->walker_coalesce_time * 1000));
+}
+
+/* The changes notified after the reset are walked by this wakeup as well, they
+ * only cost an extra wakeup of the walker that finds little to do */
+void hal_rt_walker_coalesce_reset(t_fib_walker_type type, bool is_time_wakeup) {
+    hal_rt_walker_coalesce_t &coalesce = hal_rt_walker_coalesce[type];
+
+    if (is_time_wakeup)
+        coalesce.num_time_wakeups.fetch_add(1, std::memory_order_relaxed);
+    coalesce.first_nsecs.store(0, std::memory_order_relaxed);
+    coalesce.num_changes.store(0, std::memory_order_relaxed);
+}
+
+uint64_t hal_rt_walker_clock_nsecs(void) {
+    return fib_msg_clock_nsecs(std::chrono::steady_clock::now());
+}
+
+void hal_rt_walker_convergence_record(uint64_t change_nsecs) {
+    uint64_t now = fib_msg_clock_nsecs(std::chrono::steady_clock::now());
+
+    if (now >= change_nsecs)
+        hal_rt_convergence_hist.record(now - change_nsecs);
+}
+
+void hal_rt_walker_convergence_stats_get(t_fib_convergence_stats *p_stats) {
+    const hal_rt_walker_coalesce_t &coalesce = hal_rt_walker_coalesce[FIB_WALKER_DR];
+
+    p_stats->count = hal_rt_convergence_hist.count();
+    p_stats->delay_p50 = fib_msg_nsecs_to_usecs(hal_rt_convergence_hist.percentile(50));
+    p_stats->delay_p99 = fib_msg_nsecs_to_usecs(hal_rt_convergence_hist.percentile(99));
+    p_stats->delay_max = fib_msg_nsecs_to_usecs(hal_rt_convergence_hist.max());
+    p_stats->num_time_wakeups = coalesce.num_time_wakeups.load(std::memory_order_relaxed);
+    p_stats->num_change_wakeups = coalesce.num_change_wakeups.load(std::memory_order_relaxed);
+}
+
+void hal_rt_walker_convergence_stats_clear(void) {
+    hal_rt_convergence_hist.clear();
+    for (auto &coalesce : hal_rt_walker_coalesce) {
+        coalesce.num_time_wakeups.store(0, std::memory_order_relaxed);
+        coalesce.num_change_wakeups.store(0, std::memory_order_relaxed);
+    }
+}
+
+/* The node cost is retained, it sizes the next batches */
+void hal_rt_walker_stats_clear(void) {
+    for (auto &stats : hal_rt_walker_stats) {
+        stats.num_batches.store(0, std::memory_order_relaxed);
+        stats.num_full_batches.store(0, std::memory_order_relaxed);
+        stats.num_nodes.store(0, std::memory_order_relaxed);
+        stats.busy_nsecs.store(0, std::memory_order_relaxed);
+        stats.num_propagated.store(0, std::memory_order_relaxed);
+        stats.num_deferred.store(0, std::memory_order_relaxed);
+        stats.num_parallel.store(0, std::memory_order_relaxed);
+    }
 }
 
 std::string hal_rt_queue_stats ()
 {
-    std::lock_guard<std::mutex> l {m_mtx};
     std::stringstream ss;
-    ss << "Current:" << hal_rt_msg_list.size() << "Peak:" << hal_rt_msg_peak_cnt;
+    for (uint32_t worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        ss << "Worker:" << worker_id << " " << hal_rt_msgq[worker_id]->queue_stats() << "\n";
+    }
     return ss.str();
 }
 
 std::string hal_rt_queue_msg_type_stats ()
 {
-    std::lock_guard<std::mutex> l {m_mtx};
     std::stringstream ss;
-    for (auto it = hal_rt_msg_list_stats->begin(); it != hal_rt_msg_list_stats->end(); ++it)
-        ss << "MsgType:" << it->first << "Msg Count:" << it->second;
+    for (uint32_t worker_id = 0; worker_id < hal_rt_msg_num_workers; worker_id++) {
+        ss << "Worker:" << worker_id << "\n" << hal_rt_msgq[worker_id]->msg_type_stats() << "\n";
+    }
     return ss.str();
 }
 
@@ -24,6 +24,7 @@
 #include "nas_rt_api.h"
 #include "nas_os_l3.h"
 #include "hal_rt_util.h"
+#include "hal_rt_mem.h"
 #include "hal_if_mapping.h"
 #include "event_log_types.h"
 #include "event_log.h"
@@ -41,6 +42,26 @@
 #include "dell-base-neighbor.h"
 #include "dell-base-acl.h"
 
+/*
+ * The large gets walk the FIB in chunks of FIB_GET_YIELD_COUNT entries with
+ * the VRF locked shared, the lock is dropped between the chunks so that the
+ * msg workers and walkers of the VRF are not held off for the whole walk.
+ * The walk resumes from the key of the last entry, the entry memory is kept
+ * by the epoch read section even if the entry is deleted while the lock is
+ * dropped.
+ */
+bool nas_route_get_yield (uint32_t *p_cnt, bool in_epoch, hal_vrf_id_t vrf_id)
+{
+    if ((!in_epoch) || (++(*p_cnt) < FIB_GET_YIELD_COUNT))
+        return false;
+
+    *p_cnt = 0;
+    nas_l3_vrf_unlock_shared(vrf_id);
+    /* Writer preferring locks, the waiting writers go ahead of this reader */
+    nas_l3_vrf_lock_shared(vrf_id);
+    return true;
+}
+
 BASE_ROUTE_OBJ_t nas_route_check_route_key_attr(cps_api_object_t obj) {
 
     BASE_ROUTE_OBJ_t  default_type = BASE_ROUTE_OBJ_ENTRY;
@@ -799,10 +820,21 @@ static t_std_error nas_route_get_all_vrf_routes_info(cps_api_object_list_t list,
                                                      uint32_t af_index, bool is_specific_vrf_get) {
     t_fib_dr *p_dr = NULL;
     uint32_t vrf_id = (is_specific_vrf_get ? vrf_id_get : FIB_MIN_VRF);
+    uint32_t yield_cnt = 0;
+    t_std_error rc = STD_ERR_OK;
+    bool in_epoch = hal_rt_epoch_enter();
 
+    /* The VRFs are walked one at a time, with only the VRF locked */
     for (; vrf_id < FIB_MAX_VRF; vrf_id++) {
-        if ((hal_rt_access_fib_vrf(vrf_id) == NULL) ||
-            (FIB_GET_VRF_INFO (vrf_id, af_index) == NULL)) {
+        nas_l3_vrf_lock_shared(vrf_id);
+        if (is_specific_vrf_get && (!(FIB_IS_VRF_ID_VALID (vrf_id)))) {
+            HAL_RT_LOG_ERR("RT-GET", "VRF-id:%d is not valid!", vrf_id);
+            rc = STD_ERR(ROUTE,FAIL,0);
+            nas_l3_vrf_unlock_shared(vrf_id);
+            break;
+        }
+        if (hal_rt_access_fib_vrf(vrf_id) == NULL) {
+            nas_l3_vrf_unlock_shared(vrf_id);
             if (is_specific_vrf_get) {
                 break;
             }
@@ -815,18 +847,28 @@ static t_std_error nas_route_get_all_vrf_routes_info(cps_api_object_list_t list,
                 if (!cps_api_object_list_append(list,obj)) {
                     cps_api_object_delete(obj);
                     HAL_RT_LOG_ERR("HAL-RT-API","Failed to append object to object list");
-                    return STD_ERR(ROUTE,FAIL,0);
+                    rc = STD_ERR(ROUTE,FAIL,0);
+                    break;
                 }
             }
 
+            /* VRF could have been deleted while the lock was dropped */
+            if (nas_route_get_yield (&yield_cnt, in_epoch, vrf_id) &&
+                (hal_rt_access_fib_vrf(vrf_id) == NULL)) {
+                break;
+            }
             p_dr = fib_get_next_dr (vrf_id, &p_dr->key.prefix, p_dr->prefix_len);
         }
+        nas_l3_vrf_unlock_shared(vrf_id);
 
-        if (is_specific_vrf_get) {
+        if ((rc != STD_ERR_OK) || is_specific_vrf_get) {
             break;
         }
     }
-    return STD_ERR_OK;
+    if (in_epoch) {
+        hal_rt_epoch_exit();
+    }
+    return rc;
 }
 
 t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
@@ -834,6 +876,7 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
                                          bool is_specific_vrf_get) {
 
     t_fib_dr *p_dr = NULL;
+    t_std_error rc = STD_ERR_OK;
 
     if ((is_specific_vrf_get == false) && (is_specific_prefix_get == false)) {
         return (nas_route_get_all_vrf_routes_info(list, vrf_id, af, false));
@@ -847,27 +890,26 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
         return STD_ERR(ROUTE,FAIL,0);
     }
 
-    if (is_specific_prefix_get) {
-        p_dr = fib_get_dr (vrf_id, p_prefix, pref_len);
-    } else {
-        p_dr = fib_get_first_dr(vrf_id, af);
+    /* Specific prefix get, single lookup with the VRF lock held */
+    nas_l3_vrf_lock_shared(vrf_id);
+    if (is_specific_vrf_get && (!(FIB_IS_VRF_ID_VALID (vrf_id)))) {
+        HAL_RT_LOG_ERR("RT-GET", "VRF-id:%d is not valid!", vrf_id);
+        nas_l3_vrf_unlock_shared(vrf_id);
+        return STD_ERR(ROUTE,FAIL,0);
     }
-    while (p_dr != NULL){
+    p_dr = fib_get_dr (vrf_id, p_prefix, pref_len);
+    if (p_dr != NULL){
         cps_api_object_t obj = nas_route_info_to_cps_object(0, p_dr, false);
         if(obj != NULL){
             if (!cps_api_object_list_append(list,obj)) {
                 cps_api_object_delete(obj);
                 HAL_RT_LOG_ERR("HAL-RT-API","Failed to append object to object list");
-                return STD_ERR(ROUTE,FAIL,0);
+                rc = STD_ERR(ROUTE,FAIL,0);
             }
         }
-
-        if (is_specific_prefix_get)
-            break;
-
-        p_dr = fib_get_next_dr (vrf_id, &p_dr->key.prefix, p_dr->prefix_len);
     }
-    return STD_ERR_OK;
+    nas_l3_vrf_unlock_shared(vrf_id);
+    return rc;
 }
 
 
@@ -1044,6 +1086,9 @@ t_std_error nas_route_get_all_nht_info(cps_api_object_list_t list,
                                        t_fib_ip_addr *p_dest_addr) {
 
     t_fib_nht *p_nht = NULL;
+    t_fib_ip_addr last_dest_addr;
+    uint32_t yield_cnt = 0;
+    t_std_error rc = STD_ERR_OK;
 
     HAL_RT_LOG_DEBUG("HAL-RT-NHT", "Get NHT: vrf_id: %d, af: %d ",
                  vrf_id, af);
@@ -1054,6 +1099,10 @@ t_std_error nas_route_get_all_nht_info(cps_api_object_list_t list,
         return STD_ERR(ROUTE,FAIL,0);
     }
 
+    /* NHT entries are not epoch reclaimed, the walk resumes from
+     * a copy of the last NHT key after the lock is dropped */
+    bool in_epoch = hal_rt_epoch_enter();
+    nas_l3_vrf_lock_shared(vrf_id);
     if (p_dest_addr != NULL) {
         HAL_RT_LOG_DEBUG("HAL-RT-NHT", "Get NHT: for dest:%s ",
                      FIB_IP_ADDR_TO_STR (p_dest_addr));
@@ -1075,13 +1124,23 @@ t_std_error nas_route_get_all_nht_info(cps_api_object_list_t list,
                 cps_api_object_delete(obj);
                 HAL_RT_LOG_ERR("HAL-RT-NHT","Failed to append object to object list");
 
-                return STD_ERR(ROUTE,FAIL,0);
+                rc = STD_ERR(ROUTE,FAIL,0);
+                break;
             }
         }
         if (p_dest_addr != NULL) break;
-        p_nht = fib_get_next_nht (vrf_id, &p_nht->key.dest_addr);
+        memcpy (&last_dest_addr, &p_nht->key.dest_addr, sizeof (last_dest_addr));
+        if (nas_route_get_yield (&yield_cnt, in_epoch, vrf_id) &&
+            (!(FIB_IS_VRF_ID_VALID (vrf_id)))) {
+            break;
+        }
+        p_nht = fib_get_next_nht (vrf_id, &last_dest_addr);
     }
-    return STD_ERR_OK;
+    nas_l3_vrf_unlock_shared(vrf_id);
+    if (in_epoch) {
+        hal_rt_epoch_exit();
+    }
+    return rc;
 }
 
 int nas_rt_publish_nht(t_fib_nht *p_nht, t_fib_dr *p_dr, t_fib_nh *p_nh, bool is_add) {
@@ -1384,10 +1443,8 @@ cps_api_return_code_t nas_route_process_cps_ip_unreachables_msg(cps_api_transact
     cps_api_object_clone(cloned,obj);
     cps_api_object_list_append(param->prev,cloned);
 
-    t_fib_msg *p_msg = hal_rt_alloc_mem_msg();
+    t_fib_msg *p_msg = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_INTF_IP_UNREACH_CFG);
     if (p_msg) {
-        memset(p_msg, 0, sizeof(t_fib_msg));
-        p_msg->type = FIB_MSG_TYPE_INTF_IP_UNREACH_CFG;
         p_msg->ip_unreach_cfg.if_index = if_index;
         safestrncpy(p_msg->ip_unreach_cfg.if_name, if_name,
                     sizeof(p_msg->ip_unreach_cfg.if_name));
@@ -1434,10 +1491,8 @@ cps_api_return_code_t nas_route_process_cps_ip_redirects_msg(cps_api_transaction
     cps_api_object_clone(cloned,obj);
     cps_api_object_list_append(param->prev,cloned);
 
-    t_fib_msg *p_msg = hal_rt_alloc_mem_msg();
+    t_fib_msg *p_msg = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG);
     if (p_msg) {
-        memset(p_msg, 0, sizeof(t_fib_msg));
-        p_msg->type = FIB_MSG_TYPE_INTF_IP_REDIRECTS_CFG;
         p_msg->ip_redirects_cfg .if_index = if_index;
         safestrncpy(p_msg->ip_redirects_cfg.if_name, if_name,
                     sizeof(p_msg->ip_redirects_cfg.if_name));
@@ -114,12 +114,12 @@ static cps_api_return_code_t nas_route_event_filter_get_func(void *ctx,
 
     HAL_RT_LOG_DEBUG("NAS-RT-CPS", "Route event filter function");
 
-    nas_l3_lock();
+    nas_l3_lock_shared();
     if((rc = nas_route_get_all_event_filter_info(param->list)) != STD_ERR_OK){
-        nas_l3_unlock();
+        nas_l3_unlock_shared();
         return (cps_api_return_code_t)rc;
     }
-    nas_l3_unlock();
+    nas_l3_unlock_shared();
 
     return cps_api_ret_code_OK;
 }
@@ -255,14 +255,8 @@ static cps_api_return_code_t nas_route_cps_all_route_get_func (void *ctx,
     cps_api_return_code_t rc = cps_api_ret_code_OK;
     HAL_RT_LOG_DEBUG("RT-GET", "VRF:%d(%s) prefix:%s/%d is_specific_prefix_get:%d is_specific_vrf_get:%d",
                      vrf, vrf_name, FIB_IP_ADDR_TO_STR(&ip), pref_len, is_specific_prefix_get, is_specific_vrf_get);
-    nas_l3_lock();
+    /* Route get takes the VRF lock by itself */
     do {
-        if (is_specific_vrf_get && (!(FIB_IS_VRF_ID_VALID (vrf)))) {
-            HAL_RT_LOG_ERR("RT-GET", "VRF-id:%d is not valid!", vrf);
-            rc = cps_api_ret_code_ERR;
-            break;
-        }
-
         /* if address family is not given, get all family routes */
         if ((af_attr == NULL) || (af == HAL_INET4_FAMILY)) {
             if(nas_route_get_all_route_info(param->list,vrf, HAL_INET4_FAMILY,
@@ -281,7 +275,6 @@ static cps_api_return_code_t nas_route_cps_all_route_get_func (void *ctx,
             }
         }
     } while(0);
-    nas_l3_unlock();
     return rc;
 }
 
@@ -387,7 +380,7 @@ static cps_api_return_code_t nas_route_cps_nht_get_func (void * ctx,
     }
 
     cps_api_return_code_t rc = cps_api_ret_code_OK;
-    nas_l3_lock();
+    /* NHT get takes the VRF lock by itself */
     do {
         /* if address family is not given, get all family nhts */
         if ((af_attr == NULL) || (af == HAL_INET4_FAMILY)) {
@@ -405,7 +398,6 @@ static cps_api_return_code_t nas_route_cps_nht_get_func (void * ctx,
             }
         }
     } while(0);
-    nas_l3_unlock();
     return rc;
 }
 
@@ -463,14 +455,8 @@ static cps_api_return_code_t nas_route_cps_arp_get_func(void *context,
     }
 
     cps_api_return_code_t rc = cps_api_ret_code_OK;
-    nas_l3_lock();
-
+    /* ARP get takes the VRF lock by itself */
     do {
-        if (!(FIB_IS_VRF_ID_VALID (vrf))) {
-            HAL_RT_LOG_ERR("NAS-RT-CPS-GET", "VRF-id:%d is not valid!", vrf);
-            rc = cps_api_ret_code_ERR;
-            break;
-        }
         /* if address family is not given, get all family neighbors  */
         if ((af_attr == NULL) || (af == HAL_INET4_FAMILY)) {
             if (nas_route_get_all_arp_info(param->list,vrf, HAL_INET4_FAMILY,
@@ -488,7 +474,6 @@ static cps_api_return_code_t nas_route_cps_arp_get_func(void *context,
         }
 
     } while (0);
-    nas_l3_unlock();
     return rc;
 }
 
@@ -536,11 +521,11 @@ static cps_api_return_code_t nas_route_cps_peer_routing_get_func (void *ctx,
 
     HAL_RT_LOG_DEBUG("NAS-RT-CPS", "Peer Routing Status Get function");
 
-    nas_l3_lock();
+    nas_l3_lock_shared();
     if(nas_route_get_all_peer_routing_config(param->list) != STD_ERR_OK){
         rc = cps_api_ret_code_ERR;
     }
-    nas_l3_unlock();
+    nas_l3_unlock_shared();
 
     return rc;
 }
@@ -637,20 +622,20 @@ static cps_api_return_code_t nas_route_cps_virtual_routing_ip_cfg_get_func (void
             }
         }
     }
-    nas_l3_lock();
+    nas_l3_lock_shared();
 
     /* retrieve vrf-id for given vrf_name */
     if (vrf_attr) {
         if (!hal_rt_get_vrf_id(virtual_routing_ip_config.vrf_name, &virtual_routing_ip_config.vrf_id)) {
             HAL_RT_LOG_DEBUG ("NAS-RT-CPS","Virtual routing IP Get. VRF (%s) not present",
                               virtual_routing_ip_config.vrf_name);
-            nas_l3_unlock();
+            nas_l3_unlock_shared();
             return cps_api_ret_code_ERR;
         }
         if (!(FIB_IS_VRF_ID_VALID (virtual_routing_ip_config.vrf_id))) {
             HAL_RT_LOG_ERR("NAS-RT-CPS", "Virtual routing VRF-id:%d is not valid!",
                            virtual_routing_ip_config.vrf_id);
-            nas_l3_unlock();
+            nas_l3_unlock_shared();
             return cps_api_ret_code_ERR;
         }
     }
@@ -658,7 +643,7 @@ static cps_api_return_code_t nas_route_cps_virtual_routing_ip_cfg_get_func (void
     if(nas_route_get_all_virtual_routing_ip_config(param->list, show_all, &virtual_routing_ip_config) != STD_ERR_OK){
         rc = cps_api_ret_code_ERR;
     }
-    nas_l3_unlock();
+    nas_l3_unlock_shared();
 
     return rc;
 }
@@ -689,14 +674,90 @@ static t_std_error nas_route_event_handle_init(){
 static cps_api_return_code_t nas_route_cps_fib_config_set_func(void *ctx,
                                                         cps_api_transaction_params_t * param,
                                                         size_t ix) {
+    cps_api_return_code_t rc = cps_api_ret_code_OK;
+
     HAL_RT_LOG_DEBUG("NAS-RT-CPS-SET", "FIB configuration set");
-    return cps_api_ret_code_OK;
+
+    cps_api_object_t obj = cps_api_object_list_get(param->change_list,ix);
+    if (obj == NULL) {
+        HAL_RT_LOG_ERR("NAS-RT-CPS-SET","FIB config object is not present");
+        return cps_api_ret_code_ERR;
+    }
+
+    cps_api_object_attr_t batch_size_attr = cps_api_object_attr_get(obj,
+                                                                    BASE_ROUTE_FIB_MSG_BATCH_SIZE);
+    cps_api_object_attr_t batch_time_attr = cps_api_object_attr_get(obj,
+                                                                    BASE_ROUTE_FIB_MSG_BATCH_TIME_BUDGET);
+    cps_api_object_attr_t queue_len_attr = cps_api_object_attr_get(obj,
+                                                                   BASE_ROUTE_FIB_MSG_QUEUE_MAX_LEN);
+    cps_api_object_attr_t queue_bytes_attr = cps_api_object_attr_get(obj,
+                                                                     BASE_ROUTE_FIB_MSG_QUEUE_MAX_BYTES);
+    cps_api_object_attr_t queue_policy_attr = cps_api_object_attr_get(obj,
+                                                                      BASE_ROUTE_FIB_MSG_QUEUE_OVERFLOW_POLICY);
+    cps_api_object_attr_t walker_time_attr = cps_api_object_attr_get(obj,
+                                                                     BASE_ROUTE_FIB_WALKER_TIME_BUDGET);
+    cps_api_object_attr_t coalesce_time_attr = cps_api_object_attr_get(obj,
+                                                                       BASE_ROUTE_FIB_WALKER_COALESCE_TIME);
+    cps_api_object_attr_t coalesce_changes_attr = cps_api_object_attr_get(obj,
+                                                                          BASE_ROUTE_FIB_WALKER_COALESCE_CHANGES);
+
+    nas_l3_lock();
+    if ((batch_size_attr) &&
+        (hal_rt_fib_config_set_msg_batch_size(cps_api_object_attr_data_u32(batch_size_attr)) != STD_ERR_OK)) {
+        rc = cps_api_ret_code_ERR;
+    }
+    if ((rc == cps_api_ret_code_OK) && (batch_time_attr)) {
+        hal_rt_fib_config_set_msg_batch_time_budget(cps_api_object_attr_data_u32(batch_time_attr));
+    }
+    if ((rc == cps_api_ret_code_OK) && (walker_time_attr)) {
+        hal_rt_fib_config_set_walker_time_budget(cps_api_object_attr_data_u32(walker_time_attr));
+    }
+    if ((rc == cps_api_ret_code_OK) && (coalesce_time_attr || coalesce_changes_attr)) {
+        /* Coalesce params not in the request are retained */
+        const t_fib_config *p_config = hal_rt_access_fib_config();
+        hal_rt_fib_config_set_walker_coalesce(
+            (coalesce_time_attr ? cps_api_object_attr_data_u32(coalesce_time_attr) :
+             p_config->walker_coalesce_time),
+            (coalesce_changes_attr ? cps_api_object_attr_data_u32(coalesce_changes_attr) :
+             p_config->walker_coalesce_changes));
+    }
+    if ((rc == cps_api_ret_code_OK) && (queue_len_attr || queue_bytes_attr || queue_policy_attr)) {
+        /* Bounds not in the request are retained */
+        const t_fib_config *p_config = hal_rt_access_fib_config();
+        uint32_t max_len = (queue_len_attr ? cps_api_object_attr_data_u32(queue_len_attr) :
+                            p_config->msg_queue_max_len);
+        uint64_t max_bytes = (queue_bytes_attr ? cps_api_object_attr_data_u64(queue_bytes_attr) :
+                              p_config->msg_queue_max_bytes);
+        uint32_t policy = (queue_policy_attr ? cps_api_object_attr_data_u32(queue_policy_attr) :
+                           p_config->msg_queue_overflow_policy);
+        if (hal_rt_fib_config_set_msg_queue_bounds(max_len, max_bytes,
+                                                   (t_fib_msg_queue_overflow_policy)policy) != STD_ERR_OK) {
+            rc = cps_api_ret_code_ERR;
+        }
+    }
+    HAL_RT_LOG_INFO("NAS-RT-CPS-SET", "FIB msg batch size:%d time budget:%d usecs "
+                    "queue max len:%d max bytes:%llu overflow policy:%d "
+                    "walker time budget:%d usecs coalesce:%d usecs/%d changes rc:%d",
+                    hal_rt_access_fib_config()->msg_batch_size,
+                    hal_rt_access_fib_config()->msg_batch_time_budget,
+                    hal_rt_access_fib_config()->msg_queue_max_len,
+                    (unsigned long long)hal_rt_access_fib_config()->msg_queue_max_bytes,
+                    hal_rt_access_fib_config()->msg_queue_overflow_policy,
+                    hal_rt_access_fib_config()->walker_time_budget,
+                    hal_rt_access_fib_config()->walker_coalesce_time,
+                    hal_rt_access_fib_config()->walker_coalesce_changes, rc);
+    nas_l3_unlock();
+    return rc;
 }
 
 static cps_api_return_code_t nas_route_cps_fib_config_get_func (void *ctx,
                                                          cps_api_get_params_t * param,
                                                          size_t ix) {
     uint32_t vrf_id = 0, is_fib_summary = false, itr = 0, cnt = 0, af_index = 0;
+    uint32_t msg_batch_size = 0, msg_batch_time_budget = 0, walker_time_budget = 0;
+    uint32_t walker_coalesce_time = 0, walker_coalesce_changes = 0;
+    uint32_t msg_queue_max_len = 0, msg_queue_overflow_policy = 0, msg_queue_depth = 0;
+    uint64_t msg_queue_max_bytes = 0, msg_queue_bytes = 0;
     t_fib_route_summary   *p_route_summary = NULL;
 
     HAL_RT_LOG_DEBUG("NAS-RT-CPS", "FIB Configuration Get function");
@@ -731,10 +792,10 @@ static cps_api_return_code_t nas_route_cps_fib_config_get_func (void *ctx,
         return cps_api_ret_code_ERR;
     }
 
-    nas_l3_lock();
+    nas_l3_vrf_lock_shared(vrf_id);
     if (!(FIB_IS_VRF_ID_VALID (vrf_id))) {
         HAL_RT_LOG_ERR("NAS-RT-CPS-SET", "VRF-id:%d  is not valid!", vrf_id);
-        nas_l3_unlock();
+        nas_l3_vrf_unlock_shared(vrf_id);
         return cps_api_ret_code_ERR;
     }
 
@@ -745,7 +806,16 @@ static cps_api_return_code_t nas_route_cps_fib_config_get_func (void *ctx,
             cnt += p_route_summary->a_curr_count [itr];
         }
     }
-    nas_l3_unlock();
+    msg_batch_size = hal_rt_access_fib_config()->msg_batch_size;
+    msg_batch_time_budget = hal_rt_access_fib_config()->msg_batch_time_budget;
+    msg_queue_max_len = hal_rt_access_fib_config()->msg_queue_max_len;
+    msg_queue_max_bytes = hal_rt_access_fib_config()->msg_queue_max_bytes;
+    msg_queue_overflow_policy = hal_rt_access_fib_config()->msg_queue_overflow_policy;
+    walker_time_budget = hal_rt_access_fib_config()->walker_time_budget;
+    walker_coalesce_time = hal_rt_access_fib_config()->walker_coalesce_time;
+    walker_coalesce_changes = hal_rt_access_fib_config()->walker_coalesce_changes;
+    nas_l3_vrf_unlock_shared(vrf_id);
+    hal_rt_msg_queue_gauges_get(&msg_queue_depth, &msg_queue_bytes);
     HAL_RT_LOG_DEBUG("NAS-RT-CPS-SET", "VRF-id:%d %s route_cnt:%d",
                 vrf_id, ((af_index == HAL_RT_V4_AFINDEX) ? "IPv4" : "IPv6"), cnt);
     cps_api_object_t obj = cps_api_object_create();
@@ -761,6 +831,17 @@ static cps_api_return_code_t nas_route_cps_fib_config_get_func (void *ctx,
     cps_api_object_set_key(obj,&key);
 
     cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_ROUTE_COUNT,cnt);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_MSG_BATCH_SIZE,msg_batch_size);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_MSG_BATCH_TIME_BUDGET,msg_batch_time_budget);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_MSG_QUEUE_MAX_LEN,msg_queue_max_len);
+    cps_api_object_attr_add_u64(obj,BASE_ROUTE_FIB_MSG_QUEUE_MAX_BYTES,msg_queue_max_bytes);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_MSG_QUEUE_OVERFLOW_POLICY,msg_queue_overflow_policy);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_WALKER_TIME_BUDGET,walker_time_budget);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_WALKER_COALESCE_TIME,walker_coalesce_time);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_WALKER_COALESCE_CHANGES,walker_coalesce_changes);
+    /* Gauges of the msgs pending in the msg queue */
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_FIB_MSG_QUEUE_DEPTH,msg_queue_depth);
+    cps_api_object_attr_add_u64(obj,BASE_ROUTE_FIB_MSG_QUEUE_BYTES,msg_queue_bytes);
     if (!cps_api_object_list_append(param->list,obj)) {
         cps_api_object_delete(obj);
         HAL_RT_LOG_ERR("HAL-RT-NHT","Failed to append object to object list");
@@ -770,6 +851,60 @@ static cps_api_return_code_t nas_route_cps_fib_config_get_func (void *ctx,
     return cps_api_ret_code_OK;
 }
 
+static cps_api_return_code_t nas_route_cps_msg_stats_get_func (void *ctx,
+                              cps_api_get_params_t * param, size_t ix) {
+    t_fib_msg_latency_stats stats;
+    int msg_type = FIB_MSG_TYPE_NL_INTF, msg_type_end = FIB_MSG_TYPE_MAX;
+
+    HAL_RT_LOG_DEBUG("NAS-RT-CPS", "Msg stats Get function");
+
+    cps_api_object_t filt = cps_api_object_list_get(param->filters,ix);
+    if (filt == NULL) {
+        HAL_RT_LOG_ERR("NAS-RT-CPS","Msg stats object is not present");
+        return cps_api_ret_code_ERR;
+    }
+    /* Stats of all the msg types, if the msg type is not given */
+    cps_api_object_attr_t msg_type_attr = cps_api_get_key_data(filt,BASE_ROUTE_MSG_STATS_MSG_TYPE);
+    if (msg_type_attr) {
+        msg_type = cps_api_object_attr_data_u32(msg_type_attr);
+        if ((msg_type < FIB_MSG_TYPE_NL_INTF) || (msg_type >= FIB_MSG_TYPE_MAX)) {
+            HAL_RT_LOG_ERR("NAS-RT-CPS", "Invalid msg type:%d", msg_type);
+            return cps_api_ret_code_ERR;
+        }
+        msg_type_end = msg_type + 1;
+    }
+
+    for (; msg_type < msg_type_end; msg_type++) {
+        if (!hal_rt_msg_latency_stats_get(msg_type, &stats))
+            continue;
+
+        cps_api_object_t obj = cps_api_object_create();
+        if(obj == NULL){
+            HAL_RT_LOG_ERR("HAL-RT-API","Failed to allocate memory to cps object");
+            return cps_api_ret_code_ERR;
+        }
+        cps_api_key_from_attr_with_qual(cps_api_object_key(obj), BASE_ROUTE_MSG_STATS_OBJ,
+                                        cps_api_qualifier_TARGET);
+        cps_api_set_key_data(obj, BASE_ROUTE_MSG_STATS_MSG_TYPE, cps_api_object_ATTR_T_U32,
+                             &msg_type, sizeof(msg_type));
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_COUNT,stats.count);
+        /* Latencies in micro secs */
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_QUEUE_WAIT_P50,stats.queue_wait_p50);
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_QUEUE_WAIT_P99,stats.queue_wait_p99);
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_QUEUE_WAIT_MAX,stats.queue_wait_max);
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_PROCESS_TIME_P50,stats.process_time_p50);
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_PROCESS_TIME_P99,stats.process_time_p99);
+        cps_api_object_attr_add_u64(obj,BASE_ROUTE_MSG_STATS_PROCESS_TIME_MAX,stats.process_time_max);
+        if (!cps_api_object_list_append(param->list,obj)) {
+            cps_api_object_delete(obj);
+            HAL_RT_LOG_ERR("HAL-RT-API","Failed to append object to object list");
+            return cps_api_ret_code_ERR;
+        }
+    }
+
+    return cps_api_ret_code_OK;
+}
+
 static cps_api_return_code_t nas_route_cps_fib_config_rollback_func(void * ctx,
                                                              cps_api_transaction_params_t * param, size_t ix){
 
@@ -851,10 +986,8 @@ t_std_error nas_route_process_cps_nbr_intf_msg(cps_api_transaction_params_t * pa
     bool is_admin_up = (bool)cps_api_object_attr_data_u32(enabled_attr);
     hal_ifindex_t if_index = cps_api_object_attr_data_u32(if_index_attr);
 
-    t_fib_msg *p_msg = hal_rt_alloc_mem_msg();
+    t_fib_msg *p_msg = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_NBR_MGR_INTF);
     if (p_msg) {
-        memset(p_msg, 0, sizeof(t_fib_msg));
-        p_msg->type = FIB_MSG_TYPE_NBR_MGR_INTF;
         p_msg->intf.vrf_id = vrf_id;
         p_msg->intf.if_index = if_index;
         p_msg->intf.admin_status = (is_admin_up ? RT_INTF_ADMIN_STATUS_UP : RT_INTF_ADMIN_STATUS_DOWN);
@@ -874,10 +1007,8 @@ t_std_error nas_route_process_cps_nbr_msg(cps_api_transaction_params_t * param,
 
     t_fib_msg *p_msg = NULL;
     //g_fib_gbl_info.num_nei_msg++;
-    p_msg = hal_rt_alloc_mem_msg();
+    p_msg = hal_rt_alloc_mem_msg_by_type(FIB_MSG_TYPE_NBR_MGR_NBR_INFO);
     if (p_msg) {
-        memset(p_msg, 0, sizeof(t_fib_msg));
-        p_msg->type = FIB_MSG_TYPE_NBR_MGR_NBR_INFO;
         hal_rt_cps_obj_to_neigh(obj, &(p_msg->nbr));
         nas_rt_process_msg(p_msg);
     }
@@ -945,20 +1076,11 @@ static cps_api_return_code_t nas_route_cps_nbr_get_func (void *ctx,
         }
     }
 
-    nas_l3_lock();
-    if (!(FIB_IS_VRF_ID_VALID (vrf))) {
-        HAL_RT_LOG_ERR("NAS-RT-CPS-GET", "VRF-id:%d is not valid!", vrf);
-        nas_l3_unlock();
-        return cps_api_ret_code_ERR;
-    }
-
+    /* Neighbor get takes the VRF lock by itself */
     if((rc = nas_route_get_all_arp_info(param->list,vrf, af, &ip, is_specific_nh_get, true)) != STD_ERR_OK){
-        nas_l3_unlock();
         return (cps_api_return_code_t)rc;
     }
 
-    nas_l3_unlock();
-
     return cps_api_ret_code_OK;
 }
 
@@ -1137,10 +1259,10 @@ static cps_api_return_code_t nas_route_cps_ip_unreachables_get_func (void *ctx,
 
     cps_api_return_code_t rc = cps_api_ret_code_OK;
 
-    nas_l3_lock();
+    nas_l3_lock_shared();
     rc = nas_route_get_all_ip_unreach_info(param->list, af, (if_name_attr ? if_name : NULL),
                                            is_specific_get);
-    nas_l3_unlock();
+    nas_l3_unlock_shared();
     return rc;
 }
 
@@ -1284,17 +1406,17 @@ static cps_api_return_code_t nas_route_cps_ip_redirects_get_func (void *ctx,
 
     cps_api_return_code_t rc = cps_api_ret_code_OK;
 
-    nas_l3_lock();
+    nas_l3_lock_shared();
 
     /* retrieve vrf-id for given vrf_name */
     if (vrf_attr && !hal_rt_get_vrf_id(vrf_name, &vrf_id)) {
         HAL_RT_LOG_ERR("NAS-RT-CPS","IP redirects VRF(%s) not present.", vrf_name);
-        nas_l3_unlock();
+        nas_l3_unlock_shared();
         return cps_api_ret_code_ERR;
     }
 
     rc = nas_route_get_all_ip_redirects_info(param->list, vrf_id, (if_name_attr ? if_name : NULL));
-    nas_l3_unlock();
+    nas_l3_unlock_shared();
     return rc;
 }
 
@@ -1567,6 +1689,30 @@ static t_std_error nas_route_object_fib_config_init(cps_api_operation_handle_t n
     return STD_ERR_OK;
 }
 
+static t_std_error nas_route_object_msg_stats_init(cps_api_operation_handle_t nas_route_cps_handle ) {
+
+    cps_api_registration_functions_t f;
+    char buff[CPS_API_KEY_STR_MAX];
+
+    memset(&f,0,sizeof(f));
+
+    HAL_RT_LOG_DEBUG("NAS-RT-CPS", "NAS Msg stats CPS Initialization");
+
+    f.handle                 = nas_route_cps_handle;
+    f._read_function         = nas_route_cps_msg_stats_get_func;
+
+    if (!cps_api_key_from_attr_with_qual(&f.key,BASE_ROUTE_MSG_STATS_OBJ,cps_api_qualifier_TARGET)) {
+        HAL_RT_LOG_ERR("NAS-RT-CPS","Could not translate %d to key %s",
+                    (int)(BASE_ROUTE_MSG_STATS_OBJ),cps_api_key_print(&f.key,buff,sizeof(buff)-1));
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
 static t_std_error nas_route_object_nbr_init(cps_api_operation_handle_t nas_route_cps_handle ) {
 
     cps_api_registration_functions_t f;
@@ -1764,6 +1910,10 @@ t_std_error nas_routing_cps_init(cps_api_operation_handle_t nas_route_cps_handle
         return ret;
     }
 
+    if((ret = nas_route_object_msg_stats_init(nas_route_cps_handle)) != STD_ERR_OK){
+        return ret;
+    }
+
     if((ret = nas_route_object_nbr_init(nas_route_cps_handle)) != STD_ERR_OK){
         return ret;
     }
@@ -2058,13 +2208,14 @@ t_std_error nas_route_process_cps_nht(cps_api_transaction_params_t * param, size
 
     HAL_RT_LOG_DEBUG("NAS-RT-CPS-NHT", "VRF:%d NHT Addr:%s isAdd:%d",
                  fib_nht.vrf_id, FIB_IP_ADDR_TO_STR(&fib_nht.key.dest_addr), isAdd);
-    nas_l3_lock();
+    /* NHT is resolved with the DRs/NHs of its own VRF */
+    t_fib_vrf_lock_mode lock_mode = nas_l3_vrf_lock(fib_nht.vrf_id);
     if ((rc = nas_rt_handle_nht(&fib_nht, isAdd)) != STD_ERR_OK) {
         HAL_RT_LOG_ERR("NAS-RT-CPS-NHT", "NHT handling failed");
-        nas_l3_unlock();
+        nas_l3_vrf_unlock(fib_nht.vrf_id, lock_mode);
         return cps_api_ret_code_ERR;
     }
-    nas_l3_unlock();
+    nas_l3_vrf_unlock(fib_nht.vrf_id, lock_mode);
     return rc;
 }
 
@@ -2078,21 +2229,14 @@ bool nas_route_fdb_add_cps_msg (t_fib_nh *p_nh) {
     return false;
 }
 
-bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret) {
-    t_fib_msg             *p_msg = NULL;
-    t_fib_route_entry     self_ip;
+/* Decodes the IP address object into the route entry of a 1 NH route msg */
+static bool hal_rt_ip_addr_cps_obj_decode(cps_api_object_t obj, t_fib_route_entry *p_ip) {
     cps_api_object_attr_t attr_v4 = CPS_API_ATTR_NULL;
     cps_api_object_attr_t attr_v6 = CPS_API_ATTR_NULL;
     cps_api_object_attr_t attr = CPS_API_ATTR_NULL;
     cps_api_attr_id_t attr_id, attr_vrf;
     cps_api_attr_id_t pref_len_attr_id;
     uint32_t addr_len = HAL_INET6_LEN;
-    uint32_t nh_count;
-
-    HAL_RT_LOG_DEBUG("HAL-RT-IP", "Intf msg received");
-
-    *p_msg_ret = NULL;
-    memset(&self_ip, 0, sizeof(t_fib_route_entry));
 
     attr_v4 = cps_api_get_key_data (obj, BASE_IP_IPV4_IFINDEX);
     attr_v6 = cps_api_get_key_data (obj, BASE_IP_IPV6_IFINDEX);
@@ -2100,7 +2244,7 @@ bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret
     if ((attr_v4 == CPS_API_ATTR_NULL) && (attr_v6 == CPS_API_ATTR_NULL))
         return false;
 
-    self_ip.hop_count = 1;
+    p_ip->hop_count = 1;
 
     /* Get if-index from key data */
     hal_ifindex_t nh_if_index =
@@ -2110,14 +2254,14 @@ bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret
 
     if (attr_v4 != CPS_API_ATTR_NULL) {
         /** Get the ipv4 address */
-        self_ip.prefix.af_index = HAL_RT_V4_AFINDEX;
+        p_ip->prefix.af_index = HAL_RT_V4_AFINDEX;
         attr_id = BASE_IP_IPV4_ADDRESS_IP;
         attr_vrf = BASE_IP_IPV4_VRF_NAME;
         pref_len_attr_id = BASE_IP_IPV4_ADDRESS_PREFIX_LENGTH;
         addr_len = HAL_INET4_LEN;
     } else if (attr_v6 != CPS_API_ATTR_NULL) {
         /** Get the ipv6 address */
-        self_ip.prefix.af_index = HAL_RT_V6_AFINDEX;
+        p_ip->prefix.af_index = HAL_RT_V6_AFINDEX;
         attr_id = BASE_IP_IPV6_ADDRESS_IP;
         attr_vrf = BASE_IP_IPV6_VRF_NAME;
         pref_len_attr_id = BASE_IP_IPV6_ADDRESS_PREFIX_LENGTH;
@@ -2128,96 +2272,96 @@ bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret
     if (attr == CPS_API_ATTR_NULL)
         return false;
 
-    memcpy(&self_ip.prefix.u,
+    memcpy(&p_ip->prefix.u,
            cps_api_object_attr_data_bin(attr), addr_len);
 
     attr = cps_api_object_e_get(obj, &attr_vrf, 1);
     bool is_mgmt_intf = false;
     if (attr) {
-        safestrncpy((char*)self_ip.vrf_name, (const char *)cps_api_object_attr_data_bin(attr),
-                    sizeof(self_ip.vrf_name));
+        safestrncpy((char*)p_ip->vrf_name, (const char *)cps_api_object_attr_data_bin(attr),
+                    sizeof(p_ip->vrf_name));
 
-        if (hal_rt_get_vrf_id((const char*)self_ip.vrf_name, (hal_vrf_id_t*)&self_ip.vrfid) == false) {
+        if (hal_rt_get_vrf_id((const char*)p_ip->vrf_name, (hal_vrf_id_t*)&p_ip->vrfid) == false) {
             HAL_RT_LOG_ERR("HAL-RT-IP", "VRF-name:%s to VRF-id mapping not present",
-                           self_ip.vrf_name);
+                           p_ip->vrf_name);
             return false;
         }
-        self_ip.nh_vrfid = self_ip.vrfid;
-        if (hal_rt_validate_intf(self_ip.vrfid, nh_if_index, &is_mgmt_intf) == STD_ERR_OK) {
+        p_ip->nh_vrfid = p_ip->vrfid;
+        if (hal_rt_validate_intf(p_ip->vrfid, nh_if_index, &is_mgmt_intf) == STD_ERR_OK) {
             if (is_mgmt_intf) {
                 /* Ignore the mgmt. IP address handling, since App is expected
                  * to subscribe for IP events directly. */
                 return false;
             }
         }
-        if (self_ip.vrfid == FIB_MGMT_VRF) {
+        if (p_ip->vrfid == FIB_MGMT_VRF) {
             /* Ignore the mgmt. IP address handling, since App is expected
              * to subscribe for IP events directly. */
             return false;
         }
     }
     HAL_RT_LOG_DEBUG("HAL-RT-IP", "VRF id:%lu name:%s Intf:%d Addr:%s",
-                     self_ip.vrfid, self_ip.vrf_name, nh_if_index,
-                     FIB_IP_ADDR_TO_STR(&self_ip.prefix));
+                     p_ip->vrfid, p_ip->vrf_name, nh_if_index,
+                     FIB_IP_ADDR_TO_STR(&p_ip->prefix));
 
     attr = cps_api_object_e_get(obj, &pref_len_attr_id, 1);
     if (attr == CPS_API_ATTR_NULL)
         return false;
 
-    self_ip.prefix_masklen = cps_api_object_attr_data_u32(attr);
+    p_ip->prefix_masklen = cps_api_object_attr_data_u32(attr);
 
     switch(cps_api_object_type_operation(cps_api_object_key(obj)))
     {
         case cps_api_oper_CREATE:
-            self_ip.msg_type = FIB_RT_MSG_ADD;
+            p_ip->msg_type = FIB_RT_MSG_ADD;
             break;
         case cps_api_oper_SET:
-            self_ip.msg_type = FIB_RT_MSG_UPD;
+            p_ip->msg_type = FIB_RT_MSG_UPD;
             break;
         case cps_api_oper_DELETE:
-            self_ip.msg_type = FIB_RT_MSG_DEL;
+            p_ip->msg_type = FIB_RT_MSG_DEL;
             break;
         default:
             break;
     }
 
     /* Allow the LLA from MAC-VLAN interface */
-    if (hal_rt_is_intf_mac_vlan(self_ip.vrfid, nh_if_index)) {
-        if (FIB_AFINDEX_TO_PREFIX_LEN (self_ip.prefix.af_index) == self_ip.prefix_masklen) {
+    if (hal_rt_is_intf_mac_vlan(p_ip->vrfid, nh_if_index)) {
+        if (FIB_AFINDEX_TO_PREFIX_LEN (p_ip->prefix.af_index) == p_ip->prefix_masklen) {
             /* Program only the full address with max. prefix len
              * @@TODO Explore on how to handle the route/nbr with
              MAC-VLAN interface in NAS-L3 */
-            if (STD_IP_IS_ADDR_LINK_LOCAL(&self_ip.prefix)) {
-                self_ip.rt_type = RT_UNREACHABLE;
+            if (STD_IP_IS_ADDR_LINK_LOCAL(&p_ip->prefix)) {
+                p_ip->rt_type = RT_UNREACHABLE;
             } else {
                 /* Dont program in the HW, keep it only in the cache */
-                self_ip.rt_type = RT_CACHE;
+                p_ip->rt_type = RT_CACHE;
             }
-            self_ip.hop_count = 0;
+            p_ip->hop_count = 0;
             nh_if_index = 0;
         } else {
             HAL_RT_LOG_INFO("HAL-RT-IP", "Ignored VRF id:%lu name:%s Intf:%d Addr:%s/%d op:%s",
-                            self_ip.vrfid, self_ip.vrf_name, nh_if_index,
-                            FIB_IP_ADDR_TO_STR(&self_ip.prefix),
-                            self_ip.prefix_masklen,
-                            ((self_ip.msg_type == FIB_RT_MSG_ADD) ? "Add" :
-                             ((self_ip.msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")));
+                            p_ip->vrfid, p_ip->vrf_name, nh_if_index,
+                            FIB_IP_ADDR_TO_STR(&p_ip->prefix),
+                            p_ip->prefix_masklen,
+                            ((p_ip->msg_type == FIB_RT_MSG_ADD) ? "Add" :
+                             ((p_ip->msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")));
             return false;
         }
-    } else if (!STD_IP_IS_ADDR_LINK_LOCAL(&self_ip.prefix)) {
+    } else if (!STD_IP_IS_ADDR_LINK_LOCAL(&p_ip->prefix)) {
         /* Allow only the full address route into NPU since other routes
          * with less than /32 and /128 are programmed using route events.
          * Prefix-len 0 is expected for an address with /32 or /128 prefix len
          * configuration in the kernel. */
-        if ((self_ip.prefix_masklen != 0) &&
-            (FIB_AFINDEX_TO_PREFIX_LEN (self_ip.prefix.af_index) != self_ip.prefix_masklen)) {
-            self_ip.rt_type = RT_CACHE;
+        if ((p_ip->prefix_masklen != 0) &&
+            (FIB_AFINDEX_TO_PREFIX_LEN (p_ip->prefix.af_index) != p_ip->prefix_masklen)) {
+            p_ip->rt_type = RT_CACHE;
         }
     }
     /* Validate the interface only for the interface is valid case */
     if (nh_if_index) {
         if (cps_api_object_type_operation(cps_api_object_key(obj)) != cps_api_oper_DELETE) {
-            if (hal_rt_validate_intf(self_ip.vrfid, nh_if_index, &is_mgmt_intf) != STD_ERR_OK) {
+            if (hal_rt_validate_intf(p_ip->vrfid, nh_if_index, &is_mgmt_intf) != STD_ERR_OK) {
                 HAL_RT_LOG_DEBUG("HAL-RT-RIF", "Invalid interface:%d", nh_if_index);
                 return false;
             }
@@ -2225,39 +2369,45 @@ bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret
     }
 
     HAL_RT_LOG_INFO("HAL-RT-IP", "VRF %s(%lu) Intf:%d Addr:%s/%d op:%s",
-                    self_ip.vrf_name, self_ip.vrfid, nh_if_index,
-                    FIB_IP_ADDR_TO_STR(&self_ip.prefix),
-                    self_ip.prefix_masklen,
-                    ((self_ip.msg_type == FIB_RT_MSG_ADD) ? "Add" :
-                     ((self_ip.msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")));
+                    p_ip->vrf_name, p_ip->vrfid, nh_if_index,
+                    FIB_IP_ADDR_TO_STR(&p_ip->prefix),
+                    p_ip->prefix_masklen,
+                    ((p_ip->msg_type == FIB_RT_MSG_ADD) ? "Add" :
+                     ((p_ip->msg_type == FIB_RT_MSG_DEL) ? "Del" : "Update")));
 
     /* Update the prefix len to 32/128 based on the address family,
      * since we need to install full address for trap to CPU action.
      */
-    self_ip.prefix_masklen = FIB_AFINDEX_TO_PREFIX_LEN (self_ip.prefix.af_index);
+    p_ip->prefix_masklen = FIB_AFINDEX_TO_PREFIX_LEN (p_ip->prefix.af_index);
 
-    nh_count = 1;
-    /* allocate the memory for the ip addr message for 1 nh */
-    uint32_t buf_size = sizeof(t_fib_msg) + (sizeof (t_fib_nh_info) * nh_count);
-    p_msg = hal_rt_alloc_route_mem_msg(buf_size);
+    safestrncpy((char*)p_ip->nh_vrf_name, (const char*)p_ip->vrf_name, sizeof(p_ip->nh_vrf_name));
+    p_ip->nh_list[0].nh_if_index = nh_if_index;
 
+    return true;
+}
+
+/* The IP address event is decoded straight into a pooled 1 NH route msg */
+bool hal_rt_ip_addr_cps_obj_to_route(cps_api_object_t obj, t_fib_msg **p_msg_ret) {
+    uint32_t   buf_size = sizeof(t_fib_msg) + sizeof (t_fib_nh_info);
+    t_fib_msg *p_msg = NULL;
+
+    HAL_RT_LOG_DEBUG("HAL-RT-IP", "Intf msg received");
+
+    *p_msg_ret = NULL;
+    p_msg = hal_rt_alloc_route_mem_msg(buf_size);
     if (!p_msg) {
         HAL_RT_LOG_ERR("HAL-RT", "Memory alloc failed for ip_addr msg");
         return false;
     }
 
-    HAL_RT_LOG_DEBUG("HAL-RT", "allocated buffer for ip address event "
-                     "message:%p for bytes:%d", p_msg, buf_size);
-
     memset(p_msg, 0, buf_size);
     p_msg->type = FIB_MSG_TYPE_NL_ROUTE;
-    t_fib_route_entry *p_route = &(p_msg->route);
-    memcpy(p_route, &self_ip, sizeof(self_ip));
-    safestrncpy((char*)p_route->nh_vrf_name, (const char*)self_ip.vrf_name, sizeof(p_route->nh_vrf_name));
-    p_route->nh_list[0].nh_if_index = nh_if_index;
+    if (!hal_rt_ip_addr_cps_obj_decode(obj, &p_msg->route)) {
+        hal_rt_free_mem_msg(p_msg);
+        return false;
+    }
 
     *p_msg_ret = p_msg;
-
     return true;
 }
 
@@ -329,7 +329,8 @@ int nas_rt_find_next_best_dr_for_nht(t_fib_nht *p_fib_nht, int vrf_id, t_fib_ip_
                          p_best_dr->prefix_len, FIB_IP_ADDR_TO_STR(dest_addr), prefix_len, p_best_dr->nh_handle,
                          p_best_dr->is_nh_resolved);
         if (p_best_dr->is_mgmt_route) {
-            p_best_dr = fib_get_next_best_fit_dr(vrf_id, &p_best_dr->key.prefix);
+            p_best_dr = fib_get_next_best_fit_dr(vrf_id, &p_best_dr->key.prefix,
+                                                 p_best_dr->prefix_len);
             continue;
         }
         if ((is_multiple_nht == false) &&
@@ -344,7 +345,8 @@ int nas_rt_find_next_best_dr_for_nht(t_fib_nht *p_fib_nht, int vrf_id, t_fib_ip_
             *is_next_best_rt_found = true;
             break;
         }
-        p_best_dr = fib_get_next_best_fit_dr(vrf_id, &p_best_dr->key.prefix);
+        p_best_dr = fib_get_next_best_fit_dr(vrf_id, &p_best_dr->key.prefix,
+                                             p_best_dr->prefix_len);
     }
     if (*is_next_best_rt_found == false) {
         if (is_conn_route_found) {
@@ -387,6 +389,7 @@ int fib_handle_nh_dep_dr_for_nht (t_fib_nh *p_nh, bool is_add)
 {
     t_fib_dr_key      key;
     t_fib_nh_dep_dr   *p_nh_dep_dr = NULL;
+    t_fib_dr          *p_dep_dr = NULL;
 
     if (!p_nh)
     {
@@ -410,35 +413,26 @@ int fib_handle_nh_dep_dr_for_nht (t_fib_nh *p_nh, bool is_add)
 
     while (p_nh_dep_dr != NULL)
     {
-        if (p_nh_dep_dr->p_dr == NULL)
-        {
-            p_nh_dep_dr =
-                fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                        &p_nh_dep_dr->key.dr_key.prefix,
-                                        p_nh_dep_dr->prefix_len);
-
-            continue;
-        }
-
         HAL_RT_LOG_DEBUG("HAL-RT-NH",
                      "NH: vrf_id: %d, ip_addr: %s, if_index: 0x%x, "
                      "status_flag: 0x%x, owner_flag: 0x%x, handle:%lu "
                      "NH Dep DR: vrf_id: %d, prefix: %s, prefix_len: %d %lu",
                      p_nh->vrf_id,
                      FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
-                     p_nh->status_flag, p_nh->owner_flag, p_nh->next_hop_id, p_nh_dep_dr->key.vrf_id,
-                     FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->key.dr_key.prefix),
-                     p_nh_dep_dr->prefix_len, p_nh_dep_dr->p_dr->nh_handle);
+                     p_nh->status_flag, p_nh->owner_flag, p_nh->next_hop_id, p_nh_dep_dr->p_dr->vrf_id,
+                     FIB_IP_ADDR_TO_STR (&p_nh_dep_dr->p_dr->key.prefix),
+                     p_nh_dep_dr->p_dr->prefix_len, p_nh_dep_dr->p_dr->nh_handle);
 
         /* Hanlde only non-ECMP case here, route add/del will be notified
          * to NHT as part of the ECMP route handling */
-        if (p_nh_dep_dr->p_dr->nh_handle == p_nh->next_hop_id)
-            nas_rt_handle_dest_change(p_nh_dep_dr->p_dr, NULL, is_add);
+        p_dep_dr = p_nh_dep_dr->p_dr;
+        if (p_dep_dr->nh_handle == p_nh->next_hop_id)
+            nas_rt_handle_dest_change(p_dep_dr, NULL, is_add);
 
         p_nh_dep_dr =
-            fib_get_next_nh_dep_dr (p_nh, p_nh_dep_dr->key.vrf_id,
-                                    &p_nh_dep_dr->key.dr_key.prefix,
-                                    p_nh_dep_dr->prefix_len);
+            fib_get_next_nh_dep_dr (p_nh, p_dep_dr->vrf_id,
+                                    &p_dep_dr->key.prefix,
+                                    p_dep_dr->prefix_len);
     }
 
     return STD_ERR_OK;
@@ -482,8 +476,8 @@ static int nas_rt_check_nht_and_flush_acls(t_fib_ip_addr *dest_addr, t_fib_ip_ad
     } else if (p_dr) {
         vrf_id = p_dr->vrf_id;
         af_index = p_dr->key.prefix.af_index;
-        if (p_dr->old_nh_handle_nht) {
-            next_hop_id = p_dr->old_nh_handle_nht;
+        if (FIB_DR_COLD_FIELD (p_dr, old_nh_handle_nht)) {
+            next_hop_id = p_dr->p_cold->old_nh_handle_nht;
         } else {
             next_hop_id = p_dr->nh_handle;
         }
@@ -493,7 +487,7 @@ static int nas_rt_check_nht_and_flush_acls(t_fib_ip_addr *dest_addr, t_fib_ip_ad
     HAL_RT_LOG_INFO("RT-NHT-ACL", "Dependent ACLs cleanup for Addr:%s/%d,"
                     "nh:%p dr:%p nh_id:%lu dr handle old:%lu new:%lu force_del:%d",
                     FIB_IP_ADDR_TO_STR (dest_addr), prefix_len,
-                    p_nh, p_dr, next_hop_id, (p_dr ? p_dr->old_nh_handle_nht : 0),
+                    p_nh, p_dr, next_hop_id, (p_dr ? FIB_DR_COLD_FIELD (p_dr, old_nh_handle_nht) : 0),
                     (p_dr ? p_dr->nh_handle : 0), is_force_flush);
     if (next_hop_id == 0) {
         return true;
@@ -676,7 +670,7 @@ int nas_rt_handle_dest_change(t_fib_dr *p_dr, t_fib_nh *p_nh, bool is_add) {
                         nas_rt_get_mask (p_old_dr->key.prefix.af_index, p_old_dr->prefix_len, &dr_mask);
                         nas_rt_check_nht_and_flush_acls(&p_old_dr->key.prefix, &dr_mask,
                                                         p_old_dr->prefix_len, p_old_dr, NULL, false);
-                    } else if (p_dr && (p_dr->old_nh_handle_nht) &&
+                    } else if (p_dr && (FIB_DR_COLD_FIELD (p_dr, old_nh_handle_nht)) &&
                                (FIB_IS_AFINDEX_VALID (p_fib_nht->fib_match_dest_addr.af_index)) &&
                                (memcmp(&p_fib_nht->fib_match_dest_addr, &dest_addr, sizeof(dest_addr)) == 0) &&
                                (p_fib_nht->prefix_len == prefix_len)) {
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_dr_node_unittest.cpp
+ * UT of the DR cold part and micro-benchmark of the walker reads of the
+ * DR node against the DR node layout before the hot/cold split
+ */
+extern "C" {
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_mem.h"
+}
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAS_RT_UT_DR_NODES        500000
+#define NAS_RT_UT_DR_PASSES       3
+/* Larger than the LLC, read between the passes to flush the DR nodes */
+#define NAS_RT_UT_DR_FLUSH_BYTES  (64 * 1024 * 1024)
+
+/* DR node as it was laid out before the hot/cold split, the HAL info in
+ * a separate allocation */
+typedef struct {
+    std_radical_head_t radical;
+    t_fib_dr_key       key;
+    uint8_t            prefix_len;
+    hal_vrf_id_t       vrf_id;
+    rt_proto           proto;
+    uint32_t           default_dr_owner;
+    uint32_t           status_flag;
+    uint32_t           num_nh;
+    uint32_t           num_fh;
+    uint32_t           nh_count;
+    std_dll_head       nh_list;
+    std_dll_head       fh_list;
+    std_dll_head       dep_nh_list;
+    t_fib_dr_fh        degen_dr_fh;
+    uint64_t           last_update_time;
+    uint8_t            a_is_written [HAL_RT_MAX_INSTANCE];
+    next_hop_id_t      nh_handle;
+    next_hop_id_t      onh_handle;
+    next_hop_id_t      old_nh_handle_nht;
+    bool               remove_old_handle;
+    bool               ecmp_handle_created;
+    bool               is_nh_resolved;
+    uint32_t           ofh_cnt;
+    void              *p_hal_dr_handle;
+    uint32_t           num_ipv6_link_local;
+    uint32_t           num_ipv6_rif_link_local;
+    t_rt_type          rt_type;
+    bool               is_mgmt_route;
+    uint64_t           change_nsecs;
+    t_fib_rslv_node    rslv;
+} nas_rt_ut_split_before_dr_t;
+
+TEST(hal_rt_dr_node_test, hal_rt_dr_cold) {
+    t_fib_dr      *p_dr = fib_alloc_dr_node ();
+    t_fib_dr_cold *p_dr_cold = NULL;
+
+    ASSERT_TRUE(p_dr != NULL);
+    EXPECT_EQ(((uintptr_t)p_dr % HAL_RT_CACHE_LINE_SIZE), (uintptr_t)0);
+    EXPECT_TRUE(p_dr->p_cold == NULL);
+    EXPECT_EQ(FIB_DR_COLD_FIELD (p_dr, old_nh_handle_nht), (next_hop_id_t)0);
+    EXPECT_EQ(FIB_DR_COLD_FIELD (p_dr, num_ipv6_link_local), (uint32_t)0);
+
+    /* Allocated on the first update, the same part after that */
+    p_dr_cold = fib_get_dr_cold (p_dr);
+    ASSERT_TRUE(p_dr_cold != NULL);
+    EXPECT_EQ(p_dr->p_cold, p_dr_cold);
+    p_dr_cold->old_nh_handle_nht = 10;
+    EXPECT_EQ(fib_get_dr_cold (p_dr), p_dr_cold);
+    EXPECT_EQ(FIB_DR_COLD_FIELD (p_dr, old_nh_handle_nht), (next_hop_id_t)10);
+
+    FIB_DR_COLD_MEM_FREE (p_dr->p_cold);
+    FIB_DR_MEM_FREE (p_dr);
+}
+
+static void nas_rt_ut_dr_cache_flush (std::vector<uint8_t> &flush)
+{
+    for (size_t ix = 0; ix < flush.size(); ix += HAL_RT_CACHE_LINE_SIZE) {
+        flush[ix]++;
+    }
+}
+
+/* The fields a walker reads per DR, in the random order of the DRs of
+ * a changelist, best of the passes in ns/DR */
+template <typename T, typename F>
+static long nas_rt_ut_dr_walk_bench (std::vector<T*> &drs, std::vector<uint8_t> &flush,
+                                     F read_dr)
+{
+    long      best_nsecs = -1;
+    uintptr_t sum = 0;
+
+    for (int pass = 0; pass < NAS_RT_UT_DR_PASSES; pass++) {
+        nas_rt_ut_dr_cache_flush (flush);
+        auto start = std::chrono::steady_clock::now();
+        for (auto p_dr : drs) {
+            sum += read_dr (p_dr);
+        }
+        long nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>
+            (std::chrono::steady_clock::now() - start).count() / drs.size();
+        if ((best_nsecs < 0) || (nsecs < best_nsecs))
+            best_nsecs = nsecs;
+    }
+    EXPECT_EQ(sum, (uintptr_t)0);
+
+    return best_nsecs;
+}
+
+TEST(hal_rt_dr_node_test, hal_rt_dr_walk_bench) {
+    std::vector<t_fib_dr*> drs;
+    std::vector<nas_rt_ut_split_before_dr_t*> before_drs;
+    std::vector<uint8_t> flush (NAS_RT_UT_DR_FLUSH_BYTES);
+    std::mt19937 gen (5);
+
+    for (uint32_t ix = 0; ix < NAS_RT_UT_DR_NODES; ix++) {
+        t_fib_dr *p_dr = FIB_DR_MEM_MALLOC ();
+        ASSERT_TRUE(p_dr != NULL);
+        memset (p_dr, 0, sizeof (t_fib_dr));
+        std_dll_init (&p_dr->fh_list);
+        drs.push_back (p_dr);
+
+        nas_rt_ut_split_before_dr_t *p_before_dr = (nas_rt_ut_split_before_dr_t *)
+            malloc (sizeof (nas_rt_ut_split_before_dr_t));
+        ASSERT_TRUE(p_before_dr != NULL);
+        memset (p_before_dr, 0, sizeof (nas_rt_ut_split_before_dr_t));
+        std_dll_init (&p_before_dr->fh_list);
+        p_before_dr->p_hal_dr_handle = calloc (1, sizeof (t_fib_hal_dr_info));
+        ASSERT_TRUE(p_before_dr->p_hal_dr_handle != NULL);
+        before_drs.push_back (p_before_dr);
+    }
+    std::shuffle (drs.begin(), drs.end(), gen);
+    std::shuffle (before_drs.begin(), before_drs.end(), gen);
+
+    long nsecs = nas_rt_ut_dr_walk_bench (drs, flush, [] (t_fib_dr *p_dr) {
+        return ((uintptr_t)p_dr->status_flag + (uintptr_t)std_dll_getfirst (&p_dr->fh_list) +
+                (uintptr_t)p_dr->nh_handle + (uintptr_t)p_dr->rslv.state +
+                (uintptr_t)p_dr->hal_dr_info.a_obj_status [0]); });
+    long before_nsecs = nas_rt_ut_dr_walk_bench (before_drs, flush,
+                                                 [] (nas_rt_ut_split_before_dr_t *p_dr) {
+        return ((uintptr_t)p_dr->status_flag + (uintptr_t)std_dll_getfirst (&p_dr->fh_list) +
+                (uintptr_t)p_dr->nh_handle + (uintptr_t)p_dr->rslv.state +
+                (uintptr_t)((t_fib_hal_dr_info *)p_dr->p_hal_dr_handle)->a_obj_status [0]); });
+
+    std::cout << "DRs:" << drs.size()
+              << " walker reads split:" << nsecs << " ns/DR"
+              << " before split:" << before_nsecs << " ns/DR" << std::endl;
+    std::cout << "DR node split:" << sizeof (t_fib_dr) << " bytes, cold part:"
+              << sizeof (t_fib_dr_cold) << " bytes when used"
+              << " before split:" << sizeof (nas_rt_ut_split_before_dr_t) << " + "
+              << sizeof (t_fib_hal_dr_info) << " bytes in 2 allocations" << std::endl;
+
+    for (auto p_dr : drs) {
+        FIB_DR_MEM_FREE (p_dr);
+    }
+    for (auto p_before_dr : before_drs) {
+        free (p_before_dr->p_hal_dr_handle);
+        free (p_before_dr);
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_lpm_unittest.cpp
+ * UT and micro-benchmark of the LPM index against the DR radix tree
+ */
+extern "C" {
+#include "hal_rt_lpm.h"
+#include "std_radix.h"
+}
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+/* Sizes of a full Internet table */
+#define NAS_RT_UT_LPM_V4_ROUTES   900000
+#define NAS_RT_UT_LPM_V6_ROUTES   150000
+#define NAS_RT_UT_LPM_LOOKUPS     2000000
+
+/* Route node keyed like the DR tree, the address after a 32 bit AF */
+typedef struct {
+    std_rt_head head;
+    uint8_t     key[4 + 16];
+    uint32_t    len;
+} nas_rt_ut_lpm_route_t;
+
+typedef struct {
+    std_rt_table                       *p_tree;
+    t_fib_lpm                          *p_lpm;
+    uint32_t                            max_len;
+    std::vector<nas_rt_ut_lpm_route_t*> routes;
+} nas_rt_ut_lpm_table_t;
+
+static void nas_rt_ut_lpm_key (const uint8_t *p_addr, uint32_t max_len, t_fib_lpm_key *p_key)
+{
+    p_key->hi = 0;
+    p_key->lo = 0;
+    for (uint32_t ix = 0; ix < (max_len / 8); ix++) {
+        if (ix < 8)
+            p_key->hi |= ((uint64_t)p_addr[ix] << (56 - (8 * ix)));
+        else
+            p_key->lo |= ((uint64_t)p_addr[ix] << (56 - (8 * (ix - 8))));
+    }
+}
+
+/* Prefix length of a route in a full table */
+static uint32_t nas_rt_ut_lpm_len_get (std::mt19937 &gen, uint32_t max_len)
+{
+    uint32_t pct = gen() % 100;
+
+    if (max_len == 32) {
+        if (pct < 58) return 24;
+        if (pct < 68) return 23;
+        if (pct < 78) return 22;
+        if (pct < 84) return 21;
+        if (pct < 89) return 20;
+        if (pct < 92) return 19;
+        if (pct < 95) return 16;
+        return (8 + (gen() % 25));
+    }
+    if (pct < 45) return 48;
+    if (pct < 60) return 44;
+    if (pct < 72) return 32;
+    if (pct < 82) return 40;
+    if (pct < 90) return 36;
+    return (16 + (gen() % 113));
+}
+
+static void nas_rt_ut_lpm_table_create (nas_rt_ut_lpm_table_t &table, uint32_t max_len,
+                                        uint32_t num_routes)
+{
+    std::mt19937 gen (max_len);
+
+    table.max_len = max_len;
+    table.p_tree = std_radix_create ("lpm_ut", 8 * (4 + (max_len / 8)), NULL, NULL, 0);
+    table.p_lpm = fib_lpm_create (max_len);
+    ASSERT_TRUE(table.p_tree != NULL);
+    ASSERT_TRUE(table.p_lpm != NULL);
+
+    while (table.routes.size() < num_routes) {
+        nas_rt_ut_lpm_route_t *p_route = new nas_rt_ut_lpm_route_t ();
+        uint32_t len = nas_rt_ut_lpm_len_get (gen, max_len);
+
+        p_route->len = len;
+        for (uint32_t ix = 0; ix < (max_len / 8); ix++) {
+            uint32_t bits = ((ix * 8) < len) ? std::min<uint32_t>(len - (ix * 8), 8) : 0;
+            p_route->key[4 + ix] = (gen() & (0xff00 >> bits)) & 0xff;
+        }
+        /* Routes are clustered in a part of the address space */
+        p_route->key[4] = 1 + (p_route->key[4] % 223);
+        p_route->head.rth_addr = p_route->key;
+
+        std_rt_head *p_head = std_radix_insert (table.p_tree, &p_route->head, 32 + len);
+        if (p_head != &p_route->head) {
+            delete p_route;
+            continue;
+        }
+        t_fib_lpm_key key;
+        nas_rt_ut_lpm_key (&p_route->key[4], max_len, &key);
+        ASSERT_TRUE(fib_lpm_add (table.p_lpm, &key, len, p_route));
+        table.routes.push_back (p_route);
+    }
+}
+
+static void nas_rt_ut_lpm_table_destroy (nas_rt_ut_lpm_table_t &table)
+{
+    for (auto p_route : table.routes) {
+        std_radix_remove (table.p_tree, &p_route->head);
+        delete p_route;
+    }
+    table.routes.clear();
+    std_radix_destroy (table.p_tree);
+    fib_lpm_destroy (table.p_lpm);
+}
+
+/* Addresses covered by the routes of the table, as the NH addresses are */
+static void nas_rt_ut_lpm_addrs_get (nas_rt_ut_lpm_table_t &table,
+                                     std::vector<std::vector<uint8_t>> &addrs)
+{
+    std::mt19937 gen (7);
+
+    addrs.resize (NAS_RT_UT_LPM_LOOKUPS / 16);
+    for (auto &addr : addrs) {
+        const nas_rt_ut_lpm_route_t *p_route = table.routes[gen() % table.routes.size()];
+
+        addr.assign (p_route->key, p_route->key + 4 + (table.max_len / 8));
+        for (uint32_t ix = 0; ix < (table.max_len / 8); ix++) {
+            uint32_t bits = ((ix * 8) < p_route->len) ?
+                std::min<uint32_t>(p_route->len - (ix * 8), 8) : 0;
+            addr[4 + ix] |= (gen() & (0xff >> bits));
+        }
+    }
+}
+
+static void nas_rt_ut_lpm_validate (nas_rt_ut_lpm_table_t &table)
+{
+    std::vector<std::vector<uint8_t>> addrs;
+    t_fib_lpm_key key;
+
+    nas_rt_ut_lpm_addrs_get (table, addrs);
+    for (auto &addr : addrs) {
+        nas_rt_ut_lpm_key (&addr[4], table.max_len, &key);
+        std_rt_head *p_best = std_radix_getbest (table.p_tree, addr.data(), 32 + table.max_len);
+        ASSERT_EQ((void *)p_best, fib_lpm_lookup (table.p_lpm, &key));
+
+        /* Best fit shorter than the best fit */
+        if ((p_best == NULL) || (((nas_rt_ut_lpm_route_t *)p_best)->len == 0))
+            continue;
+        uint32_t max_len = ((nas_rt_ut_lpm_route_t *)p_best)->len - 1;
+        p_best = std_radix_getbest (table.p_tree, addr.data(), 32 + max_len);
+        ASSERT_EQ((void *)p_best, fib_lpm_lookup_len (table.p_lpm, &key, max_len));
+    }
+}
+
+/* Next best fit of each route, strictly shorter than the route, as the NHT
+ * walks from a DR to the next best DR */
+static void nas_rt_ut_lpm_next_best_validate (nas_rt_ut_lpm_table_t &table)
+{
+    t_fib_lpm_key key;
+
+    for (auto p_route : table.routes) {
+        if (p_route->len == 0)
+            continue;
+        nas_rt_ut_lpm_key (&p_route->key[4], table.max_len, &key);
+        std_rt_head *p_next_best = std_radix_getnextbest (table.p_tree, p_route->key,
+                                                          32 + p_route->len);
+        void *p_lpm_next_best = fib_lpm_next_best (table.p_lpm, &key, p_route->len);
+        ASSERT_EQ((void *)p_next_best, p_lpm_next_best);
+        ASSERT_NE(p_lpm_next_best, (void *)p_route);
+        if (p_lpm_next_best != NULL)
+            ASSERT_LT(((nas_rt_ut_lpm_route_t *)p_lpm_next_best)->len, p_route->len);
+    }
+}
+
+static void nas_rt_ut_lpm_bench (nas_rt_ut_lpm_table_t &table)
+{
+    std::vector<std::vector<uint8_t>> addrs;
+    std::vector<t_fib_lpm_key> keys;
+    uintptr_t sum = 0;
+
+    nas_rt_ut_lpm_addrs_get (table, addrs);
+    keys.resize (addrs.size());
+    for (size_t ix = 0; ix < addrs.size(); ix++) {
+        nas_rt_ut_lpm_key (&addrs[ix][4], table.max_len, &keys[ix]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int iter = 0; iter < 16; iter++) {
+        for (auto &addr : addrs) {
+            sum += (uintptr_t)std_radix_getbest (table.p_tree, addr.data(), 32 + table.max_len);
+        }
+    }
+    auto radix_nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int iter = 0; iter < 16; iter++) {
+        for (auto &key : keys) {
+            sum -= (uintptr_t)fib_lpm_lookup (table.p_lpm, &key);
+        }
+    }
+    auto lpm_nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(sum, (uintptr_t)0);
+    std::cout << "IPv" << ((table.max_len == 32) ? 4 : 6) << " routes:" << table.routes.size()
+              << " radix best fit:" << (radix_nsecs / (16 * addrs.size())) << " ns"
+              << " LPM index:" << (lpm_nsecs / (16 * addrs.size())) << " ns"
+              << " LPM index memory:" << (table.p_lpm->num_bytes / table.routes.size())
+              << " bytes/route" << std::endl;
+}
+
+TEST(hal_rt_lpm_test, hal_rt_lpm_v4) {
+    nas_rt_ut_lpm_table_t table;
+
+    nas_rt_ut_lpm_table_create (table, 32, NAS_RT_UT_LPM_V4_ROUTES);
+    nas_rt_ut_lpm_validate (table);
+    nas_rt_ut_lpm_next_best_validate (table);
+    nas_rt_ut_lpm_bench (table);
+    nas_rt_ut_lpm_table_destroy (table);
+}
+
+TEST(hal_rt_lpm_test, hal_rt_lpm_v6) {
+    nas_rt_ut_lpm_table_t table;
+
+    nas_rt_ut_lpm_table_create (table, 128, NAS_RT_UT_LPM_V6_ROUTES);
+    nas_rt_ut_lpm_validate (table);
+    nas_rt_ut_lpm_next_best_validate (table);
+    nas_rt_ut_lpm_bench (table);
+    nas_rt_ut_lpm_table_destroy (table);
+}
+
+TEST(hal_rt_lpm_test, hal_rt_lpm_del) {
+    nas_rt_ut_lpm_table_t table;
+    std::mt19937 gen (1);
+    t_fib_lpm_key key;
+
+    nas_rt_ut_lpm_table_create (table, 32, 10000);
+    /* Delete half of the routes, the index should still match the tree */
+    for (size_t ix = 0; ix < table.routes.size();) {
+        nas_rt_ut_lpm_route_t *p_route = table.routes[ix];
+        if (gen() % 2) {
+            ix++;
+            continue;
+        }
+        nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+        fib_lpm_del (table.p_lpm, &key, p_route->len);
+        std_radix_remove (table.p_tree, &p_route->head);
+        delete p_route;
+        table.routes[ix] = table.routes.back();
+        table.routes.pop_back();
+    }
+    EXPECT_EQ(table.p_lpm->num_pfx, (uint32_t)table.routes.size());
+    nas_rt_ut_lpm_validate (table);
+    nas_rt_ut_lpm_next_best_validate (table);
+    nas_rt_ut_lpm_table_destroy (table);
+}
+
+/* Nested routes of the same address, the next best fit walk of the
+ * longest one visits each shorter one in turn */
+TEST(hal_rt_lpm_test, hal_rt_lpm_next_best_same_addr) {
+    const uint32_t lens[] = {0, 8, 16, 24, 25, 32};
+    nas_rt_ut_lpm_table_t table;
+    t_fib_lpm_key key;
+
+    table.max_len = 32;
+    table.p_tree = std_radix_create ("lpm_ut", 8 * (4 + 4), NULL, NULL, 0);
+    table.p_lpm = fib_lpm_create (32);
+    ASSERT_TRUE(table.p_tree != NULL);
+    ASSERT_TRUE(table.p_lpm != NULL);
+
+    /* 10.1.1.0/32, /25, /24 share the address, 10.1.0.0/16, 10.0.0.0/8, 0/0 */
+    for (auto len : lens) {
+        nas_rt_ut_lpm_route_t *p_route = new nas_rt_ut_lpm_route_t ();
+        const uint8_t addr[] = {10, 1, 1, 0};
+
+        p_route->len = len;
+        for (uint32_t ix = 0; ix < 4; ix++) {
+            uint32_t bits = ((ix * 8) < len) ? std::min<uint32_t>(len - (ix * 8), 8) : 0;
+            p_route->key[4 + ix] = addr[ix] & (0xff00 >> bits);
+        }
+        p_route->head.rth_addr = p_route->key;
+        ASSERT_EQ(std_radix_insert (table.p_tree, &p_route->head, 32 + len), &p_route->head);
+        nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+        ASSERT_TRUE(fib_lpm_add (table.p_lpm, &key, len, p_route));
+        table.routes.push_back (p_route);
+    }
+
+    nas_rt_ut_lpm_route_t *p_route = table.routes.back();
+    for (int ix = (sizeof (lens) / sizeof (lens[0])) - 2; ix >= 0; ix--) {
+        nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+        std_rt_head *p_next_best = std_radix_getnextbest (table.p_tree, p_route->key,
+                                                          32 + p_route->len);
+        p_route = (nas_rt_ut_lpm_route_t *)fib_lpm_next_best (table.p_lpm, &key,
+                                                              p_route->len);
+        ASSERT_EQ((void *)p_next_best, (void *)p_route);
+        ASSERT_TRUE(p_route != NULL);
+        EXPECT_EQ(p_route->len, lens[ix]);
+    }
+    nas_rt_ut_lpm_next_best_validate (table);
+    nas_rt_ut_lpm_table_destroy (table);
+}
+
+/* The NHT walk from a route with a longer route of the same address, the
+ * next best fit of 10.1.1.0/24 with 10.1.1.0/25 was the /24 itself before
+ * and the walk never ended */
+TEST(hal_rt_lpm_test, hal_rt_lpm_next_best_walk_ends) {
+    const uint32_t lens[] = {0, 16, 24, 25};
+    nas_rt_ut_lpm_table_t table;
+    t_fib_lpm_key key;
+
+    table.max_len = 32;
+    table.p_tree = std_radix_create ("lpm_ut", 8 * (4 + 4), NULL, NULL, 0);
+    table.p_lpm = fib_lpm_create (32);
+    ASSERT_TRUE(table.p_tree != NULL);
+    ASSERT_TRUE(table.p_lpm != NULL);
+
+    for (auto len : lens) {
+        nas_rt_ut_lpm_route_t *p_route = new nas_rt_ut_lpm_route_t ();
+        const uint8_t addr[] = {10, 1, 1, 0};
+
+        p_route->len = len;
+        for (uint32_t ix = 0; ix < 4; ix++) {
+            uint32_t bits = ((ix * 8) < len) ? std::min<uint32_t>(len - (ix * 8), 8) : 0;
+            p_route->key[4 + ix] = addr[ix] & (0xff00 >> bits);
+        }
+        p_route->head.rth_addr = p_route->key;
+        ASSERT_EQ(std_radix_insert (table.p_tree, &p_route->head, 32 + len), &p_route->head);
+        nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+        ASSERT_TRUE(fib_lpm_add (table.p_lpm, &key, len, p_route));
+        table.routes.push_back (p_route);
+    }
+
+    /* Next best fit of the /24 is the /16, not the /24 or the /25 */
+    nas_rt_ut_lpm_route_t *p_route = table.routes[2];
+    nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+    EXPECT_EQ(fib_lpm_next_best (table.p_lpm, &key, p_route->len), (void *)table.routes[1]);
+
+    /* Walk from each route as nas_rt_find_next_best_dr_for_nht does, each
+     * step is shorter, so the walk ends within the no. of routes */
+    for (auto p_start : table.routes) {
+        uint32_t num_steps = 0;
+
+        p_route = p_start;
+        while (p_route != NULL) {
+            nas_rt_ut_lpm_route_t *p_next = NULL;
+
+            ASSERT_LT(num_steps++, table.routes.size());
+            nas_rt_ut_lpm_key (&p_route->key[4], 32, &key);
+            p_next = (nas_rt_ut_lpm_route_t *)fib_lpm_next_best (table.p_lpm, &key,
+                                                                p_route->len);
+            if (p_next != NULL)
+                ASSERT_LT(p_next->len, p_route->len);
+            p_route = p_next;
+        }
+    }
+    nas_rt_ut_lpm_table_destroy (table);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_msg_queue_unittest.cpp
+ * UT for the route msg coalescing of the HAL-RT msg queue
+ */
+extern "C" {
+#include "hal_rt_main.h"
+}
+#include "hal_rt_msg_queue.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <arpa/inet.h>
+
+#define NAS_RT_UT_MSGQ_DEPTH  1024
+
+#define NAS_RT_UT_ROUTE_MSG_SIZE(_nh_count_) \
+        (sizeof(t_fib_msg) + (sizeof (t_fib_nh_info) * (_nh_count_)))
+
+/* Route msg for 10.1.1.0/24 via the given NH addresses */
+static t_fib_msg *nas_rt_ut_msgq_route_msg (t_fib_rt_msg_type msg_type,
+                                            const std::vector<const char*> &nh_list,
+                                            t_fib_rt_validation validation)
+{
+    t_fib_msg *p_msg = hal_rt_alloc_route_mem_msg (NAS_RT_UT_ROUTE_MSG_SIZE(nh_list.size()));
+    if (p_msg == NULL)
+        return NULL;
+
+    memset (p_msg, 0, NAS_RT_UT_ROUTE_MSG_SIZE(nh_list.size()));
+    p_msg->type = FIB_MSG_TYPE_NL_ROUTE;
+    t_fib_route_entry *p_rt = &p_msg->route;
+    p_rt->msg_type = msg_type;
+    p_rt->vrfid = FIB_DEFAULT_VRF;
+    p_rt->nh_vrfid = FIB_DEFAULT_VRF;
+    p_rt->prefix.af_index = HAL_INET4_FAMILY;
+    inet_pton (AF_INET, "10.1.1.0", &p_rt->prefix.u.v4_addr);
+    p_rt->prefix_masklen = 24;
+    p_rt->validation = validation;
+    p_rt->hop_count = nh_list.size();
+    for (size_t ix = 0; ix < nh_list.size(); ix++) {
+        p_rt->nh_list[ix].nh_addr.af_index = HAL_INET4_FAMILY;
+        inet_pton (AF_INET, nh_list[ix], &p_rt->nh_list[ix].nh_addr.u.v4_addr);
+    }
+    return p_msg;
+}
+
+/* Enqueues the msgs and dequeues them in the processing order */
+static void nas_rt_ut_msgq_batch (const std::vector<t_fib_msg*> &msgs,
+                                  std::vector<fib_msg_uptr_t> &batch)
+{
+    hal_rt_msgq_t msgq (NAS_RT_UT_MSGQ_DEPTH);
+
+    for (auto p_msg : msgs) {
+        EXPECT_TRUE(msgq.enqueue (p_msg));
+    }
+    msgq.dequeue_batch (batch, msgs.size());
+    EXPECT_EQ(msgq.size(), 0);
+}
+
+/* Enqueues the msgs and returns the msg types left after the coalescing */
+static std::vector<t_fib_rt_msg_type> nas_rt_ut_msgq_run (const std::vector<t_fib_msg*> &msgs,
+                                                          std::vector<size_t> *p_hop_counts)
+{
+    std::vector<fib_msg_uptr_t> batch;
+    std::vector<t_fib_rt_msg_type> types;
+
+    nas_rt_ut_msgq_batch (msgs, batch);
+    for (auto &p_msg : batch) {
+        types.push_back (p_msg->route.msg_type);
+        if (p_hop_counts)
+            p_hop_counts->push_back (p_msg->route.hop_count);
+    }
+    return types;
+}
+
+static void nas_rt_ut_msgq_prefix_set (t_fib_msg *p_msg, const char *prefix)
+{
+    inet_pton (AF_INET, prefix, &p_msg->route.prefix.u.v4_addr);
+}
+
+static bool nas_rt_ut_msgq_is_prefix (t_fib_msg *p_msg, const char *prefix)
+{
+    hal_ip_addr_t addr;
+
+    inet_pton (AF_INET, prefix, &addr.u.v4_addr);
+    return (memcmp (&addr.u.v4_addr, &p_msg->route.prefix.u.v4_addr,
+                    sizeof(addr.u.v4_addr)) == 0);
+}
+
+/* DEL of the NHs the ADD appended cancels the ADD, the DEL removes only those
+ * NHs if R exists and is ignored if they are not on R (R via X stays) */
+TEST(hal_rt_msgq_test, add_del_same_nh) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+    };
+    std::vector<size_t> hop_counts;
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, &hop_counts);
+
+    ASSERT_EQ(types.size(), 1);
+    EXPECT_EQ(types[0], FIB_RT_MSG_DEL);
+    EXPECT_EQ(hop_counts[0], 1);
+}
+
+/* DEL takes the queue position of the ADD it cancels,
+ * ahead of the msgs of the other routes staged in between */
+TEST(hal_rt_msgq_test, add_del_keeps_queue_position) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+    };
+    nas_rt_ut_msgq_prefix_set (msgs[1], "10.2.2.0");
+    std::vector<fib_msg_uptr_t> batch;
+    nas_rt_ut_msgq_batch (msgs, batch);
+
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_EQ(batch[0]->route.msg_type, FIB_RT_MSG_DEL);
+    EXPECT_TRUE(nas_rt_ut_msgq_is_prefix (batch[0].get(), "10.1.1.0"));
+    EXPECT_EQ(batch[1]->route.msg_type, FIB_RT_MSG_ADD);
+    EXPECT_TRUE(nas_rt_ut_msgq_is_prefix (batch[1].get(), "10.2.2.0"));
+    EXPECT_EQ(batch[0]->route.coalesce_flags, 0);
+}
+
+/* ADD of a connected route, UPD and DEL leave the DEL at the ADD position,
+ * carrying the neighbor flush of the connected route it overrides */
+TEST(hal_rt_msgq_test, add_upd_del_connected_route) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"0.0.0.0"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_UPD, {"1.1.1.3"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {}, FIB_RT_VALIDATION_OK),
+    };
+    nas_rt_ut_msgq_prefix_set (msgs[1], "10.2.2.0");
+    std::vector<fib_msg_uptr_t> batch;
+    nas_rt_ut_msgq_batch (msgs, batch);
+
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_EQ(batch[0]->route.msg_type, FIB_RT_MSG_DEL);
+    EXPECT_EQ(batch[0]->route.hop_count, 0);
+    EXPECT_TRUE(nas_rt_ut_msgq_is_prefix (batch[0].get(), "10.1.1.0"));
+    EXPECT_TRUE(batch[0]->route.coalesce_flags & FIB_RT_COALESCE_NEIGH_FLUSH);
+    EXPECT_TRUE(nas_rt_ut_msgq_is_prefix (batch[1].get(), "10.2.2.0"));
+}
+
+/* ADD via a gateway, UPD and DEL, no neighbor flush to carry */
+TEST(hal_rt_msgq_test, add_upd_del) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_UPD, {"1.1.1.3"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {}, FIB_RT_VALIDATION_OK),
+    };
+    std::vector<fib_msg_uptr_t> batch;
+    nas_rt_ut_msgq_batch (msgs, batch);
+
+    ASSERT_EQ(batch.size(), 1);
+    EXPECT_EQ(batch[0]->route.msg_type, FIB_RT_MSG_DEL);
+    EXPECT_EQ(batch[0]->route.coalesce_flags, 0);
+}
+
+/* DEL staged after an intf msg for its NH interface can not move ahead of it
+ * to the ADD position as the intf msg waits for the ADD position */
+TEST(hal_rt_msgq_test, add_del_waits_for_intf_msg) {
+    t_fib_msg *p_intf_msg = hal_rt_alloc_mem_msg_by_type (FIB_MSG_TYPE_NL_INTF);
+    ASSERT_TRUE(p_intf_msg != NULL);
+    p_intf_msg->intf.if_index = 5;
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        p_intf_msg,
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+    };
+    msgs[0]->route.nh_list[0].nh_if_index = 5;
+    msgs[2]->route.nh_list[0].nh_if_index = 5;
+    std::vector<fib_msg_uptr_t> batch;
+    nas_rt_ut_msgq_batch (msgs, batch);
+
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_EQ(batch[0]->type, FIB_MSG_TYPE_NL_INTF);
+    EXPECT_EQ(batch[1]->type, FIB_MSG_TYPE_NL_ROUTE);
+    EXPECT_EQ(batch[1]->route.msg_type, FIB_RT_MSG_DEL);
+}
+
+/* ADD after a route DEL is cancelled by a DEL of its NHs, the route DEL stays */
+TEST(hal_rt_msgq_test, add_del_same_nh_after_route_del) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+    };
+    std::vector<size_t> hop_counts;
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, &hop_counts);
+
+    ASSERT_EQ(types.size(), 2);
+    EXPECT_EQ(types[0], FIB_RT_MSG_DEL);
+    EXPECT_EQ(hop_counts[0], 0);
+    EXPECT_EQ(types[1], FIB_RT_MSG_DEL);
+    EXPECT_EQ(hop_counts[1], 1);
+}
+
+/* ADD with other NHs than the DEL is retained */
+TEST(hal_rt_msgq_test, add_del_other_nh_after_route_del) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_DEL, {"1.1.1.3"}, FIB_RT_VALIDATION_OK),
+    };
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, NULL);
+
+    ASSERT_EQ(types.size(), 3);
+}
+
+/* Validated UPD overrides the pending ADDs */
+TEST(hal_rt_msgq_test, upd_overrides_add) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.3"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_UPD, {"1.1.1.4"}, FIB_RT_VALIDATION_OK),
+    };
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, NULL);
+
+    ASSERT_EQ(types.size(), 1);
+    EXPECT_EQ(types[0], FIB_RT_MSG_UPD);
+}
+
+/* UPD not validated yet might be rejected at the processing,
+ * the ADDs it would override are retained */
+TEST(hal_rt_msgq_test, unvalidated_upd_keeps_add) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_UPD, {"1.1.1.4"}, FIB_RT_VALIDATION_NONE),
+    };
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, NULL);
+
+    ASSERT_EQ(types.size(), 2);
+    EXPECT_EQ(types[0], FIB_RT_MSG_ADD);
+    EXPECT_EQ(types[1], FIB_RT_MSG_UPD);
+}
+
+/* UPD with another NH VRF than the pending ADD does not override it */
+TEST(hal_rt_msgq_test, upd_other_nh_vrf_keeps_add) {
+    std::vector<t_fib_msg*> msgs = {
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"}, FIB_RT_VALIDATION_OK),
+        nas_rt_ut_msgq_route_msg (FIB_RT_MSG_UPD, {"1.1.1.4"}, FIB_RT_VALIDATION_OK),
+    };
+    msgs[1]->route.nh_vrfid = FIB_DEFAULT_VRF + 1;
+    std::vector<t_fib_rt_msg_type> types = nas_rt_ut_msgq_run (msgs, NULL);
+
+    ASSERT_EQ(types.size(), 2);
+}
+
+/* Route msg via if_index and an intf msg for it from each of the iterations,
+ * the intf msg waits for the route msg though it is on the higher priority
+ * lane, returns false if any of them got out of the order */
+static bool nas_rt_ut_msgq_if_order_run (hal_ifindex_t if_base, size_t cnt)
+{
+    hal_rt_msgq_t msgq (NAS_RT_UT_MSGQ_DEPTH);
+    std::vector<fib_msg_uptr_t> batch;
+    std::vector<bool> route_done (cnt, false);
+    bool is_ok = true;
+
+    for (size_t ix = 0; ix < cnt; ix++) {
+        t_fib_msg *p_msg = nas_rt_ut_msgq_route_msg (FIB_RT_MSG_ADD, {"1.1.1.2"},
+                                                     FIB_RT_VALIDATION_OK);
+        p_msg->route.prefix.u.v4_addr = htonl (0x0a000000 + (ix << 8));
+        p_msg->route.nh_list[0].nh_if_index = if_base + ix;
+        msgq.enqueue (p_msg);
+        p_msg = hal_rt_alloc_mem_msg_by_type (FIB_MSG_TYPE_NL_INTF);
+        p_msg->intf.if_index = if_base + ix;
+        msgq.enqueue (p_msg);
+    }
+    while (batch.size() < (2 * cnt)) {
+        msgq.dequeue_batch (batch, (2 * cnt) - batch.size());
+    }
+    for (auto &p_msg : batch) {
+        if (p_msg->type == FIB_MSG_TYPE_NL_ROUTE) {
+            route_done[p_msg->route.nh_list[0].nh_if_index - if_base] = true;
+        } else if (!route_done[p_msg->intf.if_index - if_base]) {
+            is_ok = false;
+        }
+    }
+    return is_ok;
+}
+
+/* The interface ordering state is per queue, the queues staged
+ * concurrently by their consumers do not see each other's msgs */
+TEST(hal_rt_msgq_test, concurrent_queues_if_order) {
+    const size_t cnt = 512;
+    bool is_ok[2] = {false, false};
+
+    for (int iter = 0; iter < 16; iter++) {
+        std::thread thr0 ([&] { is_ok[0] = nas_rt_ut_msgq_if_order_run (1000, cnt); });
+        std::thread thr1 ([&] { is_ok[1] = nas_rt_ut_msgq_if_order_run (5000, cnt); });
+        thr0.join();
+        thr1.join();
+        ASSERT_TRUE(is_ok[0]);
+        ASSERT_TRUE(is_ok[1]);
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
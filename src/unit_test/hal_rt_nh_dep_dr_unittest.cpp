@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_nh_dep_dr_unittest.cpp
+ * UT and micro-benchmark of the NH dependent DR list against the radix
+ * tree of dependent DR nodes it replaced
+ */
+extern "C" {
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "std_radix.h"
+}
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/* Dependent DRs of the NH of a default route with a full table */
+#define NAS_RT_UT_DEP_DR_ROUTES   200000
+
+/* Dependent DR node of the radix tree, as it was kept per NH before */
+typedef struct {
+    uint32_t      vrf_id;
+    t_fib_dr_key  dr_key;
+} nas_rt_ut_radix_dep_dr_key_t;
+
+typedef struct {
+    std_rt_head                  rt_head;
+    nas_rt_ut_radix_dep_dr_key_t key;
+    uint8_t                      prefix_len;
+    t_fib_dr                    *p_dr;
+} nas_rt_ut_radix_dep_dr_t;
+
+#define NAS_RT_UT_RADIX_DEP_DR_KEY_LEN(_prefix_len) \
+        ((8 * (sizeof (uint32_t) + sizeof (((t_fib_ip_addr *)0)->af_index))) + (_prefix_len))
+
+static uint8_t nas_rt_ut_dep_dr_byte (const t_fib_dr *p_dr, uint32_t ix)
+{
+    uint32_t bits = ((ix * 8) < p_dr->prefix_len) ?
+        std::min<uint32_t>(p_dr->prefix_len - (ix * 8), 8) : 0;
+
+    return (((const uint8_t *)&p_dr->key.prefix.u)[ix] & (0xff00 >> bits));
+}
+
+/* Order of the dependent DRs of a NH, (vrf_id, prefix, prefix_len) */
+static bool nas_rt_ut_dep_dr_less (const t_fib_dr *p_dr1, const t_fib_dr *p_dr2)
+{
+    if (p_dr1->vrf_id != p_dr2->vrf_id)
+        return (p_dr1->vrf_id < p_dr2->vrf_id);
+    for (uint32_t ix = 0; ix < 4; ix++) {
+        uint8_t byte1 = nas_rt_ut_dep_dr_byte (p_dr1, ix);
+        uint8_t byte2 = nas_rt_ut_dep_dr_byte (p_dr2, ix);
+        if (byte1 != byte2)
+            return (byte1 < byte2);
+    }
+    return (p_dr1->prefix_len < p_dr2->prefix_len);
+}
+
+/* DRs of distinct IPv4 prefixes in a full table length mix */
+static void nas_rt_ut_dep_dr_create (std::vector<t_fib_dr*> &drs, uint32_t num_routes,
+                                     uint32_t seed)
+{
+    std::mt19937 gen (seed);
+    std::set<std::pair<uint32_t, uint32_t>> keys;
+
+    while (drs.size() < num_routes) {
+        uint32_t pct = gen() % 100;
+        uint32_t len = (pct < 60) ? 24 : ((pct < 90) ? (16 + (gen() % 8)) : (8 + (gen() % 25)));
+        uint32_t addr = gen() & (0xffffffffULL << (32 - len));
+
+        if (!keys.insert (std::make_pair (addr, len)).second)
+            continue;
+
+        t_fib_dr *p_dr = (t_fib_dr *)aligned_alloc (HAL_RT_CACHE_LINE_SIZE, sizeof (t_fib_dr));
+        ASSERT_TRUE(p_dr != NULL);
+        memset (p_dr, 0, sizeof (t_fib_dr));
+        p_dr->vrf_id = gen() % 2;
+        p_dr->key.prefix.af_index = HAL_RT_V4_AFINDEX;
+        p_dr->key.prefix.u.v4_addr = htonl (addr);
+        p_dr->prefix_len = len;
+        drs.push_back (p_dr);
+    }
+}
+
+static void nas_rt_ut_dep_dr_destroy (std::vector<t_fib_dr*> &drs)
+{
+    for (auto p_dr : drs) {
+        free (p_dr);
+    }
+    drs.clear();
+}
+
+/* The walk of the list, each entry from the key of the DR before it, as
+ * the NH walks get their next dependent DR */
+static void nas_rt_ut_dep_dr_walk (t_fib_nh *p_nh, std::vector<t_fib_dr*> &walk)
+{
+    t_fib_nh_dep_dr *p_nh_dep_dr = fib_get_first_nh_dep_dr (p_nh);
+
+    walk.clear();
+    while (p_nh_dep_dr != NULL) {
+        t_fib_dr *p_dr = p_nh_dep_dr->p_dr;
+
+        walk.push_back (p_dr);
+        p_nh_dep_dr = fib_get_next_nh_dep_dr (p_nh, p_dr->vrf_id, &p_dr->key.prefix,
+                                              p_dr->prefix_len);
+    }
+}
+
+static void nas_rt_ut_dep_dr_validate (t_fib_nh *p_nh, std::vector<t_fib_dr*> &drs)
+{
+    std::vector<t_fib_dr*> walk;
+
+    std::sort (drs.begin(), drs.end(), nas_rt_ut_dep_dr_less);
+    nas_rt_ut_dep_dr_walk (p_nh, walk);
+    ASSERT_EQ(p_nh->dep_dr_list.num_dr, (uint32_t)drs.size());
+    ASSERT_TRUE(walk == drs);
+    for (auto p_dr : drs) {
+        t_fib_nh_dep_dr *p_nh_dep_dr = fib_get_nh_dep_dr (p_nh, p_dr);
+        ASSERT_TRUE(p_nh_dep_dr != NULL);
+        ASSERT_EQ(p_nh_dep_dr->p_dr, p_dr);
+    }
+}
+
+TEST(hal_rt_nh_dep_dr_test, hal_rt_nh_dep_dr_add_del) {
+    std::vector<t_fib_dr*> drs;
+    std::vector<t_fib_dr*> added;
+    std::mt19937 gen (3);
+    t_fib_nh nh;
+
+    memset (&nh, 0, sizeof (nh));
+    nas_rt_ut_dep_dr_create (drs, 20000, 1);
+
+    /* Random adds and deletes, the list should keep the DR key order */
+    for (int round = 0; round < 4; round++) {
+        for (auto p_dr : drs) {
+            if ((gen() % 2) && (fib_get_nh_dep_dr (&nh, p_dr) == NULL)) {
+                ASSERT_TRUE(fib_add_nh_dep_dr (&nh, p_dr) != NULL);
+                added.push_back (p_dr);
+            }
+        }
+        /* A DR added again gets its entry back */
+        if (!added.empty()) {
+            EXPECT_EQ(fib_add_nh_dep_dr (&nh, added[0])->p_dr, added[0]);
+        }
+        nas_rt_ut_dep_dr_validate (&nh, added);
+
+        for (size_t ix = 0; ix < added.size();) {
+            if (gen() % 3) {
+                ix++;
+                continue;
+            }
+            ASSERT_EQ(fib_del_nh_dep_dr (&nh, fib_get_nh_dep_dr (&nh, added[ix])), STD_ERR_OK);
+            EXPECT_TRUE(fib_get_nh_dep_dr (&nh, added[ix]) == NULL);
+            added[ix] = added.back();
+            added.pop_back();
+        }
+        nas_rt_ut_dep_dr_validate (&nh, added);
+    }
+
+    fib_delete_all_nh_dep_dr (&nh);
+    EXPECT_TRUE(fib_get_first_nh_dep_dr (&nh) == NULL);
+    EXPECT_EQ(fib_get_nh_dep_dr_mem_size (&nh), (uint64_t)0);
+    nas_rt_ut_dep_dr_destroy (drs);
+}
+
+static long nas_rt_ut_nsecs_since (std::chrono::steady_clock::time_point start, size_t num)
+{
+    return (std::chrono::duration_cast<std::chrono::nanoseconds>
+            (std::chrono::steady_clock::now() - start).count() / num);
+}
+
+TEST(hal_rt_nh_dep_dr_test, hal_rt_nh_dep_dr_bench) {
+    std::vector<t_fib_dr*> drs;
+    std::vector<t_fib_dr*> order;
+    std::vector<nas_rt_ut_radix_dep_dr_t*> nodes;
+    t_fib_nh nh;
+    size_t num_walk = 0;
+
+    memset (&nh, 0, sizeof (nh));
+    nas_rt_ut_dep_dr_create (drs, NAS_RT_UT_DEP_DR_ROUTES, 2);
+    order = drs;
+    std::shuffle (order.begin(), order.end(), std::mt19937 (4));
+
+    /* Dependent DR list */
+    auto start = std::chrono::steady_clock::now();
+    for (auto p_dr : order) {
+        ASSERT_TRUE(fib_add_nh_dep_dr (&nh, p_dr) != NULL);
+    }
+    long list_add = nas_rt_ut_nsecs_since (start, order.size());
+    uint64_t list_bytes = fib_get_nh_dep_dr_mem_size (&nh);
+
+    start = std::chrono::steady_clock::now();
+    for (auto p_dr : order) {
+        ASSERT_TRUE(fib_get_nh_dep_dr (&nh, p_dr) != NULL);
+    }
+    long list_get = nas_rt_ut_nsecs_since (start, order.size());
+
+    start = std::chrono::steady_clock::now();
+    for (t_fib_nh_dep_dr *p_nh_dep_dr = fib_get_first_nh_dep_dr (&nh); p_nh_dep_dr != NULL;
+         num_walk++) {
+        t_fib_dr *p_dr = p_nh_dep_dr->p_dr;
+        p_nh_dep_dr = fib_get_next_nh_dep_dr (&nh, p_dr->vrf_id, &p_dr->key.prefix,
+                                              p_dr->prefix_len);
+    }
+    long list_walk = nas_rt_ut_nsecs_since (start, order.size());
+    ASSERT_EQ(num_walk, order.size());
+
+    start = std::chrono::steady_clock::now();
+    for (auto p_dr : order) {
+        ASSERT_EQ(fib_del_nh_dep_dr (&nh, fib_get_nh_dep_dr (&nh, p_dr)), STD_ERR_OK);
+    }
+    long list_del = nas_rt_ut_nsecs_since (start, order.size());
+    fib_delete_all_nh_dep_dr (&nh);
+
+    /* Radix tree of dependent DR nodes with a copy of the DR key */
+    std_rt_table *p_tree = std_radix_create ("dep_dr_ut", 8 * sizeof (nas_rt_ut_radix_dep_dr_key_t),
+                                             NULL, NULL, 0);
+    ASSERT_TRUE(p_tree != NULL);
+
+    start = std::chrono::steady_clock::now();
+    for (auto p_dr : order) {
+        nas_rt_ut_radix_dep_dr_t *p_radix_node = (nas_rt_ut_radix_dep_dr_t *)
+            malloc (sizeof (nas_rt_ut_radix_dep_dr_t));
+        ASSERT_TRUE(p_radix_node != NULL);
+        memset (p_radix_node, 0, sizeof (nas_rt_ut_radix_dep_dr_t));
+        p_radix_node->key.vrf_id = p_dr->vrf_id;
+        memcpy (&p_radix_node->key.dr_key, &p_dr->key, sizeof (t_fib_dr_key));
+        p_radix_node->rt_head.rth_addr = (uint8_t *)&p_radix_node->key;
+        ASSERT_EQ(std_radix_insert (p_tree, &p_radix_node->rt_head,
+                                    NAS_RT_UT_RADIX_DEP_DR_KEY_LEN (p_dr->prefix_len)),
+                  &p_radix_node->rt_head);
+        p_radix_node->prefix_len = p_dr->prefix_len;
+        p_radix_node->p_dr = p_dr;
+        nodes.push_back (p_radix_node);
+    }
+    long radix_add = nas_rt_ut_nsecs_since (start, order.size());
+
+    start = std::chrono::steady_clock::now();
+    for (auto p_radix_node : nodes) {
+        ASSERT_TRUE(std_radix_getexact (p_tree, (uint8_t *)&p_radix_node->key,
+                    NAS_RT_UT_RADIX_DEP_DR_KEY_LEN (p_radix_node->prefix_len)) != NULL);
+    }
+    long radix_get = nas_rt_ut_nsecs_since (start, order.size());
+
+    /* The walk starts as fib_get_first_nh_dep_dr did, from the zero key */
+    nas_rt_ut_radix_dep_dr_t *p_node = NULL;
+    nas_rt_ut_radix_dep_dr_key_t key;
+    memset (&key, 0, sizeof (key));
+    num_walk = 0;
+    start = std::chrono::steady_clock::now();
+    p_node = (nas_rt_ut_radix_dep_dr_t *)
+        std_radix_getexact (p_tree, (uint8_t *)&key, NAS_RT_UT_RADIX_DEP_DR_KEY_LEN (0));
+    if (p_node == NULL) {
+        p_node = (nas_rt_ut_radix_dep_dr_t *)
+            std_radix_getnext (p_tree, (uint8_t *)&key, NAS_RT_UT_RADIX_DEP_DR_KEY_LEN (0));
+    }
+    for (; p_node != NULL; num_walk++) {
+        p_node = (nas_rt_ut_radix_dep_dr_t *)
+            std_radix_getnext (p_tree, (uint8_t *)&p_node->key,
+                               NAS_RT_UT_RADIX_DEP_DR_KEY_LEN (p_node->prefix_len));
+    }
+    long radix_walk = nas_rt_ut_nsecs_since (start, order.size());
+    ASSERT_EQ(num_walk, order.size());
+
+    start = std::chrono::steady_clock::now();
+    for (auto p_radix_node : nodes) {
+        std_radix_remove (p_tree, &p_radix_node->rt_head);
+        free (p_radix_node);
+    }
+    long radix_del = nas_rt_ut_nsecs_since (start, order.size());
+    std_radix_destroy (p_tree);
+
+    std::cout << "Dependent DRs:" << order.size()
+              << " list add:" << list_add << " get:" << list_get << " walk:" << list_walk
+              << " del:" << list_del << " ns/DR"
+              << " radix add:" << radix_add << " get:" << radix_get << " walk:" << radix_walk
+              << " del:" << radix_del << " ns/DR" << std::endl;
+    std::cout << "List memory:" << ((double)list_bytes / order.size()) << " bytes/DR"
+              << " radix node:" << sizeof (nas_rt_ut_radix_dep_dr_t)
+              << " bytes/DR without the malloc and radix internal nodes" << std::endl;
+    nas_rt_ut_dep_dr_destroy (drs);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_route_decode_unittest.cpp
+ * UT and micro-benchmark for the CPS route object decoder
+ */
+#include "nas_rt_util_unittest.h"
+#include "dell-base-routing.h"
+#include "cps_api_object_tools.h"
+
+extern "C" {
+#include "hal_rt_main.h"
+}
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <chrono>
+#include <arpa/inet.h>
+
+#define NAS_RT_UT_DECODE_ITERATIONS  100000
+
+static cps_api_object_t nas_rt_ut_route_obj_create (uint32_t nh_count)
+{
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+                                    BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+    cps_api_object_set_type_operation(cps_api_object_key(obj), cps_api_oper_CREATE);
+
+    const char *vrf_name = "default";
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_VRF_NAME, vrf_name, strlen(vrf_name)+1);
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_NH_VRF_NAME, vrf_name, strlen(vrf_name)+1);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,AF_INET);
+
+    struct in_addr a;
+    inet_aton("101.101.101.0", &a);
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&a.s_addr,sizeof(a.s_addr));
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,24);
+
+    cps_api_attr_id_t ids[3];
+    const int ids_len = sizeof(ids)/sizeof(*ids);
+    ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+
+    for (uint32_t ix = 0; ix < nh_count; ix++) {
+        uint32_t ip = htonl(0x64010100 + ix + 1); /* 100.1.1.x */
+        uint32_t if_index = ix + 1;
+        uint32_t weight = 1;
+
+        ids[1] = ix;
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+        cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN, &ip, sizeof(ip));
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_IFINDEX;
+        cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_U32, &if_index, sizeof(if_index));
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
+        cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_U32, &weight, sizeof(weight));
+    }
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,nh_count);
+    return obj;
+}
+
+static void nas_rt_ut_route_decode_validate (uint32_t nh_count)
+{
+    cps_api_object_guard obj_g (nas_rt_ut_route_obj_create (nh_count));
+    t_fib_msg *p_msg = NULL;
+
+    ASSERT_TRUE(hal_rt_cps_obj_to_route (obj_g.get(), &p_msg));
+    ASSERT_TRUE(p_msg != NULL);
+    EXPECT_EQ(p_msg->type, FIB_MSG_TYPE_NL_ROUTE);
+    EXPECT_EQ(p_msg->route.msg_type, FIB_RT_MSG_ADD);
+    EXPECT_EQ(p_msg->route.prefix_masklen, (unsigned short)24);
+    EXPECT_EQ(p_msg->route.hop_count, (size_t)nh_count);
+    for (uint32_t ix = 0; ix < nh_count; ix++) {
+        EXPECT_EQ(p_msg->route.nh_list[ix].nh_if_index, (hal_ifindex_t)(ix + 1));
+        EXPECT_EQ(p_msg->route.nh_list[ix].nh_addr.u.v4_addr, (uint32_t)htonl(0x64010100 + ix + 1));
+        EXPECT_EQ(p_msg->route.nh_list[ix].nh_weight, (uint32_t)1);
+    }
+    hal_rt_free_mem_msg (p_msg);
+}
+
+/* Decode time per route, the route msg buffer is taken from the pool class
+ * for the NH count, so it is moved at most once per class on the way up */
+static void nas_rt_ut_route_decode_bench (uint32_t nh_count)
+{
+    cps_api_object_guard obj_g (nas_rt_ut_route_obj_create (nh_count));
+    t_fib_msg *p_msg = NULL;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int ix = 0; ix < NAS_RT_UT_DECODE_ITERATIONS; ix++) {
+        ASSERT_TRUE(hal_rt_cps_obj_to_route (obj_g.get(), &p_msg));
+        hal_rt_free_mem_msg (p_msg);
+    }
+    auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Route decode NH count:" << nh_count << " "
+              << (nsecs / NAS_RT_UT_DECODE_ITERATIONS) << " ns/route" << std::endl;
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_1nh) {
+    nas_rt_ut_route_decode_validate (1);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_8nh) {
+    nas_rt_ut_route_decode_validate (8);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_64nh) {
+    nas_rt_ut_route_decode_validate (64);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_nh_list_over_nh_count) {
+    /* NH list with more entries than the NH count should not overflow the msg */
+    cps_api_object_guard obj_g (nas_rt_ut_route_obj_create (8));
+    t_fib_msg *p_msg = NULL;
+
+    cps_api_object_attr_delete(obj_g.get(), BASE_ROUTE_OBJ_ENTRY_NH_COUNT);
+    cps_api_object_attr_add_u32(obj_g.get(), BASE_ROUTE_OBJ_ENTRY_NH_COUNT, 2);
+    ASSERT_TRUE(hal_rt_cps_obj_to_route (obj_g.get(), &p_msg));
+    EXPECT_EQ(p_msg->route.hop_count, (size_t)2);
+    EXPECT_EQ(p_msg->route.nh_list[1].nh_if_index, (hal_ifindex_t)2);
+    hal_rt_free_mem_msg (p_msg);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_nh_count_over_nh_list) {
+    /* NH count with more NHs than the NH list should size the msg for the NH count */
+    cps_api_object_guard obj_g (nas_rt_ut_route_obj_create (2));
+    t_fib_msg *p_msg = NULL;
+
+    cps_api_object_attr_delete(obj_g.get(), BASE_ROUTE_OBJ_ENTRY_NH_COUNT);
+    cps_api_object_attr_add_u32(obj_g.get(), BASE_ROUTE_OBJ_ENTRY_NH_COUNT, 8);
+    ASSERT_TRUE(hal_rt_cps_obj_to_route (obj_g.get(), &p_msg));
+    EXPECT_EQ(p_msg->route.hop_count, (size_t)8);
+    EXPECT_EQ(p_msg->route.nh_list[1].nh_if_index, (hal_ifindex_t)2);
+    EXPECT_EQ(p_msg->route.nh_list[7].nh_if_index, (hal_ifindex_t)0);
+    hal_rt_free_mem_msg (p_msg);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_nh_list_over_pool_classes) {
+    /* NH list beyond the largest pool class is decoded into a heap buffer */
+    nas_rt_ut_route_decode_validate (HAL_RT_MSG_POOL_ROUTE_MAX_NH + 1);
+    nas_rt_ut_route_decode_validate (4 * HAL_RT_MSG_POOL_ROUTE_MAX_NH);
+}
+
+TEST(hal_rt_route_decode_test, hal_rt_route_decode_bench) {
+    nas_rt_ut_route_decode_bench (1);
+    nas_rt_ut_route_decode_bench (8);
+    nas_rt_ut_route_decode_bench (64);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * hal_rt_rslv_unittest.cpp
+ * UT for the resolution workers, the jobs run by the pool against the
+ * same jobs run serially
+ */
+extern "C" {
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_util.h"
+}
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#define NAS_RT_UT_RSLV_WORKERS   3
+#define NAS_RT_UT_RSLV_ROUNDS    256
+
+typedef struct {
+    std::vector<uint64_t>                   in;
+    std::vector<uint64_t>                   out;
+    std::unique_ptr<std::atomic<uint32_t>[]> run_cnt;
+} nas_rt_ut_rslv_job_t;
+
+static uint64_t nas_rt_ut_rslv_item_compute (uint64_t val)
+{
+    /* splitmix64 rounds, enough work per item for the workers to take some */
+    for (int ix = 0; ix < NAS_RT_UT_RSLV_ROUNDS; ix++) {
+        val += 0x9e3779b97f4a7c15ULL;
+        val = (val ^ (val >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        val = (val ^ (val >> 27)) * 0x94d049bb133111ebULL;
+        val = val ^ (val >> 31);
+    }
+    return val;
+}
+
+static void nas_rt_ut_rslv_job_run (void *p_arg, uint32_t item)
+{
+    nas_rt_ut_rslv_job_t *p_job = (nas_rt_ut_rslv_job_t *)p_arg;
+
+    p_job->out[item] = nas_rt_ut_rslv_item_compute (p_job->in[item]);
+    p_job->run_cnt[item].fetch_add (1, std::memory_order_relaxed);
+}
+
+static void nas_rt_ut_rslv_job_init (nas_rt_ut_rslv_job_t &job, uint32_t num_items, uint64_t seed)
+{
+    job.in.resize (num_items);
+    job.out.assign (num_items, 0);
+    job.run_cnt.reset (new std::atomic<uint32_t>[num_items]);
+    for (uint32_t ix = 0; ix < num_items; ix++) {
+        job.in[ix] = seed + ix;
+        job.run_cnt[ix].store (0, std::memory_order_relaxed);
+    }
+}
+
+/* Runs the job on the pool and checks it against the serial run */
+static void nas_rt_ut_rslv_job_validate (uint32_t num_items, uint64_t seed)
+{
+    nas_rt_ut_rslv_job_t job;
+
+    nas_rt_ut_rslv_job_init (job, num_items, seed);
+    hal_rt_rslv_workers_run (nas_rt_ut_rslv_job_run, &job, num_items);
+
+    for (uint32_t ix = 0; ix < num_items; ix++) {
+        EXPECT_EQ(job.run_cnt[ix].load(), 1) << "item " << ix;
+        EXPECT_EQ(job.out[ix], nas_rt_ut_rslv_item_compute (job.in[ix])) << "item " << ix;
+    }
+}
+
+static void nas_rt_ut_rslv_workers_start (void)
+{
+    static bool is_started = false;
+
+    if (is_started)
+        return;
+    for (int ix = 0; ix < NAS_RT_UT_RSLV_WORKERS; ix++) {
+        std::thread (fib_rslv_worker_main, (void *)NULL).detach();
+    }
+    while (hal_rt_rslv_workers_get () < NAS_RT_UT_RSLV_WORKERS) {
+        usleep (1000);
+    }
+    is_started = true;
+}
+
+TEST(hal_rt_rslv_test, serial_without_workers) {
+    /* Before the workers are started the caller runs all the items */
+    if (hal_rt_rslv_workers_get () != 0)
+        return;
+    nas_rt_ut_rslv_job_validate (1000, 1);
+}
+
+TEST(hal_rt_rslv_test, workers_match_serial) {
+    nas_rt_ut_rslv_workers_start ();
+    ASSERT_EQ(hal_rt_rslv_workers_get (), NAS_RT_UT_RSLV_WORKERS);
+
+    nas_rt_ut_rslv_job_validate (0, 0);
+    nas_rt_ut_rslv_job_validate (1, 7);
+    nas_rt_ut_rslv_job_validate (FIB_RSLV_MIN_PARALLEL_DRS, 11);
+    nas_rt_ut_rslv_job_validate (100000, 13);
+}
+
+TEST(hal_rt_rslv_test, workers_back_to_back_jobs) {
+    nas_rt_ut_rslv_workers_start ();
+
+    for (uint32_t ix = 0; ix < 1000; ix++) {
+        nas_rt_ut_rslv_job_validate (1 + (ix % 200), ix);
+    }
+}
+
+TEST(hal_rt_rslv_test, workers_concurrent_callers) {
+    /* A caller finding the pool busy runs its job by itself */
+    nas_rt_ut_rslv_workers_start ();
+
+    std::vector<std::thread> callers;
+    for (uint32_t caller = 0; caller < 4; caller++) {
+        callers.emplace_back ([caller] {
+            for (uint32_t ix = 0; ix < 200; ix++) {
+                nas_rt_ut_rslv_job_validate (500 + ix, (caller << 20) + ix);
+            }
+        });
+    }
+    for (auto &caller : callers) {
+        caller.join();
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}